@@ -0,0 +1,147 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * This file contains definitions of all methods of arena (bump) allocator
+ */
+
+#include "Arena.hpp"
+
+#include <cstring>
+#include <omp.h>
+
+
+/**
+ * MediaLibCleaner::Arena constructor.
+ *
+ * @param[in] chunk_size  Size of one chunk of memory (in bytes)
+ */
+MediaLibCleaner::Arena::Arena(size_t chunk_size)
+{
+	this->chunk_size = chunk_size;
+}
+
+/**
+ * MediaLibCleaner::Arena destructor. Frees all chunks.
+ */
+MediaLibCleaner::Arena::~Arena()
+{
+	this->Release();
+}
+
+/**
+ * Method returns memory block of given size (aligned to 8 bytes), valid until Release() is called.
+ *
+ * @param[in] bytes  Size of the block
+ *
+ * @return Pointer to the block
+ */
+void* MediaLibCleaner::Arena::Allocate(size_t bytes)
+{
+	bytes = (bytes + 7) & ~static_cast<size_t>(7);
+
+	Slot &slot = this->slots[static_cast<unsigned int>(omp_get_thread_num()) % SLOTS];
+
+	slot.synch.lock();
+
+	char *block;
+	if (bytes > this->chunk_size / 4)
+	{
+		// big blocks get their own chunk, so current chunk is not wasted
+		block = new char[bytes];
+		slot.chunks.push_back(block);
+		slot.bytes += bytes;
+	}
+	else
+	{
+		if (slot.current == nullptr || slot.used + bytes > this->chunk_size)
+		{
+			slot.current = new char[this->chunk_size];
+			slot.chunks.push_back(slot.current);
+			slot.used = 0;
+			slot.bytes += this->chunk_size;
+		}
+
+		block = slot.current + slot.used;
+		slot.used += bytes;
+	}
+
+	slot.synch.unlock();
+
+	return block;
+}
+
+/**
+ * Method copies given string into the arena
+ *
+ * @param[in] value  String to be copied
+ *
+ * @return Pointer to null-terminated copy of the string
+ */
+const wchar_t* MediaLibCleaner::Arena::Copy(const std::wstring &value)
+{
+	wchar_t *copy = static_cast<wchar_t*>(this->Allocate((value.length() + 1) * sizeof(wchar_t)));
+	std::memcpy(copy, value.c_str(), (value.length() + 1) * sizeof(wchar_t));
+
+	return copy;
+}
+
+/**
+ * Method frees all memory handed out by the arena (all at once - one free per chunk).
+ */
+void MediaLibCleaner::Arena::Release()
+{
+	for (unsigned int i = 0; i < SLOTS; i++)
+	{
+		Slot &slot = this->slots[i];
+
+		slot.synch.lock();
+		for (auto it = slot.chunks.begin(); it != slot.chunks.end(); ++it)
+			delete[] *it;
+
+		slot.chunks.clear();
+		slot.current = nullptr;
+		slot.used = 0;
+		slot.bytes = 0;
+		slot.synch.unlock();
+	}
+}
+
+/**
+ * Method returns amount of memory taken by the arena
+ *
+ * @return Amount of bytes
+ */
+uintmax_t MediaLibCleaner::Arena::GetBytes()
+{
+	uintmax_t bytes = 0;
+
+	for (unsigned int i = 0; i < SLOTS; i++)
+	{
+		this->slots[i].synch.lock();
+		bytes += this->slots[i].bytes;
+		this->slots[i].synch.unlock();
+	}
+
+	return bytes;
+}
+
+/**
+ * Method returns amount of chunks allocated by the arena
+ *
+ * @return Amount of chunks
+ */
+size_t MediaLibCleaner::Arena::GetChunks()
+{
+	size_t chunks = 0;
+
+	for (unsigned int i = 0; i < SLOTS; i++)
+	{
+		this->slots[i].synch.lock();
+		chunks += this->slots[i].chunks.size();
+		this->slots[i].synch.unlock();
+	}
+
+	return chunks;
+}
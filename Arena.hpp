@@ -0,0 +1,65 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * File contains declaration of arena (bump) allocator used for objects living until the end of the program
+ */
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace MediaLibCleaner
+{
+	/**
+	 * @class Arena Arena.hpp
+	 *
+	 * @brief Class MediaLibCleaner::Arena hands out memory from big chunks and frees all of them at once (thread-safe).
+	 * Every thread allocates from its own slot (by OpenMP thread number), so threads do not wait for each other.
+	 * Memory is never freed separately - destructors of objects placed in the arena are not called.
+	 */
+	class Arena
+	{
+	public:
+		Arena(size_t chunk_size = 262144);
+		~Arena();
+
+		void* Allocate(size_t bytes);
+		const wchar_t* Copy(const std::wstring &value);
+		void Release();
+
+		uintmax_t GetBytes();
+		size_t GetChunks();
+
+	protected:
+		/**
+		 * Amount of slots (threads with higher numbers share slots)
+		 */
+		static const unsigned int SLOTS = 64;
+
+		/**
+		 * Memory of one thread
+		 */
+		struct Slot
+		{
+			std::mutex synch; ///< std::mutex protecting slot from racing conditions (when threads share the slot)
+			std::vector<char*> chunks; ///< All allocated chunks
+			char* current = nullptr; ///< Chunk memory is currently handed out from
+			size_t used = 0; ///< Amount of bytes of current chunk already handed out
+			uintmax_t bytes = 0; ///< Total size of all chunks
+		};
+
+		/**
+		 * Size of one chunk (in bytes)
+		 */
+		size_t chunk_size;
+
+		/**
+		 * Slots of all threads
+		 */
+		Slot slots[SLOTS];
+	};
+}
@@ -0,0 +1,408 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * This file contains definitions of checksum store. Store is a UTF-8 text file with one line per file:
+ * hash of audio data (16 hex digits), length of audio data, modification time of the file, time of the last verification and path,
+ * separated by tabs. Only audio data is hashed (the same way MediaLibCleaner::DuplicateFinder does), so tag edits never look like corruption.
+ */
+
+#include "ChecksumStore.hpp"
+#include "DuplicateFinder.hpp"
+#include "FastTagReader.hpp"
+
+#include <algorithm>
+#include <codecvt>
+#include <ctime>
+#include <iomanip>
+#include <set>
+
+#include <boost/filesystem/fstream.hpp>
+
+#include <omp.h>
+
+
+/**
+ * First line of the store file (format version)
+ */
+static const wchar_t *STORE_HEADER = L"MediaLibCleaner checksums 1";
+
+/**
+ * @brief Structure describing single file hashed by MediaLibCleaner::ChecksumStore::Run()
+ */
+struct ChecksumTask
+{
+	MediaLibCleaner::File *file; ///< Hashed file
+	bool known; ///< True if file is verified, false if it is recorded for the first time
+	bool hashed = false; ///< True if audio data was hashed
+	unsigned long long hash = 0; ///< Hash of audio data
+	unsigned long long length = 0; ///< Length of audio data in bytes
+};
+
+/**
+ * Function hashes audio data of the file
+ *
+ * @param[in]  path    Full path to the file
+ * @param[in]  type    Type of the file
+ * @param[out] hash    Hash of audio data
+ * @param[out] length  Length of audio data in bytes
+ *
+ * @return True if audio data was found and hashed
+ */
+static bool hashAudioData(const std::wstring &path, MediaLibCleaner::FileType type, unsigned long long *hash, unsigned long long *length)
+{
+	MediaLibCleaner::MappedFile mapped;
+	std::vector<MediaLibCleaner::PayloadRange> ranges;
+
+	if (!mapped.Open(path) || !MediaLibCleaner::FindAudioPayload(mapped.GetData(), mapped.GetSize(), type, &ranges)) return false;
+
+	*length = 0;
+	for (size_t i = 0; i < ranges.size(); i++)
+		*length += ranges[i].length;
+
+	// length as seed, as in MediaLibCleaner::DuplicateFinder
+	MediaLibCleaner::Hash64 hasher(*length);
+	for (size_t i = 0; i < ranges.size(); i++)
+		hasher.Update(mapped.GetData() + static_cast<size_t>(ranges[i].offset), static_cast<size_t>(ranges[i].length));
+
+	*hash = hasher.Final();
+	return true;
+}
+
+/**
+ * MediaLibCleaner::ChecksumStore constructor
+ *
+ * @param[in] logprogram  std::unique_ptr to MediaLibCleaner::LogProgram object for logging purposes
+ * @param[in] logalert    std::unique_ptr to MediaLibCleaner::LogAlert object for logging purposes
+ */
+MediaLibCleaner::ChecksumStore::ChecksumStore(std::unique_ptr<MediaLibCleaner::LogProgram>* logprogram, std::unique_ptr<MediaLibCleaner::LogAlert>* logalert)
+{
+	this->logprogram = logprogram;
+	this->logalert = logalert;
+}
+
+/**
+ * Method reads records from the store file. Missing file is not an error (store is empty on the first run).
+ *
+ * @param[in] path  Path to the store file
+ *
+ * @return True if store was read or does not exist yet
+ */
+bool MediaLibCleaner::ChecksumStore::Load(const std::wstring &path)
+{
+	this->records.clear();
+
+	boost::system::error_code error;
+	if (!boost::filesystem::exists(boost::filesystem::path(path), error))
+	{
+		(*this->logprogram)->Log(L"MediaLibCleaner::ChecksumStore", L"Store file does not exist yet, all files will be recorded: " + path, 3);
+		return true;
+	}
+
+	boost::filesystem::wifstream file;
+	file.imbue(std::locale(std::locale::classic(), new std::codecvt_utf8<wchar_t>));
+	file.open(boost::filesystem::path(path));
+	if (!file.is_open())
+	{
+		(*this->logprogram)->Log(L"MediaLibCleaner::ChecksumStore", L"Store file could not be opened: " + path, 1);
+		return false;
+	}
+
+	std::wstring line;
+	if (!std::getline(file, line) || line != STORE_HEADER)
+	{
+		(*this->logprogram)->Log(L"MediaLibCleaner::ChecksumStore", L"File is not a checksum store: " + path, 1);
+		return false;
+	}
+
+	size_t invalid = 0;
+	while (std::getline(file, line))
+	{
+		if (line.empty()) continue;
+
+		// hash, length, modified, verified, path (path may contain tabs - it is the rest of the line)
+		size_t separators[4];
+		size_t position = 0;
+		bool valid = true;
+		for (int i = 0; i < 4 && valid; i++)
+		{
+			separators[i] = line.find(L'\t', position);
+			valid = (separators[i] != std::wstring::npos);
+			position = separators[i] + 1;
+		}
+
+		if (!valid || position >= line.size())
+		{
+			invalid++;
+			continue;
+		}
+
+		Record record;
+		try
+		{
+			record.hash = std::stoull(line.substr(0, separators[0]), nullptr, 16);
+			record.length = std::stoull(line.substr(separators[0] + 1, separators[1] - separators[0] - 1));
+			record.modified = std::stoll(line.substr(separators[1] + 1, separators[2] - separators[1] - 1));
+			record.verified = std::stoll(line.substr(separators[2] + 1, separators[3] - separators[2] - 1));
+		}
+		catch (const std::exception&)
+		{
+			invalid++;
+			continue;
+		}
+
+		this->records[line.substr(position)] = record;
+	}
+
+	if (invalid > 0)
+		(*this->logprogram)->Log(L"MediaLibCleaner::ChecksumStore", L"Skipped " + std::to_wstring(invalid) + L" invalid lines of store file: " + path, 2);
+
+	(*this->logprogram)->Log(L"MediaLibCleaner::ChecksumStore", L"Read " + std::to_wstring(this->records.size()) + L" records from store file: " + path, 3);
+	return true;
+}
+
+/**
+ * Method writes all records to the store file. Records are written to temporary file first, so the store is never left half-written.
+ *
+ * @param[in] path  Path to the store file
+ *
+ * @return True if store was written
+ */
+bool MediaLibCleaner::ChecksumStore::Save(const std::wstring &path)
+{
+	boost::filesystem::path target(path);
+	boost::filesystem::path temporary(path + L".tmp");
+
+	{
+		boost::filesystem::wofstream file;
+		file.imbue(std::locale(std::locale::classic(), new std::codecvt_utf8<wchar_t>));
+		file.open(temporary);
+		if (!file.is_open())
+		{
+			(*this->logprogram)->Log(L"MediaLibCleaner::ChecksumStore", L"Store file could not be written: " + temporary.wstring(), 1);
+			return false;
+		}
+
+		file << STORE_HEADER << L"\n";
+		for (auto it = this->records.begin(); it != this->records.end(); ++it)
+		{
+			file << std::hex << std::setw(16) << std::setfill(L'0') << it->second.hash << std::dec
+				<< L"\t" << it->second.length << L"\t" << it->second.modified << L"\t" << it->second.verified << L"\t" << it->first << L"\n";
+		}
+
+		file.flush();
+		if (!file.good())
+		{
+			(*this->logprogram)->Log(L"MediaLibCleaner::ChecksumStore", L"Store file could not be written: " + temporary.wstring(), 1);
+			return false;
+		}
+	}
+
+	boost::system::error_code error;
+	boost::filesystem::rename(temporary, target, error);
+	if (error)
+	{
+		(*this->logprogram)->Log(L"MediaLibCleaner::ChecksumStore", L"Store file could not be replaced: " + path + L" (" + s2ws(error.message()) + L")", 1);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Method adds file to the store (files which are not audio files are ignored)
+ *
+ * @param[in] file  File to record or verify
+ */
+void MediaLibCleaner::ChecksumStore::AddFile(MediaLibCleaner::File *file)
+{
+	if (file->IsInitiated()) this->files.push_back(file);
+}
+
+/**
+ * Method records hash of audio data of files seen for the first time and verifies files verified longest ago.
+ * Files are hashed on all threads (OpenMP). Files are chosen before anything is read, by their size, so the budget is never exceeded
+ * (except for a single file larger than the whole budget, which is still read so that it is not skipped forever).
+ *
+ * @param[in] fraction  Part of known files verified in this run (30 - one in 30 files; 0 - all files)
+ * @param[in] budget    Maximum amount of bytes read in this run (0 - no limit)
+ *
+ * @return Amount of files with audio data changed while the file was not modified
+ */
+size_t MediaLibCleaner::ChecksumStore::Run(int fraction, unsigned long long budget)
+{
+	this->added = 0;
+	this->verified = 0;
+	this->mismatches = 0;
+	this->bytes_hashed = 0;
+
+	long long now = static_cast<long long>(std::time(nullptr));
+
+	std::vector<File*> fresh;
+	std::vector<std::pair<long long, File*>> known;
+	std::set<std::wstring> seen;
+
+	for (size_t i = 0; i < this->files.size(); i++)
+	{
+		std::wstring path = this->files[i]->GetPath();
+		seen.insert(path);
+
+		auto record = this->records.find(path);
+		if (record == this->records.end())
+			fresh.push_back(this->files[i]);
+		else
+			known.push_back(std::make_pair(record->second.verified, this->files[i]));
+	}
+
+	// records of files removed or renamed since the last run (if the directory is gone too, the drive may be just disconnected)
+	for (auto it = this->records.begin(); it != this->records.end();)
+	{
+		boost::system::error_code error;
+		boost::filesystem::path path(it->first);
+
+		if (seen.count(it->first) == 0 && !boost::filesystem::exists(path, error) && boost::filesystem::exists(path.parent_path(), error))
+			it = this->records.erase(it);
+		else
+			++it;
+	}
+
+	std::sort(fresh.begin(), fresh.end(), [](File *a, File *b) { return a->GetPath() < b->GetPath(); });
+	std::sort(known.begin(), known.end(), [](const std::pair<long long, File*> &a, const std::pair<long long, File*> &b) {
+		return a.first != b.first ? a.first < b.first : a.second->GetPath() < b.second->GetPath();
+	});
+
+	size_t quota = (fraction > 0) ? (known.size() + fraction - 1) / fraction : known.size();
+
+	// new files first - a file without a record cannot be verified in any later run
+	std::vector<ChecksumTask> tasks;
+	unsigned long long planned = 0;
+	size_t skipped = 0;
+
+	for (size_t i = 0; i < fresh.size() + known.size(); i++)
+	{
+		bool is_known = (i >= fresh.size());
+		if (is_known && i - fresh.size() >= quota) break;
+
+		File *file = is_known ? known[i - fresh.size()].second : fresh[i];
+		unsigned long long size = file->GetFileSizeBytes();
+
+		if (budget > 0 && planned > 0 && planned + size > budget)
+		{
+			skipped += is_known ? quota - (i - fresh.size()) : fresh.size() - i + quota;
+			break;
+		}
+
+		ChecksumTask task;
+		task.file = file;
+		task.known = is_known;
+		tasks.push_back(task);
+		planned += size;
+	}
+
+	if (skipped > 0)
+		(*this->logprogram)->Log(L"MediaLibCleaner::ChecksumStore", L"Budget of " + std::to_wstring(budget) + L" bytes reached, " + std::to_wstring(skipped) + L" files left for the next run", 3);
+
+	int count = static_cast<int>(tasks.size());
+	unsigned long long bytes = 0;
+
+	#pragma omp parallel for schedule(dynamic) reduction(+:bytes)
+	for (int i = 0; i < count; i++)
+	{
+		ChecksumTask &task = tasks[i];
+		task.hashed = hashAudioData(task.file->GetPath(), task.file->GetFileType(), &task.hash, &task.length);
+		if (task.hashed) bytes += task.length;
+	}
+
+	this->bytes_hashed = bytes;
+
+	for (size_t i = 0; i < tasks.size(); i++)
+	{
+		const ChecksumTask &task = tasks[i];
+		std::wstring path = task.file->GetPath();
+		long long modified = static_cast<long long>(task.file->GetFileModDatetimeRaw());
+
+		if (!task.hashed)
+		{
+			(*this->logprogram)->Log(L"MediaLibCleaner::ChecksumStore(" + path + L")", L"Audio data not found, checksum is not " + std::wstring(task.known ? L"verified" : L"recorded"), 2);
+			continue;
+		}
+
+		Record &record = this->records[path];
+
+		if (!task.known)
+		{
+			record.hash = task.hash;
+			record.length = task.length;
+			record.modified = modified;
+			record.verified = now;
+			this->added++;
+			continue;
+		}
+
+		this->verified++;
+
+		if (record.hash != task.hash || record.length != task.length)
+		{
+			if (record.modified == modified)
+			{
+				// record is kept as it is, so the file is verified and reported again in the next run, until it is restored
+				this->mismatches++;
+				(*this->logalert)->Log(L"MediaLibCleaner::ChecksumStore(" + path + L")", L"Audio data changed while the file was not modified (silent corruption); audio data was intact on " + get_date_rfc_2822_wide(static_cast<time_t>(record.verified)));
+				continue;
+			}
+
+			(*this->logprogram)->Log(L"MediaLibCleaner::ChecksumStore(" + path + L")", L"Audio data changed together with modification time of the file, new checksum recorded", 2);
+			record.hash = task.hash;
+			record.length = task.length;
+		}
+
+		// tag edits change modification time only
+		record.modified = modified;
+		record.verified = now;
+	}
+
+	(*this->logprogram)->Log(L"MediaLibCleaner::ChecksumStore", L"Recorded " + std::to_wstring(this->added) + L" files, verified " + std::to_wstring(this->verified) + L" files (" + std::to_wstring(this->bytes_hashed) + L" bytes hashed), " + std::to_wstring(this->mismatches) + L" corrupted files found", 3);
+
+	return this->mismatches;
+}
+
+/**
+ * Method returns amount of files recorded for the first time by the last Run()
+ *
+ * @return Amount of files
+ */
+size_t MediaLibCleaner::ChecksumStore::GetAdded()
+{
+	return this->added;
+}
+
+/**
+ * Method returns amount of files verified by the last Run()
+ *
+ * @return Amount of files
+ */
+size_t MediaLibCleaner::ChecksumStore::GetVerified()
+{
+	return this->verified;
+}
+
+/**
+ * Method returns amount of files with audio data changed while the file was not modified, found by the last Run()
+ *
+ * @return Amount of files
+ */
+size_t MediaLibCleaner::ChecksumStore::GetMismatches()
+{
+	return this->mismatches;
+}
+
+/**
+ * Method returns amount of bytes of audio data hashed by the last Run()
+ *
+ * @return Amount of bytes
+ */
+unsigned long long MediaLibCleaner::ChecksumStore::GetBytesHashed()
+{
+	return this->bytes_hashed;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * File contains declarations of checksum store - detection of silent corruption of audio data between runs (bit rot)
+ */
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "MediaLibCleaner.hpp"
+
+namespace MediaLibCleaner
+{
+	/**
+	 * @class ChecksumStore ChecksumStore.hpp
+	 *
+	 * @brief Class MediaLibCleaner::ChecksumStore keeps hash of audio data (see MediaLibCleaner::FindAudioPayload()) of every file between runs.
+	 *
+	 * Hash is recorded when file is seen for the first time. Every run verifies files verified longest ago - one in given fraction of the library,
+	 * so all files are verified once in that many runs. If audio data changed while modification time of the file did not, the file
+	 * is reported to alert log. Tag edits do not change audio data, so they are never reported.
+	 * Amount of data read in one run is limited by the budget; files not read because of the budget are read in the next run.
+	 */
+	class ChecksumStore
+	{
+	public:
+		ChecksumStore(std::unique_ptr<LogProgram>*, std::unique_ptr<LogAlert>*);
+
+		bool Load(const std::wstring &path);
+		bool Save(const std::wstring &path);
+
+		void AddFile(File*);
+		size_t Run(int fraction, unsigned long long budget);
+
+		size_t GetAdded();
+		size_t GetVerified();
+		size_t GetMismatches();
+		unsigned long long GetBytesHashed();
+
+	protected:
+		/**
+		 * @brief Structure describing audio data of a single file recorded in the store
+		 */
+		struct Record
+		{
+			unsigned long long hash = 0; ///< Hash of audio data
+			unsigned long long length = 0; ///< Length of audio data in bytes
+			long long modified = 0; ///< Modification time of the file when it was hashed (unix timestamp)
+			long long verified = 0; ///< Time of the last verification (unix timestamp)
+		};
+
+		/**
+		 * Records of all files, by path
+		 */
+		std::map<std::wstring, Record> records;
+
+		/**
+		 * All audio files added to the store
+		 */
+		std::vector<File*> files;
+
+		/**
+		 * Amount of files recorded for the first time by the last Run()
+		 */
+		size_t added = 0;
+
+		/**
+		 * Amount of files verified by the last Run()
+		 */
+		size_t verified = 0;
+
+		/**
+		 * Amount of files with changed audio data found by the last Run()
+		 */
+		size_t mismatches = 0;
+
+		/**
+		 * Amount of bytes of audio data hashed by the last Run()
+		 */
+		unsigned long long bytes_hashed = 0;
+
+		/**
+		 * std::unique_ptr to MediaLibCleaner::LogAlert object for logging purposes
+		 */
+		std::unique_ptr<LogAlert>* logalert;
+
+		/**
+		 * std::unique_ptr to MediaLibCleaner::LogProgram object for logging purposes
+		 */
+		std::unique_ptr<LogProgram>* logprogram;
+	};
+}
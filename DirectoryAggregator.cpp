@@ -0,0 +1,214 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * This file contains definitions of directory aggregator. All values of a directory are collected in a single pass through its files;
+ * track numbers are counted in an array indexed by the number, which gives sorted list of tracks, gaps and duplicates without sorting.
+ */
+
+#include "DirectoryAggregator.hpp"
+
+#include <algorithm>
+#include <set>
+
+#include <omp.h>
+
+
+/**
+ * Highest track number taken into account (higher numbers and totals are treated as invalid)
+ */
+static const int MAX_TRACK = 999;
+
+/**
+ * Function parses track tag ("3" or "3/12")
+ *
+ * @param[in]  value  Value of track tag
+ * @param[out] total  Total amount of tracks (0 if not given)
+ *
+ * @return Track number or 0 if value does not contain valid track number
+ */
+static int parseTrack(const std::wstring &value, int *total)
+{
+	size_t i = 0;
+	int track = 0;
+
+	*total = 0;
+
+	while (i < value.length() && value[i] == L' ') i++;
+	if (i == value.length() || value[i] < L'0' || value[i] > L'9') return 0;
+
+	while (i < value.length() && value[i] >= L'0' && value[i] <= L'9')
+	{
+		track = track * 10 + (value[i] - L'0');
+		if (track > MAX_TRACK) return 0;
+		i++;
+	}
+
+	if (i < value.length() && value[i] == L'/')
+	{
+		int t = 0;
+		for (i++; i < value.length() && value[i] >= L'0' && value[i] <= L'9' && t <= MAX_TRACK; i++)
+			t = t * 10 + (value[i] - L'0');
+		if (t <= MAX_TRACK) *total = t;
+	}
+
+	return track;
+}
+
+
+
+
+/**
+ * MediaLibCleaner::DirectoryAggregator constructor
+ *
+ * @param[in] logprogram  std::unique_ptr to MediaLibCleaner::LogProgram object for logging purposses
+ * @param[in] logalert    std::unique_ptr to MediaLibCleaner::LogAlert object for logging purposses
+ */
+MediaLibCleaner::DirectoryAggregator::DirectoryAggregator(std::unique_ptr<MediaLibCleaner::LogProgram>* logprogram, std::unique_ptr<MediaLibCleaner::LogAlert>* logalert)
+{
+	this->logprogram = logprogram;
+	this->logalert = logalert;
+}
+
+/**
+ * Method adds file to the group of its directory (files which are not audio files are ignored)
+ *
+ * @param[in] file  File to add
+ */
+void MediaLibCleaner::DirectoryAggregator::AddFile(MediaLibCleaner::File *file)
+{
+	if (!file->IsInitiated()) return;
+
+	std::wstring path = file->GetFolderPath();
+	auto found = this->index.find(path);
+
+	if (found == this->index.end())
+	{
+		std::unique_ptr<Group> group(new Group());
+		group->path = path;
+		group->aggregate.path = path;
+
+		found = this->index.insert(std::make_pair(path, this->groups.size())).first;
+		this->groups.push_back(std::move(group));
+	}
+
+	this->groups[found->second]->files.push_back(file);
+}
+
+/**
+ * Method computes aggregates of all directories. Every directory is handled by one thread.
+ *
+ * @return Amount of directories
+ */
+size_t MediaLibCleaner::DirectoryAggregator::Run()
+{
+	int count = static_cast<int>(this->groups.size());
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int g = 0; g < count; g++)
+	{
+		Group *group = this->groups[g].get();
+		DirectoryAggregate *aggregate = &group->aggregate;
+
+		std::set<std::wstring> albums, albumartists, years, codecs;
+		std::set<int> samplerates;
+		std::vector<unsigned short> uses(MAX_TRACK + 1, 0);
+		int last = 0;
+
+		for (size_t i = 0; i < group->files.size(); i++)
+		{
+			File *file = group->files[i];
+
+			albums.insert(file->GetAlbum());
+			albumartists.insert(file->GetAlbumArtist());
+			years.insert(file->GetYear());
+			codecs.insert(file->GetCodec());
+			samplerates.insert(file->GetSampleRate());
+
+			int total;
+			int track = parseTrack(file->GetTrack(), &total);
+
+			if (track == 0)
+			{
+				aggregate->untracked++;
+				continue;
+			}
+
+			if (uses[track] < 0xFFFF) uses[track]++;
+			last = std::max(last, std::max(track, total));
+		}
+
+		aggregate->files = static_cast<int>(group->files.size());
+		aggregate->albums.assign(albums.begin(), albums.end());
+		aggregate->albumartists.assign(albumartists.begin(), albumartists.end());
+		aggregate->years.assign(years.begin(), years.end());
+		aggregate->codecs.assign(codecs.begin(), codecs.end());
+		aggregate->samplerates.assign(samplerates.begin(), samplerates.end());
+
+		for (int t = 1; t <= last; t++)
+		{
+			if (uses[t] == 0)
+			{
+				aggregate->track_gaps.push_back(t);
+				continue;
+			}
+
+			aggregate->tracks.push_back(t);
+			if (uses[t] > 1) aggregate->track_duplicates.push_back(t);
+		}
+	}
+
+	(*this->logprogram)->Log(L"MediaLibCleaner::DirectoryAggregator", L"Directories aggregated: " + std::to_wstring(count), 3);
+
+	return this->groups.size();
+}
+
+/**
+ * Method returns aggregate of directory of the file
+ *
+ * @param[in] file  File which directory is requested
+ *
+ * @return Aggregate of directory of the file or nullptr if there are no audio files in the directory
+ */
+const MediaLibCleaner::DirectoryAggregate* MediaLibCleaner::DirectoryAggregator::Get(MediaLibCleaner::File *file)
+{
+	auto found = this->index.find(file->GetFolderPath());
+	if (found == this->index.end()) return nullptr;
+
+	return &this->groups[found->second]->aggregate;
+}
+
+/**
+ * Method returns amount of directories with audio files
+ *
+ * @return Amount of directories
+ */
+size_t MediaLibCleaner::DirectoryAggregator::GetDirectories()
+{
+	return this->groups.size();
+}
+
+/**
+ * Method returns aggregate of given directory
+ *
+ * @param[in] directory  Index of the directory (less than GetDirectories())
+ *
+ * @return Aggregate of the directory
+ */
+const MediaLibCleaner::DirectoryAggregate* MediaLibCleaner::DirectoryAggregator::GetAggregate(size_t directory)
+{
+	return &this->groups[directory]->aggregate;
+}
+
+/**
+ * Method returns audio files of given directory
+ *
+ * @param[in] directory  Index of the directory (less than GetDirectories())
+ *
+ * @return Audio files of the directory
+ */
+const std::vector<MediaLibCleaner::File*>* MediaLibCleaner::DirectoryAggregator::GetFiles(size_t directory)
+{
+	return &this->groups[directory]->files;
+}
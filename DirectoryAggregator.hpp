@@ -0,0 +1,93 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * File contains declarations of directory aggregator - summary of tags and audio properties of all audio files in each directory (available in lua as dir table)
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MediaLibCleaner.hpp"
+
+namespace MediaLibCleaner
+{
+	/**
+	 * @brief Structure describing all audio files in a single directory
+	 *
+	 * Lists of values are sorted and contain every value once; empty value is listed if at least one file has no such tag.
+	 */
+	struct DirectoryAggregate
+	{
+		std::wstring path; ///< Full path of the directory
+		int files = 0; ///< Amount of audio files in the directory
+		std::vector<std::wstring> albums; ///< Distinct values of album tag
+		std::vector<std::wstring> albumartists; ///< Distinct values of album artist tag
+		std::vector<std::wstring> years; ///< Distinct values of year tag
+		std::vector<std::wstring> codecs; ///< Distinct codecs
+		std::vector<int> samplerates; ///< Distinct sample rates
+		std::vector<int> tracks; ///< Distinct track numbers
+		std::vector<int> track_gaps; ///< Track numbers missing between 1 and the last track (or total amount of tracks if given as "3/12")
+		std::vector<int> track_duplicates; ///< Track numbers used by more than one file
+		int untracked = 0; ///< Amount of audio files without valid track number
+	};
+
+	/**
+	 * @class DirectoryAggregator DirectoryAggregator.hpp
+	 *
+	 * @brief Class MediaLibCleaner::DirectoryAggregator computes MediaLibCleaner::DirectoryAggregate of every directory before files are processed.
+	 *
+	 * Files are grouped by path of their directory when added. Run() goes through files of every directory once;
+	 * each directory is handled by a single thread, so no locking is needed. Aggregates are computed from tags read during scan,
+	 * so they do not change when files are modified by the script.
+	 */
+	class DirectoryAggregator
+	{
+	public:
+		DirectoryAggregator(std::unique_ptr<LogProgram>*, std::unique_ptr<LogAlert>*);
+
+		void AddFile(File*);
+		size_t Run();
+
+		const DirectoryAggregate* Get(File*);
+
+		size_t GetDirectories();
+		const DirectoryAggregate* GetAggregate(size_t directory);
+		const std::vector<File*>* GetFiles(size_t directory);
+
+	protected:
+		/**
+		 * @brief Structure describing files of a single directory added to the aggregator
+		 */
+		struct Group
+		{
+			std::wstring path; ///< Path of the directory
+			std::vector<File*> files; ///< Audio files in the directory
+			DirectoryAggregate aggregate; ///< Result of Run()
+		};
+
+		/**
+		 * All directories added to the aggregator (pointers stay valid when more directories are added)
+		 */
+		std::vector<std::unique_ptr<Group>> groups;
+
+		/**
+		 * Index of directory in groups, by full path of the directory
+		 */
+		std::unordered_map<std::wstring, size_t> index;
+
+		/**
+		 * std::unique_ptr to MediaLibCleaner::LogAlert object for logging purposes
+		 */
+		std::unique_ptr<LogAlert>* logalert;
+
+		/**
+		 * std::unique_ptr to MediaLibCleaner::LogProgram object for logging purposes
+		 */
+		std::unique_ptr<LogProgram>* logprogram;
+	};
+}
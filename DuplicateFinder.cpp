@@ -0,0 +1,794 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * This file contains definitions of duplicate finder: location of audio data in MP3, FLAC, OGG and MP4 files (everything except tags),
+ * XXH64 hash and grouping of files with the same audio data.
+ */
+
+#include "DuplicateFinder.hpp"
+#include "FastTagReader.hpp"
+
+#include <algorithm>
+#include <codecvt>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+#include <boost/filesystem/fstream.hpp>
+
+#include <omp.h>
+
+
+/**
+ * Amount of bytes hashed at the beginning and at the end of audio data before whole audio data is hashed
+ */
+static const unsigned long long PARTIAL_HASH_BYTES = 64 * 1024;
+
+/**
+ * Primes of XXH64 hash
+ */
+static const unsigned long long PRIME64_1 = 0x9E3779B185EBCA87ULL;
+static const unsigned long long PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const unsigned long long PRIME64_3 = 0x165667B19E3779F9ULL;
+static const unsigned long long PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+static const unsigned long long PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+/**
+ * Function reads 32-bit big-endian number
+ *
+ * @param[in] p  Data to read from
+ *
+ * @return Read number
+ */
+static unsigned int readBE32(const unsigned char *p)
+{
+	return (static_cast<unsigned int>(p[0]) << 24) | (static_cast<unsigned int>(p[1]) << 16) | (static_cast<unsigned int>(p[2]) << 8) | static_cast<unsigned int>(p[3]);
+}
+
+/**
+ * Function reads 32-bit little-endian number
+ *
+ * @param[in] p  Data to read from
+ *
+ * @return Read number
+ */
+static unsigned int readLE32(const unsigned char *p)
+{
+	return (static_cast<unsigned int>(p[3]) << 24) | (static_cast<unsigned int>(p[2]) << 16) | (static_cast<unsigned int>(p[1]) << 8) | static_cast<unsigned int>(p[0]);
+}
+
+/**
+ * Function reads 64-bit little-endian number
+ *
+ * @param[in] p  Data to read from
+ *
+ * @return Read number
+ */
+static unsigned long long readLE64(const unsigned char *p)
+{
+	return (static_cast<unsigned long long>(readLE32(p + 4)) << 32) | readLE32(p);
+}
+
+/**
+ * Function reads 64-bit number in byte order of the machine (all supported platforms are little-endian), used by hash
+ *
+ * @param[in] p  Data to read from
+ *
+ * @return Read number
+ */
+static unsigned long long loadLane(const unsigned char *p)
+{
+	unsigned long long value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+/**
+ * Function rotates 64-bit number left
+ *
+ * @param[in] value  Number to rotate
+ * @param[in] bits   Amount of bits to rotate by
+ *
+ * @return Rotated number
+ */
+static unsigned long long rotateLeft(unsigned long long value, int bits)
+{
+	return (value << bits) | (value >> (64 - bits));
+}
+
+/**
+ * Function mixes 8 bytes of input into lane accumulator of XXH64
+ *
+ * @param[in] lane   Lane accumulator
+ * @param[in] input  8 bytes of input
+ *
+ * @return New value of the accumulator
+ */
+static unsigned long long mixLane(unsigned long long lane, unsigned long long input)
+{
+	lane += input * PRIME64_2;
+	lane = rotateLeft(lane, 31);
+	return lane * PRIME64_1;
+}
+
+/**
+ * Function merges lane accumulator into final hash of XXH64
+ *
+ * @param[in] hash  Hash computed so far
+ * @param[in] lane  Lane accumulator
+ *
+ * @return New value of the hash
+ */
+static unsigned long long mergeLane(unsigned long long hash, unsigned long long lane)
+{
+	hash ^= mixLane(0, lane);
+	return hash * PRIME64_1 + PRIME64_4;
+}
+
+
+
+
+/**
+ * MediaLibCleaner::Hash64 constructor
+ *
+ * @param[in] seed  Seed of the hash (hashes with different seeds are different for the same data)
+ */
+MediaLibCleaner::Hash64::Hash64(unsigned long long seed)
+{
+	this->seed = seed;
+	this->lanes[0] = seed + PRIME64_1 + PRIME64_2;
+	this->lanes[1] = seed + PRIME64_2;
+	this->lanes[2] = seed;
+	this->lanes[3] = seed - PRIME64_1;
+}
+
+/**
+ * Method adds data to the hash
+ *
+ * @param[in] data    Data to add
+ * @param[in] length  Length of the data in bytes
+ */
+void MediaLibCleaner::Hash64::Update(const unsigned char *data, size_t length)
+{
+	this->total += length;
+
+	// complete stripe started by previous call
+	if (this->buffered > 0)
+	{
+		size_t part = std::min(length, sizeof(this->buffer) - this->buffered);
+		memcpy(this->buffer + this->buffered, data, part);
+		this->buffered += part;
+		data += part;
+		length -= part;
+
+		if (this->buffered < sizeof(this->buffer)) return;
+
+		for (int i = 0; i < 4; i++)
+			this->lanes[i] = mixLane(this->lanes[i], loadLane(this->buffer + 8 * i));
+		this->buffered = 0;
+	}
+
+	// lanes do not depend on each other
+	unsigned long long lane0 = this->lanes[0], lane1 = this->lanes[1], lane2 = this->lanes[2], lane3 = this->lanes[3];
+
+	for (; length >= 32; data += 32, length -= 32)
+	{
+		lane0 = mixLane(lane0, loadLane(data));
+		lane1 = mixLane(lane1, loadLane(data + 8));
+		lane2 = mixLane(lane2, loadLane(data + 16));
+		lane3 = mixLane(lane3, loadLane(data + 24));
+	}
+
+	this->lanes[0] = lane0;
+	this->lanes[1] = lane1;
+	this->lanes[2] = lane2;
+	this->lanes[3] = lane3;
+
+	if (length > 0)
+	{
+		memcpy(this->buffer, data, length);
+		this->buffered = length;
+	}
+}
+
+/**
+ * Method returns hash of all data added so far (more data may still be added)
+ *
+ * @return 64-bit hash
+ */
+unsigned long long MediaLibCleaner::Hash64::Final()
+{
+	unsigned long long hash;
+
+	if (this->total >= 32)
+	{
+		hash = rotateLeft(this->lanes[0], 1) + rotateLeft(this->lanes[1], 7) + rotateLeft(this->lanes[2], 12) + rotateLeft(this->lanes[3], 18);
+		for (int i = 0; i < 4; i++)
+			hash = mergeLane(hash, this->lanes[i]);
+	}
+	else
+	{
+		hash = this->seed + PRIME64_5;
+	}
+
+	hash += this->total;
+
+	const unsigned char *p = this->buffer;
+	size_t remaining = this->buffered;
+
+	for (; remaining >= 8; p += 8, remaining -= 8)
+	{
+		hash ^= mixLane(0, loadLane(p));
+		hash = rotateLeft(hash, 27) * PRIME64_1 + PRIME64_4;
+	}
+	if (remaining >= 4)
+	{
+		hash ^= static_cast<unsigned long long>(readLE32(p)) * PRIME64_1;
+		hash = rotateLeft(hash, 23) * PRIME64_2 + PRIME64_3;
+		p += 4;
+		remaining -= 4;
+	}
+	for (; remaining > 0; p++, remaining--)
+	{
+		hash ^= *p * PRIME64_5;
+		hash = rotateLeft(hash, 11) * PRIME64_1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= PRIME64_2;
+	hash ^= hash >> 29;
+	hash *= PRIME64_3;
+	hash ^= hash >> 32;
+
+	return hash;
+}
+
+
+
+
+/**
+ * Function returns size of ID3v2 tag at the beginning of the file
+ *
+ * @param[in] data  Beginning of the file
+ * @param[in] size  Size of the file in bytes
+ *
+ * @return Size of the tag with its header and footer (0 if there is no tag)
+ */
+static size_t id3v2Size(const unsigned char *data, size_t size)
+{
+	if (size < 10 || memcmp(data, "ID3", 3) != 0) return 0;
+
+	size_t tag = 10 + ((static_cast<size_t>(data[6] & 0x7F) << 21) | ((data[7] & 0x7F) << 14) | ((data[8] & 0x7F) << 7) | (data[9] & 0x7F));
+	if (data[5] & 0x10) tag += 10;
+
+	return std::min(tag, size);
+}
+
+/**
+ * Function returns end of audio data of MP3 or FLAC file: ID3v1 tag, Lyrics3v2 tag and APEv2 tag at the end of the file are skipped
+ *
+ * @param[in] data   Beginning of the file
+ * @param[in] start  Beginning of audio data
+ * @param[in] end    End of the file
+ *
+ * @return End of audio data
+ */
+static size_t trailingTagsStart(const unsigned char *data, size_t start, size_t end)
+{
+	if (end - start >= 128 && memcmp(data + end - 128, "TAG", 3) == 0)
+		end -= 128;
+
+	// Lyrics3v2: content, 6-digit size of content and "LYRICS200"
+	if (end - start >= 15 && memcmp(data + end - 9, "LYRICS200", 9) == 0)
+	{
+		size_t length = 0;
+		for (size_t i = end - 15; i < end - 9; i++)
+			length = length * 10 + (data[i] >= '0' && data[i] <= '9' ? data[i] - '0' : 0);
+
+		if (length + 15 <= end - start) end -= length + 15;
+	}
+
+	// APEv2: size stored in footer covers items and footer, header is optional
+	if (end - start >= 32 && memcmp(data + end - 32, "APETAGEX", 8) == 0)
+	{
+		unsigned long long length = readLE32(data + end - 32 + 12);
+		if (readLE32(data + end - 32 + 20) & 0x80000000) length += 32;
+
+		if (length <= end - start) end -= static_cast<size_t>(length);
+	}
+
+	return end;
+}
+
+/**
+ * Function adds range to the list of audio data ranges
+ *
+ * @param[in]  offset  Offset of the range
+ * @param[in]  length  Length of the range
+ * @param[out] ranges  List of ranges
+ */
+static void addRange(size_t offset, size_t length, std::vector<MediaLibCleaner::PayloadRange> *ranges)
+{
+	MediaLibCleaner::PayloadRange range = { offset, length };
+	ranges->push_back(range);
+}
+
+/**
+ * Function finds audio data of MP3 file: everything between ID3v2 tag and tags at the end of the file
+ *
+ * @param[in]  data    Beginning of the file
+ * @param[in]  size    Size of the file
+ * @param[out] ranges  Ranges of audio data
+ *
+ * @return True if audio data was found
+ */
+static bool findMPEGPayload(const unsigned char *data, size_t size, std::vector<MediaLibCleaner::PayloadRange> *ranges)
+{
+	size_t start = id3v2Size(data, size);
+	size_t end = trailingTagsStart(data, start, size);
+
+	if (start >= end) return false;
+
+	addRange(start, end - start, ranges);
+	return true;
+}
+
+/**
+ * Function finds audio data of FLAC file: frames after the last metadata block (without ID3 and APE tags)
+ *
+ * @param[in]  data    Beginning of the file
+ * @param[in]  size    Size of the file
+ * @param[out] ranges  Ranges of audio data
+ *
+ * @return True if audio data was found
+ */
+static bool findFLACPayload(const unsigned char *data, size_t size, std::vector<MediaLibCleaner::PayloadRange> *ranges)
+{
+	size_t position = id3v2Size(data, size);
+	if (size - position < 4 || memcmp(data + position, "fLaC", 4) != 0) return false;
+	position += 4;
+
+	for (;;)
+	{
+		if (size - position < 4) return false;
+
+		bool last = (data[position] & 0x80) != 0;
+		size_t length = (static_cast<size_t>(data[position + 1]) << 16) | (static_cast<size_t>(data[position + 2]) << 8) | data[position + 3];
+
+		if (length > size - position - 4) return false;
+		position += 4 + length;
+
+		if (last) break;
+	}
+
+	size_t end = trailingTagsStart(data, position, size);
+	if (position >= end) return false;
+
+	addRange(position, end - position, ranges);
+	return true;
+}
+
+/**
+ * Function finds audio data of OGG file: bodies of all pages after header packets (identification, comment and setup).
+ * Page headers are skipped too - their sequence numbers and checksums change when comment grows by a page.
+ *
+ * @param[in]  data    Beginning of the file
+ * @param[in]  size    Size of the file
+ * @param[out] ranges  Ranges of audio data
+ *
+ * @return True if audio data was found
+ */
+static bool findOggPayload(const unsigned char *data, size_t size, std::vector<MediaLibCleaner::PayloadRange> *ranges)
+{
+	size_t position = 0;
+	bool audio = false;
+
+	while (size - position >= 27)
+	{
+		if (memcmp(data + position, "OggS", 4) != 0) break;
+
+		size_t segments = data[position + 26];
+		if (size - position < 27 + segments) break;
+
+		size_t body = 0;
+		for (size_t i = 0; i < segments; i++)
+			body += data[position + 27 + i];
+
+		size_t body_offset = position + 27 + segments;
+		if (size - body_offset < body) break;
+
+		// header pages have granule position 0 (or -1 if no packet ends on the page); audio always starts on new page
+		unsigned long long granule = readLE64(data + position + 6);
+		if (!audio && granule != 0 && granule != 0xFFFFFFFFFFFFFFFFULL) audio = true;
+
+		if (audio && body > 0) addRange(body_offset, body, ranges);
+
+		position = body_offset + body;
+	}
+
+	return !ranges->empty();
+}
+
+/**
+ * Function finds audio data of MP4 file: contents of all top-level mdat atoms
+ *
+ * @param[in]  data    Beginning of the file
+ * @param[in]  size    Size of the file
+ * @param[out] ranges  Ranges of audio data
+ *
+ * @return True if audio data was found
+ */
+static bool findMP4Payload(const unsigned char *data, size_t size, std::vector<MediaLibCleaner::PayloadRange> *ranges)
+{
+	size_t position = 0;
+
+	while (size - position >= 8)
+	{
+		unsigned long long length = readBE32(data + position);
+		size_t header = 8;
+
+		if (length == 1)
+		{
+			// 64-bit length follows atom name
+			if (size - position < 16) break;
+			length = (static_cast<unsigned long long>(readBE32(data + position + 8)) << 32) | readBE32(data + position + 12);
+			header = 16;
+		}
+		else if (length == 0)
+		{
+			// atom lasts until the end of the file
+			length = size - position;
+		}
+
+		if (length < header || length > size - position) break;
+
+		if (memcmp(data + position + 4, "mdat", 4) == 0 && length > header)
+			addRange(position + header, static_cast<size_t>(length) - header, ranges);
+
+		position += static_cast<size_t>(length);
+	}
+
+	return !ranges->empty();
+}
+
+/**
+ * Function finds parts of the file holding audio data - everything except tags (and, for OGG and MP4, except container structures
+ * which change together with tags). Only headers of tags and containers are read.
+ *
+ * @param[in]  data    Beginning of the file (usually memory-mapped, see MediaLibCleaner::MappedFile)
+ * @param[in]  size    Size of the file in bytes
+ * @param[in]  type    Type of the file
+ * @param[out] ranges  Ranges of audio data, in order
+ *
+ * @return True if audio data was found, false if file type is not supported or file is broken
+ */
+bool MediaLibCleaner::FindAudioPayload(const unsigned char *data, size_t size, FileType type, std::vector<PayloadRange> *ranges)
+{
+	ranges->clear();
+	if (data == nullptr) return false;
+
+	switch (type)
+	{
+	case FILETYPE_MP3:
+		return findMPEGPayload(data, size, ranges);
+	case FILETYPE_FLAC:
+		return findFLACPayload(data, size, ranges);
+	case FILETYPE_OGG:
+		return findOggPayload(data, size, ranges);
+	case FILETYPE_MP4:
+		return findMP4Payload(data, size, ranges);
+	default:
+		return false;
+	}
+}
+
+/**
+ * Function adds part of audio data to the hash
+ *
+ * @param[in]  data    Beginning of the file
+ * @param[in]  ranges  Ranges of audio data
+ * @param[in]  from    Beginning of hashed part (offset within audio data, not within the file)
+ * @param[in]  to      End of hashed part (offset within audio data)
+ * @param[out] hash    Hash to update
+ */
+static void hashPayload(const unsigned char *data, const std::vector<MediaLibCleaner::PayloadRange> &ranges, unsigned long long from, unsigned long long to, MediaLibCleaner::Hash64 *hash)
+{
+	unsigned long long position = 0;
+
+	for (size_t i = 0; i < ranges.size() && position < to; i++)
+	{
+		unsigned long long begin = std::max(from, position);
+		unsigned long long end = std::min(to, position + ranges[i].length);
+
+		if (begin < end)
+			hash->Update(data + ranges[i].offset + (begin - position), static_cast<size_t>(end - begin));
+
+		position += ranges[i].length;
+	}
+}
+
+/**
+ * Function splits groups of entries into smaller groups of entries with equal key; groups of single entry are dropped
+ *
+ * @param[in] groups  Groups of entries (indexes)
+ * @param[in] key     Function returning key of the entry
+ *
+ * @return New groups
+ */
+template <class Key>
+static std::vector<std::vector<size_t>> splitGroups(const std::vector<std::vector<size_t>> &groups, Key key)
+{
+	std::vector<std::vector<size_t>> result;
+
+	for (size_t g = 0; g < groups.size(); g++)
+	{
+		std::vector<size_t> sorted = groups[g];
+		std::sort(sorted.begin(), sorted.end(), [&key](size_t a, size_t b) { return key(a) < key(b); });
+
+		size_t first = 0;
+		for (size_t i = 1; i <= sorted.size(); i++)
+		{
+			if (i < sorted.size() && key(sorted[i]) == key(sorted[first])) continue;
+
+			if (i - first > 1) result.push_back(std::vector<size_t>(sorted.begin() + first, sorted.begin() + i));
+			first = i;
+		}
+	}
+
+	return result;
+}
+
+
+
+
+/**
+ * MediaLibCleaner::DuplicateFinder constructor
+ *
+ * @param[in] logprogram  std::unique_ptr to MediaLibCleaner::LogProgram object for logging purposses
+ * @param[in] logalert    std::unique_ptr to MediaLibCleaner::LogAlert object for logging purposses
+ */
+MediaLibCleaner::DuplicateFinder::DuplicateFinder(std::unique_ptr<MediaLibCleaner::LogProgram>* logprogram, std::unique_ptr<MediaLibCleaner::LogAlert>* logalert)
+{
+	this->logprogram = logprogram;
+	this->logalert = logalert;
+}
+
+/**
+ * Method adds file to be compared (files which are not audio files are ignored)
+ *
+ * @param[in] file  File to compare
+ */
+void MediaLibCleaner::DuplicateFinder::AddFile(MediaLibCleaner::File *file)
+{
+	if (file->IsInitiated()) this->files.push_back(file);
+}
+
+/**
+ * Method hashes audio data of the entry: its beginning and end (partial hash) or all of it (full hash).
+ * If audio data is short enough, partial hash covers all of it and full hash is not needed.
+ *
+ * @param[in]  entry  Entry to hash
+ * @param[in]  full   True for full hash, false for partial hash
+ * @param[out] bytes  Amount of bytes of audio data hashed
+ *
+ * @return True if file was hashed, false if it cannot be read or changed since audio data was found
+ */
+bool MediaLibCleaner::DuplicateFinder::hashEntry(Entry *entry, bool full, unsigned long long *bytes)
+{
+	*bytes = 0;
+
+	MappedFile mapped;
+	if (!mapped.Open(entry->file->GetPath())) return false;
+
+	const PayloadRange &last = entry->ranges.back();
+	if (last.offset + last.length > mapped.GetSize()) return false;
+
+	// length as seed - hashes of audio data of different length never match
+	Hash64 hash(entry->length);
+
+	if (full)
+	{
+		hashPayload(mapped.GetData(), entry->ranges, 0, entry->length, &hash);
+		entry->full = hash.Final();
+		*bytes = entry->length;
+	}
+	else if (entry->length <= 2 * PARTIAL_HASH_BYTES)
+	{
+		hashPayload(mapped.GetData(), entry->ranges, 0, entry->length, &hash);
+		entry->partial = entry->full = hash.Final();
+		entry->complete = true;
+		*bytes = entry->length;
+	}
+	else
+	{
+		hashPayload(mapped.GetData(), entry->ranges, 0, PARTIAL_HASH_BYTES, &hash);
+		hashPayload(mapped.GetData(), entry->ranges, entry->length - PARTIAL_HASH_BYTES, entry->length, &hash);
+		entry->partial = hash.Final();
+		*bytes = 2 * PARTIAL_HASH_BYTES;
+	}
+
+	return true;
+}
+
+/**
+ * Method finds all groups of files with the same audio data and sets number of the group in every file of the group.
+ * All steps run on all threads (OpenMP); files are memory-mapped, so only the parts actually hashed are read from disk.
+ *
+ * @return Amount of groups found
+ */
+size_t MediaLibCleaner::DuplicateFinder::Run()
+{
+	this->entries.clear();
+	this->groups.clear();
+	this->fully_hashed = 0;
+	this->bytes_hashed = 0;
+
+	// 1. location of audio data - only tag and container headers are read
+	int count = static_cast<int>(this->files.size());
+	std::vector<Entry> found(this->files.size());
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int i = 0; i < count; i++)
+	{
+		Entry &entry = found[i];
+		entry.file = this->files[i];
+
+		MappedFile mapped;
+		if (!mapped.Open(entry.file->GetPath()) || !FindAudioPayload(mapped.GetData(), mapped.GetSize(), entry.file->GetFileType(), &entry.ranges))
+		{
+			(*this->logprogram)->Log(L"MediaLibCleaner::DuplicateFinder(" + entry.file->GetPath() + L")", L"Audio data not found, file is not compared", 2);
+			continue;
+		}
+
+		for (size_t r = 0; r < entry.ranges.size(); r++)
+			entry.length += entry.ranges[r].length;
+	}
+
+	for (size_t i = 0; i < found.size(); i++)
+	{
+		if (found[i].length > 0) this->entries.push_back(found[i]);
+	}
+
+	std::vector<std::vector<size_t>> all(1);
+	for (size_t i = 0; i < this->entries.size(); i++) all[0].push_back(i);
+
+	// 2. files with unique length of audio data cannot have duplicates - nothing more is read from them
+	this->groups = splitGroups(all, [this](size_t i) { return this->entries[i].length; });
+
+	// 3. partial hash, 4. full hash (only files still having a match)
+	for (int step = 0; step < 2; step++)
+	{
+		bool full = (step == 1);
+
+		std::vector<size_t> pending;
+		for (size_t g = 0; g < this->groups.size(); g++)
+		{
+			for (size_t i = 0; i < this->groups[g].size(); i++)
+			{
+				if (!full || !this->entries[this->groups[g][i]].complete) pending.push_back(this->groups[g][i]);
+			}
+		}
+
+		std::vector<char> failed(this->entries.size(), 0);
+		unsigned long long bytes = 0;
+		int pending_count = static_cast<int>(pending.size());
+
+		#pragma omp parallel for schedule(dynamic) reduction(+:bytes)
+		for (int i = 0; i < pending_count; i++)
+		{
+			unsigned long long read = 0;
+			if (!this->hashEntry(&this->entries[pending[i]], full, &read))
+			{
+				(*this->logprogram)->Log(L"MediaLibCleaner::DuplicateFinder(" + this->entries[pending[i]].file->GetPath() + L")", L"File could not be hashed, it is not compared", 2);
+				failed[pending[i]] = 1;
+			}
+			bytes += read;
+		}
+
+		this->bytes_hashed += bytes;
+		if (full) this->fully_hashed = pending.size();
+
+		for (size_t g = 0; g < this->groups.size(); g++)
+		{
+			std::vector<size_t> &group = this->groups[g];
+			group.erase(std::remove_if(group.begin(), group.end(), [&failed](size_t i) { return failed[i] != 0; }), group.end());
+		}
+
+		if (full)
+			this->groups = splitGroups(this->groups, [this](size_t i) { return this->entries[i].full; });
+		else
+			this->groups = splitGroups(this->groups, [this](size_t i) { return this->entries[i].partial; });
+	}
+
+	// numbers of groups do not depend on order of scan: files sorted by path, groups by their first file
+	for (size_t g = 0; g < this->groups.size(); g++)
+	{
+		std::sort(this->groups[g].begin(), this->groups[g].end(), [this](size_t a, size_t b) { return this->entries[a].file->GetPath() < this->entries[b].file->GetPath(); });
+	}
+	std::sort(this->groups.begin(), this->groups.end(), [this](const std::vector<size_t> &a, const std::vector<size_t> &b) { return this->entries[a[0]].file->GetPath() < this->entries[b[0]].file->GetPath(); });
+
+	for (size_t g = 0; g < this->groups.size(); g++)
+	{
+		for (size_t i = 0; i < this->groups[g].size(); i++)
+			this->entries[this->groups[g][i]].file->SetDuplicateGroup(static_cast<int>(g + 1));
+	}
+
+	(*this->logprogram)->Log(L"MediaLibCleaner::DuplicateFinder", L"Compared " + std::to_wstring(this->entries.size()) + L" files, " + std::to_wstring(this->fully_hashed) + L" hashed completely, " + std::to_wstring(this->groups.size()) + L" groups of duplicates found", 3);
+
+	return this->groups.size();
+}
+
+/**
+ * Method writes report of all groups of duplicates found by Run()
+ *
+ * @param[in] path  Path to the report file ("-" for standard output)
+ *
+ * @return True if report was written
+ */
+bool MediaLibCleaner::DuplicateFinder::WriteReport(const std::wstring &path)
+{
+	boost::filesystem::wofstream file;
+	std::wostream *output = &std::wcout;
+
+	if (path != L"-")
+	{
+		file.open(boost::filesystem::path(path));
+		if (!file.is_open())
+		{
+			(*this->logprogram)->Log(L"MediaLibCleaner::DuplicateFinder", L"Report file could not be opened: " + path, 1);
+			return false;
+		}
+
+		file.imbue(std::locale(std::locale::classic(), new std::codecvt_utf8<wchar_t>));
+		output = &file;
+	}
+
+	*output << L"Groups of duplicates: " << this->groups.size() << std::endl;
+
+	for (size_t g = 0; g < this->groups.size(); g++)
+	{
+		const Entry &first = this->entries[this->groups[g][0]];
+
+		std::wstringstream hash;
+		hash << std::hex << std::setw(16) << std::setfill(L'0') << first.full;
+
+		*output << std::endl << L"Group " << (g + 1) << L": " << this->groups[g].size() << L" files, " << first.length << L" bytes of audio data, hash " << hash.str() << std::endl;
+
+		for (size_t i = 0; i < this->groups[g].size(); i++)
+			*output << L"\t" << this->entries[this->groups[g][i]].file->GetPath() << std::endl;
+	}
+
+	return output->good();
+}
+
+/**
+ * Method returns amount of files compared by the last Run() (audio files with audio data found)
+ *
+ * @return Amount of files
+ */
+size_t MediaLibCleaner::DuplicateFinder::GetCandidates()
+{
+	return this->entries.size();
+}
+
+/**
+ * Method returns amount of files hashed completely by the last Run() (all other files were told apart by length or partial hash)
+ *
+ * @return Amount of files
+ */
+size_t MediaLibCleaner::DuplicateFinder::GetFullyHashed()
+{
+	return this->fully_hashed;
+}
+
+/**
+ * Method returns amount of bytes of audio data read by hashes in the last Run()
+ *
+ * @return Amount of bytes
+ */
+unsigned long long MediaLibCleaner::DuplicateFinder::GetBytesHashed()
+{
+	return this->bytes_hashed;
+}
@@ -0,0 +1,142 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * File contains declarations of duplicate finder - detection of the same recording stored in multiple files, by hash of audio data only (tags are skipped)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "MediaLibCleaner.hpp"
+
+namespace MediaLibCleaner
+{
+	/**
+	 * @brief Structure describing part of the file holding audio data
+	 */
+	struct PayloadRange
+	{
+		unsigned long long offset; ///< Offset of the part from the beginning of the file
+		unsigned long long length; ///< Length of the part in bytes
+	};
+
+	/**
+	 * @class Hash64 DuplicateFinder.hpp
+	 *
+	 * @brief Class MediaLibCleaner::Hash64 computes 64-bit XXH64 hash of data given in any amount of parts.
+	 * Data is processed in four independent lanes of 8 bytes, so it runs at memory speed.
+	 */
+	class Hash64
+	{
+	public:
+		Hash64(unsigned long long seed = 0);
+
+		void Update(const unsigned char *data, size_t length);
+		unsigned long long Final();
+
+	protected:
+		/**
+		 * Seed of the hash
+		 */
+		unsigned long long seed;
+
+		/**
+		 * Accumulators of four lanes
+		 */
+		unsigned long long lanes[4];
+
+		/**
+		 * Data not processed yet (less than one stripe of 32 bytes)
+		 */
+		unsigned char buffer[32];
+
+		/**
+		 * Amount of bytes in buffer
+		 */
+		size_t buffered = 0;
+
+		/**
+		 * Amount of all bytes given to the hash
+		 */
+		unsigned long long total = 0;
+	};
+
+	bool FindAudioPayload(const unsigned char *data, size_t size, FileType type, std::vector<PayloadRange> *ranges);
+
+	/**
+	 * @class DuplicateFinder DuplicateFinder.hpp
+	 *
+	 * @brief Class MediaLibCleaner::DuplicateFinder finds audio files holding the same audio data (regardless of tags, file names and covers).
+	 *
+	 * Files are compared in three steps, each one reading more data, but only of files still having a match:
+	 * length of audio data (no data read), hash of the beginning and the end of audio data and hash of all audio data.
+	 * Every group of files with the same audio data gets its number (see MediaLibCleaner::File::GetDuplicateGroup()).
+	 */
+	class DuplicateFinder
+	{
+	public:
+		DuplicateFinder(std::unique_ptr<LogProgram>*, std::unique_ptr<LogAlert>*);
+
+		void AddFile(File*);
+		size_t Run();
+		bool WriteReport(const std::wstring &path);
+
+		size_t GetCandidates();
+		size_t GetFullyHashed();
+		unsigned long long GetBytesHashed();
+
+	protected:
+		/**
+		 * @brief Structure describing single file compared by MediaLibCleaner::DuplicateFinder
+		 */
+		struct Entry
+		{
+			File *file; ///< Compared file
+			std::vector<PayloadRange> ranges; ///< Parts of the file holding audio data
+			unsigned long long length = 0; ///< Length of audio data (sum of lengths of all ranges)
+			unsigned long long partial = 0; ///< Hash of the beginning and the end of audio data
+			unsigned long long full = 0; ///< Hash of all audio data
+			bool complete = false; ///< True if partial hash already covers all audio data
+		};
+
+		/**
+		 * All audio files added to the finder
+		 */
+		std::vector<File*> files;
+
+		/**
+		 * Files with known audio data
+		 */
+		std::vector<Entry> entries;
+
+		/**
+		 * Groups of duplicates (indexes of entries, sorted by path)
+		 */
+		std::vector<std::vector<size_t>> groups;
+
+		/**
+		 * Amount of files which had to be hashed completely
+		 */
+		size_t fully_hashed = 0;
+
+		/**
+		 * Amount of bytes of audio data read by all hashes
+		 */
+		unsigned long long bytes_hashed = 0;
+
+		/**
+		 * std::unique_ptr to MediaLibCleaner::LogAlert object for logging purposes
+		 */
+		std::unique_ptr<LogAlert>* logalert;
+
+		/**
+		 * std::unique_ptr to MediaLibCleaner::LogProgram object for logging purposes
+		 */
+		std::unique_ptr<LogProgram>* logprogram;
+
+		bool hashEntry(Entry *entry, bool full, unsigned long long *bytes);
+	};
+}
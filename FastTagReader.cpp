@@ -0,0 +1,2379 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * This file contains definitions of read-only tag parser used during scan: ID3v1, ID3v2.3/2.4 and APEv2 tags of MP3 files,
+ * FLAC metadata blocks (STREAMINFO, VORBIS_COMMENT, PICTURE) and ilst atom of MP4/M4A files.
+ * Embedded covers are never copied - only their headers and the header of the image itself (dimensions) are read.
+ *
+ * Parser gives the same values TagLib gives for the same file, but it does not create any TagLib objects - all data is read
+ * straight from memory-mapped file and only tag values are copied. Whenever file contains anything parser does not fully
+ * understand (unsynchronised or compressed ID3v2 frames, invalid UTF-8 in APEv2 items, truncated atoms, ...) it gives up
+ * and the file is read by TagLib.
+ */
+
+#include "FastTagReader.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <cwchar>
+#include <map>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+/**
+ * Part of the mapped file (data is not copied)
+ */
+struct ByteRange
+{
+	const unsigned char *data;
+	size_t size;
+};
+
+/**
+ * Values of basic tags read from single tag (ID3v2, ID3v1 or XiphComment), before they are merged the same way TagLib::TagUnion does
+ */
+struct BasicTags
+{
+	std::wstring title;
+	std::wstring artist;
+	std::wstring album;
+	std::wstring comment;
+	std::wstring genre;
+	unsigned int year = 0;
+	unsigned int track = 0;
+};
+
+/**
+ * Fields of XiphComment: upper-case field name => all values of the field
+ */
+typedef std::map<std::string, std::vector<std::wstring>> XiphFields;
+
+/**
+ * Function creates range of bytes
+ *
+ * @param[in] data  Beginning of the range
+ * @param[in] size  Size of the range in bytes
+ *
+ * @return Range of bytes
+ */
+static ByteRange makeRange(const unsigned char *data, size_t size)
+{
+	ByteRange range = { data, size };
+	return range;
+}
+
+/**
+ * Function reads 16-bit big-endian number
+ *
+ * @param[in] p  Data to read from
+ *
+ * @return Read number
+ */
+static unsigned int readBE16(const unsigned char *p)
+{
+	return (static_cast<unsigned int>(p[0]) << 8) | static_cast<unsigned int>(p[1]);
+}
+
+/**
+ * Function reads 24-bit big-endian number
+ *
+ * @param[in] p  Data to read from
+ *
+ * @return Read number
+ */
+static unsigned int readBE24(const unsigned char *p)
+{
+	return (static_cast<unsigned int>(p[0]) << 16) | (static_cast<unsigned int>(p[1]) << 8) | static_cast<unsigned int>(p[2]);
+}
+
+/**
+ * Function reads 32-bit big-endian number
+ *
+ * @param[in] p  Data to read from
+ *
+ * @return Read number
+ */
+static unsigned int readBE32(const unsigned char *p)
+{
+	return (static_cast<unsigned int>(p[0]) << 24) | (static_cast<unsigned int>(p[1]) << 16) | (static_cast<unsigned int>(p[2]) << 8) | static_cast<unsigned int>(p[3]);
+}
+
+/**
+ * Function reads 64-bit big-endian number
+ *
+ * @param[in] p  Data to read from
+ *
+ * @return Read number
+ */
+static unsigned long long readBE64(const unsigned char *p)
+{
+	return (static_cast<unsigned long long>(readBE32(p)) << 32) | readBE32(p + 4);
+}
+
+/**
+ * Function reads 16-bit little-endian number
+ *
+ * @param[in] p  Data to read from
+ *
+ * @return Read number
+ */
+static unsigned int readLE16(const unsigned char *p)
+{
+	return (static_cast<unsigned int>(p[1]) << 8) | static_cast<unsigned int>(p[0]);
+}
+
+/**
+ * Function reads 32-bit little-endian number
+ *
+ * @param[in] p  Data to read from
+ *
+ * @return Read number
+ */
+static unsigned int readLE32(const unsigned char *p)
+{
+	return (static_cast<unsigned int>(p[3]) << 24) | (static_cast<unsigned int>(p[2]) << 16) | (static_cast<unsigned int>(p[1]) << 8) | static_cast<unsigned int>(p[0]);
+}
+
+/**
+ * Function reads 28-bit synchsafe integer used by ID3v2
+ *
+ * @param[in] p  Data to read from
+ *
+ * @return Read number
+ */
+static unsigned int readSyncSafe(const unsigned char *p)
+{
+	return (static_cast<unsigned int>(p[0]) << 21) | (static_cast<unsigned int>(p[1]) << 14) | (static_cast<unsigned int>(p[2]) << 7) | static_cast<unsigned int>(p[3]);
+}
+
+/**
+ * Function searches for byte pattern, checking only offsets aligned to given step (the same as TagLib::ByteVector::find())
+ *
+ * @param[in] range    Data to search in
+ * @param[in] from     Offset search begins at
+ * @param[in] pattern  Pattern to search for
+ * @param[in] length   Length of the pattern
+ * @param[in] align    Step between checked offsets
+ *
+ * @return Offset of the pattern or -1 if it was not found
+ */
+static long long findBytes(ByteRange range, size_t from, const char *pattern, size_t length, size_t align)
+{
+	for (size_t i = from; i + length <= range.size; i += align)
+	{
+		if (memcmp(range.data + i, pattern, length) == 0) return static_cast<long long>(i);
+	}
+
+	return -1;
+}
+
+/**
+ * Function splits data on delimiter (the same as TagLib::ByteVectorList::split())
+ *
+ * @param[in] range      Data to split
+ * @param[in] delimiter  Delimiter
+ * @param[in] length     Length of the delimiter
+ * @param[in] align      Step between offsets checked for delimiter
+ * @param[in] max        Maximum amount of pieces (0 - unlimited); last piece holds rest of the data
+ *
+ * @return Pieces of the data
+ */
+static std::vector<ByteRange> splitBytes(ByteRange range, const char *delimiter, size_t length, size_t align, size_t max)
+{
+	std::vector<ByteRange> pieces;
+	size_t previous = 0;
+
+	for (long long offset = findBytes(range, 0, delimiter, length, align); offset >= 0 && (max == 0 || max > pieces.size() + 1); offset = findBytes(range, static_cast<size_t>(offset) + length, delimiter, length, align))
+	{
+		pieces.push_back(makeRange(range.data + previous, static_cast<size_t>(offset) - previous));
+		previous = static_cast<size_t>(offset) + length;
+	}
+
+	if (previous < range.size)
+		pieces.push_back(makeRange(range.data + previous, range.size - previous));
+
+	return pieces;
+}
+
+/**
+ * Function cuts string at first null character (TagLib::String does the same with every decoded string)
+ *
+ * @param[in,out] value  String to cut
+ */
+static void cutAtNull(std::wstring *value)
+{
+	size_t end = value->find(L'\0');
+	if (end != std::wstring::npos) value->resize(end);
+}
+
+/**
+ * Function appends Unicode code point to the string as UTF-16 code units (the same way TagLib::String stores text)
+ *
+ * @param[in,out] value  String to append to
+ * @param[in]     code   Code point
+ */
+static void appendCodePoint(std::wstring *value, unsigned int code)
+{
+	if (code > 0xFFFF)
+	{
+		code -= 0x10000;
+		value->push_back(static_cast<wchar_t>(0xD800 + (code >> 10)));
+		value->push_back(static_cast<wchar_t>(0xDC00 + (code & 0x3FF)));
+	}
+	else
+	{
+		value->push_back(static_cast<wchar_t>(code));
+	}
+}
+
+/**
+ * Function decodes ISO-8859-1 text, cut at first null character
+ *
+ * @param[in] range  Encoded text
+ *
+ * @return Decoded text
+ */
+static std::wstring decodeLatin1(ByteRange range)
+{
+	std::wstring value(range.data, range.data + range.size);
+	cutAtNull(&value);
+
+	return value;
+}
+
+/**
+ * Function decodes UTF-8 text
+ *
+ * @param[in]  range  Encoded text
+ * @param[out] value  Decoded text
+ *
+ * @return True if text was decoded, false if it is not valid UTF-8
+ */
+static bool decodeUTF8(ByteRange range, std::wstring *value)
+{
+	value->clear();
+	value->reserve(range.size);
+
+	size_t i = 0;
+	while (i < range.size)
+	{
+		unsigned int byte = range.data[i];
+		unsigned int code;
+		size_t length;
+
+		if (byte < 0x80) { code = byte; length = 1; }
+		else if ((byte & 0xE0) == 0xC0) { code = byte & 0x1F; length = 2; }
+		else if ((byte & 0xF0) == 0xE0) { code = byte & 0x0F; length = 3; }
+		else if ((byte & 0xF8) == 0xF0) { code = byte & 0x07; length = 4; }
+		else return false;
+
+		if (i + length > range.size) return false;
+
+		for (size_t j = 1; j < length; j++)
+		{
+			if ((range.data[i + j] & 0xC0) != 0x80) return false;
+			code = (code << 6) | (range.data[i + j] & 0x3F);
+		}
+
+		if ((length == 2 && code < 0x80) || (length == 3 && code < 0x800) || (length == 4 && code < 0x10000) || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF))
+			return false;
+
+		appendCodePoint(value, code);
+		i += length;
+	}
+
+	cutAtNull(value);
+	return true;
+}
+
+/**
+ * Function decodes UTF-16 text
+ *
+ * @param[in]  range       Encoded text
+ * @param[in]  big_endian  True for UTF-16BE text without BOM, false for UTF-16 text starting with BOM
+ * @param[out] value       Decoded text
+ *
+ * @return True if text was decoded, false if BOM is missing
+ */
+static bool decodeUTF16(ByteRange range, bool big_endian, std::wstring *value)
+{
+	value->clear();
+
+	size_t i = 0;
+	if (!big_endian)
+	{
+		if (range.size < 2) return false;
+
+		if (range.data[0] == 0xFE && range.data[1] == 0xFF) big_endian = true;
+		else if (range.data[0] != 0xFF || range.data[1] != 0xFE) return false;
+
+		i = 2;
+	}
+
+	value->reserve(range.size / 2);
+	for (; i + 1 < range.size; i += 2)
+	{
+		unsigned int unit = big_endian ? readBE16(range.data + i) : (static_cast<unsigned int>(range.data[i + 1]) << 8) | range.data[i];
+		value->push_back(static_cast<wchar_t>(unit));
+	}
+
+	cutAtNull(value);
+	return true;
+}
+
+/**
+ * Function decodes ID3v2 text in given encoding
+ *
+ * @param[in]  range     Encoded text
+ * @param[in]  encoding  ID3v2 text encoding (0 - Latin-1, 1 - UTF-16 with BOM, 2 - UTF-16BE, 3 - UTF-8)
+ * @param[out] value     Decoded text
+ *
+ * @return True if text was decoded, false otherwise
+ */
+static bool decodeID3v2String(ByteRange range, unsigned char encoding, std::wstring *value)
+{
+	value->clear();
+	if (range.size == 0) return true;
+
+	switch (encoding)
+	{
+	case 0:
+		*value = decodeLatin1(range);
+		return true;
+	case 1:
+	case 2:
+		return decodeUTF16(range, encoding == 2, value);
+	case 3:
+		return decodeUTF8(range, value);
+	default:
+		return false;
+	}
+}
+
+/**
+ * Function joins list of values with given separator (the same as TagLib::StringList::toString())
+ *
+ * @param[in] values     Values to join
+ * @param[in] separator  Separator put between values
+ *
+ * @return Joined values
+ */
+static std::wstring joinStrings(const std::vector<std::wstring> &values, const wchar_t *separator)
+{
+	std::wstring joined;
+
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		if (i > 0) joined += separator;
+		joined += values[i];
+	}
+
+	return joined;
+}
+
+/**
+ * Function converts text to integer (the same as TagLib::String::toInt())
+ *
+ * @param[in]  value  Text to convert
+ * @param[out] ok     Set to true if whole text was a number (may be nullptr)
+ *
+ * @return Converted number
+ */
+static int toInt(const std::wstring &value, bool *ok = nullptr)
+{
+	const wchar_t *begin = value.c_str();
+	wchar_t *end = nullptr;
+
+	errno = 0;
+	long number = wcstol(begin, &end, 10);
+
+	if (ok != nullptr) *ok = (errno == 0 && end > begin && *end == L'\0');
+
+	return static_cast<int>(number);
+}
+
+/**
+ * Function removes white space from both ends of text (the same as TagLib::String::stripWhiteSpace())
+ *
+ * @param[in] value  Text to strip
+ *
+ * @return Stripped text
+ */
+static std::wstring stripWhiteSpace(const std::wstring &value)
+{
+	size_t first = value.find_first_not_of(L"\t\n\f\r ");
+	if (first == std::wstring::npos) return L"";
+
+	size_t last = value.find_last_not_of(L"\t\n\f\r ");
+	return value.substr(first, last - first + 1);
+}
+
+/**
+ * Function converts ID3v1 genre number into its name
+ *
+ * @param[in] number  Genre number
+ *
+ * @return Genre name or empty string if number is unknown
+ */
+static std::wstring genreName(int number)
+{
+	return TagLib::ID3v1::genre(number).toWString();
+}
+
+/**
+ * Function merges basic tags the same way TagLib::TagUnion does (first non-empty value wins) and stores them
+ *
+ * @param[in]  basic  Tags in order of priority
+ * @param[in]  count  Amount of tags
+ * @param[out] tags   Values read from the file
+ */
+static void storeBasicTags(const BasicTags *const *basic, int count, MediaLibCleaner::FastTags *tags)
+{
+	BasicTags merged;
+
+	for (int i = count - 1; i >= 0; i--)
+	{
+		if (!basic[i]->title.empty()) merged.title = basic[i]->title;
+		if (!basic[i]->artist.empty()) merged.artist = basic[i]->artist;
+		if (!basic[i]->album.empty()) merged.album = basic[i]->album;
+		if (!basic[i]->comment.empty()) merged.comment = basic[i]->comment;
+		if (!basic[i]->genre.empty()) merged.genre = basic[i]->genre;
+		if (basic[i]->year != 0) merged.year = basic[i]->year;
+		if (basic[i]->track != 0) merged.track = basic[i]->track;
+	}
+
+	tags->tags[MediaLibCleaner::COLUMN_TITLE] = merged.title;
+	tags->tags[MediaLibCleaner::COLUMN_ARTIST] = merged.artist;
+	tags->tags[MediaLibCleaner::COLUMN_ALBUM] = merged.album;
+	tags->tags[MediaLibCleaner::COLUMN_COMMENT] = merged.comment;
+	tags->tags[MediaLibCleaner::COLUMN_GENRE] = merged.genre;
+	tags->tags[MediaLibCleaner::COLUMN_YEAR] = std::to_wstring(merged.year);
+	tags->tags[MediaLibCleaner::COLUMN_TRACK] = std::to_wstring(merged.track);
+}
+
+
+
+
+/**
+ * MediaLibCleaner::MappedFile constructor
+ */
+MediaLibCleaner::MappedFile::MappedFile()
+{
+}
+
+/**
+ * MediaLibCleaner::MappedFile destructor (unmaps the file)
+ */
+MediaLibCleaner::MappedFile::~MappedFile()
+{
+	this->Close();
+}
+
+/**
+ * Method maps whole file into memory (read-only)
+ *
+ * @param[in] path  Full path to the file
+ *
+ * @return True if file was mapped, false otherwise (also for empty files)
+ */
+bool MediaLibCleaner::MappedFile::Open(const std::wstring &path)
+{
+	this->Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0 || static_cast<unsigned long long>(size.QuadPart) > static_cast<size_t>(-1))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == nullptr)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	this->file = file;
+	this->mapping = mapping;
+	this->data = static_cast<const unsigned char*>(view);
+	this->size = static_cast<size_t>(size.QuadPart);
+#else
+	int descriptor = open(boost::filesystem::path(path).string().c_str(), O_RDONLY);
+	if (descriptor < 0) return false;
+
+	struct stat attrib;
+	if (fstat(descriptor, &attrib) != 0 || attrib.st_size <= 0)
+	{
+		close(descriptor);
+		return false;
+	}
+
+	void *view = mmap(nullptr, static_cast<size_t>(attrib.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+	// mapping stays valid after the descriptor is closed
+	close(descriptor);
+
+	if (view == MAP_FAILED) return false;
+
+	this->data = static_cast<const unsigned char*>(view);
+	this->size = static_cast<size_t>(attrib.st_size);
+#endif
+
+	return true;
+}
+
+/**
+ * Method unmaps the file. Does nothing if file is not mapped.
+ */
+void MediaLibCleaner::MappedFile::Close()
+{
+#ifdef _WIN32
+	if (this->data != nullptr) UnmapViewOfFile(this->data);
+	if (this->mapping != nullptr) CloseHandle(this->mapping);
+	if (this->file != nullptr) CloseHandle(this->file);
+
+	this->mapping = nullptr;
+	this->file = nullptr;
+#else
+	if (this->data != nullptr) munmap(const_cast<unsigned char*>(this->data), this->size);
+#endif
+
+	this->data = nullptr;
+	this->size = 0;
+}
+
+/**
+ * Method returns beginning of mapped file
+ *
+ * @return Pointer to the first byte of the file or nullptr if file is not mapped
+ */
+const unsigned char* MediaLibCleaner::MappedFile::GetData()
+{
+	return this->data;
+}
+
+/**
+ * Method returns size of mapped file
+ *
+ * @return Size of the file in bytes
+ */
+size_t MediaLibCleaner::MappedFile::GetSize()
+{
+	return this->size;
+}
+
+
+
+
+/**
+ * Function checks if 4 bytes at given offset are valid ID3v2.3/2.4 frame ID (upper-case letters and digits)
+ */
+static bool isValidFrameID(ByteRange frames, size_t offset)
+{
+	if (offset > frames.size || frames.size - offset < 4) return false;
+
+	for (size_t i = offset; i < offset + 4; i++)
+	{
+		unsigned char c = frames.data[i];
+		if (!((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9'))) return false;
+	}
+
+	return true;
+}
+
+/**
+ * Function reads size of ID3v2 frame
+ *
+ * @param[in] frames    All frames of the tag
+ * @param[in] position  Offset of frame header
+ * @param[in] version   Major version of the tag
+ *
+ * @return Size of frame data (without header)
+ */
+static size_t readFrameSize(ByteRange frames, size_t position, unsigned int version)
+{
+	const unsigned char *p = frames.data + position + 4;
+	if (version < 4) return readBE32(p);
+
+	// TagLib reads sizes which are not syncsafe as plain integers
+	size_t size = ((p[0] | p[1] | p[2] | p[3]) & 0x80) ? readBE32(p) : readSyncSafe(p);
+
+	// iTunes writes ID3v2.4 tags with ID3v2.3-like frame sizes (the same workaround as in TagLib)
+	if (size > 127 && (size > frames.size || !isValidFrameID(frames, position + size + 10)))
+	{
+		size_t plain = readBE32(p);
+		if (plain <= frames.size && isValidFrameID(frames, position + plain + 10)) size = plain;
+	}
+
+	return size;
+}
+
+/**
+ * Function reads all text fields of ID3v2 text frame (TagLib::ID3v2::TextIdentificationFrame)
+ *
+ * @param[in]  body    Frame data
+ * @param[out] fields  Fields of the frame
+ *
+ * @return True if frame was read, false if it uses unknown encoding or text can not be decoded
+ */
+static bool readTextFields(ByteRange body, std::vector<std::wstring> *fields)
+{
+	fields->clear();
+	if (body.size < 2) return true;
+
+	unsigned char encoding = body.data[0];
+	if (encoding > 3) return false;
+
+	size_t align = (encoding == 1 || encoding == 2) ? 2 : 1;
+
+	// trailing nulls are dropped
+	size_t length = body.size - 1;
+	while (length > 0 && body.data[length] == 0) length--;
+	while (length % align != 0) length++;
+	if (length > body.size - 1) length = body.size - 1;
+
+	std::vector<ByteRange> pieces = splitBytes(makeRange(body.data + 1, length), "\0\0", align, align, 0);
+	for (size_t i = 0; i < pieces.size(); i++)
+	{
+		if (pieces[i].size == 0) continue;
+
+		std::wstring value;
+		if (!decodeID3v2String(pieces[i], encoding, &value)) return false;
+		fields->push_back(value);
+	}
+
+	return true;
+}
+
+/**
+ * Function reads description and text of ID3v2 COMM or USLT frame
+ *
+ * @param[in]  body         Frame data
+ * @param[out] description  Description of the frame
+ * @param[out] text         Text of the frame
+ *
+ * @return True if frame was read, false if it uses unknown encoding or text can not be decoded
+ */
+static bool readCommentFrame(ByteRange body, std::wstring *description, std::wstring *text)
+{
+	description->clear();
+	text->clear();
+	if (body.size < 5) return true;
+
+	unsigned char encoding = body.data[0];
+	if (encoding > 3) return false;
+
+	size_t align = (encoding == 1 || encoding == 2) ? 2 : 1;
+
+	// encoding and language are skipped
+	std::vector<ByteRange> pieces = splitBytes(makeRange(body.data + 4, body.size - 4), "\0\0", align, align, 2);
+	if (pieces.size() != 2) return true;
+
+	return decodeID3v2String(pieces[0], encoding, description) && decodeID3v2String(pieces[1], encoding, text);
+}
+
+/**
+ * Function reads ID3v2 WXXX frame and returns it in format of TagLib::ID3v2::UserUrlLinkFrame::toString() - "[description] url"
+ */
+static bool readUserUrlFrame(ByteRange body, std::wstring *value)
+{
+	std::wstring description, url;
+
+	if (body.size >= 2)
+	{
+		unsigned char encoding = body.data[0];
+		if (encoding > 3) return false;
+
+		size_t align = (encoding == 1 || encoding == 2) ? 2 : 1;
+		long long end = findBytes(makeRange(body.data + 1, body.size - 1), 0, "\0\0", align, align);
+
+		if (end >= 0)
+		{
+			if (!decodeID3v2String(makeRange(body.data + 1, static_cast<size_t>(end)), encoding, &description)) return false;
+
+			size_t position = 1 + static_cast<size_t>(end) + align;
+			url = decodeLatin1(makeRange(body.data + position, body.size - position));
+		}
+	}
+
+	*value = L"[" + description + L"] " + url;
+	return true;
+}
+
+/**
+ * Function computes value of genre from TCON frame fields, the same way TagLib does:
+ * ID3v2.3 style "(17)Rock" values are split and genre numbers are replaced with their names
+ */
+static std::wstring readGenre(const std::vector<std::wstring> &raw)
+{
+	std::vector<std::wstring> fields;
+	for (size_t i = 0; i < raw.size(); i++)
+	{
+		const std::wstring &field = raw[i];
+		size_t end = field.find(L')');
+
+		if (!field.empty() && field[0] == L'(' && end != std::wstring::npos)
+		{
+			std::wstring text = field.substr(end + 1);
+			bool ok;
+			int number = toInt(field.substr(1, end - 1), &ok);
+
+			if (ok && number >= 0 && number <= 255 && genreName(number) != text) fields.push_back(field.substr(1, end - 1));
+			if (!text.empty()) fields.push_back(text);
+		}
+		else
+		{
+			fields.push_back(field);
+		}
+	}
+
+	std::vector<std::wstring> genres;
+	for (size_t i = 0; i < fields.size(); i++)
+	{
+		if (fields[i].empty()) continue;
+
+		bool ok;
+		int number = toInt(fields[i], &ok);
+		std::wstring genre = (ok && number >= 0 && number <= 255) ? genreName(number) : fields[i];
+
+		bool found = false;
+		for (size_t j = 0; j < genres.size() && !found; j++) found = (genres[j] == genre);
+		if (!found) genres.push_back(genre);
+	}
+
+	return joinStrings(genres, L" ");
+}
+
+/**
+ * Function reads ID3v2.3/2.4 tag from the beginning of the file: basic tags, extended tags and covers
+ *
+ * @param[in]  file     Mapped file (starting with ID3v2 tag)
+ * @param[out] tag_end  Offset of the first byte after the tag
+ * @param[out] tags     Extended tags and covers
+ * @param[out] basic    Basic tags
+ *
+ * @return True if tag was read, false if it has to be read by TagLib
+ */
+static bool readID3v2(ByteRange file, size_t *tag_end, MediaLibCleaner::FastTags *tags, BasicTags *basic)
+{
+	using namespace MediaLibCleaner;
+
+	if (file.size < 10) return false;
+
+	const unsigned char *header = file.data;
+	unsigned int version = header[3];
+	unsigned char flags = header[5];
+
+	// ID3v2.2 frames are converted by TagLib; unsynchronisation, extended header and footer are not supported
+	if (version != 3 && version != 4) return false;
+	if ((flags & 0x80) || (flags & 0x40) || (flags & 0x10)) return false;
+	if ((header[6] | header[7] | header[8] | header[9]) & 0x80) return false;
+
+	size_t size = readSyncSafe(header + 6);
+	size_t complete = 10 + size;
+	if (complete > file.size) return false;
+
+	*tag_end = complete;
+
+	ByteRange frames = makeRange(file.data + 10, size);
+	std::vector<std::wstring> fields;
+	std::wstring description, text, first_comment;
+	bool seen_title = false, seen_artist = false, seen_album = false, seen_genre = false, seen_year = false, seen_track = false;
+	bool seen_comment = false, found_comment = false;
+
+	size_t position = 0;
+	while (position + 10 < size)
+	{
+		// padding
+		if (frames.data[position] == 0) break;
+
+		if (!isValidFrameID(frames, position)) return false;
+
+		const unsigned char *frame_header = frames.data + position;
+		unsigned int id = readBE32(frame_header);
+		size_t frame_size = readFrameSize(frames, position, version);
+
+		if (frame_size == 0 || frame_size > size - position - 10) return false;
+
+		// compressed, encrypted, unsynchronised frames (and frames with grouping or data length) are left to TagLib
+		if (version == 3 && (frame_header[9] & 0xE0)) return false;
+		if (version == 4 && (frame_header[9] & 0x4F)) return false;
+
+		// frames renamed by TagLib
+		if (version == 3 && id == MLC_FRAME_ID('T', 'O', 'R', 'Y')) id = MLC_FRAME_ID('T', 'D', 'O', 'R');
+		else if (version == 3 && id == MLC_FRAME_ID('T', 'Y', 'E', 'R')) id = MLC_FRAME_ID('T', 'D', 'R', 'C');
+		else if (version == 4 && id == MLC_FRAME_ID('T', 'R', 'D', 'C')) id = MLC_FRAME_ID('T', 'D', 'R', 'C');
+
+		ByteRange body = makeRange(frame_header + 10, frame_size);
+		position += 10 + frame_size;
+
+		if (id == MLC_FRAME_ID('T', 'X', 'X', 'X'))
+		{
+			if (!readTextFields(body, &fields)) return false;
+
+			std::wstring value = L"[" + (fields.empty() ? std::wstring() : fields[0]) + L"] " + joinStrings(fields, L" ");
+			if (value.substr(0, 6) == L"[MOOD]" && value.size() >= 12)
+				tags->tags[COLUMN_MOOD] = value.substr(12); // format: [MOOD] MOOD %mood%
+		}
+		else if (id == MLC_FRAME_ID('W', 'X', 'X', 'X'))
+		{
+			std::wstring value;
+			if (!readUserUrlFrame(body, &value)) return false;
+
+			if (value.substr(0, 2) == L"[]")
+				tags->tags[COLUMN_WWW] = value.substr(3); // format: [] www
+		}
+		else if (id == MLC_FRAME_ID('A', 'P', 'I', 'C'))
+		{
+			tags->covers++;
+			if (tags->covers != 1) continue;
+
+			// mimetype is null-terminated Latin-1 string after encoding byte, picture type follows it
+			std::wstring mimetype;
+			int type = 0;
+
+			if (body.size >= 5)
+			{
+				size_t type_position = 1;
+				long long end = findBytes(body, 1, "\0", 1, 1);
+
+				if (end >= 1)
+				{
+					mimetype = decodeLatin1(makeRange(body.data + 1, static_cast<size_t>(end) - 1));
+					type_position = static_cast<size_t>(end) + 1;
+				}
+
+				if (type_position + 1 < body.size)
+				{
+					type = static_cast<signed char>(body.data[type_position]);
+
+					// description (text in frame encoding) is followed by the picture itself
+					size_t delimiter = (body.data[0] == 1 || body.data[0] == 2) ? 2 : 1;
+					size_t picture = type_position + 1;
+					long long description_end = findBytes(body, picture, "\0\0", delimiter, delimiter);
+					if (description_end >= 0) picture = static_cast<size_t>(description_end) + delimiter;
+
+					ReadImageSize(body.data + picture, body.size - picture, &tags->cover_width, &tags->cover_height);
+				}
+			}
+
+			tags->cover_mimetype = mimetype;
+			tags->cover_size = frame_size;
+			tags->cover_type = CoverTypeName(type);
+		}
+		else if (id == MLC_FRAME_ID('C', 'O', 'M', 'M'))
+		{
+			if (found_comment) continue;
+			if (!readCommentFrame(body, &description, &text)) return false;
+
+			// TagLib prefers comment without description
+			if (description.empty())
+			{
+				basic->comment = text;
+				found_comment = true;
+			}
+			else if (!seen_comment)
+			{
+				first_comment = text;
+			}
+
+			seen_comment = true;
+		}
+		else if (id == MLC_FRAME_ID('U', 'S', 'L', 'T'))
+		{
+			if (!readCommentFrame(body, &description, &text)) return false;
+
+			tags->tags[COLUMN_UNSYNCEDLYRICS] = text;
+		}
+		else if ((id >> 24) == 'T')
+		{
+			const TagInfo *info = FindID3v2Frame(id);
+			bool is_basic = (id == MLC_FRAME_ID('T', 'I', 'T', '2') && !seen_title) || (id == MLC_FRAME_ID('T', 'P', 'E', '1') && !seen_artist) || (id == MLC_FRAME_ID('T', 'A', 'L', 'B') && !seen_album) ||
+				(id == MLC_FRAME_ID('T', 'C', 'O', 'N') && !seen_genre) || (id == MLC_FRAME_ID('T', 'D', 'R', 'C') && !seen_year) || (id == MLC_FRAME_ID('T', 'R', 'C', 'K') && !seen_track);
+
+			if (!is_basic && (info == nullptr || info->column < FIRST_EXTENDED_TAG)) continue;
+			if (!readTextFields(body, &fields)) return false;
+
+			std::wstring value = joinStrings(fields, L" ");
+
+			if (info != nullptr && info->column >= FIRST_EXTENDED_TAG)
+			{
+				tags->tags[info->column] = value;
+			}
+			else if (id == MLC_FRAME_ID('T', 'I', 'T', '2'))
+			{
+				basic->title = value;
+				seen_title = true;
+			}
+			else if (id == MLC_FRAME_ID('T', 'P', 'E', '1'))
+			{
+				basic->artist = value;
+				seen_artist = true;
+			}
+			else if (id == MLC_FRAME_ID('T', 'A', 'L', 'B'))
+			{
+				basic->album = value;
+				seen_album = true;
+			}
+			else if (id == MLC_FRAME_ID('T', 'C', 'O', 'N'))
+			{
+				basic->genre = readGenre(fields);
+				seen_genre = true;
+			}
+			else if (id == MLC_FRAME_ID('T', 'D', 'R', 'C'))
+			{
+				basic->year = static_cast<unsigned int>(toInt(value.substr(0, 4)));
+				seen_year = true;
+			}
+			else if (id == MLC_FRAME_ID('T', 'R', 'C', 'K'))
+			{
+				basic->track = static_cast<unsigned int>(toInt(value));
+				seen_track = true;
+			}
+		}
+	}
+
+	if (!found_comment) basic->comment = first_comment;
+
+	return true;
+}
+
+/**
+ * Function reads ID3v1 tag (the same way TagLib::ID3v1::Tag does)
+ *
+ * @param[in]  tag    Beginning of the tag ("TAG" identifier)
+ * @param[out] basic  Basic tags
+ */
+static void readID3v1(const unsigned char *tag, BasicTags *basic)
+{
+	basic->title = stripWhiteSpace(decodeLatin1(makeRange(tag + 3, 30)));
+	basic->artist = stripWhiteSpace(decodeLatin1(makeRange(tag + 33, 30)));
+	basic->album = stripWhiteSpace(decodeLatin1(makeRange(tag + 63, 30)));
+	basic->year = static_cast<unsigned int>(toInt(stripWhiteSpace(decodeLatin1(makeRange(tag + 93, 4)))));
+
+	// ID3v1.1: track number in the last byte of comment
+	if (tag[97 + 28] == 0 && tag[97 + 29] != 0)
+	{
+		basic->comment = stripWhiteSpace(decodeLatin1(makeRange(tag + 97, 28)));
+		basic->track = tag[97 + 29];
+	}
+	else
+	{
+		basic->comment = stripWhiteSpace(decodeLatin1(makeRange(tag + 97, 30)));
+	}
+
+	basic->genre = genreName(tag[127]);
+}
+
+
+/**
+ * Single item of APEv2 tag (the same values as TagLib::APE::Item)
+ */
+struct APEItem
+{
+	unsigned int type = 0; ///< 0 - text, 1 - binary, 2 - locator
+	std::vector<std::wstring> text; ///< Values of text item
+	ByteRange value = { nullptr, 0 }; ///< Data of binary or locator item
+};
+
+/**
+ * Items of APEv2 tag: upper-case item key => item
+ */
+typedef std::map<std::string, APEItem> APEItems;
+
+/**
+ * Function checks if APEv2 item key is valid (the same as isKeyValid() of TagLib::APE::Tag)
+ *
+ * @param[in] key  Key of the item
+ *
+ * @return True if key is valid
+ */
+static bool isValidAPEKey(ByteRange key)
+{
+	if (key.size < 2 || key.size > 255) return false;
+
+	for (size_t i = 0; i < key.size; i++)
+	{
+		if (key.data[i] < 32 || key.data[i] > 126) return false;
+	}
+
+	const char *invalid[] = { "ID3", "TAG", "OGGS", "MP+" };
+	for (int i = 0; i < 4; i++)
+	{
+		size_t length = strlen(invalid[i]);
+		if (key.size != length) continue;
+
+		size_t j = 0;
+		while (j < length && toupper(key.data[j]) == invalid[i][j]) j++;
+		if (j == length) return false;
+	}
+
+	return true;
+}
+
+/**
+ * Function checks if APEv2 item has no value (the same as TagLib::APE::Item::isEmpty())
+ *
+ * @param[in] items  Items of the tag
+ * @param[in] key    Upper-case key of the item
+ *
+ * @return True if there is no such item or it has no value
+ */
+static bool apeIsEmpty(const APEItems &items, const char *key)
+{
+	auto item = items.find(key);
+	if (item == items.end()) return true;
+
+	if (item->second.type == 0)
+		return item->second.text.empty() || (item->second.text.size() == 1 && item->second.text[0].empty());
+
+	return item->second.value.size == 0;
+}
+
+/**
+ * Function returns first value of text item of APEv2 tag (the same as TagLib::APE::Item::toString())
+ *
+ * @param[in] items  Items of the tag
+ * @param[in] key    Upper-case key of the item
+ *
+ * @return First value, or empty string if there is no such text item
+ */
+static std::wstring apeText(const APEItems &items, const char *key)
+{
+	if (apeIsEmpty(items, key)) return L"";
+
+	auto item = items.find(key);
+	return (item->second.type == 0) ? item->second.text.front() : L"";
+}
+
+/**
+ * Function returns all values of text item of APEv2 tag joined by space (the same as basic tags of TagLib::APE::Tag)
+ *
+ * @param[in] items  Items of the tag
+ * @param[in] key    Upper-case key of the item
+ *
+ * @return Joined values, or empty string if there is no such item
+ */
+static std::wstring apeJoined(const APEItems &items, const char *key)
+{
+	if (apeIsEmpty(items, key)) return L"";
+
+	return joinStrings(items.find(key)->second.text, L" ");
+}
+
+/**
+ * Function reads APEv2 tag of MP3 file (the same way TagLib::APE::Tag does).
+ * Extended tags and cover are read only if file has no ID3v2 tag (see MediaLibCleaner::MPEGBackend::ReadTags()).
+ *
+ * @param[in]  file      Whole file
+ * @param[in]  footer    Offset of the tag footer ("APETAGEX" identifier)
+ * @param[in]  extended  True if extended tags and cover are to be read
+ * @param[out] tags      Values read from the file
+ * @param[out] basic     Basic tags
+ *
+ * @return True if tag was read, false if it has to be read by TagLib
+ */
+static bool readAPE(ByteRange file, size_t footer, bool extended, MediaLibCleaner::FastTags *tags, BasicTags *basic)
+{
+	size_t tag_size = readLE32(file.data + footer + 12);
+	size_t item_count = readLE32(file.data + footer + 16);
+	APEItems items;
+
+	// TagLib keeps tag of invalid size empty; size includes footer, but not header
+	if (tag_size > 32 && tag_size <= file.size)
+	{
+		if (tag_size > footer + 32) return false;
+
+		ByteRange data = makeRange(file.data + footer + 32 - tag_size, tag_size - 32);
+		size_t position = 0;
+
+		for (size_t i = 0; i < item_count && data.size >= 11 && position <= data.size - 11; i++)
+		{
+			long long key_end = findBytes(data, position + 8, "\0", 1, 1);
+			if (key_end < 0) break;
+
+			ByteRange key = makeRange(data.data + position + 8, static_cast<size_t>(key_end) - position - 8);
+			size_t value_length = readLE32(data.data + position);
+			unsigned int flags = readLE32(data.data + position + 4);
+
+			// TagLib would wrap around the position
+			if (value_length > data.size) return false;
+
+			if (isValidAPEKey(key))
+			{
+				size_t value_start = static_cast<size_t>(key_end) + 1;
+				APEItem item;
+				item.type = (flags >> 1) & 3;
+				item.value = makeRange(data.data + value_start, std::min(value_length, data.size - value_start));
+
+				if (item.type == 0)
+				{
+					std::vector<ByteRange> pieces = splitBytes(item.value, "\0", 1, 1, 0);
+					item.text.resize(pieces.size());
+					for (size_t j = 0; j < pieces.size(); j++)
+					{
+						if (!decodeUTF8(pieces[j], &item.text[j])) return false;
+					}
+					item.value = makeRange(nullptr, 0);
+				}
+
+				std::string name(key.data, key.data + key.size);
+				for (size_t j = 0; j < name.length(); j++) name[j] = static_cast<char>(toupper(name[j]));
+
+				items[name] = item;
+			}
+
+			position += key.size + value_length + 9;
+		}
+	}
+
+	basic->title = apeJoined(items, "TITLE");
+	basic->artist = apeJoined(items, "ARTIST");
+	basic->album = apeJoined(items, "ALBUM");
+	basic->comment = apeJoined(items, "COMMENT");
+	basic->genre = apeJoined(items, "GENRE");
+	basic->year = static_cast<unsigned int>(toInt(apeText(items, "YEAR")));
+	basic->track = static_cast<unsigned int>(toInt(apeText(items, "TRACK")));
+
+	if (!extended) return true;
+
+	for (int i = MediaLibCleaner::FIRST_EXTENDED_TAG; i < MediaLibCleaner::TAGS_COUNT; i++)
+	{
+		tags->tags[i] = apeText(items, MediaLibCleaner::TagSchema[i].ape);
+	}
+
+	// binary item: file name terminated with null character, followed by the picture
+	auto cover = items.find("COVER ART (FRONT)");
+	if (cover != items.end() && cover->second.value.size > 0)
+	{
+		ByteRange value = cover->second.value;
+
+		tags->covers++;
+		tags->cover_size = value.size;
+		tags->cover_type = L"front cover";
+		tags->cover_mimetype = L"unknown";
+
+		const unsigned char *name_end = static_cast<const unsigned char*>(memchr(value.data, 0, value.size));
+		if (name_end != nullptr)
+			MediaLibCleaner::ReadImageSize(name_end + 1, value.size - (name_end + 1 - value.data), &tags->cover_width, &tags->cover_height);
+
+		// extension is taken from the first characters after a dot (the same way MediaLibCleaner::FormatBackend::readAPEv2Tags() does)
+		std::string extension;
+		size_t j = 0;
+		while (j < value.size && j < 1000 && value.data[j] != '.') j++;
+		for (j++; j < value.size && j < 1000 && extension.length() < 9 && value.data[j] != ' '; j++)
+		{
+			if (value.data[j] == '\0') break;
+			extension += static_cast<char>(value.data[j]);
+		}
+
+		if (extension == "jpg") tags->cover_mimetype = L"image/jpeg";
+		else if (extension == "png") tags->cover_mimetype = L"image/png";
+	}
+
+	return true;
+}
+
+
+
+
+/**
+ * MPEG audio frame header (the same values as TagLib::MPEG::Header)
+ */
+struct MPEGHeader
+{
+	bool valid = false;
+	int version = 0; ///< 0 - MPEG 1, 1 - MPEG 2, 2 - MPEG 2.5
+	int layer = 0;
+	int bitrate = 0;
+	int samplerate = 0;
+	int channel_mode = 0;
+	int samples_per_frame = 0;
+	int frame_length = 0;
+};
+
+/**
+ * Function checks if two bytes form MPEG frame sync (the same as TagLib::MPEG::isFrameSync())
+ *
+ * @param[in] first   First byte
+ * @param[in] second  Second byte
+ *
+ * @return True if bytes form frame sync
+ */
+static bool isFrameSync(unsigned char first, unsigned char second)
+{
+	return first == 0xFF && second != 0xFF && (second & 0xE0) == 0xE0;
+}
+
+/**
+ * Function reads MPEG audio frame header
+ *
+ * @param[in] file          Mapped file
+ * @param[in] offset        Offset of the header
+ * @param[in] check_length  True if header of the next frame has to follow this frame
+ *
+ * @return Header of the frame (valid = false if there is no valid header at given offset)
+ */
+static MPEGHeader readMPEGHeader(ByteRange file, size_t offset, bool check_length)
+{
+	static const int bitrates[2][3][16] = {
+		{
+			{ 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448, 0 },
+			{ 0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 0 },
+			{ 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0 }
+		},
+		{
+			{ 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256, 0 },
+			{ 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0 },
+			{ 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0 }
+		}
+	};
+	static const int samplerates[3][4] = { { 44100, 48000, 32000, 0 }, { 22050, 24000, 16000, 0 }, { 11025, 12000, 8000, 0 } };
+	static const int samples_per_frame[3][2] = { { 384, 384 }, { 1152, 1152 }, { 1152, 576 } };
+	static const int padding_size[3] = { 4, 1, 1 };
+
+	MPEGHeader header;
+	if (offset > file.size || file.size - offset < 4) return header;
+
+	const unsigned char *p = file.data + offset;
+	if (!isFrameSync(p[0], p[1])) return header;
+
+	int version_bits = (p[1] >> 3) & 0x03;
+	if (version_bits == 0) header.version = 2;
+	else if (version_bits == 2) header.version = 1;
+	else if (version_bits == 3) header.version = 0;
+	else return header;
+
+	int layer_bits = (p[1] >> 1) & 0x03;
+	if (layer_bits == 0) return header;
+	header.layer = 4 - layer_bits;
+
+	int version_index = (header.version == 0) ? 0 : 1;
+	int layer_index = header.layer - 1;
+
+	header.bitrate = bitrates[version_index][layer_index][(p[2] >> 4) & 0x0F];
+	if (header.bitrate == 0) return header;
+
+	header.samplerate = samplerates[header.version][(p[2] >> 2) & 0x03];
+	if (header.samplerate == 0) return header;
+
+	header.channel_mode = (p[3] >> 6) & 0x03;
+	header.samples_per_frame = samples_per_frame[layer_index][version_index];
+	header.frame_length = header.samples_per_frame * header.bitrate * 125 / header.samplerate;
+	if (p[2] & 0x02) header.frame_length += padding_size[layer_index];
+
+	if (check_length)
+	{
+		// next frame has to have the same version, layer and sample rate
+		size_t next = offset + header.frame_length;
+		if (next > file.size || file.size - next < 4) return header;
+		if ((readBE32(p) & 0xFFFE0C00) != (readBE32(file.data + next) & 0xFFFE0C00)) return header;
+	}
+
+	header.valid = true;
+	return header;
+}
+
+/**
+ * Function reads audio properties of MP3 file (the same way TagLib::MPEG::Properties does with Average read style)
+ *
+ * @param[in]  file       Mapped file
+ * @param[in]  start      Offset of the first byte after ID3v2 tag
+ * @param[in]  end        Offset the last frame is searched backwards from
+ * @param[out] tags       Audio properties
+ *
+ * @return True if properties were read, false if they have to be read by TagLib
+ */
+static bool readMPEGProperties(ByteRange file, size_t start, size_t end, MediaLibCleaner::FastTags *tags)
+{
+	MPEGHeader first;
+	size_t first_offset = 0;
+
+	for (size_t i = start; i + 1 < file.size && !first.valid; i++)
+	{
+		if (!isFrameSync(file.data[i], file.data[i + 1])) continue;
+
+		first = readMPEGHeader(file, i, true);
+		first_offset = i;
+	}
+
+	if (!first.valid) return false;
+
+	// Xing or VBRI header in the first frame gives length of VBR stream
+	size_t frame_length = static_cast<size_t>(first.frame_length);
+	if (frame_length > file.size - first_offset) frame_length = file.size - first_offset;
+
+	ByteRange frame = makeRange(file.data + first_offset, frame_length);
+	unsigned int frames = 0, stream_size = 0;
+
+	long long xing = findBytes(frame, 0, "Xing", 4, 1);
+	if (xing < 0) xing = findBytes(frame, 0, "Info", 4, 1);
+
+	if (xing >= 0)
+	{
+		size_t offset = static_cast<size_t>(xing);
+		if (frame.size >= offset + 16 && (frame.data[offset + 7] & 0x03) == 0x03)
+		{
+			frames = readBE32(frame.data + offset + 8);
+			stream_size = readBE32(frame.data + offset + 12);
+		}
+	}
+	else
+	{
+		long long vbri = findBytes(frame, 0, "VBRI", 4, 1);
+		if (vbri >= 0 && frame.size >= static_cast<size_t>(vbri) + 32)
+		{
+			frames = readBE32(frame.data + vbri + 14);
+			stream_size = readBE32(frame.data + vbri + 10);
+		}
+	}
+
+	int length = 0;
+
+	if (frames > 0 && stream_size > 0)
+	{
+		double time_per_frame = first.samples_per_frame * 1000.0 / first.samplerate;
+		double stream_length = time_per_frame * frames;
+
+		length = static_cast<int>(stream_length + 0.5);
+		tags->bitrate = static_cast<int>(stream_size * 8.0 / stream_length + 0.5);
+	}
+	else
+	{
+		// constant bitrate stream - length is computed from offsets of the first and the last frame
+		tags->bitrate = first.bitrate;
+
+		long long last_offset = -1;
+		for (size_t i = end; i-- > 0 && last_offset < 0;)
+		{
+			if (i + 1 >= end || !isFrameSync(file.data[i], file.data[i + 1])) continue;
+
+			MPEGHeader header = readMPEGHeader(file, i, true);
+			if (header.valid) last_offset = static_cast<long long>(i) + header.frame_length;
+		}
+
+		if (last_offset < 0) return false;
+
+		MPEGHeader last = readMPEGHeader(file, static_cast<size_t>(last_offset), false);
+		long long stream_length = last_offset - static_cast<long long>(first_offset) + last.frame_length;
+
+		if (stream_length > 0)
+			length = static_cast<int>(stream_length * 8.0 / tags->bitrate + 0.5);
+	}
+
+	tags->samplerate = first.samplerate;
+	tags->channels = (first.channel_mode == 3) ? 1 : 2;
+	tags->length = length / 1000;
+	tags->has_properties = true;
+
+	return true;
+}
+
+/**
+ * Function reads MP3 file: ID3v2 tag at the beginning, APEv2 and ID3v1 tags at the end and audio properties
+ *
+ * @return True if file was read, false if it has to be read by TagLib
+ */
+static bool readMPEG(ByteRange file, MediaLibCleaner::PropertyAccuracy accuracy, MediaLibCleaner::FastTags *tags)
+{
+	BasicTags id3v2, ape, id3v1;
+	size_t audio_start = 0;
+	bool has_id3v2 = (file.size >= 3 && memcmp(file.data, "ID3", 3) == 0);
+
+	if (has_id3v2)
+	{
+		if (!readID3v2(file, &audio_start, tags, &id3v2)) return false;
+	}
+	else if (!readMPEGHeader(file, 0, true).valid)
+	{
+		// TagLib would search for ID3v2 tag further in the file
+		return false;
+	}
+
+	size_t audio_end = file.size;
+
+	if (file.size >= 128 && memcmp(file.data + file.size - 128, "TAG", 3) == 0)
+	{
+		readID3v1(file.data + file.size - 128, &id3v1);
+		audio_end = file.size - 128;
+	}
+
+	// TagLib looks for APEv2 footer just before ID3v1 tag (or at the end of the file) only
+	if (audio_end >= 32 && memcmp(file.data + audio_end - 32, "APETAGEX", 8) == 0)
+	{
+		if (!readAPE(file, audio_end - 32, !has_id3v2, tags, &ape)) return false;
+	}
+
+	// the same order as TagLib::MPEG::File: ID3v2, APEv2, ID3v1
+	const BasicTags *basic[3] = { &id3v2, &ape, &id3v1 };
+	storeBasicTags(basic, 3, tags);
+
+	if (accuracy != MediaLibCleaner::ACCURACY_NONE)
+	{
+		// TagLib searches the last frame starting one byte before ID3v1 tag
+		if (!readMPEGProperties(file, audio_start, audio_end == file.size ? audio_end : audio_end - 1, tags)) return false;
+	}
+
+	tags->codec = L"MPEG 1 Layer III";
+	return true;
+}
+
+
+
+
+/**
+ * Function reads XiphComment (the same way TagLib::Ogg::XiphComment does)
+ *
+ * @param[in]  data    Comment data (VORBIS_COMMENT block)
+ * @param[out] fields  Fields of the comment
+ *
+ * @return True if comment was read, false if it has to be read by TagLib
+ */
+static bool readXiphComment(ByteRange data, XiphFields *fields)
+{
+	if (data.size < 8) return false;
+
+	size_t vendor = readLE32(data.data);
+	if (vendor > data.size - 8) return false;
+
+	size_t position = 4 + vendor;
+	size_t count = readLE32(data.data + position);
+	position += 4;
+
+	if (count > (data.size - 8) / 4) return false;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		if (data.size - position < 4) return false;
+
+		size_t length = readLE32(data.data + position);
+		position += 4;
+
+		if (length > data.size - position) return false;
+
+		ByteRange entry = makeRange(data.data + position, length);
+		position += length;
+
+		// fields without separator are discarded
+		long long separator = findBytes(entry, 0, "=", 1, 1);
+		if (separator < 1) continue;
+
+		std::string key(reinterpret_cast<const char*>(entry.data), static_cast<size_t>(separator));
+		for (size_t j = 0; j < key.size(); j++)
+		{
+			if (key[j] < 0x20 || key[j] > 0x7D) return false;
+			if (key[j] >= 'a' && key[j] <= 'z') key[j] = key[j] - 'a' + 'A';
+		}
+
+		// pictures stored in comment are not FLAC pictures
+		if (key == "METADATA_BLOCK_PICTURE" || key == "COVERART") continue;
+
+		std::wstring value;
+		if (!decodeUTF8(makeRange(entry.data + separator + 1, length - static_cast<size_t>(separator) - 1), &value)) return false;
+
+		// TagLib does not add empty values
+		if (!value.empty()) (*fields)[key].push_back(value);
+	}
+
+	return true;
+}
+
+/**
+ * Function returns all values of XiphComment field, joined with space
+ *
+ * @param[in] fields  Fields of XiphComment
+ * @param[in] key     Name of the field
+ *
+ * @return Joined values or empty string if field is missing
+ */
+static std::wstring xiphField(const XiphFields &fields, const char *key)
+{
+	XiphFields::const_iterator field = fields.find(key);
+	return field != fields.end() ? joinStrings(field->second, L" ") : std::wstring();
+}
+
+/**
+ * Function returns first value of XiphComment field converted to number
+ *
+ * @param[in] fields       Fields of XiphComment
+ * @param[in] key          Name of the field
+ * @param[in] alternative  Name of the field used if the first one is missing
+ *
+ * @return Converted value or 0 if both fields are missing
+ */
+static int xiphNumber(const XiphFields &fields, const char *key, const char *alternative)
+{
+	XiphFields::const_iterator field = fields.find(key);
+	if (field == fields.end()) field = fields.find(alternative);
+
+	return field != fields.end() ? toInt(field->second.front()) : 0;
+}
+
+/**
+ * Function reads FLAC PICTURE block (the same way TagLib::FLAC::Picture does), picture itself is not copied
+ *
+ * @param[in]  block     Data of the block
+ * @param[out] type      Picture type
+ * @param[out] mimetype  Mimetype of the picture
+ * @param[out] image     Picture data (part of the block)
+ *
+ * @return True if block was read, false if it is broken
+ */
+static bool readFLACPicture(ByteRange block, int *type, std::wstring *mimetype, ByteRange *image)
+{
+	size_t size, offset;
+	if (!MediaLibCleaner::ReadPictureHeader(block.data, block.size, type, mimetype, &size, &offset)) return false;
+	if (size > block.size - offset) return false;
+
+	*image = makeRange(block.data + offset, size);
+	return true;
+}
+
+/**
+ * Function reads FLAC file: metadata blocks and audio properties
+ *
+ * @return True if file was read, false if it has to be read by TagLib
+ */
+static bool readFLAC(ByteRange file, MediaLibCleaner::PropertyAccuracy accuracy, MediaLibCleaner::FastTags *tags)
+{
+	using namespace MediaLibCleaner;
+
+	// ID3v2 tag before FLAC stream and ID3v1 tag after it are left to TagLib
+	if (file.size < 4 || memcmp(file.data, "fLaC", 4) != 0) return false;
+	if (file.size >= 128 && memcmp(file.data + file.size - 128, "TAG", 3) == 0) return false;
+
+	ByteRange streaminfo = makeRange(nullptr, 0), comment = makeRange(nullptr, 0);
+	std::vector<ByteRange> pictures;
+	bool first = true, has_comment = false;
+	size_t position = 4;
+
+	for (;;)
+	{
+		if (file.size - position < 4) return false;
+
+		unsigned char type = file.data[position] & 0x7F;
+		bool last = (file.data[position] & 0x80) != 0;
+		size_t length = readBE24(file.data + position + 1);
+
+		if (first && type != 0) return false;
+		if (length == 0 && type != 1 && type != 3) return false;
+		if (length > file.size - position - 4) return false;
+
+		ByteRange block = makeRange(file.data + position + 4, length);
+
+		if (first) streaminfo = block;
+		else if (type == 4 && !has_comment)
+		{
+			comment = block;
+			has_comment = true;
+		}
+		else if (type == 6) pictures.push_back(block);
+
+		first = false;
+		position += 4 + length;
+
+		if (last) break;
+	}
+
+	if (has_comment)
+	{
+		XiphFields fields;
+		if (!readXiphComment(comment, &fields)) return false;
+
+		BasicTags basic;
+		basic.title = xiphField(fields, "TITLE");
+		basic.artist = xiphField(fields, "ARTIST");
+		basic.album = xiphField(fields, "ALBUM");
+		basic.genre = xiphField(fields, "GENRE");
+		basic.comment = fields.count("DESCRIPTION") ? xiphField(fields, "DESCRIPTION") : xiphField(fields, "COMMENT");
+		basic.year = static_cast<unsigned int>(xiphNumber(fields, "DATE", "YEAR"));
+		basic.track = static_cast<unsigned int>(xiphNumber(fields, "TRACKNUMBER", "TRACKNUM"));
+
+		const BasicTags *list[1] = { &basic };
+		storeBasicTags(list, 1, tags);
+
+		for (int i = FIRST_EXTENDED_TAG; i < TAGS_COUNT; i++)
+			tags->tags[TagSchema[i].column] = xiphField(fields, TagSchema[i].xiph);
+
+		tags->covers = pictures.size();
+		tags->cover_mimetype = L"none";
+		tags->cover_type = L"none";
+
+		for (size_t i = 0; i < pictures.size(); i++)
+		{
+			int type;
+			std::wstring mimetype;
+			ByteRange image;
+
+			if (!readFLACPicture(pictures[i], &type, &mimetype, &image)) return false;
+
+			if (i == 0)
+			{
+				tags->cover_mimetype = mimetype;
+				tags->cover_size = image.size;
+				tags->cover_type = CoverTypeName(type);
+				ReadImageSize(image.data, image.size, &tags->cover_width, &tags->cover_height);
+			}
+		}
+	}
+	else
+	{
+		// file without any tags
+		BasicTags basic;
+		const BasicTags *list[1] = { &basic };
+		storeBasicTags(list, 1, tags);
+	}
+
+	if (accuracy != ACCURACY_NONE)
+	{
+		tags->has_properties = true;
+
+		if (streaminfo.size >= 18)
+		{
+			unsigned int flags = readBE32(streaminfo.data + 10);
+			unsigned long long samples = (static_cast<unsigned long long>(flags & 0x0F) << 32) | readBE32(streaminfo.data + 14);
+
+			tags->samplerate = flags >> 12;
+			tags->channels = ((flags >> 9) & 7) + 1;
+
+			if (samples > 0 && tags->samplerate > 0)
+			{
+				double length = samples * 1000.0 / tags->samplerate;
+
+				tags->length = static_cast<int>(length + 0.5) / 1000;
+				tags->bitrate = static_cast<int>((file.size - position) * 8.0 / length + 0.5);
+			}
+		}
+	}
+
+	tags->codec = L"Free Lossless Audio Codec";
+	return true;
+}
+
+
+
+
+/**
+ * MP4 atom (only container atoms have children, the same as in TagLib::MP4::Atoms)
+ */
+struct MP4Atom
+{
+	size_t offset;
+	size_t length;
+	std::string name;
+	std::vector<MP4Atom> children;
+};
+
+/**
+ * Item of MP4 ilst atom (only values needed by MediaLibCleaner)
+ */
+struct MP4Item
+{
+	std::vector<std::wstring> strings; ///< Text values (empty for binary and integer items)
+	int number = 0; ///< Integer value (tmpo) or first number of integer pair (trkn)
+	std::vector<std::pair<int, ByteRange>> covers; ///< Format and data of all covers (covr), data is not copied
+};
+
+typedef std::map<std::string, MP4Item> MP4Items;
+
+/**
+ * Function reads MP4 atom and all its children
+ *
+ * @param[in]  file    Mapped file
+ * @param[in]  offset  Offset of the atom
+ * @param[out] atom    Atom
+ *
+ * @return True if atom was read, false if it is broken (or longer than the file)
+ */
+static bool readMP4Atom(ByteRange file, size_t offset, MP4Atom *atom)
+{
+	static const char *containers[11] = { "moov", "udta", "mdia", "meta", "ilst", "stbl", "minf", "moof", "traf", "trak", "stsd" };
+
+	if (file.size - offset < 8) return false;
+
+	unsigned long long length = readBE32(file.data + offset);
+	size_t header = 8;
+
+	if (length == 0)
+	{
+		// the last atom extends to the end of the file
+		length = file.size - offset;
+	}
+	else if (length == 1)
+	{
+		if (file.size - offset < 16) return false;
+
+		length = readBE64(file.data + offset + 8);
+		header = 16;
+	}
+
+	if (length < header || length > file.size - offset) return false;
+
+	atom->offset = offset;
+	atom->length = static_cast<size_t>(length);
+	atom->name.assign(reinterpret_cast<const char*>(file.data + offset + 4), 4);
+
+	for (int i = 0; i < 11; i++)
+	{
+		if (atom->name != containers[i]) continue;
+
+		size_t position = offset + header;
+		if (atom->name == "meta") position += 4;
+		else if (atom->name == "stsd") position += 8;
+
+		size_t end = offset + atom->length;
+		while (position < end)
+		{
+			// child extending to the end of the file would be longer than its parent
+			if (end - position >= 4 && readBE32(file.data + position) == 0) return false;
+
+			atom->children.resize(atom->children.size() + 1);
+
+			if (!readMP4Atom(makeRange(file.data, end), position, &atom->children.back())) return false;
+			position += atom->children.back().length;
+		}
+
+		break;
+	}
+
+	return true;
+}
+
+/**
+ * Function finds atom by path (the same as TagLib::MP4::Atom::find() - only the first atom of given name is checked on every level)
+ */
+static const MP4Atom* findMP4Atom(const std::vector<MP4Atom> &atoms, const char *const *path, int count)
+{
+	for (size_t i = 0; i < atoms.size(); i++)
+	{
+		if (atoms[i].name == path[0])
+			return count == 1 ? &atoms[i] : findMP4Atom(atoms[i].children, path + 1, count - 1);
+	}
+
+	return nullptr;
+}
+
+/**
+ * Function sums lengths of all mdat atoms in the tree
+ *
+ * @param[in] atoms  Atoms to search
+ *
+ * @return Summed length in bytes
+ */
+static long long mdatLength(const std::vector<MP4Atom> &atoms)
+{
+	long long length = 0;
+
+	for (size_t i = 0; i < atoms.size(); i++)
+	{
+		if (atoms[i].name == "mdat") length += atoms[i].length;
+		length += mdatLength(atoms[i].children);
+	}
+
+	return length;
+}
+
+/**
+ * Function reads data atoms of ilst item (the same as TagLib::MP4::Tag::parseData2())
+ *
+ * @param[in]  item       Item data (without item atom header)
+ * @param[in]  freeform   True for freeform (----) items, which begin with mean and name atoms
+ * @param[out] values     Type and payload of every data atom
+ *
+ * @return True if item was read, false if it is broken
+ */
+static bool readMP4Data(ByteRange item, bool freeform, std::vector<std::pair<int, ByteRange>> *values)
+{
+	size_t position = 0;
+
+	for (int i = 0; position < item.size; i++)
+	{
+		if (item.size - position < 12) return false;
+
+		size_t length = readBE32(item.data + position);
+		if (length < 12 || length > item.size - position) return false;
+
+		const char *name = reinterpret_cast<const char*>(item.data + position + 4);
+		int type = static_cast<int>(readBE32(item.data + position + 8));
+
+		if (freeform && i < 2)
+		{
+			if (memcmp(name, i == 0 ? "mean" : "name", 4) != 0) return false;
+			values->push_back(std::make_pair(type, makeRange(item.data + position + 12, length - 12)));
+		}
+		else
+		{
+			if (memcmp(name, "data", 4) != 0 || length < 16) return false;
+			values->push_back(std::make_pair(type, makeRange(item.data + position + 16, length - 16)));
+		}
+
+		position += length;
+	}
+
+	return true;
+}
+
+/**
+ * Function reads all items of MP4 ilst atom needed by MediaLibCleaner
+ *
+ * @param[in]  file   Mapped file
+ * @param[in]  ilst   ilst atom
+ * @param[out] items  Items: atom name (or "----:mean:name" for freeform items) => value
+ *
+ * @return True if items were read, false if they have to be read by TagLib
+ */
+static bool readMP4Items(ByteRange file, const MP4Atom &ilst, MP4Items *items)
+{
+	std::vector<std::pair<int, ByteRange>> values;
+	std::wstring value;
+
+	for (size_t i = 0; i < ilst.children.size(); i++)
+	{
+		const MP4Atom &atom = ilst.children[i];
+		ByteRange item = makeRange(file.data + atom.offset + 8, atom.length - 8);
+		const std::string &name = atom.name;
+
+		values.clear();
+
+		if (name == "----")
+		{
+			if (!readMP4Data(item, true, &values)) return false;
+			if (values.size() <= 2) continue;
+
+			std::string mean(reinterpret_cast<const char*>(values[0].second.data), values[0].second.size);
+			std::string key(reinterpret_cast<const char*>(values[1].second.data), values[1].second.size);
+			mean.resize(strlen(mean.c_str()));
+			key.resize(strlen(key.c_str()));
+
+			MP4Item freeform;
+
+			// values of other types than text are read as binary data
+			if (values[2].first == 1)
+			{
+				for (size_t j = 2; j < values.size(); j++)
+				{
+					if (!decodeUTF8(values[j].second, &value)) return false;
+					freeform.strings.push_back(value);
+				}
+			}
+
+			(*items)["----:" + mean + ":" + key] = freeform;
+		}
+		else if (name == "trkn" || name == "tmpo" || name == "gnre")
+		{
+			if (!readMP4Data(item, false, &values)) return false;
+			if (values.empty()) continue;
+
+			ByteRange data = values[0].second;
+			if (data.size < (name == "trkn" ? 6u : 2u)) return false;
+
+			if (name == "gnre")
+			{
+				int index = static_cast<short>(readBE16(data.data));
+				if (index > 0) (*items)["\xA9gen"].strings.assign(1, genreName(index - 1));
+			}
+			else
+			{
+				MP4Item number;
+				number.number = static_cast<short>(readBE16(data.data + (name == "trkn" ? 2 : 0)));
+				(*items)[name] = number;
+			}
+		}
+		else if (name == "covr")
+		{
+			MP4Item covr;
+			size_t position = 0;
+
+			while (position < item.size)
+			{
+				if (item.size - position < 12) return false;
+
+				size_t length = readBE32(item.data + position);
+				if (length < 16 || length > item.size - position || memcmp(item.data + position + 4, "data", 4) != 0) return false;
+
+				int format = static_cast<int>(readBE32(item.data + position + 8));
+
+				// JPEG, PNG, BMP, GIF or implicit
+				if (format == 13 || format == 14 || format == 27 || format == 12 || format == 0)
+					covr.covers.push_back(std::make_pair(format, makeRange(item.data + position + 16, length - 16)));
+
+				position += length;
+			}
+
+			if (!covr.covers.empty()) (*items)[name] = covr;
+		}
+		else if (name == "\xA9nam" || name == "\xA9" "ART" || name == "\xA9" "alb" || name == "\xA9" "cmt" || name == "\xA9gen" || name == "\xA9" "day" || name == "\xA9lyr" || name == "cprt" || name == "aART")
+		{
+			if (!readMP4Data(item, false, &values)) return false;
+
+			// only UTF-8 values are read as text
+			MP4Item text;
+			for (size_t j = 0; j < values.size(); j++)
+			{
+				if (values[j].first != 1) continue;
+				if (!decodeUTF8(values[j].second, &value)) return false;
+				text.strings.push_back(value);
+			}
+
+			if (!text.strings.empty()) (*items)[name] = text;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Function returns all text values of MP4 item, joined with given separator
+ *
+ * @param[in] items      Items of MP4 tag
+ * @param[in] name       Name of the item
+ * @param[in] separator  Separator put between values
+ *
+ * @return Joined values or empty string if item is missing
+ */
+static std::wstring mp4Text(const MP4Items &items, const std::string &name, const wchar_t *separator)
+{
+	MP4Items::const_iterator item = items.find(name);
+	return item != items.end() ? joinStrings(item->second.strings, separator) : std::wstring();
+}
+
+/**
+ * Function reads audio properties of MP4 file (the same way TagLib::MP4::Properties does)
+ *
+ * @param[in]  file   Mapped file
+ * @param[in]  atoms  Top-level atoms of the file
+ * @param[out] tags   Audio properties and codec
+ *
+ * @return True if properties were read, false if they have to be read by TagLib
+ */
+static bool readMP4Properties(ByteRange file, const std::vector<MP4Atom> &atoms, MediaLibCleaner::FastTags *tags)
+{
+	static const char *moov_path[1] = { "moov" };
+	static const char *hdlr_path[2] = { "mdia", "hdlr" };
+	static const char *mdhd_path[2] = { "mdia", "mdhd" };
+	static const char *stsd_path[4] = { "mdia", "minf", "stbl", "stsd" };
+
+	tags->has_properties = true;
+
+	const MP4Atom *moov = findMP4Atom(atoms, moov_path, 1);
+	const MP4Atom *trak = nullptr;
+
+	// first audio track
+	for (size_t i = 0; i < moov->children.size() && trak == nullptr; i++)
+	{
+		if (moov->children[i].name != "trak") continue;
+
+		const MP4Atom *hdlr = findMP4Atom(moov->children[i].children, hdlr_path, 2);
+		if (hdlr == nullptr) return true;
+
+		if (hdlr->length >= 20 && memcmp(file.data + hdlr->offset + 16, "soun", 4) == 0) trak = &moov->children[i];
+	}
+
+	if (trak == nullptr) return true;
+
+	const MP4Atom *mdhd = findMP4Atom(trak->children, mdhd_path, 2);
+	if (mdhd == nullptr || mdhd->length < 9) return true;
+
+	const unsigned char *data = file.data + mdhd->offset;
+	long long unit, duration;
+
+	if (data[8] == 1)
+	{
+		if (mdhd->length < 44) return true;
+
+		unit = static_cast<long long>(readBE64(data + 28));
+		duration = static_cast<long long>(readBE64(data + 36));
+	}
+	else
+	{
+		if (mdhd->length < 32) return true;
+
+		unit = readBE32(data + 20);
+		duration = readBE32(data + 24);
+	}
+
+	int length = (unit > 0 && duration > 0) ? static_cast<int>(duration * 1000.0 / unit + 0.5) : 0;
+	tags->length = length / 1000;
+
+	const MP4Atom *stsd = findMP4Atom(trak->children, stsd_path, 4);
+	if (stsd == nullptr) return true;
+
+	data = file.data + stsd->offset;
+
+	if (stsd->length >= 24 && memcmp(data + 20, "mp4a", 4) == 0)
+	{
+		if (stsd->length < 50) return false;
+
+		tags->codec = L"MPEG-4 AAC";
+		tags->channels = static_cast<short>(readBE16(data + 40));
+		tags->samplerate = static_cast<int>(readBE32(data + 46));
+
+		// average bitrate from decoder config descriptor of esds atom
+		if (stsd->length >= 65 && memcmp(data + 56, "esds", 4) == 0 && data[64] == 0x03)
+		{
+			size_t position = 65;
+			if (stsd->length >= position + 3 && memcmp(data + position, "\x80\x80\x80", 3) == 0) position += 3;
+			position += 4;
+
+			if (stsd->length <= position) return false;
+
+			if (data[position] == 0x04)
+			{
+				position += 1;
+				if (stsd->length >= position + 3 && memcmp(data + position, "\x80\x80\x80", 3) == 0) position += 3;
+				position += 10;
+
+				if (stsd->length < position + 4) return false;
+
+				unsigned int bitrate = readBE32(data + position);
+				if (bitrate != 0 || length <= 0)
+					tags->bitrate = static_cast<int>((bitrate + 500) / 1000.0 + 0.5);
+				else
+					tags->bitrate = static_cast<int>((mdatLength(atoms) * 8) / length);
+			}
+		}
+	}
+	else if (stsd->length >= 24 && memcmp(data + 20, "alac", 4) == 0)
+	{
+		if (stsd->length == 88 && memcmp(data + 56, "alac", 4) == 0)
+		{
+			tags->codec = L"MPEG-4 ALAC";
+			tags->channels = static_cast<signed char>(data[73]);
+			tags->bitrate = static_cast<int>(readBE32(data + 80) / 1000.0 + 0.5);
+			tags->samplerate = static_cast<int>(readBE32(data + 84));
+
+			if (tags->bitrate == 0 && length > 0)
+				tags->bitrate = static_cast<int>((mdatLength(atoms) * 8) / length);
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Function reads MP4/M4A file: items of ilst atom and audio properties
+ *
+ * @return True if file was read, false if it has to be read by TagLib
+ */
+static bool readMP4(ByteRange file, MediaLibCleaner::PropertyAccuracy accuracy, MediaLibCleaner::FastTags *tags)
+{
+	using namespace MediaLibCleaner;
+
+	/**
+	 * Atoms of tags read from TagLib::PropertyMap (TagSchema entries without mp4item), as in translation table of TagLib's MP4 tag
+	 */
+	static const char *property_atoms[5][2] = {
+		{ "BPM", "tmpo" },
+		{ "COPYRIGHT", "cprt" },
+		{ "LANGUAGE", "----:com.apple.iTunes:LANGUAGE" },
+		{ "MOOD", "----:com.apple.iTunes:MOOD" },
+		{ "LYRICS", "\xA9lyr" }
+	};
+	static const char *ilst_path[4] = { "moov", "udta", "meta", "ilst" };
+	static const char *moov_path[1] = { "moov" };
+
+	std::vector<MP4Atom> atoms;
+	size_t position = 0;
+
+	while (file.size - position >= 8)
+	{
+		atoms.resize(atoms.size() + 1);
+
+		if (!readMP4Atom(file, position, &atoms.back())) return false;
+		position += atoms.back().length;
+	}
+
+	// TagLib considers file without moov atom invalid
+	if (findMP4Atom(atoms, moov_path, 1) == nullptr) return false;
+
+	MP4Items items;
+	const MP4Atom *ilst = findMP4Atom(atoms, ilst_path, 4);
+	if (ilst != nullptr && !readMP4Items(file, *ilst, &items)) return false;
+
+	BasicTags basic;
+	basic.title = mp4Text(items, "\xA9nam", L", ");
+	basic.artist = mp4Text(items, "\xA9" "ART", L", ");
+	basic.album = mp4Text(items, "\xA9" "alb", L", ");
+	basic.comment = mp4Text(items, "\xA9" "cmt", L", ");
+	basic.genre = mp4Text(items, "\xA9gen", L", ");
+	basic.year = static_cast<unsigned int>(toInt(mp4Text(items, "\xA9" "day", L" ")));
+	basic.track = items.count("trkn") ? static_cast<unsigned int>(items["trkn"].number) : 0;
+
+	const BasicTags *list[1] = { &basic };
+	storeBasicTags(list, 1, tags);
+
+	for (int i = FIRST_EXTENDED_TAG; i < TAGS_COUNT; i++)
+	{
+		if (TagSchema[i].mp4item != nullptr)
+		{
+			tags->tags[TagSchema[i].column] = mp4Text(items, TagSchema[i].mp4item, L", ");
+			continue;
+		}
+
+		int property = 0;
+		while (property < 5 && strcmp(property_atoms[property][0], TagSchema[i].mp4) != 0) property++;
+
+		// property not known to the parser
+		if (property == 5) return false;
+
+		const char *atom = property_atoms[property][1];
+		if (strcmp(atom, "tmpo") == 0)
+			tags->tags[TagSchema[i].column] = items.count(atom) ? std::to_wstring(items[atom].number) : L"";
+		else
+			tags->tags[TagSchema[i].column] = mp4Text(items, atom, L" ");
+	}
+
+	MP4Items::const_iterator covr = items.find("covr");
+	if (covr != items.end())
+	{
+		tags->covers = covr->second.covers.size();
+		tags->cover_size = covr->second.covers[0].second.size;
+		ReadImageSize(covr->second.covers[0].second.data, covr->second.covers[0].second.size, &tags->cover_width, &tags->cover_height);
+
+		switch (covr->second.covers[0].first)
+		{
+		case 27:
+			tags->cover_mimetype = L"image/x-portable-bitmap";
+			break;
+		case 13:
+			tags->cover_mimetype = L"image/jpeg";
+			break;
+		case 14:
+			tags->cover_mimetype = L"image/png";
+			break;
+		case 12:
+			tags->cover_mimetype = L"image/gif";
+			break;
+		case 0:
+			// implicit format is TagLib::MP4::CoverArt::Unknown
+			tags->cover_mimetype = L"image/unknown";
+			break;
+		}
+	}
+
+	// codec is known only if audio properties are read
+	tags->codec = L"MPEG-4";
+	if (accuracy != ACCURACY_NONE && !readMP4Properties(file, atoms, tags)) return false;
+
+	return true;
+}
+
+
+
+
+/**
+ * Function reads tags, covers and audio properties of the file without TagLib, straight from memory-mapped file.
+ * Values are the same as read by TagLib (with Average read style of audio properties).
+ *
+ * Supported are MP3 files with ID3v2.3/2.4 and ID3v1 tags, FLAC files with VORBIS_COMMENT and PICTURE blocks and MP4/M4A files.
+ * Function gives up (returns false) on anything else - such file has to be read by TagLib.
+ *
+ * @param[in]  path      Full path to the file
+ * @param[in]  type      Type of the file (see SniffFileType())
+ * @param[in]  accuracy  Accuracy of audio properties (ACCURACY_ACCURATE is not supported)
+ * @param[out] tags      Values read from the file
+ *
+ * @return True if all values were read, false if file has to be read by TagLib
+ */
+bool MediaLibCleaner::ReadTagsFast(const std::wstring &path, FileType type, PropertyAccuracy accuracy, FastTags *tags)
+{
+	if (accuracy == ACCURACY_ACCURATE) return false;
+	if (type != FILETYPE_MP3 && type != FILETYPE_FLAC && type != FILETYPE_MP4) return false;
+
+	MappedFile mapped;
+	if (!mapped.Open(path)) return false;
+
+	ByteRange file = makeRange(mapped.GetData(), mapped.GetSize());
+
+	switch (type)
+	{
+	case FILETYPE_MP3:
+		return readMPEG(file, accuracy, tags);
+	case FILETYPE_FLAC:
+		return readFLAC(file, accuracy, tags);
+	case FILETYPE_MP4:
+		return readMP4(file, accuracy, tags);
+	default:
+		return false;
+	}
+}
+
+/**
+ * Function reads dimensions of JPEG image from its frame header (SOFn segment). Segments before it are skipped without reading them.
+ *
+ * @param[in]  image   Image data
+ * @param[out] width   Width of the image in pixels
+ * @param[out] height  Height of the image in pixels
+ *
+ * @return True if dimensions were read, false if frame header was not found
+ */
+static bool readJPEGSize(ByteRange image, int *width, int *height)
+{
+	size_t position = 2;
+
+	while (position + 4 <= image.size)
+	{
+		if (image.data[position] != 0xFF) return false;
+
+		unsigned char marker = image.data[position + 1];
+
+		// fill byte before marker
+		if (marker == 0xFF)
+		{
+			position++;
+			continue;
+		}
+
+		// markers without segment (TEM, RSTn, SOI)
+		if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8))
+		{
+			position += 2;
+			continue;
+		}
+
+		// start of scan or end of image - there is no frame header
+		if (marker == 0xDA || marker == 0xD9) return false;
+
+		size_t length = readBE16(image.data + position + 2);
+		if (length < 2) return false;
+
+		// SOF0-SOF15, except DHT, JPG and DAC which share the range
+		if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+		{
+			if (length < 7 || position + 9 > image.size) return false;
+
+			*height = static_cast<int>(readBE16(image.data + position + 5));
+			*width = static_cast<int>(readBE16(image.data + position + 7));
+			return true;
+		}
+
+		position += 2 + length;
+	}
+
+	return false;
+}
+
+/**
+ * Function reads header of FLAC picture (PICTURE block of FLAC file or decoded METADATA_BLOCK_PICTURE field of XiphComment)
+ * the same way TagLib::FLAC::Picture does. Picture data does not have to be present - only its size and position are returned.
+ *
+ * @param[in]  data            Beginning of the picture header
+ * @param[in]  size            Amount of available bytes (may be less than whole picture)
+ * @param[out] type            Picture type
+ * @param[out] mimetype        Mimetype of the picture
+ * @param[out] picture_size    Size of the picture in bytes (as stored in the header)
+ * @param[out] picture_offset  Offset of the picture data from the beginning of the header
+ *
+ * @return True if header was read, false if it is broken or truncated
+ */
+bool MediaLibCleaner::ReadPictureHeader(const unsigned char *data, size_t size, int *type, std::wstring *mimetype, size_t *picture_size, size_t *picture_offset)
+{
+	ByteRange block = makeRange(data, size);
+	if (block.size < 32) return false;
+
+	*type = static_cast<int>(readBE32(block.data));
+
+	size_t position = 4;
+	size_t mimetype_length = readBE32(block.data + position);
+	position += 4;
+	if (mimetype_length > block.size || position + mimetype_length + 24 > block.size) return false;
+	if (!decodeUTF8(makeRange(block.data + position, mimetype_length), mimetype)) return false;
+	position += mimetype_length;
+
+	size_t description_length = readBE32(block.data + position);
+	position += 4;
+	if (description_length > block.size || position + description_length + 20 > block.size) return false;
+
+	// description, width, height, color depth and amount of colors are not needed (dimensions are read from the image itself)
+	position += description_length + 16;
+
+	*picture_size = readBE32(block.data + position);
+	*picture_offset = position + 4;
+
+	return true;
+}
+
+/**
+ * Function reads dimensions of the image (PNG, JPEG, GIF or BMP) from its header, the rest of the image is not touched
+ *
+ * @param[in]  data    Beginning of the image
+ * @param[in]  size    Size of the image in bytes
+ * @param[out] width   Width of the image in pixels (0 if unknown)
+ * @param[out] height  Height of the image in pixels (0 if unknown)
+ *
+ * @return True if dimensions were read, false if image format is not recognized or header is broken
+ */
+bool MediaLibCleaner::ReadImageSize(const unsigned char *data, size_t size, int *width, int *height)
+{
+	*width = 0;
+	*height = 0;
+
+	// PNG: signature followed by IHDR chunk
+	if (size >= 24 && memcmp(data, "\x89PNG\r\n\x1A\n", 8) == 0 && memcmp(data + 12, "IHDR", 4) == 0)
+	{
+		*width = static_cast<int>(readBE32(data + 16));
+		*height = static_cast<int>(readBE32(data + 20));
+		return true;
+	}
+
+	// GIF: logical screen descriptor follows signature
+	if (size >= 10 && (memcmp(data, "GIF87a", 6) == 0 || memcmp(data, "GIF89a", 6) == 0))
+	{
+		*width = static_cast<int>(readLE16(data + 6));
+		*height = static_cast<int>(readLE16(data + 8));
+		return true;
+	}
+
+	// BMP: OS/2 (BITMAPCOREHEADER) or Windows (BITMAPINFOHEADER and newer) DIB header, height is negative for top-down bitmaps
+	if (size >= 26 && data[0] == 'B' && data[1] == 'M')
+	{
+		unsigned int header = readLE32(data + 14);
+
+		if (header == 12)
+		{
+			*width = static_cast<int>(readLE16(data + 18));
+			*height = static_cast<int>(readLE16(data + 20));
+			return true;
+		}
+		if (header >= 40)
+		{
+			*width = static_cast<int>(readLE32(data + 18));
+			*height = static_cast<int>(readLE32(data + 22));
+			if (*height < 0) *height = -*height;
+			return true;
+		}
+
+		return false;
+	}
+
+	if (size >= 4 && data[0] == 0xFF && data[1] == 0xD8)
+		return readJPEGSize(makeRange(data, size), width, height);
+
+	return false;
+}
@@ -0,0 +1,80 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * File contains declarations of the read-only tag parser used during scan - it reads tags straight from memory-mapped file, without TagLib
+ */
+#pragma once
+
+#include <string>
+
+#include "MediaLibCleaner.hpp"
+
+namespace MediaLibCleaner
+{
+	/**
+	 * @class MappedFile FastTagReader.hpp
+	 *
+	 * @brief Class MediaLibCleaner::MappedFile maps whole file into memory (read-only). Only pages actually read are loaded from disk.
+	 */
+	class MappedFile
+	{
+	public:
+		MappedFile();
+		~MappedFile();
+
+		bool Open(const std::wstring &path);
+		void Close();
+
+		const unsigned char* GetData();
+		size_t GetSize();
+
+	protected:
+		/**
+		 * Beginning of mapped file (nullptr if file is not mapped)
+		 */
+		const unsigned char *data = nullptr;
+
+		/**
+		 * Size of mapped file in bytes
+		 */
+		size_t size = 0;
+
+#ifdef _WIN32
+		/**
+		 * Handle of the file (HANDLE)
+		 */
+		void *file = nullptr;
+
+		/**
+		 * Handle of the file mapping object (HANDLE)
+		 */
+		void *mapping = nullptr;
+#endif
+	};
+
+	/**
+	 * @brief Structure holding everything MediaLibCleaner::File reads from audio file during scan (see ReadTagsFast())
+	 */
+	struct FastTags
+	{
+		std::wstring tags[TAGS_COUNT]; ///< Values of all tags, in order of MediaLibCleaner::TagSchema
+		std::wstring codec; ///< Codec name, the same as given by the format backend
+		bool has_properties = false; ///< True if audio properties were read (false if _property_accuracy is "none")
+		int bitrate = 0; ///< Bitrate in kb/s
+		int channels = 0; ///< Amount of channels
+		int samplerate = 0; ///< Sample rate in Hz
+		int length = 0; ///< Length in seconds
+		long long covers = 0; ///< Amount of covers
+		long long cover_size = 0; ///< Size of the first cover in bytes
+		std::wstring cover_mimetype; ///< Mimetype of the first cover
+		std::wstring cover_type; ///< Type of the first cover (see CoverTypeName())
+		int cover_width = 0; ///< Width of the first cover in pixels (0 if unknown)
+		int cover_height = 0; ///< Height of the first cover in pixels (0 if unknown)
+	};
+
+	bool ReadTagsFast(const std::wstring &path, FileType type, PropertyAccuracy accuracy, FastTags *tags);
+	bool ReadPictureHeader(const unsigned char *data, size_t size, int *type, std::wstring *mimetype, size_t *picture_size, size_t *picture_offset);
+	bool ReadImageSize(const unsigned char *data, size_t size, int *width, int *height);
+}
@@ -0,0 +1,1235 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * This file contains definitions of all methods of format backends
+ */
+
+#include "FormatBackend.hpp"
+#include "FastTagReader.hpp"
+
+#include <cstring>
+
+#include <boost/filesystem/fstream.hpp>
+
+/**
+ * Amount of base64 characters of METADATA_BLOCK_PICTURE field decoded to read cover header and image dimensions (multiple of 4)
+ */
+static const size_t COVER_DECODE_LIMIT = 64 * 1024;
+
+/**
+ * MediaLibCleaner::FormatBackend destructor.
+ */
+MediaLibCleaner::FormatBackend::~FormatBackend()
+{
+}
+
+/**
+ * Allocates memory for backend object in given arena.
+ *
+ * @param[in] size   Size of the object
+ * @param[in] arena  Arena to allocate object in
+ *
+ * @return Pointer to allocated memory
+ */
+void* MediaLibCleaner::FormatBackend::operator new(size_t size, MediaLibCleaner::Arena *arena)
+{
+	return arena->Allocate(size);
+}
+
+/**
+ * Placement delete matching operator new(size_t, Arena*) - called only if constructor throws. Memory is freed with the arena.
+ */
+void MediaLibCleaner::FormatBackend::operator delete(void*, MediaLibCleaner::Arena*)
+{
+}
+
+/**
+ * Backends live in MediaLibCleaner::Arena - memory is freed with the arena, not one by one.
+ */
+void MediaLibCleaner::FormatBackend::operator delete(void*)
+{
+}
+
+/**
+ * Method prepares writing tags directly into the file (see MediaLibCleaner::ExecuteWritePlan()).
+ * By default tags are saved by TagLib.
+ *
+ * @param[in]  path     Full path to the file
+ * @param[in]  padding  Amount of padding to reserve if the file has to be rewritten
+ * @param[out] plan     Plan of the write
+ *
+ * @return True if tags can be written by MediaLibCleaner, false if they have to be saved by TagLib
+ */
+bool MediaLibCleaner::FormatBackend::PlanWrite(const std::wstring &path, size_t padding, MediaLibCleaner::WritePlan *plan)
+{
+	return false;
+}
+
+/**
+ * Method logs debug message regarding given file
+ *
+ * @param[in] file     File the message regards
+ * @param[in] module   Name of the module logging the message
+ * @param[in] message  Message
+ */
+void MediaLibCleaner::FormatBackend::log(MediaLibCleaner::File *file, const std::wstring &module, const std::wstring &message)
+{
+	(*file->logprogram)->Log(module + L"(" + file->GetPath() + L")", message, 3);
+}
+
+/**
+ * Reads and stores all extended tags read from TagLib::ID3v2::Tag object
+ *
+ * @param[in] file      File to store tags of
+ * @param[in] id3v2tag  Object holding interface to read ID3v2 tags
+ */
+void MediaLibCleaner::FormatBackend::readID3v2Tags(MediaLibCleaner::File *file, TagLib::ID3v2::Tag *id3v2tag)
+{
+	TagLib::ID3v2::FrameList::ConstIterator it = id3v2tag->frameList().begin();
+	for (; it != id3v2tag->frameList().end(); ++it) {
+		unsigned int frame = (*it)->frameID().toUInt();
+
+		if (frame == MLC_FRAME_ID('T', 'X', 'X', 'X')) {
+			std::wstring value = (*it)->toString().toWString();
+			if (value.substr(0, 6) == L"[MOOD]")
+				file->setField(COLUMN_MOOD, value.substr(12)); // format: [MOOD] MOOD %mood%
+		}
+		else if (frame == MLC_FRAME_ID('W', 'X', 'X', 'X')) {
+			std::wstring value = (*it)->toString().toWString();
+			if (value.substr(0, 2) == L"[]")
+				file->setField(COLUMN_WWW, value.substr(3));// format: [] www
+		}
+		else if (frame == MLC_FRAME_ID('A', 'P', 'I', 'C'))
+		{
+			file->setNumber(COLUMN_COVERS, file->getNumber(COLUMN_COVERS) + 1);
+
+			if (file->getNumber(COLUMN_COVERS) == 1)
+			{
+				TagLib::ID3v2::AttachedPictureFrame *frame = dynamic_cast<TagLib::ID3v2::AttachedPictureFrame*>(*it);
+				file->setField(COLUMN_COVER_MIMETYPE, frame->mimeType().toWString());
+				file->setNumber(COLUMN_COVER_SIZE, static_cast<size_t>(frame->size()));
+
+				file->setField(COLUMN_COVER_TYPE, CoverTypeName(static_cast<int>(frame->type())));
+				this->storeCoverDimensions(file, frame->picture());
+			}
+		}
+		else {
+			const TagInfo *info = FindID3v2Frame(frame);
+			if (info != nullptr && info->column >= FIRST_EXTENDED_TAG)
+				file->setField(info->column, (*it)->toString());
+		}
+	}
+}
+
+/**
+* Reads and stores all extended tags read from TagLib::Ogg::Xiphcomment object (FLAC style)
+*
+* @param[in] file         File to store tags of
+* @param[in] xiphcomment  Object holding interface to read XiphComments tags (FLAC style)
+* @param[in] piclist      Pictures stored in FLAC file
+*/
+void MediaLibCleaner::FormatBackend::readFLACXiphTags(MediaLibCleaner::File *file, TagLib::Ogg::XiphComment *xiphcomment, const TagLib::List<TagLib::FLAC::Picture*> &piclist)
+{
+	TagLib::Ogg::FieldListMap tags = xiphcomment->fieldListMap();
+
+	for (int i = FIRST_EXTENDED_TAG; i < TAGS_COUNT; i++)
+		file->setField(TagSchema[i].column, tags[TagSchema[i].xiph].toString());
+
+	if (piclist.size() == 0)
+	{
+		file->setNumber(COLUMN_COVERS, 0);
+		file->setField(COLUMN_COVER_MIMETYPE, L"none");
+		file->setField(COLUMN_COVER_TYPE, L"none");
+		file->setNumber(COLUMN_COVER_SIZE, 0);
+		file->setNumber(COLUMN_COVER_WIDTH, 0);
+		file->setNumber(COLUMN_COVER_HEIGHT, 0);
+		return;
+	}
+
+	TagLib::FLAC::Picture *picture = piclist[0];
+
+	file->setNumber(COLUMN_COVERS, piclist.size());
+	file->setField(COLUMN_COVER_MIMETYPE, picture->mimeType().toWString());
+	file->setNumber(COLUMN_COVER_SIZE, picture->data().size());
+
+	file->setField(COLUMN_COVER_TYPE, CoverTypeName(static_cast<int>(picture->type())));
+	this->storeCoverDimensions(file, picture->data());
+}
+
+/**
+* Reads and stores all extended tags read from TagLib::Ogg::XiphComment object (OGG Vorbis style)
+*
+* @param[in] file         File to store tags of
+* @param[in] xiphcomment  Object holding interface to read XiphComment tags (OGG Vorbis style)
+*/
+void MediaLibCleaner::FormatBackend::readVorbisXiphTags(MediaLibCleaner::File *file, TagLib::Ogg::XiphComment *xiphcomment)
+{
+	TagLib::PropertyMap tags = xiphcomment->properties();
+
+	for (int i = FIRST_EXTENDED_TAG; i < TAGS_COUNT; i++)
+	{
+		auto field = tags.find(TagSchema[i].xiph);
+		if (field != tags.end())
+			file->setField(TagSchema[i].column, field->second.toString());
+	}
+
+	// some taggers store website as URL field
+	auto url = tags.find("URL");
+	if (url != tags.end() && tags.find("WWW") == tags.end())
+		file->setField(COLUMN_WWW, url->second.toString());
+
+	auto picture = tags.find("METADATA_BLOCK_PICTURE"); // FLAC type coverart; proposed: http://wiki.xiph.org/VorbisComment#METADATA_BLOCK_PICTURE
+	if (picture != tags.end())
+	{
+		file->setNumber(COLUMN_COVERS, file->getNumber(COLUMN_COVERS) + 1);
+		if (file->getNumber(COLUMN_COVERS) != 1 && file->getField(COLUMN_COVER_TYPE) != L"unknown" && file->getField(COLUMN_COVER_MIMETYPE) != L"image/unknown") return;
+
+		// only the beginning of the picture is decoded: header (type, mimetype, size) and header of the image (dimensions)
+		std::string encoded = picture->second.front().to8Bit();
+		if (encoded.size() > COVER_DECODE_LIMIT) encoded.resize(COVER_DECODE_LIMIT);
+		std::vector<char> decoded = base64_decode(encoded);
+
+		int type = 0, width = 0, height = 0;
+		std::wstring mimetype;
+		size_t size = 0, offset = 0;
+
+		const unsigned char *data = reinterpret_cast<const unsigned char*>(decoded.data());
+		if (ReadPictureHeader(data, decoded.size(), &type, &mimetype, &size, &offset))
+		{
+			if (offset < decoded.size()) ReadImageSize(data + offset, std::min(size, decoded.size() - offset), &width, &height);
+		}
+		else
+		{
+			// broken picture, the same values TagLib::FLAC::Picture gives
+			type = 0;
+			mimetype.clear();
+			size = 0;
+		}
+
+		file->setField(COLUMN_COVER_MIMETYPE, mimetype);
+		file->setNumber(COLUMN_COVER_SIZE, size);
+		file->setField(COLUMN_COVER_TYPE, CoverTypeName(type));
+		file->setNumber(COLUMN_COVER_WIDTH, width);
+		file->setNumber(COLUMN_COVER_HEIGHT, height);
+	}
+}
+
+/**
+* Reads and stores all extended tags read from TagLib::APE::ItemListMap object
+*
+* @param[in] file  File to store tags of
+* @param[in] tags  Object holding interface to read APEv2 tags
+*/
+void MediaLibCleaner::FormatBackend::readAPEv2Tags(MediaLibCleaner::File *file, TagLib::APE::ItemListMap tags)
+{
+	for (int i = FIRST_EXTENDED_TAG; i < TAGS_COUNT; i++)
+		file->setField(TagSchema[i].column, tags[TagSchema[i].ape].toString());
+
+	// APE::Item::size() counts the key as well, so it is never 0 - check the data of the item instead
+	auto cover = tags.find("COVER ART (FRONT)");
+	if (cover != tags.end() && !cover->second.binaryData().isEmpty())
+	{
+		// binary item: file name terminated with null character, followed by the picture
+		const TagLib::ByteVector b = cover->second.binaryData();
+		int name_end = b.find('\0');
+
+		file->setNumber(COLUMN_COVERS, file->getNumber(COLUMN_COVERS) + 1);
+		file->setNumber(COLUMN_COVER_SIZE, static_cast<size_t>(b.size()));
+		file->setField(COLUMN_COVER_TYPE, L"front cover");
+		file->setField(COLUMN_COVER_MIMETYPE, L"unknown");
+		this->storeCoverDimensions(file, name_end >= 0 ? b.mid(name_end + 1) : TagLib::ByteVector());
+
+		bool local_ext = false;
+		char buffer[10] = "";
+		int z = 0;
+		auto it = b.begin();
+
+		for (int i = 0; i < 1000 && it != b.end() && z < 9; i++) {
+			if (!local_ext)
+			{
+				if (*it == '.')
+					local_ext = true;
+			}
+			else
+			{
+				if (*it == ' ') break;
+				buffer[z] = *it;
+				z++;
+			}
+			++it;
+		}
+
+		if (!strcmp(buffer, "jpg"))
+			file->setField(COLUMN_COVER_MIMETYPE, L"image/jpeg");
+		else if (!strcmp(buffer, "png"))
+			file->setField(COLUMN_COVER_MIMETYPE, L"image/png");
+	}
+}
+
+/**
+* Reads and stores all extended tags read from MP4/M4A file
+*
+* @param[in] file    File to store tags of
+* @param[in] m4atag  Object holding interface to read MP4/M4A tags
+*/
+void MediaLibCleaner::FormatBackend::readM4ATags(MediaLibCleaner::File *file, TagLib::MP4::Tag *m4atag)
+{
+	TagLib::MP4::ItemListMap taglist = m4atag->itemListMap();
+	this->log(file, L"MediaLibCleaner::File", L"First part of tags is being read");
+	for (int i = FIRST_EXTENDED_TAG; i < TAGS_COUNT; i++)
+	{
+		if (TagSchema[i].mp4item == nullptr) continue;
+
+		auto item = taglist.find(TagSchema[i].mp4item);
+		if (item != taglist.end())
+			file->setField(TagSchema[i].column, item->second.toStringList().toString(", "));
+	}
+
+	TagLib::PropertyMap tags = m4atag->properties();
+	this->log(file, L"MediaLibCleaner::File", L"Second part of tags is being read");
+	for (int i = FIRST_EXTENDED_TAG; i < TAGS_COUNT; i++)
+	{
+		if (TagSchema[i].mp4item != nullptr) continue;
+
+		auto property = tags.find(TagSchema[i].mp4);
+		if (property != tags.end())
+			file->setField(TagSchema[i].column, property->second.toString());
+	}
+
+	auto covr = taglist.find("covr");
+	if (covr != taglist.end())
+	{
+		TagLib::MP4::CoverArtList calist = covr->second.toCoverArtList();
+
+		file->setNumber(COLUMN_COVERS, calist.size());
+
+		if (calist.size() < 0)
+		{
+			file->setNumber(COLUMN_COVER_SIZE, 0);
+			file->setField(COLUMN_COVER_MIMETYPE, L"none");
+			file->setField(COLUMN_COVER_TYPE, L"none");
+
+			return;
+		}
+
+		// CoverArt and its data are shared with the item, not copied
+		const TagLib::MP4::CoverArt &ca = calist[0];
+		const TagLib::ByteVector image = ca.data();
+
+		file->setNumber(COLUMN_COVER_SIZE, image.size());
+		this->storeCoverDimensions(file, image);
+
+		if (ca.format() == TagLib::MP4::CoverArt::BMP)
+		{
+			file->setField(COLUMN_COVER_MIMETYPE, L"image/x-portable-bitmap");
+		}
+		else if (ca.format() == TagLib::MP4::CoverArt::JPEG)
+		{
+			file->setField(COLUMN_COVER_MIMETYPE, L"image/jpeg");
+		}
+		else if (ca.format() == TagLib::MP4::CoverArt::PNG)
+		{
+			file->setField(COLUMN_COVER_MIMETYPE, L"image/png");
+		}
+		else if (ca.format() == TagLib::MP4::CoverArt::GIF)
+		{
+			file->setField(COLUMN_COVER_MIMETYPE, L"image/gif");
+		}
+		else if (ca.format() == TagLib::MP4::CoverArt::Unknown)
+		{
+			file->setField(COLUMN_COVER_MIMETYPE, L"image/unknown");
+		}
+	}
+}
+
+/**
+ * Stores dimensions of the first cover, read from header of the image (see MediaLibCleaner::ReadImageSize())
+ *
+ * @param[in] file   File to store dimensions of
+ * @param[in] image  Image data (only its header is read)
+ */
+void MediaLibCleaner::FormatBackend::storeCoverDimensions(MediaLibCleaner::File *file, const TagLib::ByteVector &image)
+{
+	int width, height;
+	ReadImageSize(reinterpret_cast<const unsigned char*>(image.data()), image.size(), &width, &height);
+
+	file->setNumber(COLUMN_COVER_WIDTH, width);
+	file->setNumber(COLUMN_COVER_HEIGHT, height);
+}
+
+/**
+* Clears all extended tags
+*
+* @param[in] file  File to clear tags of
+*/
+void MediaLibCleaner::FormatBackend::clearExtendedTags(MediaLibCleaner::File *file)
+{
+	for (int i = FIRST_EXTENDED_TAG; i < TAGS_COUNT; i++)
+		file->setField(TagSchema[i].column, L"");
+}
+
+
+/**
+ * Method to write ID3v2 tag to the file
+ *
+ * Currently supports given frames: comments frame, text ID frame, user URL frame and unsynced lyrics frame, 
+ * which are minimum required by the program to work.
+ *
+ * @param[in] file   File the tag belongs to
+ * @param[in] info   Description of the tag (see MediaLibCleaner::TagSchema)
+ * @param[in] value  New tag value, or TagLib::String::null if tag is to be deleted
+ * @param[in] tag    Pointer to TagLib::ID3v2::Tag object containing ID3v2 tags
+ */
+void MediaLibCleaner::FormatBackend::writeID3v2Tag(MediaLibCleaner::File *file, const MediaLibCleaner::TagInfo *info, TagLib::String value, TagLib::ID3v2::Tag *tag)
+{
+	TagLib::ByteVector handle = info->id3;
+	char type = static_cast<char>(info->frame >> 24);
+
+	if (info->frame == MLC_FRAME_ID('W', 'X', 'X', 'X') && value == TagLib::String::null)
+	{
+		this->log(file, L"setTagUniversal", L"Removing ID3v2 tag '" + s2ws(info->id3));
+		auto frames = tag->frameList("WXXX");
+
+		for (auto it = frames.begin(); it != frames.end(); ++it)
+		{
+			auto fr = dynamic_cast<TagLib::ID3v2::UserUrlLinkFrame*>(*it);
+			if (fr->description() == "") {
+				tag->removeFrame(fr, true);
+			}
+		}
+	}
+	else if (value == TagLib::String::null)
+	{
+		this->log(file, L"setTagUniversal", L"Removing ID3v2 tag '" + s2ws(info->id3));
+		tag->removeFrames(handle);
+	}
+	else
+	{
+		this->log(file, L"setTagUniversal", L"Setting ID3v2 tag '" + s2ws(info->id3) + L"' to new value: '" + value.toWString() + L"'");
+		if (type == 'C') // comments frame
+		{
+			this->log(file, L"setTagUniversal", L"Setting comment type frame");
+			if (!tag->frameList(handle).isEmpty())
+			{
+				this->log(file, L"setTagUniversal", L"Substitusion possible");
+				tag->frameList(handle).front()->setText(value);
+			}
+			else
+			{
+				this->log(file, L"setTagUniversal", L"Creating and appending new frame");
+				TagLib::ID3v2::CommentsFrame *frame = new TagLib::ID3v2::CommentsFrame(TagLib::String::UTF8);
+				frame->setText(value);
+				frame->setLanguage("eng");
+				tag->addFrame(frame);
+			}
+		}
+		else if (type == 'T') // Text ID frame
+		{
+			this->log(file, L"setTagUniversal", L"Setting text type frame");
+			if (!tag->frameList(handle).isEmpty())
+			{
+				this->log(file, L"setTagUniversal", L"Substitusion possible");
+				tag->frameList(handle).front()->setText(value);
+			}
+			else
+			{
+				this->log(file, L"setTagUniversal", L"Creating and appending new frame");
+				TagLib::ID3v2::TextIdentificationFrame *frame =
+					new TagLib::ID3v2::TextIdentificationFrame(handle, TagLib::String::UTF8);
+				tag->addFrame(frame);
+				frame->setText(value);
+			}
+		}
+		else if (type == 'W') // URL frame
+		{
+			if (info->frame == MLC_FRAME_ID('W', 'X', 'X', 'X')) // user URL frame
+			{
+				this->log(file, L"setTagUniversal", L"Setting URL user frame (WWW)");
+				
+				auto wxxx_frames = tag->frameList(handle);
+				for (auto it = wxxx_frames.begin(); it != wxxx_frames.end(); ++it)
+				{
+					TagLib::ID3v2::UserUrlLinkFrame *fr = dynamic_cast<TagLib::ID3v2::UserUrlLinkFrame*>(*it);
+					if (fr->description() == "")
+						fr->setText(value);
+				}
+
+				if (!tag->frameList(handle).isEmpty())
+				{
+					this->log(file, L"setTagUniversal", L"Substitusion possible");
+					tag->frameList(handle).front()->setText(value);
+				}
+				else
+				{
+					this->log(file, L"setTagUniversal", L"Creating and appending new frame");
+					TagLib::ID3v2::UserUrlLinkFrame *frame = new TagLib::ID3v2::UserUrlLinkFrame(TagLib::String::UTF8);
+					frame->setDescription("");
+					frame->setUrl(value);
+					tag->addFrame(frame);
+				}
+			}
+		}
+		else if (info->frame == MLC_FRAME_ID('U', 'S', 'L', 'T')) // Unsynced Lyrics frame
+		{
+			this->log(file, L"setTagUniversal", L"Setting lyrics frame");
+			if (!tag->frameList(handle).isEmpty())
+			{
+				this->log(file, L"setTagUniversal", L"Substitusion possible");
+				tag->frameList(handle).front()->setText(value);
+			}
+			else
+			{
+				this->log(file, L"setTagUniversal", L"Creating and appending new frame");
+				TagLib::ID3v2::UnsynchronizedLyricsFrame *frame = new TagLib::ID3v2::UnsynchronizedLyricsFrame(TagLib::String::UTF8);
+				frame->setText(value);
+				frame->setDescription("LYRICS");
+				frame->setLanguage("eng");
+				tag->addFrame(frame);
+			}
+		}
+	}
+}
+
+/**
+* Method to write APEv2 tag to the file
+*
+* @param[in] file   File the tag belongs to
+* @param[in] info   Description of the tag (see MediaLibCleaner::TagSchema)
+* @param[in] value  New tag value, or TagLib::String::null if tag is to be deleted
+* @param[in] tag    Pointer to TagLib::APE::Tag object containing APE tags
+*/
+void MediaLibCleaner::FormatBackend::writeAPEv2Tag(MediaLibCleaner::File *file, const MediaLibCleaner::TagInfo *info, TagLib::String value, TagLib::APE::Tag *tag)
+{
+	if (value == TagLib::String::null)
+	{
+		this->log(file, L"setTagUniversal", L"Removing APE tag '" + s2ws(info->ape) + L"'");
+		tag->removeItem(info->ape);
+	}
+	else
+	{
+		this->log(file, L"setTagUniversal", L"Setting APE tag '" + s2ws(info->ape) + L"' to new value: '" + value.toWString() + L"'");
+		TagLib::APE::Item *item = new TagLib::APE::Item(info->ape, value);
+		tag->setItem(info->ape, *item);
+	}
+}
+
+/**
+* Method to write XiphComment tag to the file
+*
+* @param[in] file   File the tag belongs to
+* @param[in] info   Description of the tag (see MediaLibCleaner::TagSchema)
+* @param[in] value  New tag value, or TagLib::String::null if one is to be deleted
+* @param[in] tag    Pointer to TagLib::Ogg::XiphComment object containing XiphComment tags
+*/
+void MediaLibCleaner::FormatBackend::writeXiphTag(MediaLibCleaner::File *file, const MediaLibCleaner::TagInfo *info, TagLib::String value, TagLib::Ogg::XiphComment *tag)
+{
+	if (value == TagLib::String::null)
+	{
+		tag->removeField(info->xiph);
+	}
+	else
+	{
+		tag->addField(info->xiph, value, true);
+	}
+}
+
+/**
+* Method to write MP4/M4A tag to the file
+*
+* Works only for: ALBUM, ALBUMARTIST, ARTIST, BPM, COMMENT, COPYRIGHT, DATE, ENCODEDBY, GENRE, LANGUAGE, LYRICS, MOOD, TITLE, TRACKNUMBER
+*
+* @param[in] file   File the tag belongs to
+* @param[in] info   Description of the tag (see MediaLibCleaner::TagSchema)
+* @param[in] value  New tag value, or TagLib::String::null if one is to be deleted
+* @param[in] tag    Pointer to TagLib::MP4::Tag object containing MP4/M4A tags
+*/
+void MediaLibCleaner::FormatBackend::writeM4ATag(MediaLibCleaner::File *file, const MediaLibCleaner::TagInfo *info, TagLib::String value, TagLib::MP4::Tag *tag)
+{
+	auto props = tag->properties();
+	if (value == TagLib::String::null)
+	{
+		props = props.erase(info->mp4);
+	}
+	else
+	{
+		props.replace(info->mp4, TagLib::StringList(value));
+	}
+
+	tag->setProperties(props);
+}
+
+
+
+
+/**
+ * Method returns name of the codec
+ *
+ * @return Codec name
+ */
+std::wstring MediaLibCleaner::MPEGBackend::GetCodec()
+{
+	return L"MPEG 1 Layer III";
+}
+
+/**
+ * Method reads extended tags of MP3 file - from ID3v2 tag, or APEv2 tag if there is no ID3v2 tag
+ *
+ * @param[in] file  File to store tags of
+ */
+void MediaLibCleaner::MPEGBackend::ReadTags(MediaLibCleaner::File *file)
+{
+	this->log(file, L"MediaLibCleaner::File", L"Is MP3 file");
+
+	if (this->taglib_file->hasID3v2Tag()) {
+		this->log(file, L"MediaLibCleaner::File", L"Reading ID3v2 tags");
+		this->readID3v2Tags(file, this->taglib_file->ID3v2Tag());
+	}
+	else if (this->taglib_file->hasAPETag()) {
+		this->log(file, L"MediaLibCleaner::File", L"Reading APE tags");
+		this->readAPEv2Tags(file, this->taglib_file->APETag()->itemListMap());
+	}
+	else {
+		// ID3v1 dosen't have any of the extended tags
+		// clear them out to be on the safe side
+		this->log(file, L"MediaLibCleaner::File", L"Has ID3v1 tags");
+		this->clearExtendedTags(file);
+	}
+}
+
+/**
+ * Method sets tag of MP3 file - in ID3v2 tag (created if file has no tags) and in APEv2 tag if file has one
+ *
+ * @param[in] file   File the tag belongs to
+ * @param[in] info   Description of the tag
+ * @param[in] value  New tag value, or TagLib::String::null if tag is to be deleted
+ */
+void MediaLibCleaner::MPEGBackend::SetTag(MediaLibCleaner::File *file, const MediaLibCleaner::TagInfo *info, TagLib::String value)
+{
+	this->log(file, L"setTagUniversal", L"MP3 file detected");
+
+	if ((!this->taglib_file->hasID3v2Tag() && !this->taglib_file->hasAPETag()) || this->taglib_file->hasID3v2Tag())
+		this->writeID3v2Tag(file, info, value, this->taglib_file->ID3v2Tag(true));
+
+	if (this->taglib_file->hasAPETag())
+		this->writeAPEv2Tag(file, info, value, this->taglib_file->APETag(true));
+}
+
+/**
+ * Method prepares writing ID3v2 tag directly into the file (see MediaLibCleaner::PlanID3v2Write()).
+ * Files with APEv2 tag are saved by TagLib.
+ *
+ * @param[in]  path     Full path to the file
+ * @param[in]  padding  Amount of padding to reserve if the file has to be rewritten
+ * @param[out] plan     Plan of the write
+ *
+ * @return True if tags can be written by MediaLibCleaner, false if they have to be saved by TagLib
+ */
+bool MediaLibCleaner::MPEGBackend::PlanWrite(const std::wstring &path, size_t padding, MediaLibCleaner::WritePlan *plan)
+{
+	if (this->taglib_file->hasAPETag() || this->taglib_file->ID3v2Tag() == nullptr) return false;
+
+	// TagLib::MPEG::File::save() fills empty fields of each tag from the other one, without overwriting them,
+	// and writes ID3v1 tag unless it is empty (even if the file had none) - so do we
+	bool has_id3v1 = this->taglib_file->hasID3v1Tag();
+	if (has_id3v1)
+		TagLib::Tag::duplicate(this->taglib_file->ID3v1Tag(), this->taglib_file->ID3v2Tag(), false);
+	TagLib::Tag::duplicate(this->taglib_file->ID3v2Tag(), this->taglib_file->ID3v1Tag(true), false);
+
+	TagLib::ByteVector id3v1;
+	if (!this->taglib_file->ID3v1Tag()->isEmpty())
+		id3v1 = this->taglib_file->ID3v1Tag()->render();
+	else if (has_id3v1)
+		return false; // empty ID3v1 tag is stripped by TagLib
+
+	return PlanID3v2Write(path, this->taglib_file->ID3v2Tag()->render(), id3v1, padding, plan);
+}
+
+
+
+
+/**
+ * Method returns name of the codec
+ *
+ * @return Codec name
+ */
+std::wstring MediaLibCleaner::VorbisBackend::GetCodec()
+{
+	return L"Vorbis";
+}
+
+/**
+ * Method reads extended tags of Ogg Vorbis file
+ *
+ * @param[in] file  File to store tags of
+ */
+void MediaLibCleaner::VorbisBackend::ReadTags(MediaLibCleaner::File *file)
+{
+	this->log(file, L"MediaLibCleaner::File", L"Is OGG file");
+	this->readVorbisXiphTags(file, this->taglib_file->tag());
+}
+
+/**
+ * Method sets tag of Ogg Vorbis file
+ *
+ * @param[in] file   File the tag belongs to
+ * @param[in] info   Description of the tag
+ * @param[in] value  New tag value, or TagLib::String::null if tag is to be deleted
+ */
+void MediaLibCleaner::VorbisBackend::SetTag(MediaLibCleaner::File *file, const MediaLibCleaner::TagInfo *info, TagLib::String value)
+{
+	this->log(file, L"setTagUniversal", L"OGG file detected");
+	this->writeXiphTag(file, info, value, this->taglib_file->tag());
+}
+
+/**
+ * Method prepares writing comment header directly into the file (see MediaLibCleaner::PlanVorbisWrite())
+ *
+ * @param[in]  path     Full path to the file
+ * @param[in]  padding  Amount of padding to reserve if the file has to be rewritten
+ * @param[out] plan     Plan of the write
+ *
+ * @return True if tags can be written by MediaLibCleaner, false if they have to be saved by TagLib
+ */
+bool MediaLibCleaner::VorbisBackend::PlanWrite(const std::wstring &path, size_t padding, MediaLibCleaner::WritePlan *plan)
+{
+	if (this->taglib_file->tag() == nullptr) return false;
+
+	TagLib::ByteVector packet("\x03vorbis", 7);
+	packet.append(this->taglib_file->tag()->render(true));
+
+	return PlanVorbisWrite(path, packet, padding, plan);
+}
+
+
+
+
+/**
+ * Method returns name of the codec
+ *
+ * @return Codec name
+ */
+std::wstring MediaLibCleaner::FLACBackend::GetCodec()
+{
+	return L"Free Lossless Audio Codec";
+}
+
+/**
+ * Method reads extended tags of FLAC file - from XiphComment, or ID3v2 tag if there is no XiphComment
+ *
+ * @param[in] file  File to store tags of
+ */
+void MediaLibCleaner::FLACBackend::ReadTags(MediaLibCleaner::File *file)
+{
+	this->log(file, L"MediaLibCleaner::File", L"Is FLAC file");
+
+	if (this->taglib_file->hasXiphComment()) {
+		this->log(file, L"MediaLibCleaner::File", L"Reading Xiph comments");
+		this->readFLACXiphTags(file, this->taglib_file->xiphComment(), this->taglib_file->pictureList());
+	}
+	else if (this->taglib_file->hasID3v2Tag()) {
+		this->log(file, L"MediaLibCleaner::File", L"Reading ID3v2 tags");
+		this->readID3v2Tags(file, this->taglib_file->ID3v2Tag());
+	}
+	else {
+		// ID3v1 dosen't have any of the extended tags
+		// clear them out to be on the safe side
+		this->log(file, L"MediaLibCleaner::File", L"Has ID3v1 tags");
+		this->clearExtendedTags(file);
+	}
+}
+
+/**
+ * Method sets tag of FLAC file - in ID3v2 tag if file has one (or has no tags at all) and in XiphComment if file has one
+ *
+ * @param[in] file   File the tag belongs to
+ * @param[in] info   Description of the tag
+ * @param[in] value  New tag value, or TagLib::String::null if tag is to be deleted
+ */
+void MediaLibCleaner::FLACBackend::SetTag(MediaLibCleaner::File *file, const MediaLibCleaner::TagInfo *info, TagLib::String value)
+{
+	this->log(file, L"setTagUniversal", L"FLAC file detected");
+
+	if ((!this->taglib_file->hasID3v2Tag() && !this->taglib_file->hasXiphComment()) || this->taglib_file->hasID3v2Tag())
+		this->writeID3v2Tag(file, info, value, this->taglib_file->ID3v2Tag(true));
+
+	if (this->taglib_file->hasXiphComment())
+		this->writeXiphTag(file, info, value, this->taglib_file->xiphComment(true));
+}
+
+/**
+ * Method prepares writing VORBIS_COMMENT block directly into the file (see MediaLibCleaner::PlanFLACWrite()).
+ * Files with ID3 tags are saved by TagLib.
+ *
+ * @param[in]  path     Full path to the file
+ * @param[in]  padding  Amount of padding to reserve if the file has to be rewritten
+ * @param[out] plan     Plan of the write
+ *
+ * @return True if tags can be written by MediaLibCleaner, false if they have to be saved by TagLib
+ */
+bool MediaLibCleaner::FLACBackend::PlanWrite(const std::wstring &path, size_t padding, MediaLibCleaner::WritePlan *plan)
+{
+	if (this->taglib_file->hasID3v2Tag() || this->taglib_file->hasID3v1Tag() || this->taglib_file->ID3v2Tag() != nullptr || this->taglib_file->xiphComment() == nullptr) return false;
+
+	return PlanFLACWrite(path, this->taglib_file->xiphComment()->render(false), padding, plan);
+}
+
+
+
+
+/**
+ * Method returns name of the codec (read from audio properties; generic name if they were not read)
+ *
+ * @return Codec name
+ */
+std::wstring MediaLibCleaner::MP4Backend::GetCodec()
+{
+	if (this->taglib_file->audioProperties() == nullptr) return L"MPEG-4";
+
+	switch (this->taglib_file->audioProperties()->codec())
+	{
+	case TagLib::MP4::Properties::ALAC:
+		return L"MPEG-4 ALAC";
+	case TagLib::MP4::Properties::AAC:
+		return L"MPEG-4 AAC";
+	default:
+	case TagLib::MP4::Properties::Unknown:
+		return L"MPEG-4";
+	}
+}
+
+/**
+ * Method reads extended tags of MP4/M4A file
+ *
+ * @param[in] file  File to store tags of
+ */
+void MediaLibCleaner::MP4Backend::ReadTags(MediaLibCleaner::File *file)
+{
+	this->log(file, L"MediaLibCleaner::File", L"Is MP4/M4A file");
+	this->readM4ATags(file, this->taglib_file->tag());
+}
+
+/**
+ * Method sets tag of MP4/M4A file
+ *
+ * @param[in] file   File the tag belongs to
+ * @param[in] info   Description of the tag
+ * @param[in] value  New tag value, or TagLib::String::null if tag is to be deleted
+ */
+void MediaLibCleaner::MP4Backend::SetTag(MediaLibCleaner::File *file, const MediaLibCleaner::TagInfo *info, TagLib::String value)
+{
+	this->log(file, L"setTagUniversal", L"M4A/MP4 file detected");
+	this->writeM4ATag(file, info, value, this->taglib_file->tag());
+}
+
+
+
+
+/**
+ * Function returns type of the file guessed from its extension
+ *
+ * @param[in] ext  File extension (lowercase, without dot)
+ *
+ * @return Type of the file
+ */
+MediaLibCleaner::FileType MediaLibCleaner::GetFileTypeByExtension(const std::wstring &ext)
+{
+	if (ext == L"mp3")
+		return FILETYPE_MP3;
+	if (ext == L"ogg" || ext == L"oga")
+		return FILETYPE_OGG;
+	if (ext == L"flac")
+		return FILETYPE_FLAC;
+	if (ext == L"m4a" || ext == L"mp4" || ext == L"aac")
+		return FILETYPE_MP4;
+
+	return FILETYPE_UNKNOWN;
+}
+
+/**
+ * Function checks if given bytes are valid MPEG audio (layer I, II or III) frame header
+ *
+ * @param[in] header  First 4 bytes of the frame
+ *
+ * @return True if bytes are frame header, false otherwise
+ */
+static bool isMPEGFrameHeader(const unsigned char *header)
+{
+	if (header[0] != 0xFF || (header[1] & 0xE0) != 0xE0) return false; // frame sync
+	if ((header[1] & 0x18) == 0x08) return false; // reserved version
+	if ((header[1] & 0x06) == 0x00) return false; // reserved layer (ADTS AAC uses it)
+	if ((header[2] & 0xF0) == 0xF0) return false; // bad bitrate
+	if ((header[2] & 0x0C) == 0x0C) return false; // reserved sample rate
+
+	return true;
+}
+
+/**
+ * Function recognizes type of the file by its first bytes
+ *
+ * @param[in] header  First bytes of the file (or of audio data, when ID3v2 tag is skipped)
+ * @param[in] size    Amount of bytes
+ *
+ * @return Type of the file or FILETYPE_UNKNOWN if content was not recognized
+ */
+static MediaLibCleaner::FileType sniffHeader(const unsigned char *header, size_t size)
+{
+	if (size >= 4 && memcmp(header, "fLaC", 4) == 0)
+		return MediaLibCleaner::FILETYPE_FLAC;
+
+	// first page of Ogg stream holds identification header of the codec (at offset 28 in page with one segment)
+	if (size >= 35 && memcmp(header, "OggS", 4) == 0 && memcmp(header + 28, "\x01vorbis", 7) == 0)
+		return MediaLibCleaner::FILETYPE_OGG;
+
+	if (size >= 8 && memcmp(header + 4, "ftyp", 4) == 0)
+		return MediaLibCleaner::FILETYPE_MP4;
+
+	if (size >= 4 && isMPEGFrameHeader(header))
+		return MediaLibCleaner::FILETYPE_MP3;
+
+	return MediaLibCleaner::FILETYPE_UNKNOWN;
+}
+
+/**
+ * Function finds next box of given type among boxes of MP4 file lying between given offsets (reads only box headers)
+ *
+ * @param[in]  file       Opened file
+ * @param[in]  begin      Offset of the first box to check
+ * @param[in]  end        Offset at which boxes end (end of the file or of the parent box)
+ * @param[in]  name       Type of the box (4 characters)
+ * @param[out] box_begin  Offset of the content of found box
+ * @param[out] box_end    Offset at which found box ends
+ *
+ * @return True if box was found, false otherwise
+ */
+static bool findMP4Box(std::istream &file, uintmax_t begin, uintmax_t end, const char *name, uintmax_t *box_begin, uintmax_t *box_end)
+{
+	uintmax_t pos = begin;
+
+	while (pos + 8 <= end)
+	{
+		unsigned char header[16];
+		file.clear();
+		file.seekg(static_cast<std::streamoff>(pos));
+		file.read(reinterpret_cast<char*>(header), 8);
+		if (file.gcount() != 8) return false;
+
+		uintmax_t size = (static_cast<uintmax_t>(header[0]) << 24) | (header[1] << 16) | (header[2] << 8) | header[3];
+		uintmax_t content = pos + 8;
+
+		if (size == 1)
+		{
+			// 64-bit size follows the type
+			file.read(reinterpret_cast<char*>(header + 8), 8);
+			if (file.gcount() != 8) return false;
+
+			size = 0;
+			for (int i = 8; i < 16; i++) size = (size << 8) | header[i];
+			content += 8;
+		}
+		else if (size == 0)
+		{
+			size = end - pos; // box lasts until the end of the file
+		}
+
+		if (size < content - pos || pos + size > end) return false;
+
+		if (memcmp(header + 4, name, 4) == 0)
+		{
+			*box_begin = content;
+			*box_end = pos + size;
+			return true;
+		}
+
+		pos += size;
+	}
+
+	return false;
+}
+
+/**
+ * Function checks if MP4 file (starting with ftyp box) holds audio. Files of iTunes audio brands are accepted and files of
+ * video/image brands (M4V, QuickTime, HEIF, AVIF) are rejected by their major brand; for other brands (isom, mp42, ...)
+ * handlers of all tracks are checked - file has to have a sound track and no video track (only box headers are read).
+ *
+ * @param[in] file    Opened file
+ * @param[in] header  First bytes of the file
+ * @param[in] size    Amount of bytes
+ *
+ * @return True if file is audio file, false otherwise
+ */
+static bool isMP4Audio(std::istream &file, const unsigned char *header, size_t size)
+{
+	static const char *audio_brands[] = { "M4A ", "M4B ", "M4P ", "F4A ", "F4B " };
+	static const char *other_brands[] = { "M4V ", "M4VH", "M4VP", "F4V ", "F4P ", "qt  ", "heic", "heix", "hevc", "hevx", "mif1", "msf1", "avif", "avis" };
+
+	if (size < 12) return false;
+
+	for (size_t i = 0; i < sizeof(audio_brands) / sizeof(audio_brands[0]); i++)
+		if (memcmp(header + 8, audio_brands[i], 4) == 0) return true;
+
+	for (size_t i = 0; i < sizeof(other_brands) / sizeof(other_brands[0]); i++)
+		if (memcmp(header + 8, other_brands[i], 4) == 0) return false;
+
+	file.clear();
+	file.seekg(0, std::ios::end);
+	uintmax_t end = static_cast<uintmax_t>(file.tellg());
+
+	uintmax_t moov_begin, moov_end;
+	if (!findMP4Box(file, 0, end, "moov", &moov_begin, &moov_end)) return false;
+
+	bool sound = false;
+	uintmax_t trak_begin, trak_end;
+	uintmax_t pos = moov_begin;
+
+	while (findMP4Box(file, pos, moov_end, "trak", &trak_begin, &trak_end))
+	{
+		pos = trak_end;
+
+		uintmax_t mdia_begin, mdia_end, hdlr_begin, hdlr_end;
+		if (!findMP4Box(file, trak_begin, trak_end, "mdia", &mdia_begin, &mdia_end)) continue;
+		if (!findMP4Box(file, mdia_begin, mdia_end, "hdlr", &hdlr_begin, &hdlr_end) || hdlr_end - hdlr_begin < 12) continue;
+
+		// hdlr: version and flags, pre-defined value, handler type
+		char handler[4];
+		file.clear();
+		file.seekg(static_cast<std::streamoff>(hdlr_begin + 8));
+		file.read(handler, 4);
+		if (file.gcount() != 4) continue;
+
+		if (memcmp(handler, "vide", 4) == 0) return false;
+		if (memcmp(handler, "soun", 4) == 0) sound = true;
+	}
+
+	return sound;
+}
+
+/**
+ * Function recognizes type of the file by its content (magic bytes) - reads only first 64 bytes of the file
+ * (and first 64 bytes after ID3v2 tag, if file starts with one). Does not use TagLib.
+ * Files in MP4 container are recognized as audio only if they hold audio (see isMP4Audio()) - others (videos, HEIF/AVIF images)
+ * are recognized as not audio, so their extension is not used to guess the type.
+ *
+ * @param[in]  path        Full path to the file
+ * @param[out] recognized  True if content of the file was recognized, even as not audio (may be nullptr)
+ *
+ * @return Type of the file or FILETYPE_UNKNOWN if file is not supported audio file (or cannot be read)
+ */
+MediaLibCleaner::FileType MediaLibCleaner::SniffFileType(const std::wstring &path, bool *recognized)
+{
+	if (recognized != nullptr) *recognized = false;
+
+	boost::filesystem::ifstream file(boost::filesystem::path(path), std::ios::in | std::ios::binary);
+	if (!file.is_open()) return FILETYPE_UNKNOWN;
+
+	unsigned char header[64];
+	file.read(reinterpret_cast<char*>(header), sizeof(header));
+	size_t size = static_cast<size_t>(file.gcount());
+
+	if (size < 10 || memcmp(header, "ID3", 3) != 0)
+	{
+		FileType type = sniffHeader(header, size);
+		if (recognized != nullptr) *recognized = (type != FILETYPE_UNKNOWN);
+
+		if (type == FILETYPE_MP4 && !isMP4Audio(file, header, size))
+			return FILETYPE_UNKNOWN;
+
+		return type;
+	}
+
+	if (recognized != nullptr) *recognized = true;
+
+	// ID3v2 tag: size is synchsafe integer, footer flag adds 10 bytes
+	uintmax_t offset = 10 + ((static_cast<uintmax_t>(header[6] & 0x7F) << 21) | ((header[7] & 0x7F) << 14) | ((header[8] & 0x7F) << 7) | (header[9] & 0x7F));
+	if (header[5] & 0x10) offset += 10;
+
+	file.seekg(static_cast<std::streamoff>(offset));
+	file.read(reinterpret_cast<char*>(header), sizeof(header));
+	size = static_cast<size_t>(file.gcount());
+
+	FileType type = sniffHeader(header, size);
+
+	// ID3v2 tag is followed by audio data of the same format (FLAC, or MP3 - possibly with some padding before first frame)
+	return (type == FILETYPE_FLAC) ? FILETYPE_FLAC : FILETYPE_MP3;
+}
+
+/**
+ * Function returns human readable name of file type (for logs)
+ *
+ * @param[in] type  Type of the file
+ *
+ * @return Name of the type
+ */
+std::wstring MediaLibCleaner::FileTypeName(MediaLibCleaner::FileType type)
+{
+	switch (type)
+	{
+	case FILETYPE_MP3:
+		return L"MP3";
+	case FILETYPE_OGG:
+		return L"OGG Vorbis";
+	case FILETYPE_FLAC:
+		return L"FLAC";
+	case FILETYPE_MP4:
+		return L"MP4/M4A";
+	default:
+		return L"unknown";
+	}
+}
+
+/**
+ * Function creates backend for the file of given type
+ *
+ * @param[in] type   Type of the file
+ * @param[in] arena  Arena to allocate backend in
+ *
+ * @return Pointer to the backend or nullptr if file format is not supported
+ */
+MediaLibCleaner::FormatBackend* MediaLibCleaner::CreateFormatBackend(MediaLibCleaner::FileType type, MediaLibCleaner::Arena *arena)
+{
+	switch (type)
+	{
+	case FILETYPE_MP3:
+		return new (arena) MPEGBackend();
+	case FILETYPE_OGG:
+		return new (arena) VorbisBackend();
+	case FILETYPE_FLAC:
+		return new (arena) FLACBackend();
+	case FILETYPE_MP4:
+		return new (arena) MP4Backend();
+	default:
+		return nullptr;
+	}
+}
+
+
+
+
+/**
+ * Data useful in translating base64-encoded string into vector of chars
+ */
+static const char from_base64[] = { 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 62, 255, 62, 255, 63,
+52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 255, 255, 0, 255, 255, 255,
+255, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 255, 255, 255, 255, 63,
+255, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 255, 255, 255, 255, 255 };
+
+/**
+* Data useful in translating string into base64-encoded string
+*/
+static const char to_base64[] =
+"ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+"abcdefghijklmnopqrstuvwxyz"
+"0123456789+/";
+
+/**
+ * Function (wrapper) used to encode string
+ *
+ * @param[in] buffer  Input string
+ *
+ * @return base64-encoded string
+ */
+static std::string MediaLibCleaner::base64_encode_w(const std::vector<char>& buffer)
+{
+	return base64_encode(&buffer[0], static_cast<int>(buffer.size()));
+}
+
+/**
+* Function base64-encoding given strings
+*
+* @param[in] buf     Input string
+* @param[in] bufLen  Lenght of given buffer
+*
+* @return base64-encoded string
+*/
+static std::string MediaLibCleaner::base64_encode(const char* buf, int bufLen)
+{
+	// Calculate how many bytes that needs to be added to get a multiple of 3
+	size_t missing = 0;
+	size_t ret_size = bufLen;
+	while ((ret_size % 3) != 0)
+	{
+		++ret_size;
+		++missing;
+	}
+
+	// Expand the return string size to a multiple of 4
+	ret_size = 4 * ret_size / 3;
+
+	std::string ret;
+	ret.reserve(ret_size);
+
+	for (size_t i = 0; i < ret_size / 4; ++i)
+	{
+		// Read a group of three bytes (avoid buffer overrun by replacing with 0)
+		size_t index = i * 3;
+		char b3[3];
+		b3[0] = (index + 0 < bufLen) ? buf[index + 0] : 0;
+		b3[1] = (index + 1 < bufLen) ? buf[index + 1] : 0;
+		b3[2] = (index + 2 < bufLen) ? buf[index + 2] : 0;
+
+		// Transform into four base 64 characters
+		char b4[4];
+		b4[0] = ((b3[0] & 0xfc) >> 2);
+		b4[1] = ((b3[0] & 0x03) << 4) + ((b3[1] & 0xf0) >> 4);
+		b4[2] = ((b3[1] & 0x0f) << 2) + ((b3[2] & 0xc0) >> 6);
+		b4[3] = ((b3[2] & 0x3f) << 0);
+
+		// Add the base 64 characters to the return value
+		ret.push_back(to_base64[b4[0]]);
+		ret.push_back(to_base64[b4[1]]);
+		ret.push_back(to_base64[b4[2]]);
+		ret.push_back(to_base64[b4[3]]);
+	}
+
+	// Replace data that is invalid (always as many as there are missing bytes)
+	for (size_t i = 0; i<missing; ++i)
+		ret[ret_size - i - 1] = '=';
+
+	return ret;
+}
+
+/**
+* Function decoding base64-encoded string
+*
+* @param[in] encoded_string  base64-encoded string to be decoded
+*
+* @return std::vector of chars (decoded data)
+*/
+static std::vector<char> MediaLibCleaner::base64_decode(std::string encoded_string)
+{
+	// Make sure string length is a multiple of 4
+	while ((encoded_string.size() % 4) != 0)
+		encoded_string.push_back('=');
+
+	size_t encoded_size = encoded_string.size();
+	std::vector<char> ret;
+	ret.reserve(3 * encoded_size / 4);
+
+	for (size_t i = 0; i < encoded_size; i += 4)
+	{
+		// Get values for each group of four base 64 characters
+		char b4[4];
+		b4[0] = (encoded_string[i + 0] <= 'z') ? from_base64[encoded_string[i + 0]] : 0xff;
+		b4[1] = (encoded_string[i + 1] <= 'z') ? from_base64[encoded_string[i + 1]] : 0xff;
+		b4[2] = (encoded_string[i + 2] <= 'z') ? from_base64[encoded_string[i + 2]] : 0xff;
+		b4[3] = (encoded_string[i + 3] <= 'z') ? from_base64[encoded_string[i + 3]] : 0xff;
+
+		// Transform into a group of three bytes
+		char b3[3];
+		b3[0] = ((b4[0] & 0x3f) << 2) + ((b4[1] & 0x30) >> 4);
+		b3[1] = ((b4[1] & 0x0f) << 4) + ((b4[2] & 0x3c) >> 2);
+		b3[2] = ((b4[2] & 0x03) << 6) + ((b4[3] & 0x3f) >> 0);
+
+		// Add the byte to the return value if it isn't part of an '=' character (indicated by 0xff)
+		if (b4[1] != 0xff) ret.push_back(b3[0]);
+		if (b4[2] != 0xff) ret.push_back(b3[1]);
+		if (b4[3] != 0xff) ret.push_back(b3[2]);
+	}
+
+	return ret;
+}
@@ -0,0 +1,194 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * File contains declarations of format backends - classes holding TagLib object of the file and all code specific to its container format
+ */
+#pragma once
+
+#include <string>
+#include <memory>
+
+#include "MediaLibCleaner.hpp"
+
+namespace MediaLibCleaner
+{
+	/**
+	 * @class FormatBackend FormatBackend.hpp
+	 *
+	 * @brief Class MediaLibCleaner::FormatBackend is an interface of all format backends.
+	 *
+	 * Backend is chosen once, when file is scanned (see SniffFileType() and CreateFormatBackend()), so MediaLibCleaner::File keeps single pointer
+	 * and does not check type of the file on every operation. Backends are allocated in MediaLibCleaner::Arena, the same as files.
+	 * Adding support for new container format means adding new backend and registering it in CreateFormatBackend().
+	 */
+	class FormatBackend
+	{
+	public:
+		virtual ~FormatBackend();
+
+		static void* operator new(size_t, Arena*);
+		static void operator delete(void*, Arena*);
+		static void operator delete(void*);
+
+		virtual FileType GetType() = 0;
+		virtual TagLib::File* GetFile() = 0;
+		virtual bool Open(const std::wstring &path, PropertyAccuracy accuracy) = 0;
+		virtual void Close() = 0;
+		virtual bool IsOpen() = 0;
+		virtual bool Save() = 0;
+
+		virtual std::wstring GetCodec() = 0;
+		virtual void ReadTags(File *file) = 0;
+		virtual void SetTag(File *file, const TagInfo *info, TagLib::String value) = 0;
+		virtual bool PlanWrite(const std::wstring &path, size_t padding, WritePlan *plan);
+
+	protected:
+		void log(File *file, const std::wstring &module, const std::wstring &message);
+
+		void readID3v2Tags(File *file, TagLib::ID3v2::Tag *tag);
+		void readAPEv2Tags(File *file, TagLib::APE::ItemListMap tags);
+		void readFLACXiphTags(File *file, TagLib::Ogg::XiphComment *tag, const TagLib::List<TagLib::FLAC::Picture*> &pictures);
+		void readVorbisXiphTags(File *file, TagLib::Ogg::XiphComment *tag);
+		void readM4ATags(File *file, TagLib::MP4::Tag *tag);
+		void clearExtendedTags(File *file);
+		void storeCoverDimensions(File *file, const TagLib::ByteVector &image);
+
+		void writeID3v2Tag(File *file, const TagInfo *info, TagLib::String value, TagLib::ID3v2::Tag *tag);
+		void writeAPEv2Tag(File *file, const TagInfo *info, TagLib::String value, TagLib::APE::Tag *tag);
+		void writeXiphTag(File *file, const TagInfo *info, TagLib::String value, TagLib::Ogg::XiphComment *tag);
+		void writeM4ATag(File *file, const TagInfo *info, TagLib::String value, TagLib::MP4::Tag *tag);
+	};
+
+	/**
+	 * @class TagLibBackend FormatBackend.hpp
+	 *
+	 * @brief Class MediaLibCleaner::TagLibBackend implements part of the backend common for all formats: lifetime of TagLib object of given type.
+	 *
+	 * @tparam T     TagLib class representing file of given format (for example TagLib::MPEG::File)
+	 * @tparam TYPE  Type of the file
+	 */
+	template <class T, FileType TYPE>
+	class TagLibBackend : public FormatBackend
+	{
+	protected:
+		/**
+		 * TagLib object of the file (open only while tags are read or written)
+		 */
+		std::unique_ptr<T> taglib_file;
+
+	public:
+		/**
+		 * Method returns type of the file handled by the backend
+		 *
+		 * @return Type of the file
+		 */
+		FileType GetType() { return TYPE; }
+
+		/**
+		 * Method returns TagLib object of the file (basic tags and audio properties)
+		 *
+		 * @return TagLib object or nullptr if it is not open
+		 */
+		TagLib::File* GetFile() { return this->taglib_file.get(); }
+
+		/**
+		 * Method opens TagLib object for the file. Does nothing if TagLib object is already open.
+		 *
+		 * @param[in] path      Full path to the file
+		 * @param[in] accuracy  Accuracy of audio properties (ACCURACY_HEADER is TagLib's default read style)
+		 *
+		 * @return True if TagLib object is open and valid, false otherwise
+		 */
+		bool Open(const std::wstring &path, PropertyAccuracy accuracy)
+		{
+			if (!this->taglib_file)
+			{
+				TagLib::AudioProperties::ReadStyle style = (accuracy == ACCURACY_ACCURATE) ? TagLib::AudioProperties::Accurate : TagLib::AudioProperties::Average;
+				this->taglib_file.reset(new T(TagLib::FileName(path.c_str()), accuracy != ACCURACY_NONE, style));
+			}
+
+			return this->taglib_file->isValid();
+		}
+
+		/**
+		 * Method destroys TagLib object (closing file handle)
+		 */
+		void Close() { this->taglib_file.reset(); }
+
+		/**
+		 * Method checks if TagLib object is open
+		 *
+		 * @return True if TagLib object is open, false otherwise
+		 */
+		bool IsOpen() { return static_cast<bool>(this->taglib_file); }
+
+		/**
+		 * Method saves tags with TagLib
+		 *
+		 * @return True if tags were saved, false otherwise
+		 */
+		bool Save() { return this->taglib_file->save(); }
+	};
+
+	/**
+	 * @class MPEGBackend FormatBackend.hpp
+	 *
+	 * @brief Backend of MP3 files (ID3v1, ID3v2 or APEv2 tags)
+	 */
+	class MPEGBackend : public TagLibBackend<TagLib::MPEG::File, FILETYPE_MP3>
+	{
+	public:
+		std::wstring GetCodec();
+		void ReadTags(File *file);
+		void SetTag(File *file, const TagInfo *info, TagLib::String value);
+		bool PlanWrite(const std::wstring &path, size_t padding, WritePlan *plan);
+	};
+
+	/**
+	 * @class VorbisBackend FormatBackend.hpp
+	 *
+	 * @brief Backend of Ogg Vorbis files (XiphComment)
+	 */
+	class VorbisBackend : public TagLibBackend<TagLib::Ogg::Vorbis::File, FILETYPE_OGG>
+	{
+	public:
+		std::wstring GetCodec();
+		void ReadTags(File *file);
+		void SetTag(File *file, const TagInfo *info, TagLib::String value);
+		bool PlanWrite(const std::wstring &path, size_t padding, WritePlan *plan);
+	};
+
+	/**
+	 * @class FLACBackend FormatBackend.hpp
+	 *
+	 * @brief Backend of FLAC files (XiphComment or ID3v2 tags)
+	 */
+	class FLACBackend : public TagLibBackend<TagLib::FLAC::File, FILETYPE_FLAC>
+	{
+	public:
+		std::wstring GetCodec();
+		void ReadTags(File *file);
+		void SetTag(File *file, const TagInfo *info, TagLib::String value);
+		bool PlanWrite(const std::wstring &path, size_t padding, WritePlan *plan);
+	};
+
+	/**
+	 * @class MP4Backend FormatBackend.hpp
+	 *
+	 * @brief Backend of MP4/M4A files (iTunes-style tags)
+	 */
+	class MP4Backend : public TagLibBackend<TagLib::MP4::File, FILETYPE_MP4>
+	{
+	public:
+		std::wstring GetCodec();
+		void ReadTags(File *file);
+		void SetTag(File *file, const TagInfo *info, TagLib::String value);
+	};
+
+	FileType GetFileTypeByExtension(const std::wstring &ext);
+	FileType SniffFileType(const std::wstring &path, bool *recognized = nullptr);
+	std::wstring FileTypeName(FileType type);
+	FormatBackend* CreateFormatBackend(FileType type, Arena *arena);
+}
@@ -0,0 +1,1717 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * This file contains definitions of integrity verifier. Every file is read once, from the beginning to the end, in large
+ * chunks (see MediaLibCleaner::SequentialReader) and all checks are done on data as it is read:
+ * - Ogg: capture pattern, checksum and sequence number of every page, last page of every logical stream,
+ * - MP3: every frame header is valid and the next frame starts right after it (CRC of Layer III side info is checked if present),
+ * - FLAC: CRC-8 of every frame header, CRC-16 of every frame and MD5 of all decoded samples (frames are decoded here, no decoder library is used).
+ * Tags at the beginning and at the end of the file (ID3v2, ID3v1, Lyrics3v2, APEv2) are skipped.
+ * After the first problem verification resynchronises on the next frame/page, so amount of problems tells how much of the file is damaged.
+ */
+
+#include "IntegrityVerifier.hpp"
+#include "TagWriter.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <codecvt>
+#include <cstring>
+#include <map>
+#include <sstream>
+
+#include <boost/filesystem/fstream.hpp>
+#include <omp.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <intrin.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+/**
+ * Minimum size of a single read from the file
+ */
+static const size_t READ_CHUNK_BYTES = 1024 * 1024;
+
+/**
+ * Maximum amount of problems counted in one file (verification of the file stops after that)
+ */
+static const size_t MAX_PROBLEMS = 100;
+
+/**
+ * Function reads big-endian 16-bit number
+ *
+ * @param[in] p  Pointer to the first byte
+ *
+ * @return Number
+ */
+static unsigned int readBE16(const unsigned char *p)
+{
+	return (static_cast<unsigned int>(p[0]) << 8) | p[1];
+}
+
+/**
+ * Function reads big-endian 24-bit number
+ *
+ * @param[in] p  Pointer to the first byte
+ *
+ * @return Number
+ */
+static unsigned int readBE24(const unsigned char *p)
+{
+	return (static_cast<unsigned int>(p[0]) << 16) | (static_cast<unsigned int>(p[1]) << 8) | p[2];
+}
+
+/**
+ * Function reads big-endian 32-bit number
+ *
+ * @param[in] p  Pointer to the first byte
+ *
+ * @return Number
+ */
+static unsigned int readBE32(const unsigned char *p)
+{
+	return (static_cast<unsigned int>(p[0]) << 24) | (static_cast<unsigned int>(p[1]) << 16) | (static_cast<unsigned int>(p[2]) << 8) | p[3];
+}
+
+/**
+ * Function reads little-endian 32-bit number
+ *
+ * @param[in] p  Pointer to the first byte
+ *
+ * @return Number
+ */
+static unsigned int readLE32(const unsigned char *p)
+{
+	return (static_cast<unsigned int>(p[3]) << 24) | (static_cast<unsigned int>(p[2]) << 16) | (static_cast<unsigned int>(p[1]) << 8) | p[0];
+}
+
+
+
+
+/**
+ * MediaLibCleaner::SequentialReader constructor
+ */
+MediaLibCleaner::SequentialReader::SequentialReader()
+{
+}
+
+/**
+ * MediaLibCleaner::SequentialReader destructor (closes the file)
+ */
+MediaLibCleaner::SequentialReader::~SequentialReader()
+{
+	this->Close();
+}
+
+/**
+ * Method opens the file for reading from its beginning. Buffer of previously read file is reused.
+ *
+ * @param[in] path  Full path to the file
+ *
+ * @return True if file was opened
+ */
+bool MediaLibCleaner::SequentialReader::Open(const std::wstring &path)
+{
+	this->Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	this->file = file;
+	this->size = static_cast<unsigned long long>(size.QuadPart);
+#else
+	int descriptor = open(boost::filesystem::path(path).string().c_str(), O_RDONLY);
+	if (descriptor < 0) return false;
+
+	struct stat attrib;
+	if (fstat(descriptor, &attrib) != 0)
+	{
+		close(descriptor);
+		return false;
+	}
+
+#ifdef POSIX_FADV_SEQUENTIAL
+	posix_fadvise(descriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+	this->file = descriptor;
+	this->size = static_cast<unsigned long long>(attrib.st_size);
+#endif
+
+	return true;
+}
+
+/**
+ * Method closes the file. Does nothing if file is not open.
+ */
+void MediaLibCleaner::SequentialReader::Close()
+{
+#ifdef _WIN32
+	if (this->file != nullptr) CloseHandle(this->file);
+	this->file = nullptr;
+#else
+	if (this->file >= 0)
+	{
+#ifdef POSIX_FADV_DONTNEED
+		// file was read only once - its pages do not have to stay in cache
+		posix_fadvise(this->file, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+		close(this->file);
+	}
+	this->file = -1;
+#endif
+
+	this->start = 0;
+	this->end = 0;
+	this->position = 0;
+	this->size = 0;
+	this->bytes_read = 0;
+}
+
+/**
+ * Method reads data from given offset of the file, not using the buffer
+ *
+ * @param[in]  offset  Offset of the data from the beginning of the file
+ * @param[out] data    Read data
+ * @param[in]  length  Amount of bytes to read
+ *
+ * @return Amount of bytes read (less than length at the end of the file or on error)
+ */
+size_t MediaLibCleaner::SequentialReader::readRaw(unsigned long long offset, unsigned char *data, size_t length)
+{
+	size_t total = 0;
+
+#ifdef _WIN32
+	while (total < length)
+	{
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = static_cast<DWORD>((offset + total) & 0xFFFFFFFF);
+		overlapped.OffsetHigh = static_cast<DWORD>((offset + total) >> 32);
+
+		DWORD part = 0;
+		DWORD wanted = static_cast<DWORD>(std::min<size_t>(length - total, 0x40000000));
+		if (!ReadFile(this->file, data + total, wanted, &part, &overlapped) || part == 0) break;
+
+		total += part;
+	}
+#else
+	while (total < length)
+	{
+		ssize_t part = pread(this->file, data + total, length - total, static_cast<off_t>(offset + total));
+		if (part < 0 && errno == EINTR) continue;
+		if (part <= 0) break;
+
+		total += static_cast<size_t>(part);
+	}
+#endif
+
+	this->bytes_read += total;
+	return total;
+}
+
+/**
+ * Method makes sure given amount of bytes from current position is buffered. Reads are never shorter than 1 MiB.
+ *
+ * @param[in] length  Amount of bytes needed
+ *
+ * @return Amount of bytes buffered from current position (less than length only at the end of the file)
+ */
+size_t MediaLibCleaner::SequentialReader::Fill(size_t length)
+{
+	size_t available = this->end - this->start;
+	if (available >= length) return available;
+
+	if (this->start > 0)
+	{
+		memmove(this->buffer.data(), this->buffer.data() + this->start, available);
+		this->start = 0;
+		this->end = available;
+	}
+
+	if (this->buffer.size() < length + READ_CHUNK_BYTES)
+		this->buffer.resize(length + READ_CHUNK_BYTES);
+
+	unsigned long long offset = this->position + available;
+	while (this->end < length && offset < this->size)
+	{
+		size_t wanted = this->buffer.size() - this->end;
+		if (wanted > this->size - offset) wanted = static_cast<size_t>(this->size - offset);
+
+		size_t part = this->readRaw(offset, this->buffer.data() + this->end, wanted);
+		if (part == 0) break;
+
+		this->end += part;
+		offset += part;
+	}
+
+	return this->end - this->start;
+}
+
+/**
+ * Method returns data at current position (see Fill())
+ *
+ * @return Pointer to the byte at current position
+ */
+const unsigned char* MediaLibCleaner::SequentialReader::GetData()
+{
+	return this->buffer.data() + this->start;
+}
+
+/**
+ * Method moves current position forward. Skipped data which is not buffered yet is never read.
+ *
+ * @param[in] length  Amount of bytes to skip
+ */
+void MediaLibCleaner::SequentialReader::Skip(unsigned long long length)
+{
+	if (length <= this->end - this->start)
+	{
+		this->start += static_cast<size_t>(length);
+	}
+	else
+	{
+		this->start = 0;
+		this->end = 0;
+	}
+
+	this->position += length;
+}
+
+/**
+ * Method reads data from any offset of the file (current position and buffer are not changed)
+ *
+ * @param[in]  offset  Offset of the data from the beginning of the file
+ * @param[out] data    Read data
+ * @param[in]  length  Amount of bytes to read
+ *
+ * @return True if all bytes were read
+ */
+bool MediaLibCleaner::SequentialReader::ReadAt(unsigned long long offset, unsigned char *data, size_t length)
+{
+	return this->readRaw(offset, data, length) == length;
+}
+
+/**
+ * Method returns current position in the file
+ *
+ * @return Offset from the beginning of the file
+ */
+unsigned long long MediaLibCleaner::SequentialReader::GetPosition()
+{
+	return this->position;
+}
+
+/**
+ * Method returns size of the file
+ *
+ * @return Size of the file in bytes
+ */
+unsigned long long MediaLibCleaner::SequentialReader::GetSize()
+{
+	return this->size;
+}
+
+/**
+ * Method returns amount of bytes read from the file since it was opened
+ *
+ * @return Amount of bytes
+ */
+unsigned long long MediaLibCleaner::SequentialReader::GetBytesRead()
+{
+	return this->bytes_read;
+}
+
+
+
+
+/**
+ * Constants of MD5 rounds (integer part of abs(sin(i + 1)) * 2^32), filled once at program startup
+ */
+static struct MD5Table
+{
+	unsigned int constants[64];
+
+	MD5Table()
+	{
+		for (int i = 0; i < 64; i++)
+			this->constants[i] = static_cast<unsigned int>(static_cast<unsigned long long>(std::fabs(std::sin(i + 1.0)) * 4294967296.0));
+	}
+} md5Table;
+
+/**
+ * MediaLibCleaner::MD5 constructor
+ */
+MediaLibCleaner::MD5::MD5()
+{
+	this->state[0] = 0x67452301;
+	this->state[1] = 0xEFCDAB89;
+	this->state[2] = 0x98BADCFE;
+	this->state[3] = 0x10325476;
+}
+
+/**
+ * Method processes single block of 64 bytes
+ *
+ * @param[in] block  Block to process
+ */
+void MediaLibCleaner::MD5::processBlock(const unsigned char *block)
+{
+	static const int shifts[4][4] = { { 7, 12, 17, 22 }, { 5, 9, 14, 20 }, { 4, 11, 16, 23 }, { 6, 10, 15, 21 } };
+
+	unsigned int words[16];
+	for (int i = 0; i < 16; i++)
+		words[i] = readLE32(block + 4 * i);
+
+	unsigned int a = this->state[0], b = this->state[1], c = this->state[2], d = this->state[3];
+
+	for (int i = 0; i < 64; i++)
+	{
+		unsigned int f;
+		int g;
+
+		if (i < 16)
+		{
+			f = (b & c) | (~b & d);
+			g = i;
+		}
+		else if (i < 32)
+		{
+			f = (d & b) | (~d & c);
+			g = (5 * i + 1) & 15;
+		}
+		else if (i < 48)
+		{
+			f = b ^ c ^ d;
+			g = (3 * i + 5) & 15;
+		}
+		else
+		{
+			f = c ^ (b | ~d);
+			g = (7 * i) & 15;
+		}
+
+		f += a + md5Table.constants[i] + words[g];
+		a = d;
+		d = c;
+		c = b;
+
+		int shift = shifts[i / 16][i % 4];
+		b += (f << shift) | (f >> (32 - shift));
+	}
+
+	this->state[0] += a;
+	this->state[1] += b;
+	this->state[2] += c;
+	this->state[3] += d;
+}
+
+/**
+ * Method adds next part of the data to the digest
+ *
+ * @param[in] data    Data to add
+ * @param[in] length  Length of the data in bytes
+ */
+void MediaLibCleaner::MD5::Update(const unsigned char *data, size_t length)
+{
+	this->total += length;
+
+	if (this->buffered > 0)
+	{
+		size_t part = std::min(length, sizeof(this->buffer) - this->buffered);
+		memcpy(this->buffer + this->buffered, data, part);
+		this->buffered += part;
+		data += part;
+		length -= part;
+
+		if (this->buffered < sizeof(this->buffer)) return;
+
+		this->processBlock(this->buffer);
+		this->buffered = 0;
+	}
+
+	for (; length >= 64; data += 64, length -= 64)
+		this->processBlock(data);
+
+	if (length > 0)
+	{
+		memcpy(this->buffer, data, length);
+		this->buffered = length;
+	}
+}
+
+/**
+ * Method finishes the digest (no more data can be added)
+ *
+ * @param[out] digest  16 bytes of MD5 digest
+ */
+void MediaLibCleaner::MD5::Final(unsigned char digest[16])
+{
+	unsigned long long bits = this->total * 8;
+
+	unsigned char padding[72] = { 0x80 };
+	size_t length = (this->buffered < 56) ? 56 - this->buffered : 120 - this->buffered;
+	for (int i = 0; i < 8; i++)
+		padding[length + i] = static_cast<unsigned char>(bits >> (8 * i));
+
+	this->Update(padding, length + 8);
+
+	for (int i = 0; i < 4; i++)
+	{
+		digest[4 * i] = static_cast<unsigned char>(this->state[i]);
+		digest[4 * i + 1] = static_cast<unsigned char>(this->state[i] >> 8);
+		digest[4 * i + 2] = static_cast<unsigned char>(this->state[i] >> 16);
+		digest[4 * i + 3] = static_cast<unsigned char>(this->state[i] >> 24);
+	}
+}
+
+
+
+
+/**
+ * Lookup tables for CRC-8 (polynomial 0x07) and CRC-16 (polynomial 0x8005) used by FLAC and MPEG audio, filled once at program startup
+ */
+static struct CRCTables
+{
+	unsigned char crc8[256];
+	unsigned short crc16[256];
+
+	CRCTables()
+	{
+		for (unsigned int i = 0; i < 256; i++)
+		{
+			unsigned int crc = i;
+			for (int j = 0; j < 8; j++)
+				crc = (crc & 0x80) ? ((crc << 1) ^ 0x07) & 0xFF : (crc << 1) & 0xFF;
+			this->crc8[i] = static_cast<unsigned char>(crc);
+
+			crc = i << 8;
+			for (int j = 0; j < 8; j++)
+				crc = (crc & 0x8000) ? ((crc << 1) ^ 0x8005) & 0xFFFF : (crc << 1) & 0xFFFF;
+			this->crc16[i] = static_cast<unsigned short>(crc);
+		}
+	}
+} crcTables;
+
+/**
+ * Function computes CRC-8 of FLAC frame header
+ *
+ * @param[in] data    Data to be checksummed
+ * @param[in] length  Length of the data
+ *
+ * @return Checksum of the data
+ */
+static unsigned int crc8(const unsigned char *data, size_t length)
+{
+	unsigned int crc = 0;
+	while (length--)
+		crc = crcTables.crc8[crc ^ *data++];
+	return crc;
+}
+
+/**
+ * Function computes CRC-16 of FLAC frame or MPEG audio frame
+ *
+ * @param[in] data    Data to be checksummed
+ * @param[in] length  Length of the data
+ * @param[in] crc     Checksum of the previous part of the data (0 for FLAC, 0xFFFF for MPEG audio)
+ *
+ * @return Checksum of the data
+ */
+static unsigned int crc16(const unsigned char *data, size_t length, unsigned int crc)
+{
+	while (length--)
+		crc = ((crc << 8) ^ crcTables.crc16[(crc >> 8) ^ *data++]) & 0xFFFF;
+	return crc;
+}
+
+
+
+
+/**
+ * Function records problem found in the file (only the first one is described)
+ *
+ * @param[out] damage       Damage found in the file
+ * @param[in]  offset       Offset of the problem
+ * @param[in]  description  Description of the problem
+ */
+static void addProblem(MediaLibCleaner::Damage *damage, unsigned long long offset, const std::wstring &description)
+{
+	if (damage->problems == 0)
+	{
+		damage->offset = offset;
+		damage->description = description;
+	}
+
+	damage->problems++;
+}
+
+/**
+ * Function moves reader forward until data matching given condition is found (data at current position is never matched)
+ *
+ * @param[in] reader  Reader of the file
+ * @param[in] end     End of audio data
+ * @param[in] length  Amount of bytes condition needs
+ * @param[in] match   Condition; gets pointer to the data and amount of bytes available there (at least length)
+ *
+ * @return True if matching data was found (it is at current position of the reader), false if end of audio data was reached
+ */
+template<typename Match>
+static bool skipUntil(MediaLibCleaner::SequentialReader *reader, unsigned long long end, size_t length, Match match)
+{
+	reader->Skip(1);
+
+	while (reader->GetPosition() + length <= end)
+	{
+		size_t available = reader->Fill(READ_CHUNK_BYTES);
+		if (available > end - reader->GetPosition()) available = static_cast<size_t>(end - reader->GetPosition());
+		if (available < length) return false;
+
+		const unsigned char *data = reader->GetData();
+		for (size_t i = 0; i + length <= available; i++)
+		{
+			if (match(data + i, available - i))
+			{
+				reader->Skip(i);
+				return true;
+			}
+		}
+
+		reader->Skip(available - length + 1);
+	}
+
+	return false;
+}
+
+/**
+ * Function skips ID3v2 tags at current position of the reader
+ *
+ * @param[in] reader  Reader of the file
+ */
+static void skipID3v2(MediaLibCleaner::SequentialReader *reader)
+{
+	while (reader->Fill(10) >= 10 && memcmp(reader->GetData(), "ID3", 3) == 0)
+	{
+		const unsigned char *data = reader->GetData();
+
+		unsigned long long tag = 10 + ((static_cast<unsigned long long>(data[6] & 0x7F) << 21) | ((data[7] & 0x7F) << 14) | ((data[8] & 0x7F) << 7) | (data[9] & 0x7F));
+		if (data[5] & 0x10) tag += 10;
+
+		reader->Skip(tag);
+	}
+}
+
+/**
+ * Function returns end of audio data: ID3v1 tag, Lyrics3v2 tag and APEv2 tag at the end of the file are skipped
+ *
+ * @param[in] reader  Reader of the file
+ * @param[in] start   Beginning of audio data
+ *
+ * @return End of audio data
+ */
+static unsigned long long trailingTagsStart(MediaLibCleaner::SequentialReader *reader, unsigned long long start)
+{
+	unsigned long long end = reader->GetSize();
+	unsigned char tail[32];
+
+	if (start > end) return start;
+
+	if (end - start >= 128 && reader->ReadAt(end - 128, tail, 3) && memcmp(tail, "TAG", 3) == 0)
+		end -= 128;
+
+	// Lyrics3v2: content, 6-digit size of content and "LYRICS200"
+	if (end - start >= 15 && reader->ReadAt(end - 15, tail, 15) && memcmp(tail + 6, "LYRICS200", 9) == 0)
+	{
+		unsigned long long length = 0;
+		for (int i = 0; i < 6; i++)
+			length = length * 10 + (tail[i] >= '0' && tail[i] <= '9' ? tail[i] - '0' : 0);
+
+		if (length + 15 <= end - start) end -= length + 15;
+	}
+
+	// APEv2: size stored in footer covers items and footer, header is optional
+	if (end - start >= 32 && reader->ReadAt(end - 32, tail, 32) && memcmp(tail, "APETAGEX", 8) == 0)
+	{
+		unsigned long long length = readLE32(tail + 12);
+		if (readLE32(tail + 20) & 0x80000000) length += 32;
+
+		if (length <= end - start) end -= length;
+	}
+
+	return end;
+}
+
+
+
+
+/**
+ * Function verifies Ogg file: every page has to have correct checksum and sequence number and every logical stream has to end with its last page
+ *
+ * @param[in]  reader  Reader of the file
+ * @param[out] damage  Damage found in the file
+ *
+ * @return Result of verification
+ */
+static MediaLibCleaner::IntegrityStatus verifyOgg(MediaLibCleaner::SequentialReader *reader, MediaLibCleaner::Damage *damage)
+{
+	unsigned long long end = trailingTagsStart(reader, 0);
+
+	// logical streams: sequence number of the next page, true if the last page was found
+	std::map<unsigned int, std::pair<unsigned int, bool>> streams;
+	unsigned char header[27 + 255];
+
+	while (reader->GetPosition() < end && damage->problems < MAX_PROBLEMS)
+	{
+		unsigned long long offset = reader->GetPosition();
+		size_t available = reader->Fill(27);
+		const unsigned char *page = reader->GetData();
+
+		if (available < 27 || end - offset < 27)
+		{
+			addProblem(damage, offset, L"Truncated page header");
+			break;
+		}
+
+		if (memcmp(page, "OggS", 4) != 0 || page[4] != 0)
+		{
+			addProblem(damage, offset, L"Lost page sync (page header expected)");
+			if (!skipUntil(reader, end, 4, [](const unsigned char *data, size_t) { return memcmp(data, "OggS", 4) == 0; })) break;
+			continue;
+		}
+
+		size_t header_length = 27 + page[26];
+		available = reader->Fill(header_length);
+		page = reader->GetData();
+
+		if (available < header_length || end - offset < header_length)
+		{
+			addProblem(damage, offset, L"Truncated page header");
+			break;
+		}
+
+		size_t body_length = 0;
+		for (size_t i = 27; i < header_length; i++)
+			body_length += page[i];
+
+		available = reader->Fill(header_length + body_length);
+		page = reader->GetData();
+
+		if (available < header_length + body_length || end - offset < header_length + body_length)
+		{
+			addProblem(damage, offset, L"Truncated page (file ends inside of the page)");
+			break;
+		}
+
+		// checksum is computed with its own field set to zero
+		memcpy(header, page, header_length);
+		memset(header + 22, 0, 4);
+		unsigned int crc = MediaLibCleaner::OggCRC(header, header_length);
+		crc = MediaLibCleaner::OggCRC(page + header_length, body_length, crc);
+
+		if (crc != readLE32(page + 22))
+			addProblem(damage, offset, L"Wrong checksum of page");
+
+		unsigned int serial = readLE32(page + 14);
+		unsigned int sequence = readLE32(page + 18);
+		bool last = (page[5] & 0x04) != 0;
+
+		auto stream = streams.find(serial);
+		if (stream == streams.end())
+		{
+			streams[serial] = std::make_pair(sequence + 1, last);
+		}
+		else
+		{
+			if (stream->second.second)
+				addProblem(damage, offset, L"Page after the last page of logical stream");
+			else if (sequence != stream->second.first)
+				addProblem(damage, offset, L"Missing pages (page " + std::to_wstring(stream->second.first) + L" expected, page " + std::to_wstring(sequence) + L" found)");
+
+			stream->second.first = sequence + 1;
+			stream->second.second = stream->second.second || last;
+		}
+
+		reader->Skip(header_length + body_length);
+	}
+
+	if (streams.empty())
+		addProblem(damage, 0, L"No Ogg pages found");
+
+	for (auto stream = streams.begin(); stream != streams.end(); ++stream)
+	{
+		if (!stream->second.second)
+			addProblem(damage, reader->GetPosition(), L"Last page of logical stream is missing (file is truncated)");
+	}
+
+	return damage->problems > 0 ? MediaLibCleaner::INTEGRITY_DAMAGED : MediaLibCleaner::INTEGRITY_INTACT;
+}
+
+
+
+
+/**
+ * Function returns length of MPEG audio frame starting with given header
+ *
+ * @param[in] p  Frame header (4 bytes)
+ *
+ * @return Length of the frame in bytes, 0 if it is not valid frame header, -1 for free format frame (bitrate not given)
+ */
+static int mpegFrameLength(const unsigned char *p)
+{
+	static const int bitrates[2][3][16] = {
+		{
+			{ 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448, 0 },
+			{ 0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 0 },
+			{ 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0 }
+		},
+		{
+			{ 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256, 0 },
+			{ 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0 },
+			{ 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0 }
+		}
+	};
+	static const int samplerates[3][4] = { { 44100, 48000, 32000, 0 }, { 22050, 24000, 16000, 0 }, { 11025, 12000, 8000, 0 } };
+	static const int samples_per_frame[3][2] = { { 384, 384 }, { 1152, 1152 }, { 1152, 576 } };
+	static const int padding_size[3] = { 4, 1, 1 };
+
+	if (p[0] != 0xFF || (p[1] & 0xE0) != 0xE0) return 0;
+
+	int version_bits = (p[1] >> 3) & 0x03;
+	int version;
+	if (version_bits == 0) version = 2;
+	else if (version_bits == 2) version = 1;
+	else if (version_bits == 3) version = 0;
+	else return 0;
+
+	int layer_bits = (p[1] >> 1) & 0x03;
+	if (layer_bits == 0) return 0;
+	int layer_index = 3 - layer_bits;
+	int version_index = (version == 0) ? 0 : 1;
+
+	int bitrate_index = (p[2] >> 4) & 0x0F;
+	int samplerate = samplerates[version][(p[2] >> 2) & 0x03];
+	if (bitrate_index == 15 || samplerate == 0) return 0;
+	if (bitrate_index == 0) return -1;
+
+	int length = samples_per_frame[layer_index][version_index] * bitrates[version_index][layer_index][bitrate_index] * 125 / samplerate;
+	if (p[2] & 0x02) length += padding_size[layer_index];
+
+	return length;
+}
+
+/**
+ * Function checks CRC of MPEG audio Layer III frame (it covers last two bytes of the header and side information)
+ *
+ * @param[in] frame   Frame (its header is valid)
+ * @param[in] length  Length of the frame
+ *
+ * @return True if frame has no CRC, CRC cannot be checked or it is correct
+ */
+static bool checkMPEGCRC(const unsigned char *frame, size_t length)
+{
+	bool protection = (frame[1] & 0x01) == 0;
+	bool layer3 = ((frame[1] >> 1) & 0x03) == 1;
+	if (!protection || !layer3) return true;
+
+	bool mpeg1 = ((frame[1] >> 3) & 0x03) == 3;
+	bool mono = ((frame[3] >> 6) & 0x03) == 3;
+	size_t side_info = mpeg1 ? (mono ? 17 : 32) : (mono ? 9 : 17);
+	if (6 + side_info > length) return false;
+
+	unsigned int crc = crc16(frame + 2, 2, 0xFFFF);
+	crc = crc16(frame + 6, side_info, crc);
+
+	return crc == readBE16(frame + 4);
+}
+
+/**
+ * Function checks if there is valid MPEG audio frame header at given position (used to find next frame in damaged file)
+ *
+ * @param[in] data       Data to check
+ * @param[in] available  Amount of bytes available
+ *
+ * @return True if frame header is valid and header of the next frame (if it is available) is valid too
+ */
+static bool isMPEGFrame(const unsigned char *data, size_t available)
+{
+	int length = mpegFrameLength(data);
+	if (length <= 0) return false;
+	if (static_cast<size_t>(length) + 4 > available) return true;
+
+	// next frame has to have the same version, layer and sample rate
+	return mpegFrameLength(data + length) > 0 && (readBE32(data) & 0xFFFE0C00) == (readBE32(data + length) & 0xFFFE0C00);
+}
+
+/**
+ * Function verifies MP3 file: audio data has to consist only of valid frames following each other without gaps
+ *
+ * @param[in]  reader  Reader of the file
+ * @param[out] damage  Damage found in the file
+ *
+ * @return Result of verification
+ */
+static MediaLibCleaner::IntegrityStatus verifyMPEG(MediaLibCleaner::SequentialReader *reader, MediaLibCleaner::Damage *damage)
+{
+	skipID3v2(reader);
+	unsigned long long end = trailingTagsStart(reader, reader->GetPosition());
+
+	// padding of ID3v2 tag not counted into its size is not damage
+	while (reader->GetPosition() < end)
+	{
+		size_t available = reader->Fill(1);
+		if (available == 0 || reader->GetData()[0] != 0) break;
+
+		const unsigned char *data = reader->GetData();
+		size_t zeros = 0;
+		while (zeros < available && data[zeros] == 0) zeros++;
+
+		reader->Skip(std::min<unsigned long long>(zeros, end - reader->GetPosition()));
+	}
+
+	size_t frames = 0;
+
+	while (reader->GetPosition() < end && damage->problems < MAX_PROBLEMS)
+	{
+		unsigned long long offset = reader->GetPosition();
+		size_t available = reader->Fill(4);
+
+		int length = (available >= 4 && end - offset >= 4) ? mpegFrameLength(reader->GetData()) : 0;
+
+		if (length < 0)
+		{
+			// length of free format frames is not stored anywhere
+			if (frames == 0 && damage->problems == 0) return MediaLibCleaner::INTEGRITY_UNKNOWN;
+			length = 0;
+		}
+
+		if (length == 0)
+		{
+			addProblem(damage, offset, frames == 0 ? L"No MPEG audio frame at the beginning of audio data" : L"Lost frame sync (data between frames)");
+			if (!skipUntil(reader, end, 4, isMPEGFrame)) break;
+			continue;
+		}
+
+		if (end - offset < static_cast<unsigned long long>(length))
+		{
+			addProblem(damage, offset, L"Truncated frame (file ends inside of the frame)");
+			break;
+		}
+
+		available = reader->Fill(length);
+		if (available < static_cast<size_t>(length))
+		{
+			addProblem(damage, offset, L"Truncated frame (file ends inside of the frame)");
+			break;
+		}
+
+		if (!checkMPEGCRC(reader->GetData(), length))
+			addProblem(damage, offset, L"Wrong CRC of frame");
+
+		reader->Skip(length);
+		frames++;
+	}
+
+	if (frames == 0 && damage->problems == 0)
+		addProblem(damage, reader->GetPosition(), L"No MPEG audio frames found");
+
+	return damage->problems > 0 ? MediaLibCleaner::INTEGRITY_DAMAGED : MediaLibCleaner::INTEGRITY_INTACT;
+}
+
+
+
+
+/**
+ * Stream parameters from STREAMINFO block of FLAC file
+ */
+struct FLACInfo
+{
+	unsigned int max_blocksize = 0;
+	unsigned int samplerate = 0;
+	unsigned int channels = 0;
+	unsigned int bits_per_sample = 0;
+	unsigned long long total_samples = 0;
+	unsigned char md5[16];
+};
+
+/**
+ * Header of FLAC frame
+ */
+struct FLACFrameHeader
+{
+	unsigned int blocksize = 0;
+	unsigned int channel_assignment = 0; ///< 0-7: independent channels, 8: left/side, 9: side/right, 10: mid/side
+	unsigned int channels = 0;
+	unsigned int bits_per_sample = 0;
+	size_t length = 0; ///< Length of the header with its CRC-8
+};
+
+/**
+ * Reader of bits of FLAC frame; bits are read from the most significant one through 64-bit cache
+ */
+struct BitReader
+{
+	const unsigned char *data;
+	size_t size;
+	size_t next = 0; ///< Next byte to be loaded into cache
+	unsigned long long cache = 0; ///< Bits not read yet, aligned to the most significant bit
+	int bits = 0; ///< Amount of bits in cache
+	unsigned long long consumed = 0; ///< Amount of bits read so far (more than size * 8 if data was overrun)
+};
+
+/**
+ * Function returns amount of leading zero bits of non-zero number
+ *
+ * @param[in] value  Number (not 0)
+ *
+ * @return Amount of leading zero bits
+ */
+static int countLeadingZeros(unsigned long long value)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	if (_BitScanReverse(&index, static_cast<unsigned long>(value >> 32))) return 31 - static_cast<int>(index);
+	_BitScanReverse(&index, static_cast<unsigned long>(value));
+	return 63 - static_cast<int>(index);
+#else
+	return __builtin_clzll(value);
+#endif
+}
+
+/**
+ * Function fills cache of bit reader (at least 57 bits; zeros are loaded after the end of data)
+ *
+ * @param[in,out] reader  Bit reader
+ */
+static void refill(BitReader *reader)
+{
+	while (reader->bits <= 56)
+	{
+		if (reader->next < reader->size)
+			reader->cache |= static_cast<unsigned long long>(reader->data[reader->next]) << (56 - reader->bits);
+		reader->next++;
+		reader->bits += 8;
+	}
+}
+
+/**
+ * Function reads unsigned number
+ *
+ * @param[in,out] reader  Bit reader
+ * @param[in]     count   Amount of bits (0-56)
+ *
+ * @return Number
+ */
+static unsigned long long readBits(BitReader *reader, int count)
+{
+	if (count == 0) return 0;
+	if (reader->bits < count) refill(reader);
+
+	unsigned long long value = reader->cache >> (64 - count);
+	reader->cache <<= count;
+	reader->bits -= count;
+	reader->consumed += count;
+
+	return value;
+}
+
+/**
+ * Function reads signed (two's complement) number
+ *
+ * @param[in,out] reader  Bit reader
+ * @param[in]     count   Amount of bits (0-56)
+ *
+ * @return Number
+ */
+static long long readSigned(BitReader *reader, int count)
+{
+	if (count == 0) return 0;
+
+	unsigned long long value = readBits(reader, count);
+	if (value >> (count - 1)) return static_cast<long long>(value) - (1LL << count);
+	return static_cast<long long>(value);
+}
+
+/**
+ * Function reads unary coded number (amount of zero bits before the first one bit)
+ *
+ * @param[in,out] reader  Bit reader
+ *
+ * @return Number (reading stops at the end of data)
+ */
+static unsigned int readUnary(BitReader *reader)
+{
+	unsigned int count = 0;
+
+	for (;;)
+	{
+		if (reader->bits == 0) refill(reader);
+
+		if (reader->cache == 0)
+		{
+			count += reader->bits;
+			reader->consumed += reader->bits;
+			reader->bits = 0;
+
+			if (reader->consumed > static_cast<unsigned long long>(reader->size) * 8) return count;
+			continue;
+		}
+
+		int zeros = countLeadingZeros(reader->cache);
+		count += zeros;
+		reader->cache <<= zeros;
+		reader->cache <<= 1;
+		reader->bits -= zeros + 1;
+		reader->consumed += zeros + 1;
+
+		return count;
+	}
+}
+
+/**
+ * Function reads STREAMINFO block of FLAC file
+ *
+ * @param[in]  data  Data of the block (34 bytes)
+ * @param[out] info  Stream parameters
+ */
+static void readFLACInfo(const unsigned char *data, FLACInfo *info)
+{
+	info->max_blocksize = readBE16(data + 2);
+	info->samplerate = (readBE24(data + 10) >> 4);
+	info->channels = ((data[12] >> 1) & 0x07) + 1;
+	info->bits_per_sample = (((data[12] & 0x01) << 4) | (data[13] >> 4)) + 1;
+	info->total_samples = (static_cast<unsigned long long>(data[13] & 0x0F) << 32) | readBE32(data + 14);
+	memcpy(info->md5, data + 18, 16);
+}
+
+/**
+ * Function reads FLAC frame header and checks its CRC-8
+ *
+ * @param[in]  data       Beginning of the frame
+ * @param[in]  available  Amount of bytes available
+ * @param[in]  info       Stream parameters
+ * @param[out] header     Header of the frame
+ *
+ * @return True if header is valid
+ */
+static bool readFLACFrameHeader(const unsigned char *data, size_t available, const FLACInfo &info, FLACFrameHeader *header)
+{
+	static const unsigned int sample_sizes[8] = { 0, 8, 12, 0, 16, 20, 24, 32 };
+
+	if (available < 6 || data[0] != 0xFF || (data[1] & 0xFE) != 0xF8) return false;
+
+	unsigned int block_code = data[2] >> 4;
+	unsigned int rate_code = data[2] & 0x0F;
+	unsigned int channel_code = data[3] >> 4;
+	unsigned int size_code = (data[3] >> 1) & 0x07;
+
+	if (block_code == 0 || rate_code == 15 || channel_code > 10 || size_code == 3 || (data[3] & 0x01)) return false;
+
+	// frame or sample number coded like UTF-8 character
+	size_t position = 4;
+	unsigned char first = data[position++];
+	int extra;
+	if (first < 0x80) extra = 0;
+	else if ((first & 0xE0) == 0xC0) extra = 1;
+	else if ((first & 0xF0) == 0xE0) extra = 2;
+	else if ((first & 0xF8) == 0xF0) extra = 3;
+	else if ((first & 0xFC) == 0xF8) extra = 4;
+	else if ((first & 0xFE) == 0xFC) extra = 5;
+	else if (first == 0xFE) extra = 6;
+	else return false;
+
+	for (int i = 0; i < extra; i++, position++)
+	{
+		if (position >= available || (data[position] & 0xC0) != 0x80) return false;
+	}
+
+	if (block_code == 1) header->blocksize = 192;
+	else if (block_code <= 5) header->blocksize = 576 << (block_code - 2);
+	else if (block_code >= 8) header->blocksize = 256 << (block_code - 8);
+	else if (block_code == 6)
+	{
+		if (position + 1 > available) return false;
+		header->blocksize = data[position] + 1;
+		position += 1;
+	}
+	else
+	{
+		if (position + 2 > available) return false;
+		header->blocksize = readBE16(data + position) + 1;
+		position += 2;
+	}
+
+	if (rate_code == 12) position += 1;
+	else if (rate_code == 13 || rate_code == 14) position += 2;
+
+	if (position >= available || crc8(data, position) != data[position]) return false;
+
+	header->channel_assignment = channel_code;
+	header->channels = (channel_code < 8) ? channel_code + 1 : 2;
+	header->bits_per_sample = (size_code == 0) ? info.bits_per_sample : sample_sizes[size_code];
+	header->length = position + 1;
+
+	return true;
+}
+
+/**
+ * Function reads residual of FLAC subframe and stores it after warm-up samples
+ *
+ * @param[in,out] reader     Bit reader
+ * @param[in]     blocksize  Amount of samples in the subframe
+ * @param[in]     order      Order of predictor (amount of warm-up samples)
+ * @param[out]    samples    Samples of the subframe
+ *
+ * @return True if residual is valid
+ */
+static bool readFLACResidual(BitReader *reader, unsigned int blocksize, unsigned int order, long long *samples)
+{
+	unsigned int method = static_cast<unsigned int>(readBits(reader, 2));
+	if (method > 1) return false;
+
+	int parameter_bits = (method == 0) ? 4 : 5;
+	unsigned int escape = (method == 0) ? 15 : 31;
+	unsigned int partition_order = static_cast<unsigned int>(readBits(reader, 4));
+	unsigned int partition_samples = blocksize >> partition_order;
+
+	if ((partition_samples << partition_order) != blocksize || partition_samples < order) return false;
+
+	long long *sample = samples + order;
+	unsigned long long limit = static_cast<unsigned long long>(reader->size) * 8;
+
+	for (unsigned int partition = 0; partition < (1U << partition_order); partition++)
+	{
+		unsigned int count = partition_samples - (partition == 0 ? order : 0);
+		unsigned int parameter = static_cast<unsigned int>(readBits(reader, parameter_bits));
+
+		if (parameter == escape)
+		{
+			int bits = static_cast<int>(readBits(reader, 5));
+			for (unsigned int i = 0; i < count; i++)
+				*sample++ = readSigned(reader, bits);
+		}
+		else
+		{
+			for (unsigned int i = 0; i < count; i++)
+			{
+				unsigned long long value = (static_cast<unsigned long long>(readUnary(reader)) << parameter) | readBits(reader, parameter);
+				*sample++ = static_cast<long long>(value >> 1) ^ -static_cast<long long>(value & 1);
+			}
+		}
+
+		if (reader->consumed > limit) return false;
+	}
+
+	return true;
+}
+
+/**
+ * Function decodes single subframe of FLAC frame
+ *
+ * @param[in,out] reader           Bit reader
+ * @param[in]     blocksize        Amount of samples in the subframe
+ * @param[in]     bits_per_sample  Bits per sample of the subframe (one more for side channel)
+ * @param[out]    samples          Decoded samples
+ *
+ * @return True if subframe is valid
+ */
+static bool decodeFLACSubframe(BitReader *reader, unsigned int blocksize, int bits_per_sample, long long *samples)
+{
+	if (readBits(reader, 1) != 0) return false;
+
+	unsigned int type = static_cast<unsigned int>(readBits(reader, 6));
+
+	int wasted = 0;
+	if (readBits(reader, 1)) wasted = static_cast<int>(readUnary(reader)) + 1;
+
+	int bits = bits_per_sample - wasted;
+	if (bits <= 0) return false;
+
+	if (type == 0)
+	{
+		long long value = readSigned(reader, bits);
+		for (unsigned int i = 0; i < blocksize; i++)
+			samples[i] = value;
+	}
+	else if (type == 1)
+	{
+		for (unsigned int i = 0; i < blocksize; i++)
+			samples[i] = readSigned(reader, bits);
+	}
+	else if (type >= 8 && type <= 12)
+	{
+		unsigned int order = type - 8;
+		if (order > blocksize) return false;
+
+		for (unsigned int i = 0; i < order; i++)
+			samples[i] = readSigned(reader, bits);
+
+		if (!readFLACResidual(reader, blocksize, order, samples)) return false;
+
+		switch (order)
+		{
+		case 1:
+			for (unsigned int i = 1; i < blocksize; i++)
+				samples[i] += samples[i - 1];
+			break;
+		case 2:
+			for (unsigned int i = 2; i < blocksize; i++)
+				samples[i] += 2 * samples[i - 1] - samples[i - 2];
+			break;
+		case 3:
+			for (unsigned int i = 3; i < blocksize; i++)
+				samples[i] += 3 * samples[i - 1] - 3 * samples[i - 2] + samples[i - 3];
+			break;
+		case 4:
+			for (unsigned int i = 4; i < blocksize; i++)
+				samples[i] += 4 * samples[i - 1] - 6 * samples[i - 2] + 4 * samples[i - 3] - samples[i - 4];
+			break;
+		}
+	}
+	else if (type >= 32)
+	{
+		unsigned int order = type - 31;
+		if (order > blocksize) return false;
+
+		for (unsigned int i = 0; i < order; i++)
+			samples[i] = readSigned(reader, bits);
+
+		int precision = static_cast<int>(readBits(reader, 4)) + 1;
+		int shift = static_cast<int>(readSigned(reader, 5));
+		if (precision == 16 || shift < 0) return false;
+
+		long long coefficients[32];
+		for (unsigned int i = 0; i < order; i++)
+			coefficients[i] = readSigned(reader, precision);
+
+		if (!readFLACResidual(reader, blocksize, order, samples)) return false;
+
+		for (unsigned int i = order; i < blocksize; i++)
+		{
+			long long sum = 0;
+			for (unsigned int j = 0; j < order; j++)
+				sum += coefficients[j] * samples[i - 1 - j];
+			samples[i] += sum >> shift;
+		}
+	}
+	else
+	{
+		return false;
+	}
+
+	if (wasted > 0)
+	{
+		for (unsigned int i = 0; i < blocksize; i++)
+			samples[i] <<= wasted;
+	}
+
+	return reader->consumed <= static_cast<unsigned long long>(reader->size) * 8;
+}
+
+/**
+ * Function decodes FLAC frame and checks its CRC-16
+ *
+ * @param[in]  data       Beginning of the frame
+ * @param[in]  available  Amount of bytes available (frame may be shorter)
+ * @param[in]  info       Stream parameters
+ * @param[out] header     Header of the frame
+ * @param[out] samples    Decoded samples (header->blocksize samples of every channel)
+ * @param[out] length     Length of the frame in bytes
+ *
+ * @return Empty string if frame is valid, description of the problem otherwise
+ */
+static std::wstring decodeFLACFrame(const unsigned char *data, size_t available, const FLACInfo &info, FLACFrameHeader *header, std::vector<long long> *samples, size_t *length)
+{
+	if (available < 2 || data[0] != 0xFF || (data[1] & 0xFE) != 0xF8) return L"Lost frame sync (frame header expected)";
+	if (!readFLACFrameHeader(data, available, info, header)) return L"Invalid frame header or wrong CRC of frame header";
+	if (header->channels != info.channels || header->bits_per_sample != info.bits_per_sample) return L"Frame format does not match STREAMINFO";
+
+	BitReader reader;
+	reader.data = data + header->length;
+	reader.size = available - header->length;
+
+	for (unsigned int channel = 0; channel < header->channels; channel++)
+	{
+		int bits = header->bits_per_sample;
+		if ((header->channel_assignment == 8 && channel == 1) || (header->channel_assignment == 9 && channel == 0) || (header->channel_assignment == 10 && channel == 1)) bits++;
+
+		if (samples[channel].size() < header->blocksize) samples[channel].resize(header->blocksize);
+
+		if (!decodeFLACSubframe(&reader, header->blocksize, bits, samples[channel].data()))
+			return (reader.consumed > static_cast<unsigned long long>(reader.size) * 8) ? L"Truncated frame" : L"Invalid subframe";
+	}
+
+	size_t frame_length = header->length + static_cast<size_t>((reader.consumed + 7) / 8);
+	if (frame_length + 2 > available) return L"Truncated frame";
+	if (crc16(data, frame_length, 0) != readBE16(data + frame_length)) return L"Wrong CRC of frame";
+
+	long long *first = samples[0].data();
+	long long *second = (header->channels > 1) ? samples[1].data() : nullptr;
+
+	switch (header->channel_assignment)
+	{
+	case 8: // left/side
+		for (unsigned int i = 0; i < header->blocksize; i++)
+			second[i] = first[i] - second[i];
+		break;
+	case 9: // side/right
+		for (unsigned int i = 0; i < header->blocksize; i++)
+			first[i] += second[i];
+		break;
+	case 10: // mid/side
+		for (unsigned int i = 0; i < header->blocksize; i++)
+		{
+			long long mid = (first[i] << 1) | (second[i] & 1);
+			first[i] = (mid + second[i]) >> 1;
+			second[i] = (mid - second[i]) >> 1;
+		}
+		break;
+	}
+
+	*length = frame_length + 2;
+	return std::wstring();
+}
+
+/**
+ * Function verifies FLAC file: every frame has to have correct checksums and MD5 of all decoded samples has to be the same as in STREAMINFO
+ *
+ * @param[in]  reader  Reader of the file
+ * @param[out] damage  Damage found in the file
+ *
+ * @return Result of verification
+ */
+static MediaLibCleaner::IntegrityStatus verifyFLAC(MediaLibCleaner::SequentialReader *reader, MediaLibCleaner::Damage *damage)
+{
+	skipID3v2(reader);
+	unsigned long long end = trailingTagsStart(reader, reader->GetPosition());
+
+	if (reader->Fill(4) < 4 || memcmp(reader->GetData(), "fLaC", 4) != 0)
+	{
+		addProblem(damage, reader->GetPosition(), L"No FLAC stream marker");
+		return MediaLibCleaner::INTEGRITY_DAMAGED;
+	}
+	reader->Skip(4);
+
+	// metadata blocks
+	FLACInfo info;
+	bool found_info = false;
+	bool last = false;
+
+	while (!last)
+	{
+		unsigned long long offset = reader->GetPosition();
+		if (reader->Fill(4) < 4 || end - offset < 4)
+		{
+			addProblem(damage, offset, L"Truncated metadata block");
+			return MediaLibCleaner::INTEGRITY_DAMAGED;
+		}
+
+		const unsigned char *block = reader->GetData();
+		last = (block[0] & 0x80) != 0;
+		unsigned int type = block[0] & 0x7F;
+		unsigned int length = readBE24(block + 1);
+
+		if (end - offset - 4 < length)
+		{
+			addProblem(damage, offset, L"Truncated metadata block");
+			return MediaLibCleaner::INTEGRITY_DAMAGED;
+		}
+
+		if (type == 0)
+		{
+			if (length < 34 || reader->Fill(4 + 34) < 4 + 34)
+			{
+				addProblem(damage, offset, L"Invalid STREAMINFO block");
+				return MediaLibCleaner::INTEGRITY_DAMAGED;
+			}
+
+			readFLACInfo(reader->GetData() + 4, &info);
+			found_info = true;
+		}
+		else if (type == 127)
+		{
+			addProblem(damage, offset, L"Invalid metadata block");
+			return MediaLibCleaner::INTEGRITY_DAMAGED;
+		}
+
+		reader->Skip(4 + static_cast<unsigned long long>(length));
+	}
+
+	if (!found_info)
+	{
+		addProblem(damage, reader->GetPosition(), L"No STREAMINFO block");
+		return MediaLibCleaner::INTEGRITY_DAMAGED;
+	}
+
+	// no encoder writes frames longer than verbatim ones
+	unsigned int max_blocksize = (info.max_blocksize > 0) ? info.max_blocksize : 65535;
+	size_t max_frame = static_cast<size_t>(max_blocksize) * info.channels * (info.bits_per_sample + 1) / 8 + info.channels * 8 + 32;
+
+	static const unsigned char empty_md5[16] = { 0 };
+	bool check_md5 = memcmp(info.md5, empty_md5, 16) != 0;
+	MediaLibCleaner::MD5 md5;
+
+	std::vector<long long> samples[8];
+	std::vector<unsigned char> pcm;
+	unsigned int bytes_per_sample = (info.bits_per_sample + 7) / 8;
+	unsigned long long decoded = 0;
+
+	while (reader->GetPosition() < end && damage->problems < MAX_PROBLEMS)
+	{
+		unsigned long long offset = reader->GetPosition();
+		size_t available = reader->Fill(max_frame);
+		if (available > end - offset) available = static_cast<size_t>(end - offset);
+
+		FLACFrameHeader header;
+		size_t length = 0;
+		std::wstring problem = decodeFLACFrame(reader->GetData(), available, info, &header, samples, &length);
+
+		if (!problem.empty())
+		{
+			addProblem(damage, offset, problem);
+			if (!skipUntil(reader, end, 16, [&info](const unsigned char *data, size_t size) { FLACFrameHeader next; return readFLACFrameHeader(data, size, info, &next); })) break;
+			continue;
+		}
+
+		// MD5 covers interleaved little-endian samples
+		if (check_md5 && damage->problems == 0)
+		{
+			pcm.resize(static_cast<size_t>(header.blocksize) * header.channels * bytes_per_sample);
+			unsigned char *out = pcm.data();
+
+			for (unsigned int i = 0; i < header.blocksize; i++)
+			{
+				for (unsigned int channel = 0; channel < header.channels; channel++)
+				{
+					long long value = samples[channel][i];
+					for (unsigned int b = 0; b < bytes_per_sample; b++)
+						*out++ = static_cast<unsigned char>(value >> (8 * b));
+				}
+			}
+
+			md5.Update(pcm.data(), pcm.size());
+		}
+
+		decoded += header.blocksize;
+		reader->Skip(length);
+	}
+
+	if (damage->problems == 0 && info.total_samples > 0 && decoded != info.total_samples)
+		addProblem(damage, reader->GetPosition(), L"Missing samples (" + std::to_wstring(info.total_samples) + L" expected, " + std::to_wstring(decoded) + L" found)");
+
+	if (damage->problems == 0 && check_md5)
+	{
+		unsigned char digest[16];
+		md5.Final(digest);
+
+		if (memcmp(digest, info.md5, 16) != 0)
+			addProblem(damage, 0, L"MD5 of decoded audio does not match STREAMINFO");
+	}
+
+	return damage->problems > 0 ? MediaLibCleaner::INTEGRITY_DAMAGED : MediaLibCleaner::INTEGRITY_INTACT;
+}
+
+/**
+ * Function verifies whole audio file (reader has to be at the beginning of the file)
+ *
+ * @param[in]  reader  Reader of the file
+ * @param[in]  type    Type of the file
+ * @param[out] damage  Damage found in the file
+ *
+ * @return Result of verification (INTEGRITY_UNKNOWN for MP4 files)
+ */
+MediaLibCleaner::IntegrityStatus MediaLibCleaner::VerifyFile(SequentialReader *reader, FileType type, Damage *damage)
+{
+	switch (type)
+	{
+	case FILETYPE_MP3:
+		return verifyMPEG(reader, damage);
+	case FILETYPE_OGG:
+		return verifyOgg(reader, damage);
+	case FILETYPE_FLAC:
+		return verifyFLAC(reader, damage);
+	default:
+		return INTEGRITY_UNKNOWN;
+	}
+}
+
+
+
+
+/**
+ * MediaLibCleaner::IntegrityVerifier constructor
+ *
+ * @param[in] logprogram  std::unique_ptr to MediaLibCleaner::LogProgram object for logging purposes
+ * @param[in] logalert    std::unique_ptr to MediaLibCleaner::LogAlert object for logging purposes
+ */
+MediaLibCleaner::IntegrityVerifier::IntegrityVerifier(std::unique_ptr<MediaLibCleaner::LogProgram>* logprogram, std::unique_ptr<MediaLibCleaner::LogAlert>* logalert)
+{
+	this->logprogram = logprogram;
+	this->logalert = logalert;
+}
+
+/**
+ * Method adds file to be verified (files which are not audio files are ignored)
+ *
+ * @param[in] file  File to verify
+ */
+void MediaLibCleaner::IntegrityVerifier::AddFile(MediaLibCleaner::File *file)
+{
+	if (!file->IsInitiated()) return;
+
+	Entry entry;
+	entry.file = file;
+	this->entries.push_back(entry);
+}
+
+/**
+ * Method verifies all added files and sets result of verification in every file.
+ * Files are verified on their own pool of threads: verification is limited by disk rather than by CPU, so it usually needs less threads than the scripts.
+ *
+ * @param[in] threads  Amount of threads (0 - one per processor)
+ *
+ * @return Amount of damaged files
+ */
+size_t MediaLibCleaner::IntegrityVerifier::Run(int threads)
+{
+	this->verified = 0;
+	this->damaged = 0;
+	this->bytes_read = 0;
+
+	if (threads <= 0) threads = omp_get_num_procs();
+
+	int count = static_cast<int>(this->entries.size());
+	unsigned long long bytes = 0;
+
+	#pragma omp parallel num_threads(threads) reduction(+:bytes)
+	{
+		// buffer of the reader is reused by all files of the thread
+		SequentialReader reader;
+
+		#pragma omp for schedule(dynamic)
+		for (int i = 0; i < count; i++)
+		{
+			Entry &entry = this->entries[i];
+
+			if (!reader.Open(entry.file->GetPath()))
+			{
+				(*this->logprogram)->Log(L"MediaLibCleaner::IntegrityVerifier(" + entry.file->GetPath() + L")", L"File could not be opened, it is not verified", 2);
+				continue;
+			}
+
+			entry.status = VerifyFile(&reader, entry.file->GetFileType(), &entry.damage);
+			bytes += reader.GetBytesRead();
+			reader.Close();
+
+			if (entry.status == INTEGRITY_DAMAGED)
+				(*this->logalert)->Log(L"MediaLibCleaner::IntegrityVerifier(" + entry.file->GetPath() + L")", L"File is damaged: " + entry.damage.description + L" at offset " + std::to_wstring(entry.damage.offset));
+		}
+	}
+
+	for (size_t i = 0; i < this->entries.size(); i++)
+	{
+		this->entries[i].file->SetIntegrity(this->entries[i].status);
+
+		if (this->entries[i].status != INTEGRITY_UNKNOWN) this->verified++;
+		if (this->entries[i].status == INTEGRITY_DAMAGED) this->damaged++;
+	}
+
+	this->bytes_read = bytes;
+
+	(*this->logprogram)->Log(L"MediaLibCleaner::IntegrityVerifier", L"Verified " + std::to_wstring(this->verified) + L" files (" + std::to_wstring(this->bytes_read) + L" bytes read), " + std::to_wstring(this->damaged) + L" damaged files found", 3);
+
+	return this->damaged;
+}
+
+/**
+ * Method writes report of all damaged files found by Run()
+ *
+ * @param[in] path  Path to the report file ("-" for standard output)
+ *
+ * @return True if report was written
+ */
+bool MediaLibCleaner::IntegrityVerifier::WriteReport(const std::wstring &path)
+{
+	boost::filesystem::wofstream file;
+	std::wostream *output = &std::wcout;
+
+	if (path != L"-")
+	{
+		file.open(boost::filesystem::path(path));
+		if (!file.is_open())
+		{
+			(*this->logprogram)->Log(L"MediaLibCleaner::IntegrityVerifier", L"Report file could not be opened: " + path, 1);
+			return false;
+		}
+
+		file.imbue(std::locale(std::locale::classic(), new std::codecvt_utf8<wchar_t>));
+		output = &file;
+	}
+
+	std::vector<const Entry*> damaged_entries;
+	for (size_t i = 0; i < this->entries.size(); i++)
+	{
+		if (this->entries[i].status == INTEGRITY_DAMAGED) damaged_entries.push_back(&this->entries[i]);
+	}
+	std::sort(damaged_entries.begin(), damaged_entries.end(), [](const Entry *a, const Entry *b) { return a->file->GetPath() < b->file->GetPath(); });
+
+	*output << L"Damaged files: " << damaged_entries.size() << L" of " << this->verified << L" verified" << std::endl;
+
+	for (size_t i = 0; i < damaged_entries.size(); i++)
+	{
+		const Damage &damage = damaged_entries[i]->damage;
+
+		*output << std::endl << damaged_entries[i]->file->GetPath() << std::endl;
+		*output << L"\t" << damage.description << L" at offset " << damage.offset;
+		if (damage.problems > 1)
+			*output << L" (" << damage.problems << (damage.problems >= MAX_PROBLEMS ? L" or more" : L"") << L" problems in total)";
+		*output << std::endl;
+	}
+
+	return output->good();
+}
+
+/**
+ * Method returns amount of files verified by the last Run() (files of not supported formats are not counted)
+ *
+ * @return Amount of files
+ */
+size_t MediaLibCleaner::IntegrityVerifier::GetVerified()
+{
+	return this->verified;
+}
+
+/**
+ * Method returns amount of damaged files found by the last Run()
+ *
+ * @return Amount of files
+ */
+size_t MediaLibCleaner::IntegrityVerifier::GetDamaged()
+{
+	return this->damaged;
+}
+
+/**
+ * Method returns amount of bytes read by the last Run()
+ *
+ * @return Amount of bytes
+ */
+unsigned long long MediaLibCleaner::IntegrityVerifier::GetBytesRead()
+{
+	return this->bytes_read;
+}
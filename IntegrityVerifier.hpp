@@ -0,0 +1,201 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * File contains declarations of integrity verifier - detection of damaged audio files (Ogg page checksums, MPEG frame sync, FLAC frame checksums and MD5 of decoded audio)
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "MediaLibCleaner.hpp"
+
+namespace MediaLibCleaner
+{
+	/**
+	 * @class SequentialReader IntegrityVerifier.hpp
+	 *
+	 * @brief Class MediaLibCleaner::SequentialReader reads file from the beginning to the end in large chunks.
+	 * Operating system is told the file is read sequentially (read-ahead) and that its pages will not be needed again,
+	 * so reading whole library does not push everything else out of the disk cache.
+	 */
+	class SequentialReader
+	{
+	public:
+		SequentialReader();
+		~SequentialReader();
+
+		bool Open(const std::wstring &path);
+		void Close();
+
+		size_t Fill(size_t length);
+		const unsigned char* GetData();
+		void Skip(unsigned long long length);
+		bool ReadAt(unsigned long long offset, unsigned char *data, size_t length);
+
+		unsigned long long GetPosition();
+		unsigned long long GetSize();
+		unsigned long long GetBytesRead();
+
+	protected:
+		/**
+		 * Buffered data (valid bytes are between start and end)
+		 */
+		std::vector<unsigned char> buffer;
+
+		/**
+		 * Index of the byte in buffer at current position
+		 */
+		size_t start = 0;
+
+		/**
+		 * Index of the first byte after buffered data
+		 */
+		size_t end = 0;
+
+		/**
+		 * Current position in the file
+		 */
+		unsigned long long position = 0;
+
+		/**
+		 * Size of the file in bytes
+		 */
+		unsigned long long size = 0;
+
+		/**
+		 * Amount of bytes read from the file so far
+		 */
+		unsigned long long bytes_read = 0;
+
+#ifdef _WIN32
+		/**
+		 * Handle of the file (HANDLE)
+		 */
+		void *file = nullptr;
+#else
+		/**
+		 * Descriptor of the file (-1 if file is not open)
+		 */
+		int file = -1;
+#endif
+
+		size_t readRaw(unsigned long long offset, unsigned char *data, size_t length);
+	};
+
+	/**
+	 * @class MD5 IntegrityVerifier.hpp
+	 *
+	 * @brief Class MediaLibCleaner::MD5 computes MD5 digest of data given in any amount of parts (used to check decoded audio of FLAC files).
+	 */
+	class MD5
+	{
+	public:
+		MD5();
+
+		void Update(const unsigned char *data, size_t length);
+		void Final(unsigned char digest[16]);
+
+	protected:
+		/**
+		 * State of the digest (A, B, C, D)
+		 */
+		unsigned int state[4];
+
+		/**
+		 * Data not processed yet (less than one block of 64 bytes)
+		 */
+		unsigned char buffer[64];
+
+		/**
+		 * Amount of bytes in buffer
+		 */
+		size_t buffered = 0;
+
+		/**
+		 * Amount of all bytes given to the digest
+		 */
+		unsigned long long total = 0;
+
+		void processBlock(const unsigned char *block);
+	};
+
+	/**
+	 * @brief Structure describing damage found in the file
+	 */
+	struct Damage
+	{
+		size_t problems = 0; ///< Amount of problems found
+		unsigned long long offset = 0; ///< Offset of the first problem from the beginning of the file
+		std::wstring description; ///< Description of the first problem
+	};
+
+	IntegrityStatus VerifyFile(SequentialReader *reader, FileType type, Damage *damage);
+
+	/**
+	 * @class IntegrityVerifier IntegrityVerifier.hpp
+	 *
+	 * @brief Class MediaLibCleaner::IntegrityVerifier reads whole audio data of audio files and checks it is not damaged.
+	 *
+	 * Checks depend on the format: Ogg - checksum and sequence number of every page and presence of the last page,
+	 * MP3 - every frame has to follow the previous one without gaps (CRC of Layer III side info is checked if present),
+	 * FLAC - checksums of every frame header and frame and MD5 of all decoded samples compared with the one in STREAMINFO.
+	 * MP4 files are not verified. Result of every file is available as MediaLibCleaner::File::GetIntegrity().
+	 */
+	class IntegrityVerifier
+	{
+	public:
+		IntegrityVerifier(std::unique_ptr<LogProgram>*, std::unique_ptr<LogAlert>*);
+
+		void AddFile(File*);
+		size_t Run(int threads);
+		bool WriteReport(const std::wstring &path);
+
+		size_t GetVerified();
+		size_t GetDamaged();
+		unsigned long long GetBytesRead();
+
+	protected:
+		/**
+		 * @brief Structure describing single file verified by MediaLibCleaner::IntegrityVerifier
+		 */
+		struct Entry
+		{
+			File *file; ///< Verified file
+			IntegrityStatus status = INTEGRITY_UNKNOWN; ///< Result of verification
+			Damage damage; ///< Damage found in the file
+		};
+
+		/**
+		 * All audio files added to the verifier
+		 */
+		std::vector<Entry> entries;
+
+		/**
+		 * Amount of files verified by the last Run()
+		 */
+		size_t verified = 0;
+
+		/**
+		 * Amount of damaged files found by the last Run()
+		 */
+		size_t damaged = 0;
+
+		/**
+		 * Amount of bytes read by the last Run()
+		 */
+		unsigned long long bytes_read = 0;
+
+		/**
+		 * std::unique_ptr to MediaLibCleaner::LogAlert object for logging purposes
+		 */
+		std::unique_ptr<LogAlert>* logalert;
+
+		/**
+		 * std::unique_ptr to MediaLibCleaner::LogProgram object for logging purposes
+		 */
+		std::unique_ptr<LogProgram>* logprogram;
+	};
+}
@@ -0,0 +1,399 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * This file contains definitions of all methods of classes storing metadata of all files in the library
+ */
+
+#include "LibraryStore.hpp"
+
+
+/**
+ * Information which text columns are interned - titles, comments, lyrics, file names etc. are mostly unique
+ */
+const bool MediaLibCleaner::LibraryStore::interned[MediaLibCleaner::STRING_COLUMNS_COUNT] = {
+	true, // COLUMN_ARTIST
+	false, // COLUMN_TITLE
+	true, // COLUMN_ALBUM
+	true, // COLUMN_GENRE
+	false, // COLUMN_COMMENT
+	true, // COLUMN_TRACK
+	true, // COLUMN_YEAR
+	true, // COLUMN_ALBUMARTIST
+	true, // COLUMN_BPM
+	true, // COLUMN_COPYRIGHT
+	true, // COLUMN_LANGUAGE
+	false, // COLUMN_LENGTH
+	true, // COLUMN_MOOD
+	true, // COLUMN_ORIGALBUM
+	true, // COLUMN_ORIGARTIST
+	false, // COLUMN_ORIGFILENAME
+	true, // COLUMN_ORIGYEAR
+	true, // COLUMN_PUBLISHER
+	false, // COLUMN_UNSYNCEDLYRICS
+	true, // COLUMN_WWW
+	true, // COLUMN_CODEC
+	true, // COLUMN_COVER_MIMETYPE
+	true, // COLUMN_COVER_TYPE
+	false // COLUMN_FILENAME
+};
+
+/**
+ * Returns amount of memory taken by given string kept in std::wstring object (approximately)
+ *
+ * @param[in] s  String
+ *
+ * @return Amount of bytes
+ */
+static uintmax_t stringBytes(const std::wstring &s)
+{
+	return sizeof(std::wstring) + (s.empty() ? 0 : (s.length() + 1) * sizeof(wchar_t));
+}
+
+
+
+
+/**
+ * MediaLibCleaner::StringInterner constructor.
+ */
+MediaLibCleaner::StringInterner::StringInterner()
+{
+}
+
+/**
+ * MediaLibCleaner::StringInterner destructor.
+ */
+MediaLibCleaner::StringInterner::~StringInterner()
+{
+}
+
+/**
+ * Method returns identifier of given string, storing the string if it was not seen before.
+ * Empty string is always identified by 0.
+ *
+ * @param[in] value  String to be interned
+ *
+ * @return Identifier of the string
+ */
+unsigned int MediaLibCleaner::StringInterner::Intern(const std::wstring &value)
+{
+	if (value.empty()) return 0;
+
+	unsigned int shard = static_cast<unsigned int>(PointerHash()(value.c_str())) & (SHARDS - 1);
+	Shard &s = this->shards[shard];
+
+	s.synch.lock();
+
+	unsigned int index;
+	auto it = s.ids.find(value.c_str());
+	if (it != s.ids.end())
+	{
+		index = it->second;
+	}
+	else
+	{
+		index = static_cast<unsigned int>(s.count);
+		const wchar_t *copy = this->arena.Copy(value);
+		s.strings.Reserve(index);
+		s.strings.At(index) = copy;
+		s.ids[copy] = index;
+		s.count++;
+	}
+
+	s.synch.unlock();
+
+	return (index * SHARDS + shard) + 1;
+}
+
+/**
+ * Method returns string of given identifier (without locking - identifier is only known after its string was stored)
+ *
+ * @param[in] id  Identifier returned by Intern()
+ *
+ * @return Interned string (null-terminated)
+ */
+const wchar_t* MediaLibCleaner::StringInterner::Get(unsigned int id)
+{
+	if (id == 0) return L"";
+
+	return this->shards[(id - 1) & (SHARDS - 1)].strings.At((id - 1) / SHARDS);
+}
+
+/**
+ * Method returns amount of interned strings
+ *
+ * @return Amount of strings
+ */
+size_t MediaLibCleaner::StringInterner::GetCount()
+{
+	size_t count = 0;
+
+	for (unsigned int i = 0; i < SHARDS; i++)
+	{
+		this->shards[i].synch.lock();
+		count += this->shards[i].count;
+		this->shards[i].synch.unlock();
+	}
+
+	return count;
+}
+
+/**
+ * Method returns amount of memory taken by interned strings and their index (approximately)
+ *
+ * @return Amount of bytes
+ */
+uintmax_t MediaLibCleaner::StringInterner::GetBytes()
+{
+	uintmax_t bytes = sizeof(this->shards) + this->arena.GetBytes();
+
+	for (unsigned int i = 0; i < SHARDS; i++)
+	{
+		Shard &s = this->shards[i];
+
+		s.synch.lock();
+		bytes += s.strings.GetBytes();
+
+		// each index entry: node with key, value and next pointer + bucket pointer
+		bytes += s.ids.size() * (sizeof(void*) * 2 + sizeof(unsigned int) + sizeof(size_t)) + s.ids.bucket_count() * sizeof(void*);
+		s.synch.unlock();
+	}
+
+	return bytes;
+}
+
+
+
+
+/**
+ * MediaLibCleaner::LibraryStore constructor.
+ */
+MediaLibCleaner::LibraryStore::LibraryStore()
+{
+}
+
+/**
+ * MediaLibCleaner::LibraryStore destructor.
+ */
+MediaLibCleaner::LibraryStore::~LibraryStore()
+{
+}
+
+/**
+ * Method adds new row for the file of given path. All other values of the row are empty (or 0).
+ *
+ * @param[in] path  Full path to the file
+ *
+ * @return Index of the new row
+ */
+size_t MediaLibCleaner::LibraryStore::AddRow(const std::wstring &path)
+{
+	this->synch.lock();
+
+	size_t row = this->rows++;
+
+	for (int i = 0; i < STRING_COLUMNS_COUNT; i++)
+	{
+		if (interned[i]) this->ids[i].Reserve(row);
+		else this->texts[i].Reserve(row);
+	}
+	for (int i = 0; i < NUMBER_COLUMNS_COUNT; i++)
+	{
+		this->numbers[i].Reserve(row);
+	}
+	this->folders.Reserve(row);
+
+	this->synch.unlock();
+
+	this->SetPath(row, path);
+
+	return row;
+}
+
+/**
+ * Method returns value of text column
+ *
+ * @param[in] row     Row index
+ * @param[in] column  Column
+ *
+ * @return Value of the column
+ */
+std::wstring MediaLibCleaner::LibraryStore::GetString(size_t row, MediaLibCleaner::StringColumn column)
+{
+	if (interned[column]) return this->strings.Get(this->ids[column].At(row));
+
+	const wchar_t *value = this->texts[column].At(row);
+	return (value != nullptr) ? value : L"";
+}
+
+/**
+ * Method returns value of text column without copying it.
+ * Values are kept in arenas until the store is destroyed, so pointer stays valid even after the value is changed.
+ *
+ * @param[in] row     Row index
+ * @param[in] column  Column
+ *
+ * @return Value of the column (never nullptr)
+ */
+const wchar_t* MediaLibCleaner::LibraryStore::GetStringData(size_t row, MediaLibCleaner::StringColumn column)
+{
+	if (interned[column]) return this->strings.Get(this->ids[column].At(row));
+
+	const wchar_t *value = this->texts[column].At(row);
+	return (value != nullptr) ? value : L"";
+}
+
+/**
+ * Method sets value of text column
+ *
+ * @param[in] row     Row index
+ * @param[in] column  Column
+ * @param[in] value   New value
+ */
+void MediaLibCleaner::LibraryStore::SetString(size_t row, MediaLibCleaner::StringColumn column, const std::wstring &value)
+{
+	if (interned[column]) this->ids[column].At(row) = this->strings.Intern(value);
+	else this->texts[column].At(row) = value.empty() ? nullptr : this->texts_arena.Copy(value);
+}
+
+/**
+ * Method returns value of numeric column
+ *
+ * @param[in] row     Row index
+ * @param[in] column  Column
+ *
+ * @return Value of the column
+ */
+long long MediaLibCleaner::LibraryStore::GetNumber(size_t row, MediaLibCleaner::NumberColumn column)
+{
+	return this->numbers[column].At(row);
+}
+
+/**
+ * Method sets value of numeric column
+ *
+ * @param[in] row     Row index
+ * @param[in] column  Column
+ * @param[in] value   New value
+ */
+void MediaLibCleaner::LibraryStore::SetNumber(size_t row, MediaLibCleaner::NumberColumn column, long long value)
+{
+	this->numbers[column].At(row) = value;
+}
+
+/**
+ * Method returns path of the directory containing the file
+ *
+ * @param[in] row  Row index
+ *
+ * @return Path to the directory
+ */
+std::wstring MediaLibCleaner::LibraryStore::GetFolder(size_t row)
+{
+	return this->directories.Get(this->folders.At(row));
+}
+
+/**
+ * Method returns full path to the file
+ *
+ * @param[in] row  Row index
+ *
+ * @return Full path to the file
+ */
+std::wstring MediaLibCleaner::LibraryStore::GetPath(size_t row)
+{
+	std::wstring folder = this->GetFolder(row);
+	std::wstring filename = this->GetString(row, COLUMN_FILENAME);
+
+	if (folder.empty()) return filename;
+	if (folder.back() == L'/' || folder.back() == L'\\') return folder + filename;
+	return folder + L"/" + filename;
+}
+
+/**
+ * Method sets full path to the file (splitting it into directory and file name)
+ *
+ * @param[in] row   Row index
+ * @param[in] path  Full path to the file
+ */
+void MediaLibCleaner::LibraryStore::SetPath(size_t row, const std::wstring &path)
+{
+	size_t pos = path.find_last_of(L"/\\");
+
+	if (pos == std::wstring::npos)
+	{
+		this->folders.At(row) = 0;
+		this->SetString(row, COLUMN_FILENAME, path);
+		return;
+	}
+
+	// keep separator for root directories ("C:/", "/")
+	size_t folderEnd = (pos == 0 || path[pos - 1] == L':') ? pos + 1 : pos;
+
+	this->folders.At(row) = this->directories.Intern(path.substr(0, folderEnd));
+	this->SetString(row, COLUMN_FILENAME, path.substr(pos + 1));
+}
+
+/**
+ * Method returns amount of rows
+ *
+ * @return Amount of rows
+ */
+size_t MediaLibCleaner::LibraryStore::GetRows()
+{
+	this->synch.lock();
+	size_t rows = this->rows;
+	this->synch.unlock();
+
+	return rows;
+}
+
+/**
+ * Method returns amount of memory taken by the store (approximately)
+ *
+ * @return Amount of bytes
+ */
+uintmax_t MediaLibCleaner::LibraryStore::GetBytes()
+{
+	uintmax_t bytes = this->strings.GetBytes() + this->directories.GetBytes() + this->folders.GetBytes() + this->texts_arena.GetBytes();
+
+	for (int i = 0; i < STRING_COLUMNS_COUNT; i++)
+	{
+		if (interned[i]) bytes += this->ids[i].GetBytes();
+		else bytes += this->texts[i].GetBytes();
+	}
+	for (int i = 0; i < NUMBER_COLUMNS_COUNT; i++)
+	{
+		bytes += this->numbers[i].GetBytes();
+	}
+
+	return bytes;
+}
+
+/**
+ * Method returns amount of memory the same data would take if every file kept its own copy of every value
+ * (one string object per value, 6 path strings per file - as MediaLibCleaner::File used to do) - approximately.
+ *
+ * @return Amount of bytes
+ */
+uintmax_t MediaLibCleaner::LibraryStore::GetFlatBytes()
+{
+	size_t rows = this->GetRows();
+	uintmax_t bytes = rows * NUMBER_COLUMNS_COUNT * sizeof(long long);
+
+	for (size_t row = 0; row < rows; row++)
+	{
+		for (int i = 0; i < STRING_COLUMNS_COUNT; i++)
+		{
+			bytes += stringBytes(this->GetString(row, static_cast<StringColumn>(i)));
+		}
+
+		// full path, folder path, directory, parent directory, file name without extension and extension
+		std::wstring folder = this->GetFolder(row);
+		std::wstring filename = this->GetString(row, COLUMN_FILENAME);
+		bytes += 2 * stringBytes(folder + filename) + 2 * stringBytes(folder) + 2 * stringBytes(filename);
+	}
+
+	return bytes;
+}
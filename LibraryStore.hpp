@@ -0,0 +1,346 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * File contains declarations of classes storing metadata of all files in the library (columnar store and string interner)
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cwchar>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Arena.hpp"
+
+namespace MediaLibCleaner
+{
+	/**
+	 * @brief Enumerate type describing text columns of MediaLibCleaner::LibraryStore
+	 */
+	enum StringColumn
+	{
+		COLUMN_ARTIST, ///< \%artist% tag
+		COLUMN_TITLE, ///< \%title% tag
+		COLUMN_ALBUM, ///< \%album% tag
+		COLUMN_GENRE, ///< \%genre% tag
+		COLUMN_COMMENT, ///< \%comment% tag
+		COLUMN_TRACK, ///< \%track% tag
+		COLUMN_YEAR, ///< \%year% tag
+		COLUMN_ALBUMARTIST, ///< \%albumartist% tag
+		COLUMN_BPM, ///< \%bpm% tag
+		COLUMN_COPYRIGHT, ///< \%copyright% tag
+		COLUMN_LANGUAGE, ///< \%language% tag
+		COLUMN_LENGTH, ///< \%length% tag
+		COLUMN_MOOD, ///< \%mood% tag
+		COLUMN_ORIGALBUM, ///< \%origalbum% tag
+		COLUMN_ORIGARTIST, ///< \%origartist% tag
+		COLUMN_ORIGFILENAME, ///< \%origfilename% tag
+		COLUMN_ORIGYEAR, ///< \%origyear% tag
+		COLUMN_PUBLISHER, ///< \%publisher% tag
+		COLUMN_UNSYNCEDLYRICS, ///< \%unsyncedlyrics% tag
+		COLUMN_WWW, ///< \%www% tag
+		COLUMN_CODEC, ///< Audio codec name
+		COLUMN_COVER_MIMETYPE, ///< Mimetype of the first cover
+		COLUMN_COVER_TYPE, ///< Type of the first cover
+		COLUMN_FILENAME, ///< File name (with extension)
+		STRING_COLUMNS_COUNT ///< Amount of text columns (not a real column)
+	};
+
+	/**
+	 * @brief Enumerate type describing numeric columns of MediaLibCleaner::LibraryStore
+	 */
+	enum NumberColumn
+	{
+		COLUMN_BITRATE, ///< Audio bitrate
+		COLUMN_CHANNELS, ///< Amount of audio channels
+		COLUMN_SAMPLERATE, ///< Audio sample rate
+		COLUMN_DURATION, ///< Audio length in seconds
+		COLUMN_COVERS, ///< Amount of covers
+		COLUMN_COVER_SIZE, ///< Size of the first cover (in bytes)
+		COLUMN_COVER_WIDTH, ///< Width of the first cover (in pixels)
+		COLUMN_COVER_HEIGHT, ///< Height of the first cover (in pixels)
+		COLUMN_FILE_SIZE, ///< File size (in bytes)
+		COLUMN_CREATE_TIME, ///< File creation time (unix timestamp)
+		COLUMN_MOD_TIME, ///< File modification time (unix timestamp)
+		COLUMN_DUP_GROUP, ///< Number of group of files with the same audio data (0 if file has no duplicates)
+		COLUMN_INTEGRITY, ///< Result of integrity check (MediaLibCleaner::IntegrityStatus)
+		NUMBER_COLUMNS_COUNT ///< Amount of numeric columns (not a real column)
+	};
+
+	/**
+	 * @class Column LibraryStore.hpp
+	 *
+	 * @brief Class MediaLibCleaner::Column stores values of one column of MediaLibCleaner::LibraryStore in fixed-size blocks.
+	 * Blocks are never moved, so values of existing rows can be accessed while new rows are being added.
+	 * Table of blocks grows by doubling; replaced tables are kept until the column is destroyed, so readers still using them see the same blocks.
+	 */
+	template<typename T, size_t ROWS = 16384>
+	class Column
+	{
+	public:
+		/**
+		 * Amount of rows in one block
+		 */
+		static const size_t BLOCK_ROWS = ROWS;
+
+		/**
+		 * Initial amount of blocks in the table of blocks
+		 */
+		static const size_t INITIAL_BLOCKS = 64;
+
+		/**
+		 * MediaLibCleaner::Column constructor.
+		 */
+		Column()
+		{
+			T **initial = new T*[INITIAL_BLOCKS]();
+			this->tables.push_back(initial);
+			this->capacity = INITIAL_BLOCKS;
+			this->table_bytes = INITIAL_BLOCKS * sizeof(T*);
+			this->blocks.store(initial);
+		}
+
+		/**
+		 * MediaLibCleaner::Column destructor.
+		 */
+		~Column()
+		{
+			T **current = this->blocks.load();
+			for (size_t i = 0; i < this->capacity; i++) delete[] current[i];
+			for (size_t i = 0; i < this->tables.size(); i++) delete[] this->tables[i];
+		}
+
+		/**
+		 * Method makes sure block containing given row is allocated, growing table of blocks if needed (callers have to synchronize).
+		 *
+		 * @param[in] row  Row index
+		 */
+		void Reserve(size_t row)
+		{
+			size_t block = row / BLOCK_ROWS;
+			T **current = this->blocks.load(std::memory_order_relaxed);
+
+			if (block >= this->capacity)
+			{
+				size_t capacity = this->capacity;
+				while (capacity <= block) capacity *= 2;
+
+				T **grown = new T*[capacity]();
+				std::copy(current, current + this->capacity, grown);
+
+				this->tables.push_back(grown);
+				this->capacity = capacity;
+				this->table_bytes += capacity * sizeof(T*);
+				this->blocks.store(grown, std::memory_order_release);
+				current = grown;
+			}
+
+			if (current[block] == nullptr) current[block] = new T[BLOCK_ROWS]();
+		}
+
+		/**
+		 * Method returns value of given row
+		 *
+		 * @param[in] row  Row index (its block has to be reserved)
+		 *
+		 * @return Reference to the value
+		 */
+		T& At(size_t row)
+		{
+			return this->blocks.load(std::memory_order_acquire)[row / BLOCK_ROWS][row % BLOCK_ROWS];
+		}
+
+		/**
+		 * Method returns amount of memory taken by allocated blocks
+		 *
+		 * @return Amount of bytes
+		 */
+		uintmax_t GetBytes()
+		{
+			T **current = this->blocks.load();
+			uintmax_t bytes = this->table_bytes;
+			for (size_t i = 0; i < this->capacity; i++)
+				if (current[i] != nullptr) bytes += BLOCK_ROWS * sizeof(T);
+			return bytes;
+		}
+
+	protected:
+		/**
+		 * Current table of blocks of values
+		 */
+		std::atomic<T**> blocks;
+
+		/**
+		 * Amount of blocks in the current table
+		 */
+		size_t capacity;
+
+		/**
+		 * All tables of blocks allocated so far (including the current one)
+		 */
+		std::vector<T**> tables;
+
+		/**
+		 * Amount of memory taken by all tables of blocks
+		 */
+		uintmax_t table_bytes;
+	};
+
+	/**
+	 * @class StringInterner LibraryStore.hpp
+	 *
+	 * @brief Class MediaLibCleaner::StringInterner stores every distinct string once and identifies it with a number (thread-safe).
+	 * Strings are split into shards (by hash), each protected by its own mutex, so threads rarely wait for each other.
+	 * Strings are never removed or moved, so they are kept in MediaLibCleaner::Column and read without taking the mutex.
+	 * Strings themselves are copied into MediaLibCleaner::Arena and freed all at once.
+	 */
+	class StringInterner
+	{
+	public:
+		StringInterner();
+		~StringInterner();
+
+		unsigned int Intern(const std::wstring&);
+		const wchar_t* Get(unsigned int);
+
+		size_t GetCount();
+		uintmax_t GetBytes();
+
+	protected:
+		/**
+		 * Amount of shards (power of 2)
+		 */
+		static const unsigned int SHARDS = 16;
+
+		/**
+		 * Hash of the string pointed to (FNV-1a)
+		 */
+		struct PointerHash
+		{
+			size_t operator()(const wchar_t *s) const
+			{
+				size_t hash = 2166136261U;
+				for (; *s != L'\0'; s++) hash = (hash ^ static_cast<size_t>(*s)) * 16777619U;
+				return hash;
+			}
+		};
+
+		/**
+		 * Equality of the strings pointed to
+		 */
+		struct PointerEqual
+		{
+			bool operator()(const wchar_t *a, const wchar_t *b) const { return std::wcscmp(a, b) == 0; }
+		};
+
+		/**
+		 * Part of the interned strings
+		 */
+		struct Shard
+		{
+			std::mutex synch; ///< std::mutex protecting shard from racing conditions
+			Column<const wchar_t*, 1024> strings; ///< Interned strings (copies in arena)
+			size_t count = 0; ///< Amount of interned strings
+			std::unordered_map<const wchar_t*, unsigned int, PointerHash, PointerEqual> ids; ///< Index of string in strings
+		};
+
+		/**
+		 * All shards
+		 */
+		Shard shards[SHARDS];
+
+		/**
+		 * Memory of interned strings
+		 */
+		Arena arena;
+	};
+
+	/**
+	 * @class LibraryStore LibraryStore.hpp
+	 *
+	 * @brief Class MediaLibCleaner::LibraryStore holds metadata of all files in the library as columns (one row per file).
+	 * Repeating values (artist, album, genre, directories, ...) are interned; file paths are stored as (directory, file name) pairs.
+	 * Rows can be added by many threads at once; each row should be modified by one thread at a time.
+	 * All strings are kept in arenas, so the store is freed in O(blocks + chunks) regardless of amount of files.
+	 */
+	class LibraryStore
+	{
+	public:
+		LibraryStore();
+		~LibraryStore();
+
+		size_t AddRow(const std::wstring&);
+
+		std::wstring GetString(size_t, StringColumn);
+		const wchar_t* GetStringData(size_t, StringColumn);
+		void SetString(size_t, StringColumn, const std::wstring&);
+
+		long long GetNumber(size_t, NumberColumn);
+		void SetNumber(size_t, NumberColumn, long long);
+
+		std::wstring GetFolder(size_t);
+		std::wstring GetPath(size_t);
+		void SetPath(size_t, const std::wstring&);
+
+		size_t GetRows();
+		uintmax_t GetBytes();
+		uintmax_t GetFlatBytes();
+
+	protected:
+		/**
+		 * Information if values of given text column are interned (columns with mostly unique values are not)
+		 */
+		static const bool interned[STRING_COLUMNS_COUNT];
+
+		/**
+		 * Amount of rows
+		 */
+		size_t rows = 0;
+
+		/**
+		 * std::mutex protecting adding rows from racing conditions
+		 */
+		std::mutex synch;
+
+		/**
+		 * Interned values of text columns
+		 */
+		StringInterner strings;
+
+		/**
+		 * Interned directory paths
+		 */
+		StringInterner directories;
+
+		/**
+		 * Identifiers of interned values (for interned text columns)
+		 */
+		Column<unsigned int> ids[STRING_COLUMNS_COUNT];
+
+		/**
+		 * Values of text columns which are not interned (copies in texts_arena; nullptr - empty string)
+		 */
+		Column<const wchar_t*> texts[STRING_COLUMNS_COUNT];
+
+		/**
+		 * Memory of values of text columns which are not interned (values replaced by new ones are freed with the store)
+		 */
+		Arena texts_arena;
+
+		/**
+		 * Values of numeric columns
+		 */
+		Column<long long> numbers[NUMBER_COLUMNS_COUNT];
+
+		/**
+		 * Identifiers of directories (in directories interner)
+		 */
+		Column<unsigned int> folders;
+	};
+}
@@ -0,0 +1,275 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * File contains definitions of lookup tables - named CSV/TSV files loaded once by the script (_LoadTable) and searched by key (_Lookup)
+ */
+#include "LookupTables.hpp"
+#include "helpers.hpp"
+
+#include <codecvt>
+#include <iterator>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+
+
+
+/**
+ * Function converts field read from the file (UTF-8) to the encoding of strings of the script.
+ * Fields which are not valid UTF-8 are assumed to be in that encoding already.
+ *
+ * @param[in] bytes  Field as read from the file
+ *
+ * @return Converted field
+ */
+static std::string convertField(const std::string &bytes)
+{
+	bool ascii = true;
+	for (size_t i = 0; i < bytes.length() && ascii; i++)
+	{
+		ascii = (static_cast<unsigned char>(bytes[i]) < 0x80);
+	}
+	if (ascii) return bytes;
+
+	try
+	{
+		std::wstring_convert<std::codecvt_utf8<wchar_t>> convert;
+		return ws2s(convert.from_bytes(bytes));
+	}
+	catch (const std::range_error&)
+	{
+		return bytes;
+	}
+}
+
+/**
+ * Function parses content of CSV or TSV file into the table (see MediaLibCleaner::LookupTables for the format)
+ *
+ * @param[in]  data   Content of the file
+ * @param[in]  size   Size of the content in bytes
+ * @param[out] table  Table to fill
+ */
+static void parseTable(const char *data, size_t size, MediaLibCleaner::LookupTable *table)
+{
+	size_t i = 0;
+	if (size >= 3 && data[0] == '\xEF' && data[1] == '\xBB' && data[2] == '\xBF') i = 3; // UTF-8 BOM
+
+	char delimiter = ',';
+	for (size_t j = i; j < size && data[j] != '\n'; j++)
+	{
+		if (data[j] == '\t')
+		{
+			delimiter = '\t';
+			break;
+		}
+	}
+
+	std::vector<std::string> fields;
+	std::string field;
+	while (i < size)
+	{
+		fields.clear();
+
+		// one field per iteration, until the end of the line
+		while (true)
+		{
+			field.clear();
+
+			if (delimiter == ',' && i < size && data[i] == '"')
+			{
+				for (i++; i < size; i++)
+				{
+					if (data[i] != '"') field += data[i];
+					else if (i + 1 < size && data[i + 1] == '"') field += data[++i];
+					else
+					{
+						i++;
+						break;
+					}
+				}
+			}
+
+			while (i < size && data[i] != delimiter && data[i] != '\n' && data[i] != '\r')
+			{
+				field += data[i++];
+			}
+
+			fields.push_back(convertField(field));
+
+			if (i < size && data[i] == delimiter) i++;
+			else break;
+		}
+
+		if (i < size && data[i] == '\r') i++;
+		if (i < size && data[i] == '\n') i++;
+
+		if (fields.size() == 1 && fields[0].empty()) continue;
+
+		std::vector<std::string> values(fields.begin() + 1, fields.end());
+		if (!table->rows.insert(std::make_pair(fields[0], std::move(values))).second) table->duplicates++;
+	}
+}
+
+/**
+ * Function reads CSV or TSV file into the table. File is memory-mapped; if that is not possible, it is read into memory.
+ *
+ * @param[in]  path   Path to the file (in the encoding of strings of the script)
+ * @param[out] table  Table to fill
+ * @param[out] error  Error message if file could not be read
+ *
+ * @return True if file was read
+ */
+static bool loadFile(const std::string &path, MediaLibCleaner::LookupTable *table, std::wstring *error)
+{
+	boost::system::error_code ec;
+	if (!boost::filesystem::is_regular_file(path, ec))
+	{
+		*error = L"File does not exist: " + s2ws(path);
+		return false;
+	}
+
+	// empty file cannot be mapped
+	if (boost::filesystem::file_size(path, ec) == 0) return true;
+
+	try
+	{
+		boost::interprocess::file_mapping file(path.c_str(), boost::interprocess::read_only);
+		boost::interprocess::mapped_region region(file, boost::interprocess::read_only);
+
+		parseTable(static_cast<const char*>(region.get_address()), region.get_size(), table);
+		return true;
+	}
+	catch (const boost::interprocess::interprocess_exception&)
+	{
+		// mapping is not possible, file is read below
+	}
+
+	boost::filesystem::ifstream file(path, std::ios::binary);
+	std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (!file.is_open() || file.bad())
+	{
+		*error = L"Cannot read file: " + s2ws(path);
+		return false;
+	}
+
+	parseTable(data.data(), data.size(), table);
+	return true;
+}
+
+
+
+
+/**
+ * Method loads table from CSV or TSV file. If table of that name was already loaded (or loading failed), the file is not read again.
+ * File is read outside of the lock; if two threads load the same name at once, the first table stored is kept.
+ *
+ * @param[in]  name   Name of the table as given in the config file
+ * @param[in]  path   Path to the file (in the encoding of strings of the script)
+ * @param[out] error  Error message if file could not be read (may be nullptr)
+ *
+ * @return Table of given name (valid until the object is destroyed) or nullptr if file could not be read
+ */
+const MediaLibCleaner::LookupTable* MediaLibCleaner::LookupTables::Load(const std::string &name, const std::string &path, std::wstring *error)
+{
+	Entry *entry = nullptr;
+
+	this->synch.lock();
+	auto found = this->tables.find(name);
+	if (found != this->tables.end()) entry = found->second.get();
+	this->synch.unlock();
+
+	if (entry == nullptr)
+	{
+		std::unique_ptr<Entry> loaded(new Entry());
+		loaded->table.reset(new LookupTable());
+
+		if (!loadFile(path, loaded->table.get(), &loaded->error)) loaded->table.reset();
+
+		this->synch.lock();
+		auto inserted = this->tables.insert(std::make_pair(name, std::move(loaded)));
+		entry = inserted.first->second.get();
+		this->synch.unlock();
+	}
+
+	if (entry->table == nullptr && error != nullptr) *error = entry->error;
+
+	return entry->table.get();
+}
+
+/**
+ * Method returns table of given name
+ *
+ * @param[in] name  Name of the table as given in the config file
+ *
+ * @return Table of given name (valid until the object is destroyed) or nullptr if there is no such table
+ */
+const MediaLibCleaner::LookupTable* MediaLibCleaner::LookupTables::Get(const std::string &name)
+{
+	const LookupTable *result = nullptr;
+
+	this->synch.lock();
+	auto found = this->tables.find(name);
+	if (found != this->tables.end()) result = found->second->table.get();
+	this->synch.unlock();
+
+	return result;
+}
+
+/**
+ * Method checks if table of given name was loaded or its loading failed (so Load() would not read the file again)
+ *
+ * @param[in] name  Name of the table as given in the config file
+ *
+ * @return True if name was already given to Load(), false otherwise
+ */
+bool MediaLibCleaner::LookupTables::Contains(const std::string &name)
+{
+	this->synch.lock();
+	bool found = (this->tables.find(name) != this->tables.end());
+	this->synch.unlock();
+
+	return found;
+}
+
+/**
+ * Method returns amount of loaded tables
+ *
+ * @return Amount of tables
+ */
+size_t MediaLibCleaner::LookupTables::GetTables()
+{
+	size_t count = 0;
+
+	this->synch.lock();
+	for (auto it = this->tables.begin(); it != this->tables.end(); ++it)
+	{
+		if (it->second->table != nullptr) count++;
+	}
+	this->synch.unlock();
+
+	return count;
+}
+
+/**
+ * Method returns amount of rows in all loaded tables
+ *
+ * @return Amount of rows
+ */
+size_t MediaLibCleaner::LookupTables::GetRows()
+{
+	size_t rows = 0;
+
+	this->synch.lock();
+	for (auto it = this->tables.begin(); it != this->tables.end(); ++it)
+	{
+		if (it->second->table != nullptr) rows += it->second->table->rows.size();
+	}
+	this->synch.unlock();
+
+	return rows;
+}
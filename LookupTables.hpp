@@ -0,0 +1,71 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * File contains declarations of lookup tables - named CSV/TSV files loaded once by the script (_LoadTable) and searched by key (_Lookup)
+ */
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace MediaLibCleaner
+{
+	/**
+	 * @brief Structure describing a single loaded table
+	 *
+	 * Strings are kept in the encoding of strings of the script, so keys given by the script are looked up without any conversion.
+	 */
+	struct LookupTable
+	{
+		std::unordered_map<std::string, std::vector<std::string>> rows; ///< Values of other columns of every row, by value of the first column
+		size_t duplicates = 0; ///< Amount of rows ignored because of key already used by an earlier row
+	};
+
+	/**
+	 * @class LookupTables LookupTables.hpp
+	 *
+	 * @brief Class MediaLibCleaner::LookupTables keeps named tables loaded from CSV or TSV files, shared by all threads.
+	 *
+	 * File is memory-mapped (read into memory if mapping is not possible) and parsed once, by the first load of the name;
+	 * further loads of the same name return the same table (or the same error), so the file is not read again for every file.
+	 * Fields are copied into the table (converted to the encoding of the script, quotes removed), so the mapping is released right after parsing.
+	 * Tables are never changed after loading, so they are searched without holding the lock and without copying.
+	 * Files are expected in UTF-8 (optionally with BOM); first column of every row is its key. Delimiter is tab if the first line
+	 * contains one, comma otherwise; comma separated values may be quoted ("a, ""b""" is a, "b"). Empty lines are skipped.
+	 */
+	class LookupTables
+	{
+	public:
+		const LookupTable* Load(const std::string &name, const std::string &path, std::wstring *error);
+		const LookupTable* Get(const std::string &name);
+		bool Contains(const std::string &name);
+
+		size_t GetTables();
+		size_t GetRows();
+
+	protected:
+		/**
+		 * @brief Structure describing a single name given to _LoadTable()
+		 */
+		struct Entry
+		{
+			std::unique_ptr<LookupTable> table; ///< Loaded table, or nullptr if file could not be read
+			std::wstring error; ///< Error message if file could not be read
+		};
+
+		/**
+		 * All tables, by name as given in the config file (entries stay at the same address when more tables are loaded)
+		 */
+		std::unordered_map<std::string, std::unique_ptr<Entry>> tables;
+
+		/**
+		 * std::mutex protecting tables from racing conditions
+		 */
+		std::mutex synch;
+	};
+}
@@ -31,6 +31,54 @@ int lua_IsAudioFile(lua_State *L, MediaLibCleaner::File* audiofile, std::unique_
 	return 1; // numer of output arguments
 }
 
+/**
+ * Function returning if there is another file with the same audio data as given file (requires _find_duplicates = true)
+ *
+ * @param[in] L	         lua_State object to config file
+ * @param[in] audiofile  std::unique_ptr to MediaLibCleaner::File object representing current file
+ * @param[in] lp         std::unique_ptr to MediaLibCleaner::LogProgram object used for logging purposes
+ * @param[in] la         std::unique_ptr to MediaLibCleaner::LogAlert object used for logging purposes
+ *
+ * @return Number of output arguments (for lua_register)
+ */
+int lua_IsDuplicate(lua_State *L, MediaLibCleaner::File* audiofile, std::unique_ptr<MediaLibCleaner::LogProgram>* lp, std::unique_ptr<MediaLibCleaner::LogAlert>* la) {
+	int n = lua_gettop(L);
+	if (n > 1)
+	{
+		lua_pushboolean(L, false);
+		(*lp)->Log(L"lua_IsDuplicate(" + audiofile->GetPath() + L")", L"Function expects 0 arguments (" + std::to_wstring(n) + L" given)", 2);
+		return 1;
+	}
+
+	lua_pushboolean(L, audiofile->IsDuplicate());
+
+	return 1; // numer of output arguments
+}
+
+/**
+ * Function returning if no damage was found in given file (requires _verify_integrity = true; files not verified are treated as intact)
+ *
+ * @param[in] L	         lua_State object to config file
+ * @param[in] audiofile  std::unique_ptr to MediaLibCleaner::File object representing current file
+ * @param[in] lp         std::unique_ptr to MediaLibCleaner::LogProgram object used for logging purposes
+ * @param[in] la         std::unique_ptr to MediaLibCleaner::LogAlert object used for logging purposes
+ *
+ * @return Number of output arguments (for lua_register)
+ */
+int lua_IsIntact(lua_State *L, MediaLibCleaner::File* audiofile, std::unique_ptr<MediaLibCleaner::LogProgram>* lp, std::unique_ptr<MediaLibCleaner::LogAlert>* la) {
+	int n = lua_gettop(L);
+	if (n > 1)
+	{
+		lua_pushboolean(L, false);
+		(*lp)->Log(L"lua_IsIntact(" + audiofile->GetPath() + L")", L"Function expects 0 arguments (" + std::to_wstring(n) + L" given)", 2);
+		return 1;
+	}
+
+	lua_pushboolean(L, audiofile->IsIntact());
+
+	return 1; // numer of output arguments
+}
+
 /**
  * Function to set tag(s) in given audio file
  *
@@ -125,7 +173,8 @@ int lua_SetRequiredTags(lua_State *L, MediaLibCleaner::File* audiofile, std::uni
 }
 
 /**
-* Function to set required tag(s) in given audio file, as well checks if it has desired values
+* Function to set required tag(s) in given audio file, as well checks if it has desired values.
+* Instead of the list of values, set defined by _DefineValueSet() can be given, e.g. _CheckTagValues("genre", _ValueSet("genres")).
 *
 * @param[in] L          lua_State object to config file
 * @param[in] audiofile  std::unique_ptr to MediaLibCleaner::File object representing current file
@@ -144,6 +193,18 @@ int lua_CheckTagValues(lua_State *L, MediaLibCleaner::File* audiofile, std::uniq
 	}
 
 	std::wstring tag = s2ws(lua_tostring(L, 1));
+
+	if (n == 2 && !lua_isstring(L, 2)) { // set of values returned by _ValueSet()
+		if (!lua_islightuserdata(L, 2)) {
+			lua_pushboolean(L, false);
+			(*lp)->Log(L"lua_CheckTagsValues(" + audiofile->GetPath() + L")", L"Function expects value or set of values returned by _ValueSet() as the second argument", 2);
+			return 1;
+		}
+
+		lua_pushboolean(L, audiofile->HasTag(tag, *static_cast<const MediaLibCleaner::ValueSet*>(lua_touserdata(L, 2))));
+		return 1;
+	}
+
 	std::vector< std::wstring > val;
 	for (int i = 2; i <= n; i++)
 	{
@@ -259,6 +320,501 @@ int lua_Log(lua_State *L, MediaLibCleaner::File* audiofile, std::unique_ptr<Medi
 }
 
 
+/**
+ * Function returning canonical spelling of artist or album name (see MediaLibCleaner::NameClusterer), e.g. _CanonicalName("artist", "%artist%").
+ * Name is returned unchanged if names were not clustered (_cluster_names) or it has no other spellings.
+ * Function does not need current file, but names are clustered only after scan, so it works in the directory pass and when files are processed;
+ * in _action == "System" names are not clustered yet and every name is returned unchanged.
+ *
+ * @param[in] L          lua_State object to config file
+ * @param[in] clusterer  MediaLibCleaner::NameClusterer object with clusters of names (nullptr if names were not clustered)
+ * @param[in] lp         std::unique_ptr to MediaLibCleaner::LogProgram object used for logging purposes
+ * @param[in] la         std::unique_ptr to MediaLibCleaner::LogAlert object used for logging purposes
+ *
+ * @return Number of output arguments (for lua_register)
+ */
+int lua_CanonicalName(lua_State *L, MediaLibCleaner::NameClusterer* clusterer, std::unique_ptr<MediaLibCleaner::LogProgram>* lp, std::unique_ptr<MediaLibCleaner::LogAlert>* la) {
+	int n = lua_gettop(L); // argc for function
+
+	if (n != 2 || !lua_isstring(L, 1) || !lua_isstring(L, 2)) { // requires kind of name and name
+		(*lp)->Log(L"lua_CanonicalName", L"Function expects exactly 2 arguments: [kind, name] (" + std::to_wstring(n) + L" given)", 2);
+		lua_pushnil(L);
+		return 1;
+	}
+
+	std::string kind = lua_tostring(L, 1);
+	std::wstring name = s2ws(lua_tostring(L, 2));
+
+	if (kind != "artist" && kind != "albumartist" && kind != "album") {
+		(*lp)->Log(L"lua_CanonicalName", L"Unknown kind of name: " + s2ws(kind) + L" (artist, albumartist or album expected)", 2);
+	}
+	else if (clusterer != nullptr) {
+		name = clusterer->GetCanonical(kind == "album" ? MediaLibCleaner::NAME_ALBUM : MediaLibCleaner::NAME_ARTIST, name);
+	}
+
+	lua_pushstring(L, ws2s(name).c_str());
+	return 1;
+}
+
+/**
+ * Function defines named set of values for _CheckTagValues(), e.g. _DefineValueSet("genres", {"Rock", "Jazz", ...}).
+ * Set is built only by the first definition of the name (best in _action == "System"); later calls, e.g. when the script is run
+ * for every file, return at once without reading the table. Function does not need current file, so it can be used in all passes of the script.
+ *
+ * @param[in] L     lua_State object to config file
+ * @param[in] sets  MediaLibCleaner::ValueSets object keeping all sets
+ * @param[in] lp    std::unique_ptr to MediaLibCleaner::LogProgram object used for logging purposes
+ * @param[in] la    std::unique_ptr to MediaLibCleaner::LogAlert object used for logging purposes
+ *
+ * @return Number of output arguments (for lua_register)
+ */
+int lua_DefineValueSet(lua_State *L, MediaLibCleaner::ValueSets* sets, std::unique_ptr<MediaLibCleaner::LogProgram>* lp, std::unique_ptr<MediaLibCleaner::LogAlert>* la) {
+	int n = lua_gettop(L); // argc for function
+
+	if (n != 2 || !lua_isstring(L, 1) || !lua_istable(L, 2)) { // requires name and table of values
+		(*lp)->Log(L"lua_DefineValueSet", L"Function expects exactly 2 arguments: [name, {value1, value2, ...}] (" + std::to_wstring(n) + L" given)", 2);
+		lua_pushboolean(L, false);
+		return 1;
+	}
+
+	std::string name = lua_tostring(L, 1);
+	if (sets->Get(name) != nullptr) {
+		lua_pushboolean(L, true);
+		return 1;
+	}
+
+	std::vector<std::wstring> values;
+	lua_Integer count = static_cast<lua_Integer>(lua_rawlen(L, 2));
+	values.reserve(static_cast<size_t>(count));
+	for (lua_Integer i = 1; i <= count; i++)
+	{
+		lua_rawgeti(L, 2, i);
+		if (lua_isstring(L, -1)) values.push_back(s2ws(lua_tostring(L, -1)));
+		else (*lp)->Log(L"lua_DefineValueSet", L"Value " + std::to_wstring(i) + L" of set " + s2ws(name) + L" is not a string, skipping", 2);
+		lua_pop(L, 1);
+	}
+
+	const MediaLibCleaner::ValueSet *set = sets->Define(name, values);
+	(*lp)->Log(L"lua_DefineValueSet", L"Set " + s2ws(name) + L" defined with " + std::to_wstring(set->size()) + L" distinct value(s)", 3);
+
+	lua_pushboolean(L, true);
+	return 1;
+}
+
+/**
+ * Function returns set of values defined by _DefineValueSet(), to be given to _CheckTagValues() instead of the list of values.
+ * Function does not need current file, so it can be used in all passes of the script.
+ *
+ * @param[in] L     lua_State object to config file
+ * @param[in] sets  MediaLibCleaner::ValueSets object keeping all sets
+ * @param[in] lp    std::unique_ptr to MediaLibCleaner::LogProgram object used for logging purposes
+ * @param[in] la    std::unique_ptr to MediaLibCleaner::LogAlert object used for logging purposes
+ *
+ * @return Number of output arguments (for lua_register)
+ */
+int lua_ValueSet(lua_State *L, MediaLibCleaner::ValueSets* sets, std::unique_ptr<MediaLibCleaner::LogProgram>* lp, std::unique_ptr<MediaLibCleaner::LogAlert>* la) {
+	int n = lua_gettop(L); // argc for function
+
+	if (n != 1 || !lua_isstring(L, 1)) { // requires name of the set
+		(*lp)->Log(L"lua_ValueSet", L"Function expects exactly 1 argument: [name] (" + std::to_wstring(n) + L" given)", 2);
+		lua_pushnil(L);
+		return 1;
+	}
+
+	const MediaLibCleaner::ValueSet *set = sets->Get(lua_tostring(L, 1));
+	if (set == nullptr) {
+		(*lp)->Log(L"lua_ValueSet", L"Set " + s2ws(lua_tostring(L, 1)) + L" is not defined (see _DefineValueSet)", 2);
+		lua_pushnil(L);
+		return 1;
+	}
+
+	// set is never changed nor freed until the end of the run, so it is passed as a plain pointer
+	lua_pushlightuserdata(L, const_cast<MediaLibCleaner::ValueSet*>(set));
+	return 1;
+}
+
+/**
+ * Function loads table from CSV or TSV file, e.g. _LoadTable("artists", "C:\music\artists.csv") (see MediaLibCleaner::LookupTables for the format).
+ * File is read only by the first load of the name (best in _action == "System"); later calls, e.g. when the script is run
+ * for every file, return at once with the same result (failure is logged only once). Function does not need current file, so it can be used in all passes of the script.
+ *
+ * @param[in] L       lua_State object to config file
+ * @param[in] tables  MediaLibCleaner::LookupTables object keeping all tables
+ * @param[in] lp      std::unique_ptr to MediaLibCleaner::LogProgram object used for logging purposes
+ * @param[in] la      std::unique_ptr to MediaLibCleaner::LogAlert object used for logging purposes
+ *
+ * @return Number of output arguments (for lua_register)
+ */
+int lua_LoadTable(lua_State *L, MediaLibCleaner::LookupTables* tables, std::unique_ptr<MediaLibCleaner::LogProgram>* lp, std::unique_ptr<MediaLibCleaner::LogAlert>* la) {
+	int n = lua_gettop(L); // argc for function
+
+	if (n != 2 || !lua_isstring(L, 1) || !lua_isstring(L, 2)) { // requires name and path
+		(*lp)->Log(L"lua_LoadTable", L"Function expects exactly 2 arguments: [name, path] (" + std::to_wstring(n) + L" given)", 2);
+		lua_pushboolean(L, false);
+		return 1;
+	}
+
+	// failure is logged only by the load which read the file
+	std::string name = lua_tostring(L, 1);
+	if (tables->Contains(name)) {
+		lua_pushboolean(L, tables->Get(name) != nullptr);
+		return 1;
+	}
+
+	std::wstring error;
+	const MediaLibCleaner::LookupTable *table = tables->Load(name, lua_tostring(L, 2), &error);
+	if (table == nullptr) {
+		(*lp)->Log(L"lua_LoadTable", L"Table " + s2ws(name) + L" not loaded: " + error, 2);
+		lua_pushboolean(L, false);
+		return 1;
+	}
+
+	(*lp)->Log(L"lua_LoadTable", L"Table " + s2ws(name) + L" loaded with " + std::to_wstring(table->rows.size()) + L" row(s), " + std::to_wstring(table->duplicates) + L" duplicate key(s) ignored", 3);
+
+	lua_pushboolean(L, true);
+	return 1;
+}
+
+/**
+ * Function looks up row of table loaded by _LoadTable(), e.g. artist = _Lookup("artists", "%artist%") or "%artist%".
+ * Returns values of all other columns of the row (key itself if table has one column), or nil if there is no such key.
+ * Function does not need current file, so it can be used in all passes of the script.
+ *
+ * @param[in] L       lua_State object to config file
+ * @param[in] tables  MediaLibCleaner::LookupTables object keeping all tables
+ * @param[in] lp      std::unique_ptr to MediaLibCleaner::LogProgram object used for logging purposes
+ * @param[in] la      std::unique_ptr to MediaLibCleaner::LogAlert object used for logging purposes
+ *
+ * @return Number of output arguments (for lua_register)
+ */
+int lua_Lookup(lua_State *L, MediaLibCleaner::LookupTables* tables, std::unique_ptr<MediaLibCleaner::LogProgram>* lp, std::unique_ptr<MediaLibCleaner::LogAlert>* la) {
+	int n = lua_gettop(L); // argc for function
+
+	if (n != 2 || !lua_isstring(L, 1) || !lua_isstring(L, 2)) { // requires name and key
+		(*lp)->Log(L"lua_Lookup", L"Function expects exactly 2 arguments: [name, key] (" + std::to_wstring(n) + L" given)", 2);
+		lua_pushnil(L);
+		return 1;
+	}
+
+	const MediaLibCleaner::LookupTable *table = tables->Get(lua_tostring(L, 1));
+	if (table == nullptr) {
+		(*lp)->Log(L"lua_Lookup", L"Table " + s2ws(lua_tostring(L, 1)) + L" is not loaded (see _LoadTable)", 2);
+		lua_pushnil(L);
+		return 1;
+	}
+
+	size_t length = 0;
+	const char *key = lua_tolstring(L, 2, &length);
+
+	auto row = table->rows.find(std::string(key, length));
+	if (row == table->rows.end()) {
+		lua_pushnil(L);
+		return 1;
+	}
+
+	if (row->second.empty()) {
+		lua_pushvalue(L, 2);
+		return 1;
+	}
+
+	int values = static_cast<int>(row->second.size());
+	luaL_checkstack(L, values, "too many columns");
+	for (int i = 0; i < values; i++)
+	{
+		lua_pushlstring(L, row->second[i].data(), row->second[i].length());
+	}
+
+	return values;
+}
+
+/**
+ * Function finds tag and compiled pattern given as arguments of _CheckTagRegex() and _MatchTag()
+ *
+ * @param[in]  L          lua_State object to config file
+ * @param[in]  audiofile  MediaLibCleaner::File object representing current file
+ * @param[in]  cache      MediaLibCleaner::RegexCache object with compiled patterns
+ * @param[in]  lp         std::unique_ptr to MediaLibCleaner::LogProgram object used for logging purposes
+ * @param[in]  name       Name of the lua function (for logging purposes)
+ * @param[out] value      Current value of the tag (kept in the store, not copied)
+ *
+ * @return Compiled pattern or nullptr if arguments are invalid (error is logged)
+ */
+static const boost::wregex* getTagRegex(lua_State *L, MediaLibCleaner::File* audiofile, MediaLibCleaner::RegexCache* cache, std::unique_ptr<MediaLibCleaner::LogProgram>* lp, const std::wstring &name, const wchar_t **value)
+{
+	int n = lua_gettop(L) - 1; // argc for function
+
+	if (n != 2 || !lua_isstring(L, 1) || !lua_isstring(L, 2)) { // requires tag and pattern
+		(*lp)->Log(name + L"(" + audiofile->GetPath() + L")", L"Function expects exactly 2 arguments: [tag, pattern] (" + std::to_wstring(n) + L" given)", 2);
+		return nullptr;
+	}
+
+	std::wstring tag = s2ws(lua_tostring(L, 1));
+	const MediaLibCleaner::TagInfo *info = MediaLibCleaner::FindTag(tag);
+	if (info == nullptr) {
+		(*lp)->Log(name + L"(" + audiofile->GetPath() + L")", L"Unknown tag: '" + tag + L"'", 2);
+		return nullptr;
+	}
+
+	std::wstring error;
+	const boost::wregex *regex = cache->Get(lua_tostring(L, 2), &error);
+	if (regex == nullptr) {
+		(*lp)->Log(name + L"(" + audiofile->GetPath() + L")", L"Invalid pattern: " + s2ws(lua_tostring(L, 2)) + L" (" + error + L")", 2);
+		return nullptr;
+	}
+
+	*value = audiofile->GetTagData(info);
+	return regex;
+}
+
+/**
+ * Function checks if whole value of given tag matches regular expression (Perl syntax), e.g. _CheckTagRegex("year", "(19|20)\d\d").
+ * Backslashes of the config file are escaped before it is run, so they are written in patterns once.
+ * Pattern is compiled once per run and matched directly on the value kept in the store.
+ *
+ * @param[in] L          lua_State object to config file
+ * @param[in] audiofile  MediaLibCleaner::File object representing current file
+ * @param[in] cache      MediaLibCleaner::RegexCache object with compiled patterns
+ * @param[in] lp         std::unique_ptr to MediaLibCleaner::LogProgram object used for logging purposes
+ * @param[in] la         std::unique_ptr to MediaLibCleaner::LogAlert object used for logging purposes
+ *
+ * @return Number of output arguments (for lua_register)
+ */
+int lua_CheckTagRegex(lua_State *L, MediaLibCleaner::File* audiofile, MediaLibCleaner::RegexCache* cache, std::unique_ptr<MediaLibCleaner::LogProgram>* lp, std::unique_ptr<MediaLibCleaner::LogAlert>* la) {
+	const wchar_t *value = nullptr;
+	const boost::wregex *regex = getTagRegex(L, audiofile, cache, lp, L"lua_CheckTagRegex", &value);
+
+	if (regex == nullptr) {
+		lua_pushboolean(L, false);
+		return 1;
+	}
+
+	bool retval = boost::regex_match(value, value + wcslen(value), *regex);
+	if (!retval)
+		(*la)->Log(audiofile->GetPath(), L"Tag '" + s2ws(lua_tostring(L, 1)) + L"' doesn't match pattern '" + s2ws(lua_tostring(L, 2)) + L"'; current value: '" + value + L"'");
+
+	lua_pushboolean(L, retval);
+	return 1;
+}
+
+/**
+ * Function searches value of given tag for regular expression (Perl syntax), e.g. artist, title = _MatchTag("title", "^(.+?) - (.+)$").
+ * Like string.match() in lua, it returns all captures of the first match (or whole match if pattern has no captures; nil for captures
+ * not taking part in the match), or nil if value does not match. Pattern is compiled once per run and matched directly on the value kept in the store.
+ *
+ * @param[in] L          lua_State object to config file
+ * @param[in] audiofile  MediaLibCleaner::File object representing current file
+ * @param[in] cache      MediaLibCleaner::RegexCache object with compiled patterns
+ * @param[in] lp         std::unique_ptr to MediaLibCleaner::LogProgram object used for logging purposes
+ * @param[in] la         std::unique_ptr to MediaLibCleaner::LogAlert object used for logging purposes
+ *
+ * @return Number of output arguments (for lua_register)
+ */
+int lua_MatchTag(lua_State *L, MediaLibCleaner::File* audiofile, MediaLibCleaner::RegexCache* cache, std::unique_ptr<MediaLibCleaner::LogProgram>* lp, std::unique_ptr<MediaLibCleaner::LogAlert>* la) {
+	const wchar_t *value = nullptr;
+	const boost::wregex *regex = getTagRegex(L, audiofile, cache, lp, L"lua_MatchTag", &value);
+
+	boost::wcmatch match;
+	if (regex == nullptr || !boost::regex_search(value, value + wcslen(value), match, *regex)) {
+		lua_pushnil(L);
+		return 1;
+	}
+
+	if (match.size() == 1) {
+		lua_pushstring(L, ws2s(match.str(0)).c_str());
+		return 1;
+	}
+
+	int captures = static_cast<int>(match.size()) - 1;
+	luaL_checkstack(L, captures, "too many captures");
+	for (int i = 1; i <= captures; i++)
+	{
+		if (match[i].matched) lua_pushstring(L, ws2s(match.str(i)).c_str());
+		else lua_pushnil(L);
+	}
+
+	return captures;
+}
+
+/**
+ * Function pushes list of strings as lua array (1-based table)
+ *
+ * @param[in] L       lua_State object to config file
+ * @param[in] values  Values of the list
+ */
+static void pushStringList(lua_State *L, const std::vector<std::wstring> &values)
+{
+	lua_createtable(L, static_cast<int>(values.size()), 0);
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		lua_pushstring(L, ws2s(values[i]).c_str());
+		lua_rawseti(L, -2, static_cast<lua_Integer>(i + 1));
+	}
+}
+
+/**
+ * Function pushes list of numbers as lua array (1-based table)
+ *
+ * @param[in] L       lua_State object to config file
+ * @param[in] values  Values of the list
+ */
+static void pushIntegerList(lua_State *L, const std::vector<int> &values)
+{
+	lua_createtable(L, static_cast<int>(values.size()), 0);
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		lua_pushinteger(L, values[i]);
+		lua_rawseti(L, -2, static_cast<lua_Integer>(i + 1));
+	}
+}
+
+/**
+ * Function pushes table describing directory of current file (set by the caller as dir global).
+ * Fields: path (full path of the directory), files, untracked (numbers and strings) and albums, albumartists, years, codecs, samplerates,
+ * tracks, track_gaps, track_duplicates (arrays). Empty table is pushed if there are no audio files in the directory.
+ *
+ * @param[in] L          lua_State object to config file
+ * @param[in] aggregate  Aggregate of the directory (may be nullptr)
+ */
+void lua_PushDirectory(lua_State *L, const MediaLibCleaner::DirectoryAggregate *aggregate)
+{
+	lua_newtable(L);
+	if (aggregate == nullptr) return;
+
+	lua_pushstring(L, ws2s(aggregate->path).c_str());
+	lua_setfield(L, -2, "path");
+	lua_pushinteger(L, aggregate->files);
+	lua_setfield(L, -2, "files");
+	lua_pushinteger(L, aggregate->untracked);
+	lua_setfield(L, -2, "untracked");
+
+	pushStringList(L, aggregate->albums);
+	lua_setfield(L, -2, "albums");
+	pushStringList(L, aggregate->albumartists);
+	lua_setfield(L, -2, "albumartists");
+	pushStringList(L, aggregate->years);
+	lua_setfield(L, -2, "years");
+	pushStringList(L, aggregate->codecs);
+	lua_setfield(L, -2, "codecs");
+	pushIntegerList(L, aggregate->samplerates);
+	lua_setfield(L, -2, "samplerates");
+
+	pushIntegerList(L, aggregate->tracks);
+	lua_setfield(L, -2, "tracks");
+	pushIntegerList(L, aggregate->track_gaps);
+	lua_setfield(L, -2, "track_gaps");
+	pushIntegerList(L, aggregate->track_duplicates);
+	lua_setfield(L, -2, "track_duplicates");
+}
+
+
+/**
+ * Function calls one of lua functions for the file of file view (see lua_PushFileView()).
+ * File, MediaLibCleaner::LogProgram and MediaLibCleaner::LogAlert objects are upvalues of the called closure.
+ *
+ * @param[in] L         lua_State object to config file
+ * @param[in] function  Function to call
+ *
+ * @return Number of output arguments (for lua_register)
+ */
+static int callFileView(lua_State *L, int (*function)(lua_State *, MediaLibCleaner::File*, std::unique_ptr<MediaLibCleaner::LogProgram>*, std::unique_ptr<MediaLibCleaner::LogAlert>*))
+{
+	auto audiofile = static_cast<MediaLibCleaner::File*>(lua_touserdata(L, lua_upvalueindex(1)));
+	auto lp = static_cast<std::unique_ptr<MediaLibCleaner::LogProgram>*>(lua_touserdata(L, lua_upvalueindex(2)));
+	auto la = static_cast<std::unique_ptr<MediaLibCleaner::LogAlert>*>(lua_touserdata(L, lua_upvalueindex(3)));
+
+	// view:SetTags(...) passes the view itself as the first argument
+	if (lua_istable(L, 1)) lua_remove(L, 1);
+
+	// functions expect one more value on the stack (__thread global pushed by callers of registered functions)
+	lua_pushnil(L);
+
+	return function(L, audiofile, lp, la);
+}
+
+/**
+ * SetTags method of file view
+ *
+ * @param[in] L  lua_State object to config file
+ *
+ * @return Number of output arguments (for lua_register)
+ */
+static int fileViewSetTags(lua_State *L)
+{
+	return callFileView(L, lua_SetTags);
+}
+
+/**
+ * RemoveTags method of file view
+ *
+ * @param[in] L  lua_State object to config file
+ *
+ * @return Number of output arguments (for lua_register)
+ */
+static int fileViewRemoveTags(lua_State *L)
+{
+	return callFileView(L, lua_RemoveTags);
+}
+
+/**
+ * Log method of file view
+ *
+ * @param[in] L  lua_State object to config file
+ *
+ * @return Number of output arguments (for lua_register)
+ */
+static int fileViewLog(lua_State *L)
+{
+	return callFileView(L, lua_Log);
+}
+
+/**
+ * Function pushes table describing single file to be used by _OnDirectory() hook: path, filename, values of all tags
+ * (by tag name, as in MediaLibCleaner::TagSchema), codec and samplerate, and methods SetTags, RemoveTags and Log
+ * working the same way as functions of the same names called for that file (view.SetTags(...) or view:SetTags(...)).
+ *
+ * @param[in] L          lua_State object to config file
+ * @param[in] audiofile  File the view describes
+ * @param[in] lp         std::unique_ptr to MediaLibCleaner::LogProgram object used for logging purposes
+ * @param[in] la         std::unique_ptr to MediaLibCleaner::LogAlert object used for logging purposes
+ */
+void lua_PushFileView(lua_State *L, MediaLibCleaner::File* audiofile, std::unique_ptr<MediaLibCleaner::LogProgram>* lp, std::unique_ptr<MediaLibCleaner::LogAlert>* la)
+{
+	lua_createtable(L, 0, MediaLibCleaner::TAGS_COUNT + 7);
+
+	lua_pushstring(L, ws2s(audiofile->GetPath()).c_str());
+	lua_setfield(L, -2, "path");
+	lua_pushstring(L, ws2s(audiofile->GetFilename()).c_str());
+	lua_setfield(L, -2, "filename");
+
+	for (int i = 0; i < MediaLibCleaner::TAGS_COUNT; i++)
+	{
+		const MediaLibCleaner::TagInfo *info = &MediaLibCleaner::TagSchema[i];
+		lua_pushstring(L, ws2s(audiofile->GetTag(info)).c_str());
+		lua_setfield(L, -2, ws2s(info->name).c_str());
+	}
+
+	lua_pushstring(L, ws2s(audiofile->GetCodec()).c_str());
+	lua_setfield(L, -2, "codec");
+	lua_pushinteger(L, audiofile->GetSampleRate());
+	lua_setfield(L, -2, "samplerate");
+
+	static const struct { const char *name; lua_CFunction function; } methods[] = {
+		{ "SetTags", fileViewSetTags },
+		{ "RemoveTags", fileViewRemoveTags },
+		{ "Log", fileViewLog }
+	};
+
+	for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++)
+	{
+		lua_pushlightuserdata(L, audiofile);
+		lua_pushlightuserdata(L, lp);
+		lua_pushlightuserdata(L, la);
+		lua_pushcclosure(L, methods[i].function, 3);
+		lua_setfield(L, -2, methods[i].name);
+	}
+}
+
+
 /**
  * Function redirecting lua errors to MediaLibCleaner::LogProgram as an error message
  *
@@ -12,8 +12,15 @@
 #include <memory>
 
 #include "MediaLibCleaner.hpp"
+#include "DirectoryAggregator.hpp"
+#include "NameClusterer.hpp"
+#include "RegexCache.hpp"
+#include "ValueSets.hpp"
+#include "LookupTables.hpp"
 
 int lua_IsAudioFile(lua_State *, MediaLibCleaner::File*, std::unique_ptr<MediaLibCleaner::LogProgram>*, std::unique_ptr<MediaLibCleaner::LogAlert>*);
+int lua_IsDuplicate(lua_State *, MediaLibCleaner::File*, std::unique_ptr<MediaLibCleaner::LogProgram>*, std::unique_ptr<MediaLibCleaner::LogAlert>*);
+int lua_IsIntact(lua_State *, MediaLibCleaner::File*, std::unique_ptr<MediaLibCleaner::LogProgram>*, std::unique_ptr<MediaLibCleaner::LogAlert>*);
 int lua_SetTags(lua_State *, MediaLibCleaner::File*, std::unique_ptr<MediaLibCleaner::LogProgram>*, std::unique_ptr<MediaLibCleaner::LogAlert>*);
 int lua_RemoveTags(lua_State *, MediaLibCleaner::File*, std::unique_ptr<MediaLibCleaner::LogProgram>*, std::unique_ptr<MediaLibCleaner::LogAlert>*);
 int lua_SetRequiredTags(lua_State *, MediaLibCleaner::File*, std::unique_ptr<MediaLibCleaner::LogProgram>*, std::unique_ptr<MediaLibCleaner::LogAlert>*);
@@ -22,5 +29,14 @@ int lua_Rename(lua_State *, MediaLibCleaner::File*, std::unique_ptr<MediaLibClea
 int lua_Move(lua_State *, MediaLibCleaner::File*, std::string, std::unique_ptr<MediaLibCleaner::LogProgram>*, std::unique_ptr<MediaLibCleaner::LogAlert>*);
 int lua_Delete(lua_State *, MediaLibCleaner::File*, std::unique_ptr<MediaLibCleaner::LogProgram>*, std::unique_ptr<MediaLibCleaner::LogAlert>*);
 int lua_Log(lua_State *, MediaLibCleaner::File*, std::unique_ptr<MediaLibCleaner::LogProgram>*, std::unique_ptr<MediaLibCleaner::LogAlert>*);
+int lua_CanonicalName(lua_State *, MediaLibCleaner::NameClusterer*, std::unique_ptr<MediaLibCleaner::LogProgram>*, std::unique_ptr<MediaLibCleaner::LogAlert>*);
+int lua_CheckTagRegex(lua_State *, MediaLibCleaner::File*, MediaLibCleaner::RegexCache*, std::unique_ptr<MediaLibCleaner::LogProgram>*, std::unique_ptr<MediaLibCleaner::LogAlert>*);
+int lua_MatchTag(lua_State *, MediaLibCleaner::File*, MediaLibCleaner::RegexCache*, std::unique_ptr<MediaLibCleaner::LogProgram>*, std::unique_ptr<MediaLibCleaner::LogAlert>*);
+int lua_DefineValueSet(lua_State *, MediaLibCleaner::ValueSets*, std::unique_ptr<MediaLibCleaner::LogProgram>*, std::unique_ptr<MediaLibCleaner::LogAlert>*);
+int lua_ValueSet(lua_State *, MediaLibCleaner::ValueSets*, std::unique_ptr<MediaLibCleaner::LogProgram>*, std::unique_ptr<MediaLibCleaner::LogAlert>*);
+int lua_LoadTable(lua_State *, MediaLibCleaner::LookupTables*, std::unique_ptr<MediaLibCleaner::LogProgram>*, std::unique_ptr<MediaLibCleaner::LogAlert>*);
+int lua_Lookup(lua_State *, MediaLibCleaner::LookupTables*, std::unique_ptr<MediaLibCleaner::LogProgram>*, std::unique_ptr<MediaLibCleaner::LogAlert>*);
 
+void lua_PushDirectory(lua_State *, const MediaLibCleaner::DirectoryAggregate*);
+void lua_PushFileView(lua_State *, MediaLibCleaner::File*, std::unique_ptr<MediaLibCleaner::LogProgram>*, std::unique_ptr<MediaLibCleaner::LogAlert>*);
 void lua_ErrorReporting(lua_State *, int, std::unique_ptr<MediaLibCleaner::LogProgram>*);
\ No newline at end of file
@@ -7,6 +7,9 @@
  */
 
 #include "MediaLibCleaner.hpp"
+#include "FormatBackend.hpp"
+#include "FastTagReader.hpp"
+#include "RegexCache.hpp"
 
 
 
@@ -14,12 +17,14 @@
  * Constructor for MediaLibCleaner::File class.
  * 
  * File class constructor creaties instance of TagLib::FileRef object (or simillar) and reads all common tags from the file.
+ * TagLib objects are closed as soon as all values are read - they are reopened only to save tag changes (see save()).
  * @param[in] path        Path to audio file this instance will represent
  * @param[in] dfc	      An instance of MediaLibCleaner::DFC
  * @param[in] logprogram  std::unique_ptr to MediaLibCleaner::LogProgram object for logging purposses
  * @param[in] logalert    std::unique_ptr to MediaLibCleaner::LogAlert object for logging purposses
+ * @param[in] runcontext  std::unique_ptr to MediaLibCleaner::RunContext object (tag writing settings and statistics)
  */
-MediaLibCleaner::File::File(std::wstring path, MediaLibCleaner::DFC* dfc, std::unique_ptr<MediaLibCleaner::LogProgram>* logprogram, std::unique_ptr<MediaLibCleaner::LogAlert>* logalert)
+MediaLibCleaner::File::File(std::wstring path, MediaLibCleaner::DFC* dfc, std::unique_ptr<MediaLibCleaner::LogProgram>* logprogram, std::unique_ptr<MediaLibCleaner::LogAlert>* logalert, std::unique_ptr<MediaLibCleaner::RunContext>* runcontext)
 {
 	//>> - CASE: This is fast for atmosferic entry. Should we use thrusters to slow?
 	//>> - C: No. I'm gonna use Rangers aerodynamics to save some fuel.
@@ -50,10 +55,12 @@ MediaLibCleaner::File::File(std::wstring path, MediaLibCleaner::DFC* dfc, std::u
 	//>> - C: Fire!
 
 
-	this->d_path = path;
 	this->d_dfc = dfc;
 	this->logalert = logalert;
 	this->logprogram = logprogram;
+	this->runcontext = runcontext;
+	this->store = (*this->runcontext)->GetStore();
+	this->row = this->store->AddRow(path);
 
 	(*this->logprogram)->Log(L"MediaLibCleaner::File(" + path + L")", L"Beginning: " + path, 3);
 
@@ -63,212 +70,104 @@ MediaLibCleaner::File::File(std::wstring path, MediaLibCleaner::DFC* dfc, std::u
 		return;
 	}
 
-	std::unique_ptr <TagLib::FileRef> f(new TagLib::FileRef(TagLib::FileName(this->d_path.c_str())));
-
-	this->fileref.swap(f);
-
-	// BOOST INIT FOR PATH INFORMATIONS
-	namespace fs = boost::filesystem;
-	fs::path temp = this->d_path;
-	fs::path fileParentDir = temp.parent_path();
-	fs::path pDirParentDir = fileParentDir.parent_path();
-
 	// PATH INFO
-	(*this->logprogram)->Log(L"MediaLibCleaner::File(" + path + L")", L"Reading path informations", 3);
-	try {
-		this->d_directory = fileParentDir.filename().wstring();
-		this->d_ext = temp.extension().wstring();					if (this->d_ext.length() > 1) { this->d_ext = this->d_ext.substr(1); }
-		this->d_filename = temp.filename().wstring();				this->d_filename = this->d_filename.substr(0, this->d_filename.length() - this->d_ext.length() - 1);
-		this->d_folderpath = fileParentDir.wstring();
-		this->d_parent_dir = pDirParentDir.filename().wstring();
-		// _path is setted before - required
-#ifdef WIN32
-		this->d_volume = temp.root_name().wstring();
-#endif
-	}
-	catch (...)
-	{
-		(*this->logprogram)->Log(L"MediaLibCleaner::File(" + path + L")", L"File path info reading failed", 2);
-	}
+	// directory and file name are kept by the store, rest of path informations is derived from them (see GetDirectory() etc.)
+	namespace fs = boost::filesystem;
+	fs::path temp = path;
+	std::wstring ext = this->GetExt();
 
 	// STAT INIT FOR DATE INFORMATION
 	// WARNING: MAY ONLY WORK IN WINDOWS!!!
 
 	struct stat attrib;
-	stat(ws2s(this->d_path).c_str(), &attrib);
+	stat(ws2s(this->GetPath()).c_str(), &attrib);
 
 	// FILE PROPERTIES
 	(*this->logprogram)->Log(L"MediaLibCleaner::File(" + path + L")", L"Reading file properties", 3);
 	try {
-		this->d_file_create_datetime_raw = attrib.st_ctime;
-		this->d_file_mod_datetime_raw = attrib.st_mtime;
-		this->d_file_size_bytes = static_cast<size_t>(fs::file_size(temp));
+		this->setNumber(COLUMN_CREATE_TIME, attrib.st_ctime);
+		this->setNumber(COLUMN_MOD_TIME, attrib.st_mtime);
+		this->setNumber(COLUMN_FILE_SIZE, static_cast<size_t>(fs::file_size(temp)));
 	}
 	catch (const boost::filesystem::filesystem_error& e)
 	{
 		(*this->logprogram)->Log(L"MediaLibCleaner::File(" + path + L")", L"File properities reading failed: " + s2ws(e.code().message()), 2);
 	}
 
-	// check if file is in fact audio file (as it sometimes cannot be!)
+	// check if file is in fact audio file (as it sometimes cannot be!) - by its first bytes, without TagLib
 	// effect: this->isInitalized == false, but rest info (about files) is present
-	if (this->fileref->isNull()) return;
-	
-	// SONG INFO
-	(*this->logprogram)->Log(L"MediaLibCleaner::File(" + path + L")", L"Reading basic song tags", 3);
-	this->artist = this->fileref->tag()->artist();
-	this->title = this->fileref->tag()->title();
-	this->album = this->fileref->tag()->album();
-	this->genre = this->fileref->tag()->genre();
-	this->comment = this->fileref->tag()->comment();
-	this->track = std::to_wstring(this->fileref->tag()->track());
-	this->year = std::to_wstring(this->fileref->tag()->year());
-	// rest of aliases defined below
-
-	// TECHNICAL INFO
-	(*this->logprogram)->Log(L"MediaLibCleaner::File(" + path + L")", L"Reading technical file info", 3);
-	this->d_bitrate = this->fileref->audioProperties()->bitrate();
-	this->d_channels = this->fileref->audioProperties()->channels();
-	this->d_sampleRate = this->fileref->audioProperties()->sampleRate();
-	this->d_length = this->fileref->audioProperties()->length();
-
-	TagLib::FileRef *fr = this->fileref.release();
-	delete fr;
-
-	// CAN WORK WITH THE REST OF ALIASES NOW,
-	// SINCE _EXT IS AVALIABLE
-
-	//check for file type
 	(*this->logprogram)->Log(L"MediaLibCleaner::File(" + path + L")", L"Checking file type and creating appropirate objects", 3);
-	if (this->d_ext == L"mp3") {
-		this->d_codec = L"MPEG 1 Layer III";
-
-		std::unique_ptr<TagLib::MPEG::File> temp(new TagLib::MPEG::File(TagLib::FileName(this->d_path.c_str())));
-		temp.swap(this->taglib_file_mp3);
-
-		if (!this->taglib_file_mp3->isValid())
-		{
-			this->isInitiated = false;
-			this->filetype = FILETYPE_UNKNOWN;
-			return;
-		}
-
-		this->filetype = FILETYPE_MP3;
-	}
-	else if (this->d_ext == L"ogg" || this->d_ext == L"oga") {
-		this->d_codec = L"Vorbis";
-
-		std::unique_ptr<TagLib::Ogg::Vorbis::File> temp(new TagLib::Ogg::Vorbis::File(TagLib::FileName(this->d_path.c_str())));
-		temp.swap(this->taglib_file_ogg);
-
-		if (!this->taglib_file_ogg->isValid())
-		{
-			this->isInitiated = false;
-			this->filetype = FILETYPE_UNKNOWN;
-			return;
-		}
+	FileType by_ext = GetFileTypeByExtension(ext);
+	bool recognized = false;
+	FileType by_content = SniffFileType(this->GetPath(), &recognized);
 
-		this->filetype = FILETYPE_OGG;
+	if (by_content != by_ext && (by_content != FILETYPE_UNKNOWN || by_ext != FILETYPE_UNKNOWN))
+	{
+		(*this->logprogram)->Log(L"MediaLibCleaner::File(" + path + L")", L"File extension does not match its content (extension: " + FileTypeName(by_ext) + L", content: " + FileTypeName(by_content) + L")", 2);
 	}
-	else if (this->d_ext == L"flac") {
-		this->d_codec = L"Free Lossless Audio Codec";
 
-		std::unique_ptr<TagLib::FLAC::File> temp(new TagLib::FLAC::File(TagLib::FileName(this->d_path.c_str())));
-		temp.swap(this->taglib_file_flac);
+	// content decides; extension is used only if content was not recognized (for example MP3 with garbage before first frame),
+	// so videos and images in MP4 container are skipped even if their extension is mp4 or m4a
+	FileType type = recognized ? by_content : by_ext;
 
-		if (!this->taglib_file_flac->isValid())
-		{
-			this->isInitiated = false;
-			this->filetype = FILETYPE_UNKNOWN;
-			return;
-		}
+	this->backend = CreateFormatBackend(type, (*this->runcontext)->GetArena());
 
-		this->filetype = FILETYPE_FLAC;
+	if (this->backend == nullptr)
+	{
+		this->isInitiated = false;
+		return;
 	}
-	else if (this->d_ext == L"m4a" || this->d_ext == L"mp4" || this->d_ext == L"aac") {
-		std::unique_ptr<TagLib::MP4::File> temp(new TagLib::MP4::File(TagLib::FileName(this->d_path.c_str())));
-		temp.swap(this->taglib_file_m4a);
 
-		if (!this->taglib_file_m4a->isValid())
-		{
-			this->isInitiated = false;
-			this->filetype = FILETYPE_UNKNOWN;
-			return;
-		}
+	PropertyAccuracy accuracy = (*this->runcontext)->GetPropertyAccuracy();
 
-		this->filetype = FILETYPE_MP4;
-
-		auto audioProp = this->taglib_file_m4a->audioProperties();
-		switch (audioProp->codec())
-		{
-		case TagLib::MP4::Properties::ALAC:
-			this->d_codec = L"MPEG-4 ALAC";
-			break;
-		case TagLib::MP4::Properties::AAC:
-			this->d_codec = L"MPEG-4 AAC";
-			break;
-		default:
-		case TagLib::MP4::Properties::Unknown:
-			this->d_codec = L"MPEG-4";
-			break;
-		}
+	// tags are read straight from the mapped file if parser understands all of it; TagLib object is created only when tags are saved
+	FastTags fast;
+	if ((*this->runcontext)->GetFastScan() && ReadTagsFast(this->GetPath(), type, accuracy, &fast))
+	{
+		(*this->logprogram)->Log(L"MediaLibCleaner::File(" + path + L")", L"Tags read by fast parser", 3);
+		this->storeFastTags(fast);
 	}
-	else
+	else if (!this->backend->Open(this->GetPath(), accuracy) || this->backend->GetFile()->tag() == nullptr)
 	{
+		this->closeHandles();
+		this->backend = nullptr;
 		this->isInitiated = false;
-		this->filetype = FILETYPE_UNKNOWN;
-
 		return;
 	}
-
-
-	if (this->filetype == FILETYPE_MP3) { // ID3v1, ID3v2 or APE tags present
-		(*this->logprogram)->Log(L"MediaLibCleaner::File(" + path + L")", L"Is MP3 file", 3);
-		TagLib::ID3v2::Tag *id3v2tag = this->taglib_file_mp3->ID3v2Tag();
-		TagLib::APE::Tag *apetag = this->taglib_file_mp3->APETag();
-
-		if (this->taglib_file_mp3->hasID3v2Tag()) {
-			(*this->logprogram)->Log(L"MediaLibCleaner::File(" + path + L")", L"Reading ID3v2 tags", 3);
-			this->getID3v2Tags(id3v2tag);
-		}
-		
-		else if (this->taglib_file_mp3->hasAPETag()) {
-			(*this->logprogram)->Log(L"MediaLibCleaner::File(" + path + L")", L"Reading APE tags", 3);
-			TagLib::APE::ItemListMap tags = apetag->itemListMap();
-			this->getAPEv2Tags(tags);
-		}
-		else {
-			// ID3v1 dosen't have any of the extended tags
-			// clear them out to be on the safe side
-			(*this->logprogram)->Log(L"MediaLibCleaner::File(" + path + L")", L"Has ID3v1 tags", 3);
-			this->clearExtendedTags();
+	else
+	{
+		(*this->logprogram)->Log(L"MediaLibCleaner::File(" + path + L")", L"Tags read by TagLib", 3);
+
+		TagLib::Tag *tag = this->backend->GetFile()->tag();
+		TagLib::AudioProperties *properties = this->backend->GetFile()->audioProperties();
+
+		// SONG INFO
+		(*this->logprogram)->Log(L"MediaLibCleaner::File(" + path + L")", L"Reading basic song tags", 3);
+		this->setField(COLUMN_ARTIST, tag->artist());
+		this->setField(COLUMN_TITLE, tag->title());
+		this->setField(COLUMN_ALBUM, tag->album());
+		this->setField(COLUMN_GENRE, tag->genre());
+		this->setField(COLUMN_COMMENT, tag->comment());
+		this->setField(COLUMN_TRACK, std::to_wstring(tag->track()));
+		this->setField(COLUMN_YEAR, std::to_wstring(tag->year()));
+		// rest of aliases are read by the backend
+
+		// TECHNICAL INFO
+		// not read at all if _property_accuracy is "none" (values stay 0)
+		if (properties != nullptr)
+		{
+			(*this->logprogram)->Log(L"MediaLibCleaner::File(" + path + L")", L"Reading technical file info", 3);
+			this->setNumber(COLUMN_BITRATE, properties->bitrate());
+			this->setNumber(COLUMN_CHANNELS, properties->channels());
+			this->setNumber(COLUMN_SAMPLERATE, properties->sampleRate());
+			this->setNumber(COLUMN_DURATION, properties->length());
 		}
-	}
-	else if (this->filetype == FILETYPE_OGG) {
-		(*this->logprogram)->Log(L"MediaLibCleaner::File(" + path + L")", L"Is OGG file", 3);
-		this->getVorbisXiphTags(this->taglib_file_ogg->tag());
-	}
-	else if (this->filetype == FILETYPE_FLAC) {
-		(*this->logprogram)->Log(L"MediaLibCleaner::File(" + path + L")", L"Is FLAC file", 3);
 
-		if (this->taglib_file_flac->hasXiphComment()) {
-			(*this->logprogram)->Log(L"MediaLibCleaner::File(" + path + L")", L"Reading Xiph comments", 3);
-			this->getFLACXiphTags(this->taglib_file_flac->xiphComment());
-		}
-		else if (this->taglib_file_flac->hasID3v2Tag()) {
-			(*this->logprogram)->Log(L"MediaLibCleaner::File(" + path + L")", L"Reading ID3v2 tags", 3);
-			this->getID3v2Tags(this->taglib_file_flac->ID3v2Tag());
-		}
-		else {
-			// ID3v1 dosen't have any of the extended tags
-			// clear them out to be on the safe side
-			(*this->logprogram)->Log(L"MediaLibCleaner::File(" + path + L")", L"Has ID3v1 tags", 3);
-			this->clearExtendedTags();
-		}
-	}
-	else if (this->filetype == FILETYPE_MP4)
-	{
-		(*this->logprogram)->Log(L"MediaLibCleaner::File(" + path + L")", L"Is MP4/M4A file", 3);
-		this->getM4ATags();
+		this->setField(COLUMN_CODEC, this->backend->GetCodec());
+		this->backend->ReadTags(this);
+
+		// all values are read - TagLib object is not needed until tags are saved (see save())
+		this->closeHandles();
 	}
 
 
@@ -284,9 +183,38 @@ MediaLibCleaner::File::File(std::wstring path, MediaLibCleaner::DFC* dfc, std::u
 
 /**
  * Deconstructor for MediaLibCleaner::File class.
+ *
+ * Files allocated in MediaLibCleaner::Arena are not destructed - arena memory is freed all at once.
+ * It is safe, since TagLib objects are closed after scan and after save(), so File does not own any other memory.
  */
 MediaLibCleaner::File::~File() {
-	(*this->logprogram)->Log(L"MediaLibCleaner::File(" + this->d_path + L")", L"Calling destructor", 3);
+}
+
+/**
+ * Allocates memory for MediaLibCleaner::File object in given arena.
+ *
+ * @param[in] size   Size of the object
+ * @param[in] arena  Arena to allocate object in
+ *
+ * @return Pointer to allocated memory
+ */
+void* MediaLibCleaner::File::operator new(size_t size, MediaLibCleaner::Arena *arena)
+{
+	return arena->Allocate(size);
+}
+
+/**
+ * Called only if MediaLibCleaner::File constructor throws - memory is freed together with the arena.
+ */
+void MediaLibCleaner::File::operator delete(void*, MediaLibCleaner::Arena*)
+{
+}
+
+/**
+ * Called when MediaLibCleaner::File object is deleted - memory is freed together with the arena.
+ */
+void MediaLibCleaner::File::operator delete(void*)
+{
 }
 
 
@@ -294,6 +222,32 @@ MediaLibCleaner::File::~File() {
 
 // SONG INFO
 
+/**
+ * Method allowing to read any supported tag from an audio file
+ *
+ * @param[in] info  Description of the tag (see MediaLibCleaner::TagSchema)
+ *
+ * @return Value of the tag or empty string if file is not audio file
+ */
+std::wstring MediaLibCleaner::File::GetTag(const TagInfo *info) {
+	if (this->isInitiated)
+		return this->getField(info->column);
+	return L"";
+}
+
+/**
+ * Method returns value of any supported tag as kept in the store, without copying it (for matching by regular expressions)
+ *
+ * @param[in] info  Description of the tag (see MediaLibCleaner::TagSchema)
+ *
+ * @return Value of the tag (valid until the end of the run) or empty string if file is not audio file; never nullptr
+ */
+const wchar_t* MediaLibCleaner::File::GetTagData(const TagInfo *info) {
+	if (this->isInitiated)
+		return this->store->GetStringData(this->row, info->column);
+	return L"";
+}
+
 /**
  * Method allowing to read \%artist% tag from an audio file
  *
@@ -301,7 +255,7 @@ MediaLibCleaner::File::~File() {
  */
 std::wstring MediaLibCleaner::File::GetArtist() {
 	if (this->isInitiated)
-		return this->artist.toWString();
+		return this->getField(COLUMN_ARTIST);
 	return L"";
 }
 
@@ -312,7 +266,7 @@ std::wstring MediaLibCleaner::File::GetArtist() {
 */
 std::wstring MediaLibCleaner::File::GetTitle() {
 	if (this->isInitiated)
-		return this->title.toWString();
+		return this->getField(COLUMN_TITLE);
 	return L"";
 }
 
@@ -323,7 +277,7 @@ std::wstring MediaLibCleaner::File::GetTitle() {
 */
 std::wstring MediaLibCleaner::File::GetAlbum() {
 	if (this->isInitiated)
-		return this->album.toWString();
+		return this->getField(COLUMN_ALBUM);
 	return L"";
 }
 
@@ -334,7 +288,7 @@ std::wstring MediaLibCleaner::File::GetAlbum() {
 */
 std::wstring MediaLibCleaner::File::GetGenre() {
 	if (this->isInitiated)
-		return this->genre.toWString();
+		return this->getField(COLUMN_GENRE);
 	return L"";
 }
 
@@ -345,7 +299,7 @@ std::wstring MediaLibCleaner::File::GetGenre() {
 */
 std::wstring MediaLibCleaner::File::GetComment() {
 	if (this->isInitiated)
-		return this->comment.toWString();
+		return this->getField(COLUMN_COMMENT);
 	return L"";
 }
 
@@ -356,7 +310,7 @@ std::wstring MediaLibCleaner::File::GetComment() {
 */
 std::wstring MediaLibCleaner::File::GetTrack() {
 	if (this->isInitiated)
-		return this->track.toWString();
+		return this->getField(COLUMN_TRACK);
 	return L"";
 }
 
@@ -367,7 +321,7 @@ std::wstring MediaLibCleaner::File::GetTrack() {
 */
 std::wstring MediaLibCleaner::File::GetYear() {
 	if (this->isInitiated)
-		return this->year.toWString();
+		return this->getField(COLUMN_YEAR);
 	return L"";
 }
 
@@ -378,7 +332,7 @@ std::wstring MediaLibCleaner::File::GetYear() {
 */
 std::wstring MediaLibCleaner::File::GetAlbumArtist() {
 	if (this->isInitiated)
-		return this->albumartist.toWString();
+		return this->getField(COLUMN_ALBUMARTIST);
 	return L"";
 }
 
@@ -389,7 +343,7 @@ std::wstring MediaLibCleaner::File::GetAlbumArtist() {
 */
 std::wstring MediaLibCleaner::File::GetBPM() {
 	if (this->isInitiated)
-		return this->bpm.toWString();
+		return this->getField(COLUMN_BPM);
 	return L"";
 }
 
@@ -400,7 +354,7 @@ std::wstring MediaLibCleaner::File::GetBPM() {
 */
 std::wstring MediaLibCleaner::File::GetCopyright() {
 	if (this->isInitiated)
-		return this->copyright.toWString();
+		return this->getField(COLUMN_COPYRIGHT);
 	return L"";
 }
 
@@ -411,7 +365,7 @@ std::wstring MediaLibCleaner::File::GetCopyright() {
 */
 std::wstring MediaLibCleaner::File::GetLanguage() {
 	if (this->isInitiated)
-		return this->language.toWString();
+		return this->getField(COLUMN_LANGUAGE);
 	return L"";
 }
 
@@ -422,7 +376,7 @@ std::wstring MediaLibCleaner::File::GetLanguage() {
 */
 std::wstring MediaLibCleaner::File::GetTagLength() {
 	if (this->isInitiated)
-		return this->length.toWString();
+		return this->getField(COLUMN_LENGTH);
 	return L"";
 }
 
@@ -433,7 +387,7 @@ std::wstring MediaLibCleaner::File::GetTagLength() {
 */
 std::wstring MediaLibCleaner::File::GetMood() {
 	if (this->isInitiated)
-		return this->mood.toWString();
+		return this->getField(COLUMN_MOOD);
 	return L"";
 }
 
@@ -444,7 +398,7 @@ std::wstring MediaLibCleaner::File::GetMood() {
 */
 std::wstring MediaLibCleaner::File::GetOrigAlbum() {
 	if (this->isInitiated)
-		return this->origalbum.toWString();
+		return this->getField(COLUMN_ORIGALBUM);
 	return L"";
 }
 
@@ -455,7 +409,7 @@ std::wstring MediaLibCleaner::File::GetOrigAlbum() {
 */
 std::wstring MediaLibCleaner::File::GetOrigArtist() {
 	if (this->isInitiated)
-		return this->origartist.toWString();
+		return this->getField(COLUMN_ORIGARTIST);
 	return L"";
 }
 
@@ -466,7 +420,7 @@ std::wstring MediaLibCleaner::File::GetOrigArtist() {
 */
 std::wstring MediaLibCleaner::File::GetOrigFilename() {
 	if (this->isInitiated)
-		return this->origfilename.toWString();
+		return this->getField(COLUMN_ORIGFILENAME);
 	return L"";
 }
 
@@ -477,7 +431,7 @@ std::wstring MediaLibCleaner::File::GetOrigFilename() {
 */
 std::wstring MediaLibCleaner::File::GetOrigYear() {
 	if (this->isInitiated)
-		return this->origyear.toWString();
+		return this->getField(COLUMN_ORIGYEAR);
 	return L"";
 }
 
@@ -488,7 +442,7 @@ std::wstring MediaLibCleaner::File::GetOrigYear() {
 */
 std::wstring MediaLibCleaner::File::GetPublisher() {
 	if (this->isInitiated)
-		return this->publisher.toWString();
+		return this->getField(COLUMN_PUBLISHER);
 	return L"";
 }
 
@@ -499,7 +453,7 @@ std::wstring MediaLibCleaner::File::GetPublisher() {
 */
 std::wstring MediaLibCleaner::File::GetLyricsUnsynced() {
 	if (this->isInitiated)
-		return this->unsyncedlyrics.toWString();
+		return this->getField(COLUMN_UNSYNCEDLYRICS);
 	return L"";
 }
 
@@ -510,7 +464,7 @@ std::wstring MediaLibCleaner::File::GetLyricsUnsynced() {
 */
 std::wstring MediaLibCleaner::File::GetWWW() {
 	if (this->isInitiated)
-		return this->www.toWString();
+		return this->getField(COLUMN_WWW);
 	return L"";
 }
 
@@ -520,786 +474,172 @@ std::wstring MediaLibCleaner::File::GetWWW() {
 /**
 * Method allowing for easy tags setting
 *
-* @param[in] id3tag   ID3v2 frame name of given tag
-* @param[in] xiphtag  XiphComment tag name
-* @param[in] apetag   APEv2 tag name
-* @param[in] mp4tag   M4A/MP4 tag name
-* @param[in] value    New value of given tag
+* @param[in] info   Description of the tag (see MediaLibCleaner::TagSchema)
+* @param[in] value  New value of given tag
 *
 * @return Status of changing tag value operation
 */
-bool MediaLibCleaner::File::setTagUniversal(std::string id3tag, std::string xiphtag, std::string apetag, std::string mp4tag, TagLib::String value)
+bool MediaLibCleaner::File::setTagUniversal(const TagInfo *info, TagLib::String value)
 {
 	if (this->isInitiated)
 	{
-		(*this->logprogram)->Log(L"setTagUniversal(" + this->d_path + L")", L"Setting tag to new value", 3);
-
-		if (this->filetype == FILETYPE_MP3)
-		{
-			(*this->logprogram)->Log(L"setTagUniversal(" + this->d_path + L")", L"MP3 file detected", 3);
-			if ((!this->taglib_file_mp3->hasID3v2Tag() && !this->taglib_file_mp3->hasAPETag()) || this->taglib_file_mp3->hasID3v2Tag())
-			{
-				TagLib::ID3v2::Tag *tag = this->taglib_file_mp3->ID3v2Tag(true);
-				this->setID3v2Tag(value, id3tag, tag);
-			}
-
-			if (this->taglib_file_mp3->hasAPETag())
-			{
-				TagLib::APE::Tag *tag = this->taglib_file_mp3->APETag(true);
-				this->setAPEv2Tag(value, apetag, tag);
-			}
-		}
-		else if (this->filetype == FILETYPE_OGG)
-		{
-			(*this->logprogram)->Log(L"setTagUniversal(" + this->d_path + L")", L"OGG file detected", 3);
+		(*this->logprogram)->Log(L"setTagUniversal(" + this->GetPath() + L")", L"Setting tag to new value", 3);
 
-			TagLib::Ogg::XiphComment *tag = this->taglib_file_ogg->tag();
-			this->setXiphTag(value, xiphtag, tag);
-		}
-		else if (this->filetype == FILETYPE_FLAC)
-		{
-			(*this->logprogram)->Log(L"setTagUniversal(" + this->d_path + L")", L"FLAC file detected", 3);
-			if ((!this->taglib_file_flac->hasID3v2Tag() && !this->taglib_file_flac->hasXiphComment()) || this->taglib_file_flac->hasID3v2Tag())
-			{
-				TagLib::ID3v2::Tag *tag = this->taglib_file_flac->ID3v2Tag(true);
-				this->setID3v2Tag(value, id3tag, tag);
-			}
-
-			if (this->taglib_file_flac->hasXiphComment())
-			{
-				TagLib::Ogg::XiphComment *tag = this->taglib_file_flac->xiphComment(true);
-				this->setXiphTag(value, xiphtag, tag);
-			}
-		}
-		else if (this->filetype == FILETYPE_MP4)
-		{
-			(*this->logprogram)->Log(L"setTagUniversal(" + this->d_path + L")", L"M4A/MP4 file detected", 3);
-
-			TagLib::MP4::Tag *tag = this->taglib_file_m4a->tag();
-
-			this->setM4ATag(value, mp4tag, tag);
-		}
+		this->backend->SetTag(this, info, value);
 		return true;
 	}
 	return false;
 }
 
 /**
- * Reads and stores all extended tags read from TagLib::ID3v2::Tag object
+ * Stores all values read by read-only parser (see MediaLibCleaner::ReadTagsFast())
  *
- * @param[in] id3v2tag  Object holding interface to read ID3v2 tags
+ * @param[in] fast  Values read from the file
  */
-void MediaLibCleaner::File::getID3v2Tags(TagLib::ID3v2::Tag *id3v2tag)
+void MediaLibCleaner::File::storeFastTags(const FastTags &fast)
 {
-	TagLib::ID3v2::FrameList::ConstIterator it = id3v2tag->frameList().begin();
-	for (; it != id3v2tag->frameList().end(); ++it) {
-		std::wstring name = TagLib::String((*it)->frameID()).toWString();
-		std::wstring value = (*it)->toString().toWString();
+	for (int i = 0; i < TAGS_COUNT; i++)
+		this->setField(TagSchema[i].column, fast.tags[i]);
 
-		if (name == L"TPE2") {
-			this->albumartist = value;
-		}
-		else if (name == L"TBPM") {
-			this->bpm = value;
-		}
-		else if (name == L"TCOP") {
-			this->copyright = value;
-		}
-		else if (name == L"TLAN") {
-			this->language = value;
-		}
-		else if (name == L"TLEN") {
-			this->length = value;
-		}
-		else if (name == L"TMOO") {
-			this->mood = value;
-		}
-		else if (name == L"TXXX" && value.substr(0, 6) == L"[MOOD]") {
-			this->mood = value.substr(12); // format: [MOOD] MOOD %mood%
-		}
-		else if (name == L"TOAL") {
-			this->origalbum = value;
-		}
-		else if (name == L"TOPE") {
-			this->origartist = value;
-		}
-		else if (name == L"TOFN") {
-			this->origfilename = value;
-		}
-		else if (name == L"TDOR") {
-			this->origyear = value;
-		}
-		else if (name == L"TPUB") {
-			this->publisher = value;
-		}
-		else if (name == L"USLT") {
-			this->unsyncedlyrics = value;
-		}
-		else if (name == L"WXXX" && value.substr(0, 2) == L"[]") {
-			this->www = value.substr(3);// format: [] www
-		}
-		else if (name == L"APIC")
-		{
-			this->d_covers++;
-
-			if (this->d_covers == 1)
-			{
-				TagLib::ID3v2::AttachedPictureFrame *frame = dynamic_cast<TagLib::ID3v2::AttachedPictureFrame*>(*it);
-				this->d_cover_mimetype = frame->mimeType().toWString();
-				this->d_cover_size = static_cast<size_t>(frame->size());
-
-				switch (frame->type())
-				{
-				default:
-				case TagLib::ID3v2::AttachedPictureFrame::Type::Other:
-					this->d_cover_type = L"other";
-					break;
-				case TagLib::ID3v2::AttachedPictureFrame::Type::FileIcon:
-					this->d_cover_type = L"file icon";
-					break;
-				case TagLib::ID3v2::AttachedPictureFrame::Type::OtherFileIcon:
-					this->d_cover_type = L"other file icon";
-					break;
-				case TagLib::ID3v2::AttachedPictureFrame::Type::FrontCover:
-					this->d_cover_type = L"front cover";
-					break;
-				case TagLib::ID3v2::AttachedPictureFrame::Type::BackCover:
-					this->d_cover_type = L"back cover";
-					break;
-				case TagLib::ID3v2::AttachedPictureFrame::Type::LeafletPage:
-					this->d_cover_type = L"leaflet page";
-					break;
-				case TagLib::ID3v2::AttachedPictureFrame::Type::Media:
-					this->d_cover_type = L"media";
-					break;
-				case TagLib::ID3v2::AttachedPictureFrame::Type::LeadArtist:
-					this->d_cover_type = L"lead artist";
-					break;
-				case TagLib::ID3v2::AttachedPictureFrame::Type::Artist:
-					this->d_cover_type = L"artist";
-					break;
-				case TagLib::ID3v2::AttachedPictureFrame::Type::Conductor:
-					this->d_cover_type = L"conductor";
-					break;
-				case TagLib::ID3v2::AttachedPictureFrame::Type::Band:
-					this->d_cover_type = L"band";
-					break;
-				case TagLib::ID3v2::AttachedPictureFrame::Type::Composer:
-					this->d_cover_type = L"composer";
-					break;
-				case TagLib::ID3v2::AttachedPictureFrame::Type::Lyricist:
-					this->d_cover_type = L"lyricist";
-					break;
-				case TagLib::ID3v2::AttachedPictureFrame::Type::RecordingLocation:
-					this->d_cover_type = L"recording location";
-					break;
-				case TagLib::ID3v2::AttachedPictureFrame::Type::DuringRecording:
-					this->d_cover_type = L"during recording";
-					break;
-				case TagLib::ID3v2::AttachedPictureFrame::Type::DuringPerformance:
-					this->d_cover_type = L"during performance";
-					break;
-				case TagLib::ID3v2::AttachedPictureFrame::Type::MovieScreenCapture:
-					this->d_cover_type = L"movie screencapture";
-					break;
-				case TagLib::ID3v2::AttachedPictureFrame::Type::ColouredFish:
-					this->d_cover_type = L"coloured fish";
-					break;
-				case TagLib::ID3v2::AttachedPictureFrame::Type::Illustration:
-					this->d_cover_type = L"illustration";
-					break;
-				case TagLib::ID3v2::AttachedPictureFrame::Type::BandLogo:
-					this->d_cover_type = L"band logo";
-					break;
-				case TagLib::ID3v2::AttachedPictureFrame::Type::PublisherLogo:
-					this->d_cover_type = L"publisher logo";
-					break;
-				}
-			}
-		}
+	// not read at all if _property_accuracy is "none" (values stay 0)
+	if (fast.has_properties)
+	{
+		this->setNumber(COLUMN_BITRATE, fast.bitrate);
+		this->setNumber(COLUMN_CHANNELS, fast.channels);
+		this->setNumber(COLUMN_SAMPLERATE, fast.samplerate);
+		this->setNumber(COLUMN_DURATION, fast.length);
 	}
+
+	this->setField(COLUMN_CODEC, fast.codec);
+	this->setNumber(COLUMN_COVERS, fast.covers);
+	this->setNumber(COLUMN_COVER_SIZE, fast.cover_size);
+	this->setField(COLUMN_COVER_MIMETYPE, fast.cover_mimetype);
+	this->setField(COLUMN_COVER_TYPE, fast.cover_type);
+	this->setNumber(COLUMN_COVER_WIDTH, fast.cover_width);
+	this->setNumber(COLUMN_COVER_HEIGHT, fast.cover_height);
 }
 
 /**
-* Reads and stores all extended tags read from TagLib::Ogg::Xiphcomment object (FLAC style)
+* Method returns value of text column of the row representing the file
 *
-* @param[in] xiphcomment  Object holding interface to read XiphComments tags (FLAC style)
+* @param[in] column  Column
+*
+* @return Value of the column
 */
-void MediaLibCleaner::File::getFLACXiphTags(TagLib::Ogg::XiphComment *xiphcomment)
+std::wstring MediaLibCleaner::File::getField(StringColumn column)
 {
-	TagLib::Ogg::FieldListMap tags = xiphcomment->fieldListMap();
-
-	this->albumartist = tags["ALBUMARTIST"].toString();
-	this->bpm = tags["BPM"].toString();
-	this->copyright = tags["COPYRIGHT"].toString();
-	this->language = tags["LANGUAGE"].toString();
-	this->length = tags["LENGTH"].toString();
-	this->mood = tags["MOOD"].toString();
-	this->origalbum = tags["ORIGALBUM"].toString();
-	this->origartist = tags["ORIGARTIST"].toString();
-	this->origfilename = tags["ORIGFILENAME"].toString();
-	this->origyear = tags["ORIGYEAR"].toString();
-	this->publisher = tags["ORGANIZATION"].toString();
-	this->unsyncedlyrics = tags["UNSYNCEDLYRICS"].toString();
-	this->www = tags["WWW"].toString();
-
-	auto piclist = this->taglib_file_flac->pictureList();
-
-	if (piclist.size() == 0)
-	{
-		this->d_covers = 0;
-		this->d_cover_mimetype = L"none";
-		this->d_cover_type = L"none";
-		this->d_cover_size = 0;
-		return;
-	}
-
-	TagLib::FLAC::Picture *picture = piclist[0];
-
-	this->d_covers = piclist.size();
-	this->d_cover_mimetype = picture->mimeType().toWString();
-	this->d_cover_size = picture->data().size();
-
-	switch (picture->type())
-	{
-	default:
-	case TagLib::FLAC::Picture::Type::Other:
-		this->d_cover_type = L"other";
-		break;
-	case TagLib::FLAC::Picture::Type::FileIcon:
-		this->d_cover_type = L"file icon";
-		break;
-	case TagLib::FLAC::Picture::Type::OtherFileIcon:
-		this->d_cover_type = L"other file icon";
-		break;
-	case TagLib::FLAC::Picture::Type::FrontCover:
-		this->d_cover_type = L"front cover";
-		break;
-	case TagLib::FLAC::Picture::Type::BackCover:
-		this->d_cover_type = L"back cover";
-		break;
-	case TagLib::FLAC::Picture::Type::LeafletPage:
-		this->d_cover_type = L"leaflet page";
-		break;
-	case TagLib::FLAC::Picture::Type::Media:
-		this->d_cover_type = L"media";
-		break;
-	case TagLib::FLAC::Picture::Type::LeadArtist:
-		this->d_cover_type = L"lead artist";
-		break;
-	case TagLib::FLAC::Picture::Type::Artist:
-		this->d_cover_type = L"artist";
-		break;
-	case TagLib::FLAC::Picture::Type::Conductor:
-		this->d_cover_type = L"conductor";
-		break;
-	case TagLib::FLAC::Picture::Type::Band:
-		this->d_cover_type = L"band";
-		break;
-	case TagLib::FLAC::Picture::Type::Composer:
-		this->d_cover_type = L"composer";
-		break;
-	case TagLib::FLAC::Picture::Type::Lyricist:
-		this->d_cover_type = L"lyricist";
-		break;
-	case TagLib::FLAC::Picture::Type::RecordingLocation:
-		this->d_cover_type = L"recording location";
-		break;
-	case TagLib::FLAC::Picture::Type::DuringRecording:
-		this->d_cover_type = L"during recording";
-		break;
-	case TagLib::FLAC::Picture::Type::DuringPerformance:
-		this->d_cover_type = L"during performance";
-		break;
-	case TagLib::FLAC::Picture::Type::MovieScreenCapture:
-		this->d_cover_type = L"movie screencapture";
-		break;
-	case TagLib::FLAC::Picture::Type::ColouredFish:
-		this->d_cover_type = L"coloured fish";
-		break;
-	case TagLib::FLAC::Picture::Type::Illustration:
-		this->d_cover_type = L"illustration";
-		break;
-	case TagLib::FLAC::Picture::Type::BandLogo:
-		this->d_cover_type = L"band logo";
-		break;
-	case TagLib::FLAC::Picture::Type::PublisherLogo:
-		this->d_cover_type = L"publisher logo";
-		break;
-	}
-}
-
-/**
-* Reads and stores all extended tags read from TagLib::Ogg::XiphComment object (OGG Vorbis style)
-*
-* @param[in] xiphcomment  Object holding interface to read XiphComment tags (OGG Vorbis style)
-*/
-void MediaLibCleaner::File::getVorbisXiphTags(TagLib::Ogg::XiphComment *xiphcomment)
-{
-	TagLib::PropertyMap tags = xiphcomment->properties();
-
-	for (auto it = tags.begin(); it != tags.end(); ++it) {
-		if (it->first.toWString() == L"ALBUMARTIST")
-			this->albumartist = it->second.toString().toWString();
-		else if (it->first.toWString() == L"BPM")
-			this->bpm = it->second.toString().toWString();
-		else if (it->first.toWString() == L"COPYRIGHT")
-			this->copyright = it->second.toString().toWString();
-		else if (it->first.toWString() == L"LANGUAGE")
-			this->language = it->second.toString().toWString();
-		else if (it->first.toWString() == L"LENGTH")
-			this->length = it->second.toString().toWString();
-		else if (it->first.toWString() == L"MOOD")
-			this->mood = it->second.toString().toWString();
-		else if (it->first.toWString() == L"ORIGALBUM")
-			this->origalbum = it->second.toString().toWString();
-		else if (it->first.toWString() == L"ORIGARTIST")
-			this->origartist = it->second.toString().toWString();
-		else if (it->first.toWString() == L"ORIGFILENAME")
-			this->origfilename = it->second.toString().toWString();
-		else if (it->first.toWString() == L"ORIGYEAR")
-			this->origyear = it->second.toString().toWString();
-		else if (it->first.toWString() == L"ORGANIZATION") // publisher
-			this->publisher = it->second.toString().toWString();
-		else if (it->first.toWString() == L"UNSYNCEDLYRICS")
-			this->unsyncedlyrics = it->second.toString().toWString();
-		else if (it->first.toWString() == L"URL" || it->first.toWString() == L"WWW")
-			this->www = it->second.toString().toWString();
-		else if (it->first.toWString() == L"METADATA_BLOCK_PICTURE") // FLAC type coverart; proposed: http://wiki.xiph.org/VorbisComment#METADATA_BLOCK_PICTURE
-		{
-			this->d_covers++;
-			if (this->d_covers != 1 && this->d_cover_type != L"unknown" && this->d_cover_mimetype != L"image/unknown") continue;
-
-			auto temp = it->second.toString().to8Bit();
-			auto data = base64_decode(temp);
-			TagLib::ByteVector data_bv;
-
-			for (auto it = data.begin(); it != data.end(); ++it)
-			{
-				data_bv.append(*it);
-			}
-
-			TagLib::FLAC::Picture *pict = new TagLib::FLAC::Picture(data_bv);
-
-			this->d_cover_mimetype = pict->mimeType().toWString();
-			this->d_cover_size = pict->data().size();
-
-			switch (pict->type())
-			{
-			default:
-			case TagLib::FLAC::Picture::Type::Other:
-				this->d_cover_type = L"other";
-				break;
-			case TagLib::FLAC::Picture::Type::FileIcon:
-				this->d_cover_type = L"file icon";
-				break;
-			case TagLib::FLAC::Picture::Type::OtherFileIcon:
-				this->d_cover_type = L"other file icon";
-				break;
-			case TagLib::FLAC::Picture::Type::FrontCover:
-				this->d_cover_type = L"front cover";
-				break;
-			case TagLib::FLAC::Picture::Type::BackCover:
-				this->d_cover_type = L"back cover";
-				break;
-			case TagLib::FLAC::Picture::Type::LeafletPage:
-				this->d_cover_type = L"leaflet page";
-				break;
-			case TagLib::FLAC::Picture::Type::Media:
-				this->d_cover_type = L"media";
-				break;
-			case TagLib::FLAC::Picture::Type::LeadArtist:
-				this->d_cover_type = L"lead artist";
-				break;
-			case TagLib::FLAC::Picture::Type::Artist:
-				this->d_cover_type = L"artist";
-				break;
-			case TagLib::FLAC::Picture::Type::Conductor:
-				this->d_cover_type = L"conductor";
-				break;
-			case TagLib::FLAC::Picture::Type::Band:
-				this->d_cover_type = L"band";
-				break;
-			case TagLib::FLAC::Picture::Type::Composer:
-				this->d_cover_type = L"composer";
-				break;
-			case TagLib::FLAC::Picture::Type::Lyricist:
-				this->d_cover_type = L"lyricist";
-				break;
-			case TagLib::FLAC::Picture::Type::RecordingLocation:
-				this->d_cover_type = L"recording location";
-				break;
-			case TagLib::FLAC::Picture::Type::DuringRecording:
-				this->d_cover_type = L"during recording";
-				break;
-			case TagLib::FLAC::Picture::Type::DuringPerformance:
-				this->d_cover_type = L"during performance";
-				break;
-			case TagLib::FLAC::Picture::Type::MovieScreenCapture:
-				this->d_cover_type = L"movie screencapture";
-				break;
-			case TagLib::FLAC::Picture::Type::ColouredFish:
-				this->d_cover_type = L"coloured fish";
-				break;
-			case TagLib::FLAC::Picture::Type::Illustration:
-				this->d_cover_type = L"illustration";
-				break;
-			case TagLib::FLAC::Picture::Type::BandLogo:
-				this->d_cover_type = L"band logo";
-				break;
-			case TagLib::FLAC::Picture::Type::PublisherLogo:
-				this->d_cover_type = L"publisher logo";
-				break;
-			}
-
-			delete pict;
-		}
-	}
+	return this->store->GetString(this->row, column);
 }
 
 /**
-* Reads and stores all extended tags read from TagLib::APE::ItemListMap object
+* Method sets value of text column of the row representing the file
 *
-* @param[in] tags  Object holding interface to read APEv2 tags
+* @param[in] column  Column
+* @param[in] value   New value
 */
-void MediaLibCleaner::File::getAPEv2Tags(TagLib::APE::ItemListMap tags)
+void MediaLibCleaner::File::setField(StringColumn column, const std::wstring &value)
 {
-	this->albumartist = tags["ALBUMARTIST"].toString();
-	this->bpm = tags["BPM"].toString();
-	this->copyright = tags["COPYRIGHT"].toString();
-	this->language = tags["LANGUAGE"].toString();
-	this->length = tags["LENGTH"].toString();
-	this->mood = tags["MOOD"].toString();
-	this->origalbum = tags["ORIGALBUM"].toString();
-	this->origartist = tags["ORIGARTIST"].toString();
-	this->origfilename = tags["ORIGFILENAME"].toString();
-	this->origyear = tags["ORIGYEAR"].toString();
-	this->publisher = tags["PUBLISHER"].toString();
-	this->unsyncedlyrics = tags["UNSYNCEDLYRICS"].toString();
-	this->www = tags["WWW"].toString();
-
-	auto cover = tags["COVER ART (FRONT)"];
-	if (cover.size() > 0)
-	{
-		this->d_covers++;
-		this->d_cover_size = static_cast<size_t>(cover.binaryData().size());
-		this->d_cover_type = L"front cover";
-		this->d_cover_mimetype = L"unknown";
-
-		TagLib::ByteVector b = cover.binaryData();
-		bool local_ext = false;
-		char buffer[10] = "";
-		int z = 0;
-		auto it = b.begin();
-
-		for (int i = 0; i < 1000; i++) {
-			if (!local_ext)
-			{
-				if (*it == '.')
-					local_ext = true;
-			}
-			else
-			{
-				if (*it == ' ') break;
-				buffer[z] = *it;
-				z++;
-			}
-			++it;
-		}
-
-		if (!strcmp(buffer, "jpg"))
-			this->d_cover_mimetype = L"image/jpeg";
-		else if (!strcmp(buffer, "png"))
-			this->d_cover_mimetype = L"imape/png";
-	}
+	this->store->SetString(this->row, column, value);
 }
 
 /**
-* Reads and stores all extended tags read from MP4/M4A file
+* Method sets value of text column of the row representing the file
+*
+* @param[in] column  Column
+* @param[in] value   New value
 */
-void MediaLibCleaner::File::getM4ATags()
+void MediaLibCleaner::File::setField(StringColumn column, const TagLib::String &value)
 {
-	TagLib::MP4::ItemListMap taglist = this->taglib_file_m4a->tag()->itemListMap();
-	(*this->logprogram)->Log(L"MediaLibCleaner::File(" + this->d_path + L")", L"First part of tags is being read", 3);
-	for (auto it = taglist.begin(); it != taglist.end(); ++it)
-	{
-		if (it->first.toWString() == L"aART")
-			this->albumartist = it->second.toStringList().toString(", ").toWString();
-		if (it->first.toWString() == L"----:com.apple.iTunes:LENGTH")
-			this->length = it->second.toStringList().toString(", ").toWString();
-		if (it->first.toWString() == L"----:com.apple.iTunes:ORIGARTIST")
-			this->origartist = it->second.toStringList().toString(", ").toWString();
-		if (it->first.toWString() == L"----:com.apple.iTunes:ORIGALBUM")
-			this->origalbum = it->second.toStringList().toString(", ").toWString();
-		if (it->first.toWString() == L"----:com.apple.iTunes:ORIGFILENAME")
-			this->origfilename = it->second.toStringList().toString(", ").toWString();
-		if (it->first.toWString() == L"----:com.apple.iTunes:ORIGYEAR")
-			this->origyear = it->second.toStringList().toString(", ").toWString();
-		if (it->first.toWString() == L"----:com.apple.iTunes:PUBLISHER")
-			this->publisher = it->second.toStringList().toString(", ").toWString();
-		if (it->first.toWString() == L"----:com.apple.iTunes:WWW")
-			this->www = it->second.toStringList().toString(", ").toWString();
-		if (it->first.toWString() == L"covr")
-		{
-			TagLib::MP4::CoverArtList calist = it->second.toCoverArtList();
-
-			this->d_covers = calist.size();
-
-			if (calist.size() < 0)
-			{
-				this->d_cover_size = 0;
-				this->d_cover_mimetype = L"none";
-				this->d_cover_type = L"none";
-
-				continue;
-			}
-
-			TagLib::MP4::CoverArt ca = calist[0];
-
-			this->d_cover_size = ca.data().size();
-
-			if (ca.format() == TagLib::MP4::CoverArt::BMP)
-			{
-				this->d_cover_mimetype = L"image/x-portable-bitmap";
-			}
-			else if (ca.format() == TagLib::MP4::CoverArt::JPEG)
-			{
-				this->d_cover_mimetype = L"image/jpeg";
-			}
-			else if (ca.format() == TagLib::MP4::CoverArt::PNG)
-			{
-				this->d_cover_mimetype = L"image/png";
-			}
-			else if (ca.format() == TagLib::MP4::CoverArt::GIF)
-			{
-				this->d_cover_mimetype = L"image/gif";
-			}
-			else if (ca.format() == TagLib::MP4::CoverArt::Unknown)
-			{
-				this->d_cover_mimetype = L"image/unknown";
-			}
-		}
-	}
-
-	TagLib::PropertyMap tags = this->taglib_file_m4a->tag()->properties();
-	(*this->logprogram)->Log(L"MediaLibCleaner::File(" + this->d_path + L")", L"Second part of tags is being read", 3);
-	for (auto it = tags.begin(); it != tags.end(); ++it) {
-		if (it->first.toWString() == L"BPM")
-			this->bpm = it->second.toString().toWString();
-		else if (it->first.toWString() == L"COPYRIGHT")
-			this->copyright = it->second.toString().toWString();
-		else if (it->first.toWString() == L"LANGUAGE")
-			this->language = it->second.toString().toWString();
-		else if (it->first.toWString() == L"MOOD")
-			this->mood = it->second.toString().toWString();
-		else if (it->first.toWString() == L"LYRICS")
-			this->unsyncedlyrics = it->second.toString().toWString();
-	}
+	this->store->SetString(this->row, column, value.toWString());
 }
 
 /**
-* Clears all extended tags
+* Method sets value of text column of the row representing the file
+*
+* @param[in] column  Column
+* @param[in] value   New value (null-terminated string)
 */
-void MediaLibCleaner::File::clearExtendedTags()
+void MediaLibCleaner::File::setField(StringColumn column, const wchar_t *value)
 {
-	this->albumartist = "";
-	this->bpm = "";
-	this->copyright = "";
-	this->language = "";
-	this->length = "";
-	this->mood = "";
-	this->origalbum = "";
-	this->origartist = "";
-	this->origfilename = "";
-	this->origyear = "";
-	this->publisher = "";
-	this->unsyncedlyrics = "";
-	this->www = "";
+	this->store->SetString(this->row, column, std::wstring(value));
 }
 
-
 /**
- * Method to write ID3v2 tag to the file
- *
- * Currently supports given frames: comments frame, text ID frame, user URL frame and unsynced lyrics frame, 
- * which are minimum required by the program to work.
- *
- * @param[in] value   New tag value, or TagLib::String::null if tag is to be deleted
- * @param[in] id3tag  ID3v2 frame ID/name
- * @param[in] tag     Pointer to TagLib::ID3v2::Tag object containing ID3v2 tags
- */
-void MediaLibCleaner::File::setID3v2Tag(TagLib::String value, std::string id3tag, TagLib::ID3v2::Tag *tag)
+* Method returns value of numeric column of the row representing the file
+*
+* @param[in] column  Column
+*
+* @return Value of the column
+*/
+long long MediaLibCleaner::File::getNumber(NumberColumn column)
 {
-	TagLib::ByteVector handle = id3tag.c_str();
-	if (id3tag == "WXXX[WWW]" && value == TagLib::String::null)
-	{
-		(*this->logprogram)->Log(L"setTagUniversal(" + this->d_path + L")", L"Removing ID3v2 tag '" + s2ws(id3tag), 3);
-		auto frames = tag->frameList("WXXX");
-
-		for (auto it = frames.begin(); it != frames.end(); ++it)
-		{
-			auto fr = dynamic_cast<TagLib::ID3v2::UserUrlLinkFrame*>(*it);
-			if (fr->description() == "") {
-				tag->removeFrame(fr, true);
-			}
-		}
-	}
-	else if (value == TagLib::String::null)
-	{
-		(*this->logprogram)->Log(L"setTagUniversal(" + this->d_path + L")", L"Removing ID3v2 tag '" + s2ws(id3tag), 3);
-		tag->removeFrames(handle);
-	}
-	else
-	{
-		(*this->logprogram)->Log(L"setTagUniversal(" + this->d_path + L")", L"Setting ID3v2 tag '" + s2ws(id3tag) + L"' to new value: '" + value.toWString() + L"'", 3);
-		if (id3tag.length() > 1 && id3tag.substr(0, 1) == "C") // comments frame
-		{
-			(*this->logprogram)->Log(L"setTagUniversal(" + this->d_path + L")", L"Setting comment type frame", 3);
-			if (!tag->frameList(handle).isEmpty())
-			{
-				(*this->logprogram)->Log(L"setTagUniversal(" + this->d_path + L")", L"Substitusion possible", 3);
-				tag->frameList(handle).front()->setText(value);
-			}
-			else
-			{
-				(*this->logprogram)->Log(L"setTagUniversal(" + this->d_path + L")", L"Creating and appending new frame", 3);
-				TagLib::ID3v2::CommentsFrame *frame = new TagLib::ID3v2::CommentsFrame(TagLib::String::UTF8);
-				frame->setText(value);
-				frame->setLanguage("eng");
-				tag->addFrame(frame);
-			}
-		}
-		else if (id3tag.length() > 1 && id3tag.substr(0, 1) == "T") // Text ID frame
-		{
-			(*this->logprogram)->Log(L"setTagUniversal(" + this->d_path + L")", L"Setting text type frame", 3);
-			if (!tag->frameList(handle).isEmpty())
-			{
-				(*this->logprogram)->Log(L"setTagUniversal(" + this->d_path + L")", L"Substitusion possible", 3);
-				tag->frameList(handle).front()->setText(value);
-			}
-			else
-			{
-				(*this->logprogram)->Log(L"setTagUniversal(" + this->d_path + L")", L"Creating and appending new frame", 3);
-				TagLib::ID3v2::TextIdentificationFrame *frame =
-					new TagLib::ID3v2::TextIdentificationFrame(handle, TagLib::String::UTF8);
-				tag->addFrame(frame);
-				frame->setText(value);
-			}
-		}
-		else if (id3tag.length() > 1 && id3tag.substr(0, 1) == "W") // URL frame
-		{
-			if (id3tag == "WXXX[WWW]") // user URL frame
-			{
-				handle = "WXXX";
-				(*this->logprogram)->Log(L"setTagUniversal(" + this->d_path + L")", L"Setting URL user frame (WWW)", 3);
-				
-				auto wxxx_frames = tag->frameList(handle);
-				for (auto it = wxxx_frames.begin(); it != wxxx_frames.end(); ++it)
-				{
-					TagLib::ID3v2::UserUrlLinkFrame *fr = dynamic_cast<TagLib::ID3v2::UserUrlLinkFrame*>(*it);
-					if (fr->description() == "")
-						fr->setText(value);
-				}
-
-				if (!tag->frameList(handle).isEmpty())
-				{
-					(*this->logprogram)->Log(L"setTagUniversal(" + this->d_path + L")", L"Substitusion possible", 3);
-					tag->frameList(handle).front()->setText(value);
-				}
-				else
-				{
-					(*this->logprogram)->Log(L"setTagUniversal(" + this->d_path + L")", L"Creating and appending new frame", 3);
-					TagLib::ID3v2::UserUrlLinkFrame *frame = new TagLib::ID3v2::UserUrlLinkFrame(TagLib::String::UTF8);
-					frame->setDescription("");
-					frame->setUrl(value);
-					tag->addFrame(frame);
-				}
-			}
-		}
-		else if (id3tag.length() >= 4 && id3tag.substr(0, 4) == "USLT") // Unsynced Lyrics frame
-		{
-			(*this->logprogram)->Log(L"setTagUniversal(" + this->d_path + L")", L"Setting lyrics frame", 3);
-			if (!tag->frameList(handle).isEmpty())
-			{
-				(*this->logprogram)->Log(L"setTagUniversal(" + this->d_path + L")", L"Substitusion possible", 3);
-				tag->frameList(handle).front()->setText(value);
-			}
-			else
-			{
-				(*this->logprogram)->Log(L"setTagUniversal(" + this->d_path + L")", L"Creating and appending new frame", 3);
-				TagLib::ID3v2::UnsynchronizedLyricsFrame *frame = new TagLib::ID3v2::UnsynchronizedLyricsFrame(TagLib::String::UTF8);
-				frame->setText(value);
-				frame->setDescription("LYRICS");
-				frame->setLanguage("eng");
-				tag->addFrame(frame);
-			}
-		}
-	}
+	return this->store->GetNumber(this->row, column);
 }
 
 /**
-* Method to write APEv2 tag to the file
+* Method sets value of numeric column of the row representing the file
 *
-* @param[in] value   New tag value, or TagLib::String::null if tag is to be deleted
-* @param[in] apetag  APE tag name
-* @param[in] tag     Pointer to TagLib::APE::Tag object containing APE tags
+* @param[in] column  Column
+* @param[in] value   New value
 */
-void MediaLibCleaner::File::setAPEv2Tag(TagLib::String value, std::string apetag, TagLib::APE::Tag *tag)
+void MediaLibCleaner::File::setNumber(NumberColumn column, long long value)
 {
-	if (value == TagLib::String::null)
-	{
-		(*this->logprogram)->Log(L"setTagUniversal(" + this->d_path + L")", L"Removing APE tag '" + s2ws(apetag) + L"'", 3);
-		tag->removeItem(apetag);
-	}
-	else
-	{
-		(*this->logprogram)->Log(L"setTagUniversal(" + this->d_path + L")", L"Setting APE tag '" + s2ws(apetag) + L"' to new value: '" + value.toWString() + L"'", 3);
-		TagLib::APE::Item *item = new TagLib::APE::Item(apetag, value);
-		tag->setItem(apetag, *item);
-	}
+	this->store->SetNumber(this->row, column, value);
 }
 
+
 /**
-* Method to write XiphComment tag to the file
+* Method recording change of a tag into the set of pending changes, which is applied to the file in save()
+*
+* Changes that would write value identical to the current one are dropped, as well as changes that
+* restore original value of the tag (net delta is empty in such case).
+*
+* @param[in]     column   Column of MediaLibCleaner::LibraryStore holding the tag (index in MediaLibCleaner::TagSchema); will contain new value after the call
+* @param[in]     value    New value of the tag, or TagLib::String::null if tag is to be deleted
 *
-* @param[in] value    New tag value, or TagLib::String::null if one is to be deleted
-* @param[in] xiphtag  XiphComment tag name
-* @param[in] tag      Pointer to TagLib::Ogg::XiphComment object containing XiphComment tags
+* @return Status of recording the change
 */
-void MediaLibCleaner::File::setXiphTag(TagLib::String value, std::string xiphtag, TagLib::Ogg::XiphComment *tag)
+bool MediaLibCleaner::File::queueTagChange(StringColumn column, TagLib::String value)
 {
-	if (value == TagLib::String::null)
+	const TagInfo *info = &TagSchema[column];
+	std::wstring name = info->name;
+	TagLib::String current = this->getField(column);
+
+	if (current == value)
 	{
-		tag->removeField(xiphtag);
+		(*this->logprogram)->Log(L"queueTagChange(" + this->GetPath() + L")", L"Tag '" + name + L"' already has given value, skipping", 3);
+		return true;
 	}
-	else
+
+	(*this->logalert)->Log(this->GetPath(), L"Setting tag '" + name + L"' to new value: '" + value.toWString() + L"'");
+
+	if (!this->mutations)
+		this->mutations.reset(new std::map<StringColumn, TagMutation>());
+
+	auto it = this->mutations->find(column);
+	if (it == this->mutations->end())
 	{
-		tag->addField(xiphtag, value, true);
-	}
-}
+		TagMutation mutation;
+		mutation.info = info;
+		mutation.original = current;
+		mutation.value = value;
 
-/**
-* Method to write MP4/M4A tag to the file
-*
-* Works only for: ALBUM, ALBUMARTIST, ARTIST, BPM, COMMENT, COPYRIGHT, DATE, ENCODEDBY, GENRE, LANGUAGE, LYRICS, MOOD, TITLE, TRACKNUMBER
-*
-* @param[in] value   New tag value, or TagLib::String::null if one is to be deleted
-* @param[in] m4atag  M4A tag name
-* @param[in] tag     Pointer to TagLib::MP4::Tag object containing MP4/M4A tags
-*/
-void MediaLibCleaner::File::setM4ATag(TagLib::String value, std::string m4atag, TagLib::MP4::Tag *tag)
-{
-	auto props = tag->properties();
-	if (value == TagLib::String::null)
+		(*this->mutations)[column] = mutation;
+	}
+	else if (it->second.original == value)
 	{
-		props = props.erase(m4atag);
+		// tag goes back to the value read from the file - nothing to write
+		(*this->logprogram)->Log(L"queueTagChange(" + this->GetPath() + L")", L"Tag '" + name + L"' restored to original value, dropping pending change", 3);
+		this->mutations->erase(it);
 	}
 	else
 	{
-		props.replace(m4atag, TagLib::StringList(value));
+		it->second.value = value;
 	}
 
-	tag->setProperties(props);
+	this->setField(column, value);
+
+	return true;
 }
 
 
@@ -1314,11 +654,7 @@ bool MediaLibCleaner::File::SetArtist(TagLib::String value)
 {
 	if (this->isInitiated)
 	{
-		// change inner value
-		this->artist = value;
-
-		// change value in file
-		return this->setTagUniversal("TPE1", "ARTIST", "ARTIST", "ARTIST", value);
+		return this->queueTagChange(COLUMN_ARTIST, value);
 	}
 	return false;
 }
@@ -1333,11 +669,7 @@ bool MediaLibCleaner::File::SetArtist(TagLib::String value)
 bool MediaLibCleaner::File::SetTitle(TagLib::String value) {
 	if (this->isInitiated)
 	{
-		// change inner value
-		this->title = value;
-
-		// change value in file
-		return this->setTagUniversal("TIT2", "TITLE", "TITLE", "TITLE", value);
+		return this->queueTagChange(COLUMN_TITLE, value);
 	}
 	return false;
 }
@@ -1352,11 +684,7 @@ bool MediaLibCleaner::File::SetTitle(TagLib::String value) {
 bool MediaLibCleaner::File::SetAlbum(TagLib::String value) {
 	if (this->isInitiated)
 	{
-		// change inner value
-		this->album = value;
-
-		// change value in file
-		return this->setTagUniversal("TALB", "ALBUM", "ALBUM", "ALBUM", value);
+		return this->queueTagChange(COLUMN_ALBUM, value);
 	}
 	return false;
 }
@@ -1371,11 +699,7 @@ bool MediaLibCleaner::File::SetAlbum(TagLib::String value) {
 bool MediaLibCleaner::File::SetGenre(TagLib::String value) {
 	if (this->isInitiated)
 	{
-		// change inner value
-		this->genre = value;
-
-		// change value in file
-		return this->setTagUniversal("TCON", "GENRE", "GENRE", "GENRE", value);
+		return this->queueTagChange(COLUMN_GENRE, value);
 	}
 	return false;
 }
@@ -1390,11 +714,7 @@ bool MediaLibCleaner::File::SetGenre(TagLib::String value) {
 bool MediaLibCleaner::File::SetComment(TagLib::String value) {
 	if (this->isInitiated)
 	{
-		// change inner value
-		this->comment = value;
-
-		// change value in file
-		return this->setTagUniversal("COMM", "COMMENT", "COMMENT", "COMMENT", value);
+		return this->queueTagChange(COLUMN_COMMENT, value);
 	}
 	return false;
 }
@@ -1409,11 +729,7 @@ bool MediaLibCleaner::File::SetComment(TagLib::String value) {
 bool MediaLibCleaner::File::SetTrack(TagLib::String value) {
 	if (this->isInitiated)
 	{
-		// change inner value
-		this->track = value;
-
-		// change value in file
-		return this->setTagUniversal("TRCK", "TRACKNUMBER", "TRACK", "TRACKNUMBER", value);
+		return this->queueTagChange(COLUMN_TRACK, value);
 	}
 	return false;
 }
@@ -1428,11 +744,7 @@ bool MediaLibCleaner::File::SetTrack(TagLib::String value) {
 bool MediaLibCleaner::File::SetYear(TagLib::String value) {
 	if (this->isInitiated)
 	{
-		// change inner value
-		this->year = value;
-
-		// change value in file
-		return this->setTagUniversal("TYER", "YEAR", "YEAR", "DATE", value);
+		return this->queueTagChange(COLUMN_YEAR, value);
 	}
 	return false;
 }
@@ -1448,8 +760,7 @@ bool MediaLibCleaner::File::SetAlbumArtist(TagLib::String value)
 {
 	if (this->isInitiated)
 	{
-		this->albumartist = value;
-		return this->setTagUniversal("TPE2", "ALBUMARTIST", "ALBUMARTIST", "ALBUMARTIST", value);
+		return this->queueTagChange(COLUMN_ALBUMARTIST, value);
 	}
 	return false;
 }
@@ -1464,8 +775,7 @@ bool MediaLibCleaner::File::SetAlbumArtist(TagLib::String value)
 bool MediaLibCleaner::File::SetBPM(TagLib::String value) {
 	if (this->isInitiated)
 	{
-		this->bpm = value;
-		return this->setTagUniversal("TBPM", "BPM", "BPM", "BPM", value);
+		return this->queueTagChange(COLUMN_BPM, value);
 	}
 	return false;
 }
@@ -1480,8 +790,7 @@ bool MediaLibCleaner::File::SetBPM(TagLib::String value) {
 bool MediaLibCleaner::File::SetCopyright(TagLib::String value) {
 	if (this->isInitiated)
 	{
-		this->copyright = value;
-		return this->setTagUniversal("TCOP", "COPYRIGHT", "COPYRIGHT", "COPYRIGHT", value);
+		return this->queueTagChange(COLUMN_COPYRIGHT, value);
 	}
 	return false;
 }
@@ -1496,8 +805,7 @@ bool MediaLibCleaner::File::SetCopyright(TagLib::String value) {
 bool MediaLibCleaner::File::SetLanguage(TagLib::String value) {
 	if (this->isInitiated)
 	{
-		this->language = value;
-		return this->setTagUniversal("TLAN", "LANGUAGE", "LANGUAGE", "LANGUAGE", value);
+		return this->queueTagChange(COLUMN_LANGUAGE, value);
 	}
 	return false;
 }
@@ -1512,8 +820,7 @@ bool MediaLibCleaner::File::SetLanguage(TagLib::String value) {
 bool MediaLibCleaner::File::SetTagLength(TagLib::String value) {
 	if (this->isInitiated)
 	{
-		this->length = value;
-		return this->setTagUniversal("TLEN", "LENGTH", "LENGTH", "LENGTH", value);
+		return this->queueTagChange(COLUMN_LENGTH, value);
 	}
 	return false;
 }
@@ -1528,8 +835,7 @@ bool MediaLibCleaner::File::SetTagLength(TagLib::String value) {
 bool MediaLibCleaner::File::SetMood(TagLib::String value) {
 	if (this->isInitiated)
 	{
-		this->mood = value;
-		return this->setTagUniversal("TMOO", "MOOD", "MOOD", "MOOD", value);
+		return this->queueTagChange(COLUMN_MOOD, value);
 	}
 	return false;
 }
@@ -1544,8 +850,7 @@ bool MediaLibCleaner::File::SetMood(TagLib::String value) {
 bool MediaLibCleaner::File::SetOrigAlbum(TagLib::String value) {
 	if (this->isInitiated)
 	{
-		this->origalbum = value;
-		return this->setTagUniversal("TOAL", "ORIGALBUM", "ORIGALBUM", "ORIGALBUM", value);
+		return this->queueTagChange(COLUMN_ORIGALBUM, value);
 	}
 	return false;
 }
@@ -1560,8 +865,7 @@ bool MediaLibCleaner::File::SetOrigAlbum(TagLib::String value) {
 bool MediaLibCleaner::File::SetOrigArtist(TagLib::String value) {
 	if (this->isInitiated)
 	{
-		this->origartist = value;
-		return this->setTagUniversal("TOPE", "ORIGARTIST", "ORIGARTIST", "ORIGARTIST", value);
+		return this->queueTagChange(COLUMN_ORIGARTIST, value);
 	}
 	return false;
 }
@@ -1576,8 +880,7 @@ bool MediaLibCleaner::File::SetOrigArtist(TagLib::String value) {
 bool MediaLibCleaner::File::SetOrigFilename(TagLib::String value) {
 	if (this->isInitiated)
 	{
-		this->origfilename = value;
-		return this->setTagUniversal("TOFN", "ORIGFILENAME", "ORIGFILENAME", "ORIGFILENAME", value);
+		return this->queueTagChange(COLUMN_ORIGFILENAME, value);
 	}
 	return false;
 }
@@ -1592,8 +895,7 @@ bool MediaLibCleaner::File::SetOrigFilename(TagLib::String value) {
 bool MediaLibCleaner::File::SetOrigYear(TagLib::String value) {
 	if (this->isInitiated)
 	{
-		this->origyear = value;
-		return this->setTagUniversal("TDOR", "ORIGYEAR", "ORIGYEAR", "ORIGYEAR", value);
+		return this->queueTagChange(COLUMN_ORIGYEAR, value);
 	}
 	return false;
 }
@@ -1608,8 +910,7 @@ bool MediaLibCleaner::File::SetOrigYear(TagLib::String value) {
 bool MediaLibCleaner::File::SetPublisher(TagLib::String value) {
 	if (this->isInitiated)
 	{
-		this->publisher = value;
-		return this->setTagUniversal("TPUB", "ORGANIZATION", "PUBLISHER", "PUBLISHER", value);
+		return this->queueTagChange(COLUMN_PUBLISHER, value);
 	}
 	return false;
 }
@@ -1624,8 +925,7 @@ bool MediaLibCleaner::File::SetPublisher(TagLib::String value) {
 bool MediaLibCleaner::File::SetLyricsUnsynced(TagLib::String value) {
 	if (this->isInitiated)
 	{
-		this->unsyncedlyrics = value;
-		return this->setTagUniversal("USLT", "UNSYNCEDLYRICS", "UNSYNCEDLYRICS", "LYRICS", value);
+		return this->queueTagChange(COLUMN_UNSYNCEDLYRICS, value);
 	}
 	return false;
 }
@@ -1640,8 +940,7 @@ bool MediaLibCleaner::File::SetLyricsUnsynced(TagLib::String value) {
 bool MediaLibCleaner::File::SetWWW(TagLib::String value) {
 	if (this->isInitiated)
 	{
-		this->www = value;
-		return this->setTagUniversal("WXXX[WWW]", "WWW", "WWW", "WWW", value);
+		return this->queueTagChange(COLUMN_WWW, value);
 	}
 	return false;
 }
@@ -1665,7 +964,7 @@ bool MediaLibCleaner::File::SetWWW(TagLib::String value) {
 */
 int MediaLibCleaner::File::GetBitrate() {
 	if (this->isInitiated)
-		return this->d_bitrate;
+		return static_cast<int>(this->getNumber(COLUMN_BITRATE));
 	return -1;
 }
 
@@ -1676,7 +975,7 @@ int MediaLibCleaner::File::GetBitrate() {
 */
 std::wstring MediaLibCleaner::File::GetCodec() {
 	if (this->isInitiated)
-		return this->d_codec;
+		return this->getField(COLUMN_CODEC);
 	return L"";
 }
 
@@ -1687,7 +986,7 @@ std::wstring MediaLibCleaner::File::GetCodec() {
 */
 std::wstring MediaLibCleaner::File::GetCoverMimetype() {
 	if (this->isInitiated)
-		return this->d_cover_mimetype;
+		return this->getField(COLUMN_COVER_MIMETYPE);
 	return L"";
 }
 
@@ -1698,7 +997,7 @@ std::wstring MediaLibCleaner::File::GetCoverMimetype() {
 */
 size_t MediaLibCleaner::File::GetCoverSize() {
 	if (this->isInitiated)
-		return this->d_cover_size;
+		return static_cast<size_t>(this->getNumber(COLUMN_COVER_SIZE));
 	return -1;
 }
 
@@ -1709,7 +1008,7 @@ size_t MediaLibCleaner::File::GetCoverSize() {
 */
 std::wstring MediaLibCleaner::File::GetCoverType() {
 	if (this->isInitiated)
-		return this->d_cover_type;
+		return this->getField(COLUMN_COVER_TYPE);
 	return L"";
 }
 
@@ -1720,10 +1019,90 @@ std::wstring MediaLibCleaner::File::GetCoverType() {
 */
 int MediaLibCleaner::File::GetCovers() {
 	if (this->isInitiated)
-		return this->d_covers;
+		return static_cast<int>(this->getNumber(COLUMN_COVERS));
 	return -1;
 }
 
+/**
+* Method allowing to read width of first cover in an audio file
+*
+* @return Width of first cover in pixels (0 if unknown) or -1 if file is not audio file
+*/
+int MediaLibCleaner::File::GetCoverWidth() {
+	if (this->isInitiated)
+		return static_cast<int>(this->getNumber(COLUMN_COVER_WIDTH));
+	return -1;
+}
+
+/**
+* Method allowing to read height of first cover in an audio file
+*
+* @return Height of first cover in pixels (0 if unknown) or -1 if file is not audio file
+*/
+int MediaLibCleaner::File::GetCoverHeight() {
+	if (this->isInitiated)
+		return static_cast<int>(this->getNumber(COLUMN_COVER_HEIGHT));
+	return -1;
+}
+
+/**
+* Method allowing to read number of group of files with the same audio data (see MediaLibCleaner::DuplicateFinder)
+*
+* @return Number of the group (0 if file has no duplicates or duplicates were not searched for) or -1 if file is not audio file
+*/
+int MediaLibCleaner::File::GetDuplicateGroup() {
+	if (this->isInitiated)
+		return static_cast<int>(this->getNumber(COLUMN_DUP_GROUP));
+	return -1;
+}
+
+/**
+* Method allowing to check if there is another file with the same audio data
+*
+* @return True if file belongs to any group of duplicates
+*/
+bool MediaLibCleaner::File::IsDuplicate() {
+	return this->GetDuplicateGroup() > 0;
+}
+
+/**
+* Method sets number of group of files with the same audio data (called by MediaLibCleaner::DuplicateFinder)
+*
+* @param[in] group  Number of the group (0 if file has no duplicates)
+*/
+void MediaLibCleaner::File::SetDuplicateGroup(int group) {
+	this->setNumber(COLUMN_DUP_GROUP, group);
+}
+
+/**
+* Method allowing to read result of integrity check of audio file (see MediaLibCleaner::IntegrityVerifier)
+*
+* @return Result of integrity check (INTEGRITY_UNKNOWN if file was not verified or is not audio file)
+*/
+MediaLibCleaner::IntegrityStatus MediaLibCleaner::File::GetIntegrity() {
+	if (this->isInitiated)
+		return static_cast<IntegrityStatus>(this->getNumber(COLUMN_INTEGRITY));
+	return INTEGRITY_UNKNOWN;
+}
+
+/**
+* Method allowing to check if audio file is not damaged. Files which were not verified are treated as intact.
+*
+* @return False only if integrity check found damage in the file
+*/
+bool MediaLibCleaner::File::IsIntact() {
+	return this->GetIntegrity() != INTEGRITY_DAMAGED;
+}
+
+/**
+* Method sets result of integrity check (called by MediaLibCleaner::IntegrityVerifier)
+*
+* @param[in] status  Result of integrity check
+*/
+void MediaLibCleaner::File::SetIntegrity(IntegrityStatus status) {
+	this->setNumber(COLUMN_INTEGRITY, status);
+}
+
 /**
 * Method allowing to read amount of channels in audio file
 *
@@ -1731,7 +1110,7 @@ int MediaLibCleaner::File::GetCovers() {
 */
 int MediaLibCleaner::File::GetChannels() {
 	if (this->isInitiated)
-		return this->d_channels;
+		return static_cast<int>(this->getNumber(COLUMN_CHANNELS));
 	return -1;
 }
 
@@ -1742,7 +1121,7 @@ int MediaLibCleaner::File::GetChannels() {
 */
 int MediaLibCleaner::File::GetSampleRate() {
 	if (this->isInitiated)
-		return this->d_sampleRate;
+		return static_cast<int>(this->getNumber(COLUMN_SAMPLERATE));
 	return -1;
 }
 
@@ -1755,10 +1134,11 @@ std::wstring MediaLibCleaner::File::GetLengthAsString() {
 	if (!this->isInitiated) return L"";
 
 	std::wstring out = L"";
+	int length = this->GetLength();
 	int hours = 0, minutes = 0, seconds;
 
-	if (this->d_length >= 3600) { // if longer than or equal to 1 hour
-		hours = this->d_length / 3600; // no rest, only full hours
+	if (length >= 3600) { // if longer than or equal to 1 hour
+		hours = length / 3600; // no rest, only full hours
 
 		if (hours < 10) {
 			out += L"0";
@@ -1766,8 +1146,8 @@ std::wstring MediaLibCleaner::File::GetLengthAsString() {
 		out += std::to_wstring(hours) + L":";
 	}
 
-	if (this->d_length >= 60) { // if longer than or equal to 1 minute
-		minutes = (this->d_length - hours * 3600) / 60; //  no rest, only full remaining minutes
+	if (length >= 60) { // if longer than or equal to 1 minute
+		minutes = (length - hours * 3600) / 60; //  no rest, only full remaining minutes
 
 		if (minutes < 10) {
 			out += L"0";
@@ -1775,7 +1155,7 @@ std::wstring MediaLibCleaner::File::GetLengthAsString() {
 		out += std::to_wstring(minutes) + L":";
 	}
 
-	seconds = this->d_length - hours * 3600 - minutes * 60;
+	seconds = length - hours * 3600 - minutes * 60;
 	if (seconds < 10) {
 		out += L"0";
 	}
@@ -1791,7 +1171,7 @@ std::wstring MediaLibCleaner::File::GetLengthAsString() {
 */
 int MediaLibCleaner::File::GetLength() {
 	if (this->isInitiated)
-		return this->d_length;
+		return static_cast<int>(this->getNumber(COLUMN_DURATION));
 	return -1;
 }
 
@@ -1806,7 +1186,7 @@ int MediaLibCleaner::File::GetLength() {
 * @return Directory name containing file
 */
 std::wstring MediaLibCleaner::File::GetDirectory() {
-	return this->d_directory;
+	return boost::filesystem::path(this->store->GetFolder(this->row)).filename().wstring();
 }
 /**
 * Method returns extension of the file
@@ -1814,7 +1194,8 @@ std::wstring MediaLibCleaner::File::GetDirectory() {
 * @return File extension
 */
 std::wstring MediaLibCleaner::File::GetExt() {
-	return this->d_ext;
+	std::wstring ext = boost::filesystem::path(this->GetFilenameExt()).extension().wstring();
+	return (ext.length() > 1) ? ext.substr(1) : ext;
 }
 /**
 * Method returns name of the file without extension
@@ -1822,7 +1203,7 @@ std::wstring MediaLibCleaner::File::GetExt() {
 * @return Filename without extension
 */
 std::wstring MediaLibCleaner::File::GetFilename() {
-	return this->d_filename;
+	return boost::filesystem::path(this->GetFilenameExt()).stem().wstring();
 }
 /**
 * Method returns filename with the extension
@@ -1830,7 +1211,7 @@ std::wstring MediaLibCleaner::File::GetFilename() {
 * @return Filename with extensions
 */
 std::wstring MediaLibCleaner::File::GetFilenameExt() {
-	return (this->d_filename + L"." + this->d_ext);
+	return this->store->GetString(this->row, COLUMN_FILENAME);
 }
 /**
 * Method returns path to directory that contains the file
@@ -1838,7 +1219,7 @@ std::wstring MediaLibCleaner::File::GetFilenameExt() {
 * @return Path to directory containing file
 */
 std::wstring MediaLibCleaner::File::GetFolderPath() {
-	return this->d_folderpath;
+	return this->store->GetFolder(this->row);
 }
 /**
 * Method returns name of parent directory for %_directory% dir
@@ -1846,7 +1227,7 @@ std::wstring MediaLibCleaner::File::GetFolderPath() {
 * @return Name of parent dir for %_directory% dir
 */
 std::wstring MediaLibCleaner::File::GetParentDir() {
-	return this->d_parent_dir;
+	return boost::filesystem::path(this->store->GetFolder(this->row)).parent_path().filename().wstring();
 }
 /**
 * Method returns full path to audio file given object represents
@@ -1854,7 +1235,7 @@ std::wstring MediaLibCleaner::File::GetParentDir() {
 * @return Full path to audio file
 */
 std::wstring MediaLibCleaner::File::GetPath() {
-	return this->d_path;
+	return this->store->GetPath(this->row);
 }
 
 #ifdef WIN32
@@ -1864,7 +1245,7 @@ std::wstring MediaLibCleaner::File::GetPath() {
 	* @return Letter followed by colon of volume the file resides on
 	*/
 	std::wstring MediaLibCleaner::File::GetVolume() {
-		return this->d_volume;
+		return boost::filesystem::path(this->store->GetFolder(this->row)).root_name().wstring();
 	}
 #endif
 
@@ -1877,7 +1258,7 @@ std::wstring MediaLibCleaner::File::GetPath() {
 * @return File created date in ISO 8601 format
 */
 std::wstring MediaLibCleaner::File::GetFileCreateDate() {
-	return get_date_iso_8601_wide(this->d_file_create_datetime_raw);
+	return get_date_iso_8601_wide(this->GetFileCreateDatetimeRaw());
 }
 /**
 * Method returns file created date in RFC 2822 format
@@ -1885,7 +1266,7 @@ std::wstring MediaLibCleaner::File::GetFileCreateDate() {
 * @return File created date in RFC 2822 format
 */
 std::wstring MediaLibCleaner::File::GetFileCreateDatetime() {
-	return get_date_rfc_2822_wide(this->d_file_create_datetime_raw);
+	return get_date_rfc_2822_wide(this->GetFileCreateDatetimeRaw());
 }
 /**
 * Method returns file created date in unix timestamp format
@@ -1893,7 +1274,7 @@ std::wstring MediaLibCleaner::File::GetFileCreateDatetime() {
 * @return File created date in unix timestamp format
 */
 time_t MediaLibCleaner::File::GetFileCreateDatetimeRaw() {
-	return this->d_file_create_datetime_raw;
+	return static_cast<time_t>(this->getNumber(COLUMN_CREATE_TIME));
 }
 /**
 * Method returns file modified date in ISO 8601 format
@@ -1901,7 +1282,7 @@ time_t MediaLibCleaner::File::GetFileCreateDatetimeRaw() {
 * @return File modified date in ISO 8601 format
 */
 std::wstring MediaLibCleaner::File::GetFileModDate() {
-	return get_date_iso_8601_wide(this->d_file_mod_datetime_raw);
+	return get_date_iso_8601_wide(this->GetFileModDatetimeRaw());
 }
 /**
 * Method returns file modified date in RFC 2822 format
@@ -1909,7 +1290,7 @@ std::wstring MediaLibCleaner::File::GetFileModDate() {
 * @return File modified date in RFC 2822 format
 */
 std::wstring MediaLibCleaner::File::GetFileModDatetime() {
-	return get_date_rfc_2822_wide(this->d_file_mod_datetime_raw);
+	return get_date_rfc_2822_wide(this->GetFileModDatetimeRaw());
 }
 /**
 * Method returns file modified date in unix timestamp format
@@ -1917,7 +1298,7 @@ std::wstring MediaLibCleaner::File::GetFileModDatetime() {
 * @return File modified date in unix timestamp format
 */
 time_t MediaLibCleaner::File::GetFileModDatetimeRaw() {
-	return this->d_file_mod_datetime_raw;
+	return static_cast<time_t>(this->getNumber(COLUMN_MOD_TIME));
 }
 /**
 * Method returns file size in human readable format
@@ -1925,15 +1306,16 @@ time_t MediaLibCleaner::File::GetFileModDatetimeRaw() {
 * @return File size in human readable format
 */
 std::wstring MediaLibCleaner::File::GetFileSize() {
-	float temp = static_cast<float>(this->d_file_size_bytes) / 1048576; // MB
+	size_t size = this->GetFileSizeBytes();
+	float temp = static_cast<float>(size) / 1048576; // MB
 
-	if (this->d_file_size_bytes <= 1023) { // B
-		return std::to_wstring(this->d_file_size_bytes) + L"B";
+	if (size <= 1023) { // B
+		return std::to_wstring(size) + L"B";
 	}
-	else if (this->d_file_size_bytes > 1023 && this->d_file_size_bytes <= 1048575) { // KB
+	else if (size > 1023 && size <= 1048575) { // KB
 		return this->GetFileSizeKB();
 	}
-	else if (this->d_file_size_bytes > 1048575 && temp < 1024) { // MB
+	else if (size > 1048575 && temp < 1024) { // MB
 		return this->GetFileSizeMB();
 	}
 	else { // GB
@@ -1946,7 +1328,7 @@ std::wstring MediaLibCleaner::File::GetFileSize() {
 * @return File size in bytes
 */
 size_t MediaLibCleaner::File::GetFileSizeBytes() {
-	return this->d_file_size_bytes;
+	return static_cast<size_t>(this->getNumber(COLUMN_FILE_SIZE));
 }
 /**
 * Method returns file size in kilo bytes
@@ -1954,7 +1336,7 @@ size_t MediaLibCleaner::File::GetFileSizeBytes() {
 * @return File size in kilo bytes
 */
 std::wstring MediaLibCleaner::File::GetFileSizeKB() {
-	return std::to_wstring(this->d_file_size_bytes / 1024) + L"KB";
+	return std::to_wstring(this->getNumber(COLUMN_FILE_SIZE) / 1024) + L"KB";
 }
 /**
 * Method returns file size in mega bytes
@@ -1962,7 +1344,7 @@ std::wstring MediaLibCleaner::File::GetFileSizeKB() {
 * @return File size in mega bytes
 */
 std::wstring MediaLibCleaner::File::GetFileSizeMB() {
-	return std::to_wstring(this->d_file_size_bytes / 1048576) + L"MB";
+	return std::to_wstring(this->getNumber(COLUMN_FILE_SIZE) / 1048576) + L"MB";
 }
 
 /**
@@ -1998,50 +1380,13 @@ bool MediaLibCleaner::File::HasTag(std::wstring tag, std::vector<std::wstring> v
 {
 	TagLib::String curr_val;
 
-	if (tag == L"artist")
-		curr_val = this->artist;
-	else if (tag == L"title")
-		curr_val = this->title;
-	else if (tag == L"album")
-		curr_val = this->album;
-	else if (tag == L"comment")
-		curr_val = this->comment;
-	else if (tag == L"genre")
-		curr_val = this->genre;
-	else if (tag == L"year")
-		curr_val = this->year;
-	else if (tag == L"track")
-		curr_val = this->track;
-	else if (tag == L"albumartist")
-		curr_val = this->albumartist;
-	else if (tag == L"bpm")
-		curr_val = this->bpm;
-	else if (tag == L"copyright")
-		curr_val = this->copyright;
-	else if (tag == L"language")
-		curr_val = this->language;
-	else if (tag == L"length")
-		curr_val = this->length;
-	else if (tag == L"mood")
-		curr_val = this->mood;
-	else if (tag == L"origartist")
-		curr_val = this->origartist;
-	else if (tag == L"origalbum")
-		curr_val = this->origalbum;
-	else if (tag == L"origfilename")
-		curr_val = this->origfilename;
-	else if (tag == L"origyear")
-		curr_val = this->origyear;
-	else if (tag == L"publisher")
-		curr_val = this->publisher;
-	else if (tag == L"unsyncedlyrics")
-		curr_val = this->unsyncedlyrics;
-	else if (tag == L"www")
-		curr_val = this->www;
+	const TagInfo *info = FindTag(tag);
+	if (info != nullptr)
+		curr_val = this->getField(info->column);
 
 	if (curr_val == TagLib::String::null || curr_val == L"")
 	{
-		(*this->logalert)->Log(this->d_path, L"File doesn't have specified tag or tag is empty: '" + tag + L"'");
+		(*this->logalert)->Log(this->GetPath(), L"File doesn't have specified tag or tag is empty: '" + tag + L"'");
 		return false;
 	}
 
@@ -2059,7 +1404,7 @@ bool MediaLibCleaner::File::HasTag(std::wstring tag, std::vector<std::wstring> v
 
 		if (!retval)
 		{
-			(*this->logalert)->Log(this->d_path, L"Tag '" + tag + L"' doesn't have any of the required value; current value: '" + curr_val.toWString() + L"'");
+			(*this->logalert)->Log(this->GetPath(), L"Tag '" + tag + L"' doesn't have any of the required value; current value: '" + curr_val.toWString() + L"'");
 			return false;
 		}
 	}
@@ -2067,6 +1412,37 @@ bool MediaLibCleaner::File::HasTag(std::wstring tag, std::vector<std::wstring> v
 	return true;
 }
 
+/**
+ * Method checks if file has given tag with one of values of the set (set is searched by hash, not compared value by value)
+ *
+ * @param[in] tag Tag name, without % signs!
+ * @param[in] val Allowed values of the tag (see MediaLibCleaner::ValueSets)
+ *
+ * @return True if tag is present and has one of given values, false otherwise
+ */
+bool MediaLibCleaner::File::HasTag(std::wstring tag, const ValueSet &val)
+{
+	std::wstring curr_val;
+
+	const TagInfo *info = FindTag(tag);
+	if (info != nullptr)
+		curr_val = this->getField(info->column);
+
+	if (curr_val.empty())
+	{
+		(*this->logalert)->Log(this->GetPath(), L"File doesn't have specified tag or tag is empty: '" + tag + L"'");
+		return false;
+	}
+
+	if (val.find(curr_val) == val.end())
+	{
+		(*this->logalert)->Log(this->GetPath(), L"Tag '" + tag + L"' doesn't have any of the required value; current value: '" + curr_val + L"'");
+		return false;
+	}
+
+	return true;
+}
+
 /**
 * Method checks if file has given tag
 *
@@ -2079,56 +1455,19 @@ bool MediaLibCleaner::File::HasTag(std::wstring tag, TagLib::String val)
 {
 	TagLib::String curr_val;
 
-	if (tag == L"artist")
-		curr_val = this->artist;
-	else if (tag == L"title")
-		curr_val = this->title;
-	else if (tag == L"album")
-		curr_val = this->album;
-	else if (tag == L"comment")
-		curr_val = this->comment;
-	else if (tag == L"genre")
-		curr_val = this->genre;
-	else if (tag == L"year")
-		curr_val = this->year;
-	else if (tag == L"track")
-		curr_val = this->track;
-	else if (tag == L"albumartist")
-		curr_val = this->albumartist;
-	else if (tag == L"bpm")
-		curr_val = this->bpm;
-	else if (tag == L"copyright")
-		curr_val = this->copyright;
-	else if (tag == L"language")
-		curr_val = this->language;
-	else if (tag == L"length")
-		curr_val = this->length;
-	else if (tag == L"mood")
-		curr_val = this->mood;
-	else if (tag == L"origartist")
-		curr_val = this->origartist;
-	else if (tag == L"origalbum")
-		curr_val = this->origalbum;
-	else if (tag == L"origfilename")
-		curr_val = this->origfilename;
-	else if (tag == L"origyear")
-		curr_val = this->origyear;
-	else if (tag == L"publisher")
-		curr_val = this->publisher;
-	else if (tag == L"unsyncedlyrics")
-		curr_val = this->unsyncedlyrics;
-	else if (tag == L"www")
-		curr_val = this->www;
+	const TagInfo *info = FindTag(tag);
+	if (info != nullptr)
+		curr_val = this->getField(info->column);
 
 	if (curr_val == TagLib::String::null || curr_val == L"")
 	{
-		(*this->logalert)->Log(this->d_path, L"File doesn't have specified tag or tag is empty: '" + tag + L"'");
+		(*this->logalert)->Log(this->GetPath(), L"File doesn't have specified tag or tag is empty: '" + tag + L"'");
 		return false;
 	}
 
 	if (val != TagLib::String::null && curr_val != val)
 	{
-		(*this->logalert)->Log(this->d_path, L"Tag '" + tag + L"' doesn't have required value: '" + val.toWString() + L"'");
+		(*this->logalert)->Log(this->GetPath(), L"Tag '" + tag + L"' doesn't have required value: '" + val.toWString() + L"'");
 		return false;
 	}
 
@@ -2159,9 +1498,9 @@ bool MediaLibCleaner::File::Rename(std::wstring nname)
 	replaceAll(nname, L"..", L""); // security, so there's no ../../../../ (...) values or anything
 #endif
 
-	(*this->logalert)->Log(this->d_path, L"Renaming file to: '" + nname + L"'");
+	(*this->logalert)->Log(this->GetPath(), L"Renaming file to: '" + nname + L"'");
 
-	boost::filesystem::wpath loc_path = this->d_path, new_loc_path;
+	boost::filesystem::wpath loc_path = this->GetPath(), new_loc_path;
 
 	std::wstring nn = loc_path.parent_path().generic_wstring() + L"/" + nname;
 
@@ -2177,27 +1516,14 @@ bool MediaLibCleaner::File::Rename(std::wstring nname)
 
 	new_loc_path = nn;
 
-	FileType t = this->release();
+	// pending tag changes are not written here - they will be written
+	// once by save() at the new location
+	this->release();
 
-	try {
-		boost::filesystem::rename(loc_path, new_loc_path);
-	}
-	catch (boost::filesystem::filesystem_error e)
-	{
-		if (e.path1 == e.path2)
-		{
-			this->reopen(t);
-			return true;
-		}
-
-		(*this->logprogram)->Log(L"MediaLibCleaner::File::Rename()", s2ws(e.what()), 1);
-		this->reopen(t);
+	if (!this->relocate(loc_path, new_loc_path))
 		return false;
-	}
-
-	this->d_path = new_loc_path.generic_wstring();
 
-	this->reopen(t);
+	this->store->SetPath(this->row, new_loc_path.generic_wstring());
 
 	return true;
 }
@@ -2233,8 +1559,8 @@ bool MediaLibCleaner::File::Move(std::wstring nloc, std::string path)
 	replaceAll(nn, L".", L""); // security, so there's no ../../../../ (...) values or anything
 #endif
 
-	boost::filesystem::path loc_path = this->d_path;
-	boost::filesystem::wpath new_loc_path = (s2ws(path) + L"/" + nn + this->d_filename + L"." + this->d_ext);
+	boost::filesystem::path loc_path = this->GetPath();
+	boost::filesystem::wpath new_loc_path = (s2ws(path) + L"/" + nn + this->GetFilenameExt());
 
 	nn = new_loc_path.generic_wstring();
 	replaceAll(nn, L"\\", L"/");
@@ -2243,7 +1569,7 @@ bool MediaLibCleaner::File::Move(std::wstring nloc, std::string path)
 
 	if (boost::filesystem::exists(new_loc_path))
 	{
-		(*this->logalert)->Log(this->d_path, L"_Move(): file already exists: '" + nloc + L"'");
+		(*this->logalert)->Log(this->GetPath(), L"_Move(): file already exists: '" + nloc + L"'");
 	}
 
 	boost::filesystem::path dir = new_loc_path.parent_path();
@@ -2253,158 +1579,156 @@ bool MediaLibCleaner::File::Move(std::wstring nloc, std::string path)
 		boost::filesystem::create_directories(dir);
 	}
 
-	(*this->logalert)->Log(this->d_path, L"Moving file to: '" + new_loc_path.generic_wstring() + L"'");
+	(*this->logalert)->Log(this->GetPath(), L"Moving file to: '" + new_loc_path.generic_wstring() + L"'");
 
-	FileType t = this->release();
+	// pending tag changes are not written here - they will be written
+	// once by save() at the new location
+	this->release();
 
-	try {
-		boost::filesystem::rename(loc_path, new_loc_path);
-	}
-	catch (boost::filesystem::filesystem_error e)
-	{
-		if (e.path1 == e.path2)
-		{
-			this->reopen(t);
-			return true;
-		}
-
-		(*this->logprogram)->Log(L"MediaLibCleaner::File::Rename()", s2ws(e.what()), 1);
-		this->reopen(t);
+	if (!this->relocate(loc_path, new_loc_path))
 		return false;
-	}
-	this->d_path = new_loc_path.generic_wstring();
-	this->d_dfc = nullptr;
 
-	this->reopen(t);
+	this->store->SetPath(this->row, new_loc_path.generic_wstring());
+	this->d_dfc = nullptr;
 
 	return true;
 }
 
 /**
-* Method for deleting given file
+* Method for changing location of the file in the user filesystem (used by Rename() and Move()).
 *
-* @return Status of delete operation
+* If both locations are on the same volume, file is simply renamed and pending tag changes are left to be written by save().
+* Otherwise file is copied to a temporary file next to its destination, pending tag changes are written into that copy,
+* and only then it is renamed to its destination and the source file is removed - so the data is copied only once
+* and destination never contains partially written file. If the copy cannot be put in place, pending tag changes are kept
+* for save() at the old location; if only the source cannot be removed, the move is logged and treated as done.
+*
+* TagLib object has to be released before calling this method.
+*
+* @param[in] loc_path      Current location of the file
+* @param[in] new_loc_path  New location of the file
+*
+* @return Status of relocate operation
 */
-bool MediaLibCleaner::File::Delete()
+bool MediaLibCleaner::File::relocate(boost::filesystem::path loc_path, boost::filesystem::path new_loc_path)
 {
-	(*this->logalert)->Log(this->d_path, L"Deleting file");
-
-	boost::filesystem::wpath loc_path = this->d_path;
-
-	if (boost::filesystem::exists(loc_path))
+	try {
+		boost::filesystem::rename(loc_path, new_loc_path);
+		return true;
+	}
+	catch (boost::filesystem::filesystem_error e)
 	{
-		FileType t = this->release();
-		boost::filesystem::remove(loc_path);
+		if (e.path1() == e.path2())
+		{
+			return true;
+		}
 
-		if (t != FILETYPE_UNKNOWN)
+		if (e.code() != boost::system::errc::cross_device_link)
 		{
-			this->d_dfc->DecCount();
+			(*this->logprogram)->Log(L"MediaLibCleaner::File::relocate()", s2ws(e.what()), 1);
+			return false;
 		}
-		return true;
 	}
 
-	return false;
-}
+	(*this->logprogram)->Log(L"MediaLibCleaner::File::relocate(" + this->GetPath() + L")", L"Destination is on another volume, writing file through temporary copy", 3);
 
-/**
- * Method for easy setting tag in the audio file using already existing methods.
- * This method is for TagLib::String type of value variable
- *
- * @param[in] key  Tag name (wthout \% signs)
- * @param[in] val  New tag value
- *
- * @return True if tag setting operation succeded, false otherwise
- */
-bool MediaLibCleaner::File::SetTag(std::wstring key, TagLib::String val)
-{
-	bool locHasChanged = this->hasChanged;
+	boost::filesystem::path temp_path = new_loc_path;
+	temp_path += L".mlctmp";
 
-	this->hasChanged = true;
+	std::wstring orig_path = this->GetPath();
 
-	(*this->logalert)->Log(this->d_path, L"Setting tag '" + key + L"' to new value: '" + val.toWString() + L"'");
+	// save() clears pending tag changes, so they are kept until the copy is in place;
+	// if it cannot be moved there they are written by the next save() to the file at its old location
+	std::unique_ptr<std::map<StringColumn, TagMutation>> pending;
+	if (this->mutations)
+		pending.reset(new std::map<StringColumn, TagMutation>(*this->mutations));
 
-	if (key == L"artist")
-	{
-		return this->SetArtist(val);
-	}
-	else if (key == L"title")
-	{
-		return this->SetTitle(val);
-	}
-	else if (key == L"album")
-	{
-		return this->SetAlbum(val);
-	}
-	else if (key == L"genre")
-	{
-		return this->SetGenre(val);
-	}
-	else if (key == L"comment")
-	{
-		return this->SetComment(val);
-	}
-	else if (key == L"albumartist")
-	{
-		return this->SetAlbumArtist(val);
-	}
-	else if (key == L"bpm")
-	{
-		return this->SetBPM(val);
-	}
-	else if (key == L"copyright")
-	{
-		return this->SetCopyright(val);
-	}
-	else if (key == L"language")
-	{
-		return this->SetLanguage(val);
-	}
-	else if (key == L"length")
-	{
-		return this->SetTagLength(val);
-	}
-	else if (key == L"mood")
-	{
-		return this->SetMood(val);
-	}
-	else if (key == L"origalbum")
-	{
-		return this->SetOrigAlbum(val);
-	}
-	else if (key == L"origartist")
-	{
-		return this->SetOrigArtist(val);
-	}
-	else if (key == L"origfilename")
-	{
-		return this->SetOrigFilename(val);
-	}
-	else if (key == L"origyear")
-	{
-		return this->SetOrigYear(val);
-	}
-	else if (key == L"publisher")
-	{
-		return this->SetPublisher(val);
+	try {
+		boost::filesystem::copy_file(loc_path, temp_path, boost::filesystem::copy_options::overwrite_existing);
+
+		// write pending tag changes into the copy
+		this->store->SetPath(this->row, temp_path.generic_wstring());
+		this->save();
+		this->release();
+		this->store->SetPath(this->row, orig_path);
+
+		boost::filesystem::rename(temp_path, new_loc_path);
 	}
-	else if (key == L"unsyncedlyrics")
+	catch (boost::filesystem::filesystem_error e)
 	{
-		return this->SetLyricsUnsynced(val);
+		this->release();
+		this->store->SetPath(this->row, orig_path);
+		this->mutations = std::move(pending);
+
+		boost::system::error_code ec;
+		boost::filesystem::remove(temp_path, ec);
+
+		(*this->logprogram)->Log(L"MediaLibCleaner::File::relocate()", s2ws(e.what()), 1);
+		return false;
 	}
-	else if (key == L"www")
+
+	// file is already at its destination, so failing to remove the source does not undo the move
+	boost::system::error_code ec;
+	boost::filesystem::remove(loc_path, ec);
+	if (ec)
 	{
-		return this->SetWWW(val);
+		(*this->logalert)->Log(orig_path, L"File was copied to '" + new_loc_path.generic_wstring() + L"', but could not be removed: " + s2ws(ec.message()));
 	}
-	else if (key == L"track")
+
+	return true;
+}
+
+/**
+* Method for deleting given file
+*
+* @return Status of delete operation
+*/
+bool MediaLibCleaner::File::Delete()
+{
+	(*this->logalert)->Log(this->GetPath(), L"Deleting file");
+
+	boost::filesystem::wpath loc_path = this->GetPath();
+
+	if (boost::filesystem::exists(loc_path))
 	{
-		return this->SetTrack(val);
+		FileType t = this->release();
+		boost::filesystem::remove(loc_path);
+
+		// changes of deleted file are not going to be written anywhere
+		this->mutations.reset();
+		this->backend = nullptr;
+		this->isInitiated = false;
+
+		if (t != FILETYPE_UNKNOWN && this->d_dfc != nullptr)
+		{
+			this->d_dfc->DecCount();
+		}
+		return true;
 	}
-	else if (key == L"year")
+
+	return false;
+}
+
+/**
+ * Method for easy setting tag in the audio file using already existing methods.
+ * This method is for TagLib::String type of value variable
+ *
+ * @param[in] key  Tag name (wthout \% signs)
+ * @param[in] val  New tag value
+ *
+ * @return True if tag setting operation succeded, false otherwise
+ */
+bool MediaLibCleaner::File::SetTag(std::wstring key, TagLib::String val)
+{
+	const TagInfo *info = FindTag(key);
+
+	if (info != nullptr)
 	{
-		return this->SetYear(val);
+		if (!this->isInitiated) return false;
+		return this->queueTagChange(info->column, val);
 	}
 
-	this->hasChanged = locHasChanged;
+	(*this->logalert)->Log(this->GetPath(), L"Unknown tag '" + key + L"', cannot set it");
 	return false;
 }
 
@@ -2417,6 +1741,17 @@ bool MediaLibCleaner::File::IsInitiated() {
 	return this->isInitiated;
 }
 
+/**
+* Method returns type of the file, decided by its content when file was scanned
+*
+* @return Type of the file (FILETYPE_UNKNOWN if file is not audio file)
+*/
+MediaLibCleaner::FileType MediaLibCleaner::File::GetFileType() {
+	if (this->backend != nullptr)
+		return this->backend->GetType();
+	return FILETYPE_UNKNOWN;
+}
+
 /**
  * Method returning MediaLibCleaner::DFC object of the current file
  *
@@ -2429,98 +1764,132 @@ MediaLibCleaner::DFC* MediaLibCleaner::File::GetDFC() {
 /**
  * Method executed by process() after processing LUA script to save changes made by user script to the file.
  *
+ * All pending tag changes are applied to TagLib object in one pass and then written to the file (see writeTags()).
+ * If there are no pending changes (or all of them cancelled each other out) file is not touched at all.
+ *
  * It is important to not call save() on every tag change, as TagLib docs says:
  * "In the current implementation, it's dangerous to call save() repeatedly. At worst it will corrupt the file."
  */
 void MediaLibCleaner::File::save()
 {
-	if (this->isInitiated && this->hasChanged && boost::filesystem::exists(this->d_path))
+	if (!this->isInitiated) return;
+
+	if (!this->mutations || this->mutations->empty())
 	{
-		(*this->logprogram)->Log(L"MediaLibCleaner::save(" + this->d_path + L")", L"Writing all changes to file", 3);
+		(*this->logprogram)->Log(L"MediaLibCleaner::save(" + this->GetPath() + L")", L"No tag changes to write, skipping", 3);
+		this->mutations.reset();
+		return;
+	}
+
+	if (boost::filesystem::exists(this->GetPath()))
+	{
+		// TagLib object is opened only when there are changes to write
+		if (!this->reopen())
+		{
+			(*this->logprogram)->Log(L"MediaLibCleaner::save(" + this->GetPath() + L")", L"Could not open file to write tag changes", 1);
+			this->closeHandles();
+			this->mutations.reset();
+			return;
+		}
+
+		(*this->logprogram)->Log(L"MediaLibCleaner::save(" + this->GetPath() + L")", L"Applying " + std::to_wstring(this->mutations->size()) + L" tag change(s)", 3);
 
-		if (this->filetype == FILETYPE_MP3)
-			this->taglib_file_mp3->save();
-		else if (this->filetype == FILETYPE_FLAC)
-			this->taglib_file_flac->save();
-		else if (this->filetype == FILETYPE_OGG)
-			this->taglib_file_ogg->save();
-		else if (this->filetype == FILETYPE_MP4)
-			this->taglib_file_m4a->save();
+		for (auto it = this->mutations->begin(); it != this->mutations->end(); ++it)
+		{
+			this->setTagUniversal(it->second.info, it->second.value);
+		}
+
+		(*this->logprogram)->Log(L"MediaLibCleaner::save(" + this->GetPath() + L")", L"Writing all changes to file", 3);
+
+		uintmax_t written = 0;
+		SaveMode mode = this->writeTags(&written);
+		(*this->runcontext)->GetSaveStats()->Count(mode, written);
+
+		if (mode == SAVE_FAILED)
+			(*this->logprogram)->Log(L"MediaLibCleaner::save(" + this->GetPath() + L")", L"Writing tag changes to file failed", 1);
+
+		// TagLib object is never used for a second save (see above)
+		this->closeHandles();
 	}
+
+	this->mutations.reset();
 }
 
 /**
- * Method allows to release all file handles MLC or taglib can have; invalidates the file and resets it's FileType
+ * Method writes tags from TagLib object to the file.
+ *
+ * For MP3 files with ID3v2 tag (and no APEv2 tag), FLAC files with Vorbis Comment only and single-stream Ogg Vorbis files,
+ * tags are rendered by TagLib but written by MediaLibCleaner::PlanID3v2Write() / MediaLibCleaner::PlanFLACWrite() /
+ * MediaLibCleaner::PlanVorbisWrite(): if tags fit into the space already reserved in the file they are written in place,
+ * otherwise the file is rewritten once with configured padding (_tag_padding) reserved, so next changes can be written in place.
+ * All other files are saved by TagLib.
+ * TagLib object is released if tags were written by MediaLibCleaner.
  *
- * @return Old filetype to be saved for later
+ * @param[out] written  Amount of bytes written to the disk (0 if unknown)
+ *
+ * @return Mode in which tags were written
  */
-MediaLibCleaner::FileType MediaLibCleaner::File::release()
+MediaLibCleaner::SaveMode MediaLibCleaner::File::writeTags(uintmax_t *written)
 {
-	if (!this->IsInitiated()) return FILETYPE_UNKNOWN;
+	WritePlan plan;
+	size_t padding = (*this->runcontext)->GetTagPadding();
 
-	this->save();
-	this->hasChanged = false;
+	*written = 0;
 
-	
-	if (this->filetype == FILETYPE_MP3)
-	{
-		auto ptr = this->taglib_file_mp3.release();
-		delete ptr;
-	}
-	else if (this->filetype == FILETYPE_OGG)
-	{
-		auto ptr2 = this->taglib_file_ogg.release();
-		delete ptr2;
-	}
-	else if (this->filetype == FILETYPE_FLAC)
-	{
-		auto ptr3 = this->taglib_file_flac.release();
-		delete ptr3;
-	}
-	else if (this->filetype == FILETYPE_MP4)
+	bool planned = this->backend->PlanWrite(this->GetPath(), padding, &plan);
+
+	if (!planned)
 	{
-		auto ptr4 = this->taglib_file_m4a.release();
-		delete ptr4;
+		(*this->logprogram)->Log(L"MediaLibCleaner::writeTags(" + this->GetPath() + L")", L"Saving tags with TagLib", 3);
+
+		bool result = this->backend->Save();
+
+		return result ? SAVE_TAGLIB : SAVE_FAILED;
 	}
 
-	auto retval = this->filetype;
+	(*this->logprogram)->Log(L"MediaLibCleaner::writeTags(" + this->GetPath() + L")", L"Tags take " + std::to_wstring(plan.tags_size) + L" of " + std::to_wstring(plan.available) + L" bytes available, " + (plan.mode == SAVE_IN_PLACE ? L"writing in place" : L"rewriting file"), 3);
 
-	this->filetype = FILETYPE_UNKNOWN;
-	this->isInitiated = false;
+	// TagLib may not hold the file while it is being modified behind its back
+	this->release();
 
-	return retval;
+	return ExecuteWritePlan(this->GetPath(), plan, written);
 }
 
 /**
- * Method allows to reopen file based on given FileType
+ * Method allows to release all file handles MLC or taglib can have.
+ * Pending tag changes are kept and will be written by the next save() call.
  *
- * @param[in] type  FileType enum value indicating what kind of file is this File object represents
+ * @return Filetype of the file
  */
-void MediaLibCleaner::File::reopen(MediaLibCleaner::FileType type)
+MediaLibCleaner::FileType MediaLibCleaner::File::release()
 {
-	if (type == FILETYPE_MP3)
-	{
-		std::unique_ptr<TagLib::MPEG::File> temp(new TagLib::MPEG::File(TagLib::FileName(this->d_path.c_str())));
-		this->taglib_file_mp3.swap(temp);
-	}
-	else if (type == FILETYPE_OGG)
-	{
-		std::unique_ptr<TagLib::Ogg::Vorbis::File> temp2(new TagLib::Ogg::Vorbis::File(TagLib::FileName(this->d_path.c_str())));
-		this->taglib_file_ogg.swap(temp2);
-	}
-	else if (type == FILETYPE_FLAC)
-	{
-		std::unique_ptr<TagLib::FLAC::File> temp3(new TagLib::FLAC::File(TagLib::FileName(this->d_path.c_str())));
-		this->taglib_file_flac.swap(temp3);
-	}
-	else if (type == FILETYPE_MP4)
-	{
-		std::unique_ptr<TagLib::MP4::File> temp4(new TagLib::MP4::File(TagLib::FileName(this->d_path.c_str())));
-		this->taglib_file_m4a.swap(temp4);
-	}
+	if (!this->IsInitiated()) return FILETYPE_UNKNOWN;
 
-	this->filetype = type;
-	this->isInitiated = true;
+	this->closeHandles();
+
+	return this->backend->GetType();
+}
+
+/**
+ * Method destroys TagLib objects of the file (closing file handles).
+ */
+void MediaLibCleaner::File::closeHandles()
+{
+	if (this->backend != nullptr) this->backend->Close();
+}
+
+/**
+ * Method allows to reopen TagLib object for the file, if it has been released before.
+ * Does nothing if TagLib object is already open.
+ *
+ * @return True if TagLib object is open and valid, false otherwise
+ */
+bool MediaLibCleaner::File::reopen()
+{
+	if (this->backend == nullptr) return false;
+
+	// audio properties are not needed to write tags
+	return this->backend->Open(this->GetPath(), ACCURACY_NONE);
 }
 
 
@@ -2548,9 +1917,7 @@ MediaLibCleaner::FilesAggregator::FilesAggregator(std::unique_ptr<MediaLibCleane
 MediaLibCleaner::FilesAggregator::~FilesAggregator() {
 	(*this->logprogram)->Log(L"MediaLibCleaner::FilesAggregator", L"Calling destructor", 3);
 
-	auto nd = this->end();
-	for (auto it = this->begin(); it != nd; ++it)
-		delete *it;
+	// MediaLibCleaner::File objects live in the arena of MediaLibCleaner::RunContext and are freed with it
 }
 
 /**
@@ -3038,6 +2405,183 @@ void MediaLibCleaner::LogProgram::Log(std::wstring module, std::wstring message,
 	}
 }
 
+/**
+* MediaLibCleaner::RunContext constructor.
+*
+* Computes values of all run-constant system aliases, so they do not need to be recomputed for every file.
+*
+* @param[in] path          Path to the working directory
+* @param[in] datetime_raw  Unix timestamp of the program startup moment
+* @param[in] tag_padding   Amount of padding (in bytes) reserved when file has to be rewritten to fit new tags
+* @param[in] accuracy      Accuracy of audio properties read during scan
+* @param[in] fast_scan     True if tags are read during scan by read-only parser, false if always by TagLib
+*/
+MediaLibCleaner::RunContext::RunContext(std::string path, time_t datetime_raw, size_t tag_padding, MediaLibCleaner::PropertyAccuracy accuracy, bool fast_scan)
+{
+	this->path = path;
+
+	this->d_date = get_date_iso_8601_wide(datetime_raw);
+	this->d_datetime = get_date_rfc_2822_wide(datetime_raw);
+	this->d_datetime_raw = std::to_wstring(datetime_raw);
+
+	boost::filesystem::path loc_path = path;
+	this->d_workingdir = loc_path.filename().generic_wstring();
+	this->d_workingpath = loc_path.generic_wstring();
+
+	this->d_total_files = L"0";
+	this->tag_padding = tag_padding;
+	this->property_accuracy = accuracy;
+	this->fast_scan = fast_scan;
+	this->store.reset(new LibraryStore());
+	this->arena.reset(new Arena());
+	this->regexcache.reset(new RegexCache());
+}
+
+/**
+* MediaLibCleaner::RunContext destructor.
+*/
+MediaLibCleaner::RunContext::~RunContext()
+{
+}
+
+/**
+* Method sets amount of audio files found by scan() (\%_total_files% alias)
+*
+* @param[in] total_files  Number of all audio files found in the working directory
+*/
+void MediaLibCleaner::RunContext::SetTotalFiles(int total_files) {
+	this->d_total_files = std::to_wstring(total_files);
+}
+
+/**
+* Method returns path to the working directory
+*
+* @return Path to the working directory
+*/
+std::string MediaLibCleaner::RunContext::GetPath() {
+	return this->path;
+}
+
+/**
+* Method returns program startup date in ISO 8601 format (\%_date% alias)
+*
+* @return Program startup date in ISO 8601 format
+*/
+std::wstring MediaLibCleaner::RunContext::GetDate() {
+	return this->d_date;
+}
+
+/**
+* Method returns program startup date in RFC 2822 format (\%_datetime% alias)
+*
+* @return Program startup date in RFC 2822 format
+*/
+std::wstring MediaLibCleaner::RunContext::GetDatetime() {
+	return this->d_datetime;
+}
+
+/**
+* Method returns program startup date as unix timestamp (\%_datetime_raw% alias)
+*
+* @return Program startup date as unix timestamp
+*/
+std::wstring MediaLibCleaner::RunContext::GetDatetimeRaw() {
+	return this->d_datetime_raw;
+}
+
+/**
+* Method returns name of the working directory (\%_workingdir% alias)
+*
+* @return Name of the working directory
+*/
+std::wstring MediaLibCleaner::RunContext::GetWorkingDir() {
+	return this->d_workingdir;
+}
+
+/**
+* Method returns full path of the working directory (\%_workingpath% alias)
+*
+* @return Full path of the working directory
+*/
+std::wstring MediaLibCleaner::RunContext::GetWorkingPath() {
+	return this->d_workingpath;
+}
+
+/**
+* Method returns amount of audio files found in the working directory (\%_total_files% alias)
+*
+* @return Amount of audio files found in the working directory
+*/
+std::wstring MediaLibCleaner::RunContext::GetTotalFiles() {
+	return this->d_total_files;
+}
+
+/**
+* Method returns amount of padding reserved when file has to be rewritten to fit new tags
+*
+* @return Amount of padding in bytes
+*/
+size_t MediaLibCleaner::RunContext::GetTagPadding() {
+	return this->tag_padding;
+}
+
+/**
+* Method returns accuracy of audio properties read during scan
+*
+* @return Property accuracy
+*/
+MediaLibCleaner::PropertyAccuracy MediaLibCleaner::RunContext::GetPropertyAccuracy() {
+	return this->property_accuracy;
+}
+
+/**
+* Method checks if tags are read during scan by read-only parser (see MediaLibCleaner::ReadTagsFast())
+*
+* @return True if read-only parser is used, false if tags are always read by TagLib
+*/
+bool MediaLibCleaner::RunContext::GetFastScan() {
+	return this->fast_scan;
+}
+
+/**
+* Method returns statistics of tag writes done during the run
+*
+* @return Pointer to MediaLibCleaner::SaveStats object
+*/
+MediaLibCleaner::SaveStats* MediaLibCleaner::RunContext::GetSaveStats() {
+	return &this->savestats;
+}
+
+/**
+* Method returns columnar store holding data of all files
+*
+* @return Pointer to MediaLibCleaner::LibraryStore object
+*/
+MediaLibCleaner::LibraryStore* MediaLibCleaner::RunContext::GetStore() {
+	return this->store.get();
+}
+
+/**
+* Method returns arena MediaLibCleaner::File objects are allocated in
+*
+* @return Pointer to MediaLibCleaner::Arena object
+*/
+MediaLibCleaner::Arena* MediaLibCleaner::RunContext::GetArena() {
+	return this->arena.get();
+}
+
+/**
+* Method returns cache of regular expressions used by the config file
+*
+* @return Pointer to MediaLibCleaner::RegexCache object
+*/
+MediaLibCleaner::RegexCache* MediaLibCleaner::RunContext::GetRegexCache() {
+	return this->regexcache.get();
+}
+
+
+
+
 /**
 * Method to add or create DFC object (depending on its presence in dfc_list).
 * If given path has already assigned DFC object it is returned; if not, new DFC object is created and returned.
@@ -3085,13 +2629,11 @@ MediaLibCleaner::DFC* MediaLibCleaner::AddDFC(std::list<MediaLibCleaner::DFC*>*
 *
 * @param[in]	wcfg	      String with config file content. Any format is accepted.
 * @param[in]	audiofile     std::unique_ptr to MediaLibCleaner::AudioFile object representing current file
-* @param[in]	path	      Path to the working directory
-* @param[in]	datetime_raw  Unix timestamp of the program startup moment
-* @param[in]	total_files   Number of all files contained in the working directory
+* @param[in]	runcontext    MediaLibCleaner::RunContext object holding precomputed values of system aliases
 *
 * @return String containing config file with aliases replaced
 */
-std::wstring MediaLibCleaner::ReplaceAllAliasOccurences(std::wstring& wcfg, MediaLibCleaner::File* audiofile, std::string path, time_t datetime_raw, int total_files) {
+std::wstring MediaLibCleaner::ReplaceAllAliasOccurences(std::wstring& wcfg, MediaLibCleaner::File* audiofile, MediaLibCleaner::RunContext* runcontext) {
 	std::wstring newc = wcfg;
 
 	// copy original path to not confuse rest of the program
@@ -3099,26 +2641,12 @@ std::wstring MediaLibCleaner::ReplaceAllAliasOccurences(std::wstring& wcfg, Medi
 
 	// do the magic!
 	// SONG DATA
-	replaceAll(newc, L"%artist%", audiofile->GetArtist());
-	replaceAll(newc, L"%title%", audiofile->GetTitle());
-	replaceAll(newc, L"%album%", audiofile->GetAlbum());
-	replaceAll(newc, L"%genre%", audiofile->GetGenre());
-	replaceAll(newc, L"%comment%", audiofile->GetComment());
-	replaceAll(newc, L"%track%", audiofile->GetTrack());
-	replaceAll(newc, L"%year%", audiofile->GetYear());
-	replaceAll(newc, L"%albumartist%", audiofile->GetAlbumArtist());
-	replaceAll(newc, L"%bpm%", audiofile->GetBPM());
-	replaceAll(newc, L"%copyright%", audiofile->GetCopyright());
-	replaceAll(newc, L"%language%", audiofile->GetLanguage());
-	replaceAll(newc, L"%length%", audiofile->GetTagLength());
-	replaceAll(newc, L"%mood%", audiofile->GetMood());
-	replaceAll(newc, L"%origalbum%", audiofile->GetOrigAlbum());
-	replaceAll(newc, L"%origartist%", audiofile->GetOrigArtist());
-	replaceAll(newc, L"%origfilename%", audiofile->GetOrigFilename());
-	replaceAll(newc, L"%origyear%", audiofile->GetOrigYear());
-	replaceAll(newc, L"%publisher%", audiofile->GetPublisher());
-	replaceAll(newc, L"%unsyncedlyrics%", audiofile->GetLyricsUnsynced());
-	replaceAll(newc, L"%www%", audiofile->GetWWW());
+	for (int i = 0; i < TAGS_COUNT; i++)
+	{
+		std::wstring alias = L"%" + std::wstring(TagSchema[i].name) + L"%";
+		if (newc.find(alias) != std::wstring::npos)
+			replaceAll(newc, alias, audiofile->GetTag(&TagSchema[i]));
+	}
 
 	// TECHNICAL INFO
 	replaceAll(newc, L"%_bitrate%", std::to_wstring(audiofile->GetBitrate()));
@@ -3127,6 +2655,9 @@ std::wstring MediaLibCleaner::ReplaceAllAliasOccurences(std::wstring& wcfg, Medi
 	replaceAll(newc, L"%_cover_size%", std::to_wstring(audiofile->GetCoverSize()));
 	replaceAll(newc, L"%_cover_type%", audiofile->GetCoverType());
 	replaceAll(newc, L"%_covers%", std::to_wstring(audiofile->GetCovers()));
+	replaceAll(newc, L"%_cover_width%", std::to_wstring(audiofile->GetCoverWidth()));
+	replaceAll(newc, L"%_cover_height%", std::to_wstring(audiofile->GetCoverHeight()));
+	replaceAll(newc, L"%_dup_group%", std::to_wstring(audiofile->GetDuplicateGroup()));
 	replaceAll(newc, L"%_length%", audiofile->GetLengthAsString());
 	replaceAll(newc, L"%_length_seconds%", std::to_wstring(audiofile->GetLength()));
 	replaceAll(newc, L"%_channels%", std::to_wstring(audiofile->GetChannels()));
@@ -3144,9 +2675,8 @@ std::wstring MediaLibCleaner::ReplaceAllAliasOccurences(std::wstring& wcfg, Medi
 #ifdef WIN32
 	replaceAll(newc, L"%_volume%", audiofile->GetVolume());
 #endif
-	boost::filesystem::path loc_path = path;
-	replaceAll(newc, L"%_workingdir%", loc_path.filename().generic_wstring());
-	replaceAll(newc, L"%_workingpath%", loc_path.generic_wstring());
+	replaceAll(newc, L"%_workingdir%", runcontext->GetWorkingDir());
+	replaceAll(newc, L"%_workingpath%", runcontext->GetWorkingPath());
 
 
 	// FILES PROPERTIES
@@ -3164,159 +2694,13 @@ std::wstring MediaLibCleaner::ReplaceAllAliasOccurences(std::wstring& wcfg, Medi
 
 	// SYSTEM DATA
 	replaceAll(newc, L"%_counter_dir%", std::to_wstring(audiofile->GetCounterDir()));
-	replaceAll(newc, L"%_date%", get_date_iso_8601_wide(datetime_raw));
-	replaceAll(newc, L"%_datetime%", get_date_rfc_2822_wide(datetime_raw));
-	replaceAll(newc, L"%_datetime_raw%", std::to_wstring(datetime_raw));
-	replaceAll(newc, L"%_total_files%", std::to_wstring(total_files));
+	replaceAll(newc, L"%_date%", runcontext->GetDate());
+	replaceAll(newc, L"%_datetime%", runcontext->GetDatetime());
+	replaceAll(newc, L"%_datetime_raw%", runcontext->GetDatetimeRaw());
+	replaceAll(newc, L"%_total_files%", runcontext->GetTotalFiles());
 	replaceAll(newc, L"%_total_files_dir%", std::to_wstring(audiofile->GetCounterTotal()));
 
 	replaceAll(newc, L"\\", L"\\\\");
 
 	return newc;
 }
-
-
-
-
-/**
- * Data useful in translating base64-encoded string into vector of chars
- */
-static const char from_base64[] = { 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
-255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
-255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 62, 255, 62, 255, 63,
-52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 255, 255, 0, 255, 255, 255,
-255, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
-15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 255, 255, 255, 255, 63,
-255, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
-41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 255, 255, 255, 255, 255 };
-
-/**
-* Data useful in translating string into base64-encoded string
-*/
-static const char to_base64[] =
-"ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-"abcdefghijklmnopqrstuvwxyz"
-"0123456789+/";
-
-/**
- * Function (wrapper) used to encode string
- *
- * @param[in] buffer  Input string
- *
- * @return base64-encoded string
- */
-static std::string MediaLibCleaner::base64_encode_w(const std::vector<char>& buffer)
-{
-	return base64_encode(&buffer[0], static_cast<int>(buffer.size()));
-}
-
-/**
-* Function base64-encoding given strings
-*
-* @param[in] buf     Input string
-* @param[in] bufLen  Lenght of given buffer
-*
-* @return base64-encoded string
-*/
-static std::string MediaLibCleaner::base64_encode(const char* buf, int bufLen)
-{
-	// Calculate how many bytes that needs to be added to get a multiple of 3
-	size_t missing = 0;
-	size_t ret_size = bufLen;
-	while ((ret_size % 3) != 0)
-	{
-		++ret_size;
-		++missing;
-	}
-
-	// Expand the return string size to a multiple of 4
-	ret_size = 4 * ret_size / 3;
-
-	std::string ret;
-	ret.reserve(ret_size);
-
-	for (size_t i = 0; i < ret_size / 4; ++i)
-	{
-		// Read a group of three bytes (avoid buffer overrun by replacing with 0)
-		size_t index = i * 3;
-		char b3[3];
-		b3[0] = (index + 0 < bufLen) ? buf[index + 0] : 0;
-		b3[1] = (index + 1 < bufLen) ? buf[index + 1] : 0;
-		b3[2] = (index + 2 < bufLen) ? buf[index + 2] : 0;
-
-		// Transform into four base 64 characters
-		char b4[4];
-		b4[0] = ((b3[0] & 0xfc) >> 2);
-		b4[1] = ((b3[0] & 0x03) << 4) + ((b3[1] & 0xf0) >> 4);
-		b4[2] = ((b3[1] & 0x0f) << 2) + ((b3[2] & 0xc0) >> 6);
-		b4[3] = ((b3[2] & 0x3f) << 0);
-
-		// Add the base 64 characters to the return value
-		ret.push_back(to_base64[b4[0]]);
-		ret.push_back(to_base64[b4[1]]);
-		ret.push_back(to_base64[b4[2]]);
-		ret.push_back(to_base64[b4[3]]);
-	}
-
-	// Replace data that is invalid (always as many as there are missing bytes)
-	for (size_t i = 0; i<missing; ++i)
-		ret[ret_size - i - 1] = '=';
-
-	return ret;
-}
-
-/**
-* Function decoding base64-encoded string
-*
-* @param[in] encoded_string  base64-encoded string to be decoded
-*
-* @return std::vector of chars (decoded data)
-*/
-static std::vector<char> MediaLibCleaner::base64_decode(std::string encoded_string)
-{
-	// Make sure string length is a multiple of 4
-	while ((encoded_string.size() % 4) != 0)
-		encoded_string.push_back('=');
-
-	size_t encoded_size = encoded_string.size();
-	std::vector<char> ret;
-	ret.reserve(3 * encoded_size / 4);
-
-	for (size_t i = 0; i < encoded_size; i += 4)
-	{
-		// Get values for each group of four base 64 characters
-		char b4[4];
-		b4[0] = (encoded_string[i + 0] <= 'z') ? from_base64[encoded_string[i + 0]] : 0xff;
-		b4[1] = (encoded_string[i + 1] <= 'z') ? from_base64[encoded_string[i + 1]] : 0xff;
-		b4[2] = (encoded_string[i + 2] <= 'z') ? from_base64[encoded_string[i + 2]] : 0xff;
-		b4[3] = (encoded_string[i + 3] <= 'z') ? from_base64[encoded_string[i + 3]] : 0xff;
-
-		// Transform into a group of three bytes
-		char b3[3];
-		b3[0] = ((b4[0] & 0x3f) << 2) + ((b4[1] & 0x30) >> 4);
-		b3[1] = ((b4[1] & 0x0f) << 4) + ((b4[2] & 0x3c) >> 2);
-		b3[2] = ((b4[2] & 0x03) << 6) + ((b4[3] & 0x3f) >> 0);
-
-		// Add the byte to the return value if it isn't part of an '=' character (indicated by 0xff)
-		if (b4[1] != 0xff) ret.push_back(b3[0]);
-		if (b4[2] != 0xff) ret.push_back(b3[1]);
-		if (b4[3] != 0xff) ret.push_back(b3[2]);
-	}
-
-	return ret;
-}
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
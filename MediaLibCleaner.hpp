@@ -9,6 +9,9 @@
 
 #include <iostream>
 #include <vector>
+#include <algorithm>
+#include <map>
+#include <list>
 #include <stdlib.h>
 
 #include <boost/locale.hpp>
@@ -67,6 +70,10 @@
 #include <memory>
 
 #include "helpers.hpp"
+#include "LibraryStore.hpp"
+#include "TagSchema.hpp"
+#include "TagWriter.hpp"
+#include "ValueSets.hpp"
 #include <mutex>
 #include <codecvt>
 
@@ -91,6 +98,26 @@ namespace MediaLibCleaner
 		FILETYPE_UNKNOWN ///< Type of the file is unknown (for example *.jpg, *.png, *.ini, ...)
 	};
 
+	/**
+	 * @brief Enumerate type describing how accurately audio properties (bitrate, length, channels, sample rate) are read during scan
+	 */
+	enum PropertyAccuracy
+	{
+		ACCURACY_NONE, ///< Audio properties are not read at all (technical info aliases are 0)
+		ACCURACY_HEADER, ///< Audio properties are read from headers only (Xing/VBRI frame, STREAMINFO block, first and last Ogg page...)
+		ACCURACY_ACCURATE ///< Audio properties are computed as accurately as possible (may read large part of the file)
+	};
+
+	/**
+	 * @brief Enumerate type describing result of integrity check of the file (see MediaLibCleaner::IntegrityVerifier)
+	 */
+	enum IntegrityStatus
+	{
+		INTEGRITY_UNKNOWN, ///< File was not verified (verification is disabled or format is not supported)
+		INTEGRITY_INTACT, ///< No damage was found
+		INTEGRITY_DAMAGED ///< File is damaged
+	};
+
 	/**
 	 * @class LogAlert MediaLibCleaner.hpp
 	 *
@@ -204,189 +231,142 @@ namespace MediaLibCleaner
 		void DecCount();
 	};
 
+	class FormatBackend;
+	class RegexCache;
+	struct FastTags;
+
 	/**
-	* @class File MediaLibCleaner.hpp
-	*
-	* @brief Class MediaLibCleaner::File contains all fileds and methods to effectively mainpulate (read and write) tags within a file.
-	*/
-	class File {
+	 * @class RunContext MediaLibCleaner.hpp
+	 *
+	 * @brief Class MediaLibCleaner::RunContext holds values of all system aliases that do not change during program execution.
+	 * Object is created once before scan() (total files are set after it) and shared by all threads in scan() and process().
+	 * It also holds run-wide tag writing settings and statistics.
+	 */
+	class RunContext {
 
 	protected:
-		
-		// SONG INFO
-		/**
-		 * An TagLib::String object containing \%artist% name written in audio file
-		 */
-		TagLib::String artist;
-		/**
-		* An TagLib::String object containing \%title% written in audio file
-		*/
-		TagLib::String title;
-		/**
-		* An TagLib::String object containing \%album% name written in audio file
-		*/
-		TagLib::String album;
-		/**
-		* An TagLib::String object containing \%genre% written in audio file
-		*/
-		TagLib::String genre;
-		/**
-		* An TagLib::String object containing \%comment% written in audio file
-		*/
-		TagLib::String comment;
-		/**
-		* An TagLib::uint object containing \%track% number written in audio file
-		*/
-		TagLib::String track;
 		/**
-		* An TagLib::uint object containing release \%year% written in audio file
+		* Path of the working directory as given by the user
 		*/
-		TagLib::String year;
-		/**
-		* An TagLib::String object containing \%albumartist% written in audio file
-		*/
-		TagLib::String albumartist;
-		/**
-		* An TagLib::String object containing \%bpm% written in audio file
-		*/
-		TagLib::String bpm;
-		/**
-		* An TagLib::String object containing \%copyright% written in audio file
-		*/
-		TagLib::String copyright;
-		/**
-		* An TagLib::String object containing \%language% written in audio file
-		*/
-		TagLib::String language;
-		/**
-		* An TagLib::String object containing \%length% written in audio file
-		*/
-		TagLib::String length;
-		/**
-		* An TagLib::String object containing \%mood% written in audio file
-		*/
-		TagLib::String mood;
-		/**
-		* An TagLib::String object containing \%origalbum% written in audio file
-		*/
-		TagLib::String origalbum;
-		/**
-		* An TagLib::String object containing \%origartist% written in audio file
-		*/
-		TagLib::String origartist;
-		/**
-		* An TagLib::String object containing \%origfilename% written in audio file
-		*/
-		TagLib::String origfilename;
-		/**
-		* An TagLib::String object containing \%origyear% written in audio file
-		*/
-		TagLib::String origyear;
-		/**
-		* An TagLib::String object containing \%publisher% written in audio file
-		*/
-		TagLib::String publisher;
-		/**
-		* An TagLib::String object containing \%unsyncedlyrics% written in audio file
-		*/
-		TagLib::String unsyncedlyrics;
-		/**
-		* An TagLib::String object containing \%www% written in audio file
-		*/
-		TagLib::String www;
-
-
+		std::string path;
 
-		// TECHNICAL INFO
-		/**
-		* An int containing information about audio file bitrate
-		*/
-		int d_bitrate;
 		/**
-		* An int containing information about audio file codec
+		* Value of \%_date% alias (ISO 8601 date of program startup)
 		*/
-		std::wstring d_codec;
-		/**
-		* An int containing information about audio file first cover mimetype
-		*/
-		std::wstring d_cover_mimetype;
-		/**
-		* An int containing information about audio file first cover size (in bytes)
-		*/
-		size_t d_cover_size;
+		std::wstring d_date;
+
 		/**
-		* An int containing information about audio file first cover type
+		* Value of \%_datetime% alias (RFC 2822 date of program startup)
 		*/
-		std::wstring d_cover_type;
+		std::wstring d_datetime;
+
 		/**
-		* An int containing information about audio file covers count
+		* Value of \%_datetime_raw% alias (unix timestamp of program startup)
 		*/
-		int d_covers;
+		std::wstring d_datetime_raw;
+
 		/**
-		* An int containing information about amount of channels in audio file
+		* Value of \%_workingdir% alias (name of the working directory)
 		*/
-		int d_channels;
+		std::wstring d_workingdir;
+
 		/**
-		* An int containing information about auido file sample rate
+		* Value of \%_workingpath% alias (full path of the working directory)
 		*/
-		int d_sampleRate;
+		std::wstring d_workingpath;
+
 		/**
-		* An int containing information about audio file length in seconds
+		* Value of \%_total_files% alias (amount of audio files found by scan())
 		*/
-		int d_length;
-
-
-
+		std::wstring d_total_files;
 
-		// PATH INFO
 		/**
-		* An std::string containing full name of directory file resides in
+		* Amount of padding (in bytes) reserved in the file when tags do not fit and file has to be rewritten
 		*/
-		std::wstring d_directory = L"";
+		size_t tag_padding;
+
 		/**
-		* An std::string containing file extension
+		* Accuracy of audio properties read during scan
 		*/
-		std::wstring d_ext = L"";
+		PropertyAccuracy property_accuracy;
+
 		/**
-		* An std::string containing file name (without extension)
+		* True if tags are read during scan by read-only parser (see ReadTagsFast()), false if always by TagLib
 		*/
-		std::wstring d_filename = L"";
+		bool fast_scan;
+
 		/**
-		* An std::string containing full path of directory file resides in
+		* Statistics of tag writes done during the run
 		*/
-		std::wstring d_folderpath = L"";
+		SaveStats savestats;
+
 		/**
-		* An std::string containing name of parent directory
+		* Columnar store holding data of all files
 		*/
-		std::wstring d_parent_dir = L"";
+		std::unique_ptr<LibraryStore> store;
+
 		/**
-		* An std::string containing full path to audio file
+		* Arena holding all MediaLibCleaner::File objects
 		*/
-		std::wstring d_path = L"";
+		std::unique_ptr<Arena> arena;
 
-#ifdef WIN32
 		/**
-		* An std::string containing volume letter (Windows only)
+		* Regular expressions used by the config file, compiled once per run
 		*/
-		std::wstring d_volume = L"";
-#endif
+		std::unique_ptr<RegexCache> regexcache;
 
+	public:
+		RunContext(std::string, time_t, size_t, PropertyAccuracy, bool);
+		~RunContext();
+
+		void SetTotalFiles(int);
+
+		std::string GetPath();
+		std::wstring GetDate();
+		std::wstring GetDatetime();
+		std::wstring GetDatetimeRaw();
+		std::wstring GetWorkingDir();
+		std::wstring GetWorkingPath();
+		std::wstring GetTotalFiles();
+		size_t GetTagPadding();
+		PropertyAccuracy GetPropertyAccuracy();
+		bool GetFastScan();
+		SaveStats* GetSaveStats();
+		LibraryStore* GetStore();
+		Arena* GetArena();
+		RegexCache* GetRegexCache();
+	};
 
+	/**
+	 * @brief Structure describing single pending tag change. All pending changes are applied to the file at once in MediaLibCleaner::File::save()
+	 */
+	struct TagMutation
+	{
+		const TagInfo *info; ///< Description of the tag (names of the tag in all tag formats)
+		TagLib::String original; ///< Value of the tag read from the file (before first change)
+		TagLib::String value; ///< New value of the tag, or TagLib::String::null if tag is to be deleted
+	};
 
+	/**
+	* @class File MediaLibCleaner.hpp
+	*
+	* @brief Class MediaLibCleaner::File contains all fileds and methods to effectively mainpulate (read and write) tags within a file.
+	*/
+	class File {
 
-		// FILES PROPERITIES
-		/**
-		* An std::string containing file created date in unix timestamp format
-		*/
-		time_t d_file_create_datetime_raw = 0;
+		friend class FormatBackend;
+
+	protected:
+		
 		/**
-		* An std::string containing file modified date in unix timestamp format
-		*/
-		time_t d_file_mod_datetime_raw = 0;
+		 * Index of the row of MediaLibCleaner::LibraryStore holding all tags, technical info, path and properties of the file
+		 */
+		size_t row = 0;
+
 		/**
-		* A size_t containing file size (in bytes)
-		*/
-		size_t d_file_size_bytes = 0;
+		 * Pointer to MediaLibCleaner::LibraryStore holding data of the file (owned by MediaLibCleaner::RunContext)
+		 */
+		LibraryStore* store = nullptr;
 
 
 
@@ -407,34 +387,10 @@ namespace MediaLibCleaner
 		int d_counter_dir = 0;
 
 		/**
-		 * Variable allowing for easy access to some of the tags and properities inside audio file
-		 */
-		std::unique_ptr<TagLib::FileRef> fileref;
-
-		/**
-		 * Enum type for filetype distinctness
-		 */
-		MediaLibCleaner::FileType filetype = FILETYPE_UNKNOWN;
-
-		/**
-		 * TagLib::MPEG::File object representing MP3 file (if file represented by given File object is in fact MP3 file)
+		 * Backend of the file format, holding TagLib object of the file (nullptr if file is not supported audio file).
+		 * Allocated in MediaLibCleaner::Arena of the run.
 		 */
-		std::unique_ptr<TagLib::MPEG::File> taglib_file_mp3;
-
-		/**
-		* TagLib::Ogg::Vorbis::File object representing OGG Vorbis file (if file represented by given File object is in fact OGG Vorbis file)
-		*/
-		std::unique_ptr<TagLib::Ogg::Vorbis::File> taglib_file_ogg;
-
-		/**
-		* TagLib::MPEG::File object representing FLAC file (if file represented by given File object is in fact FLAC file)
-		*/
-		std::unique_ptr<TagLib::FLAC::File> taglib_file_flac;
-
-		/**
-		* TagLib::MPEG::File object representing M4A file (if file represented by given File object is in fact M4A file)
-		*/
-		std::unique_ptr<TagLib::MP4::File> taglib_file_m4a;
+		FormatBackend* backend = nullptr;
 
 		/**
 		* std::unique_ptr to MediaLibCleaner::LogAlert object for logging purposes
@@ -447,34 +403,46 @@ namespace MediaLibCleaner
 		std::unique_ptr<LogProgram>* logprogram;
 
 		/**
-		 * Value indicates if there was any changes made to the file itself
+		* std::unique_ptr to MediaLibCleaner::RunContext object (tag writing settings and statistics)
+		*/
+		std::unique_ptr<RunContext>* runcontext;
+
+		/**
+		 * Set of pending tag changes (tag column => change), applied to the file in save(); allocated only when there are changes
 		 */
-		bool hasChanged = false;
+		std::unique_ptr<std::map<StringColumn, TagMutation>> mutations;
 
-		bool setTagUniversal(std::string id3tag, std::string xiphtag, std::string apetag, std::string mp4tag, TagLib::String value = TagLib::String::null);
+		std::wstring getField(StringColumn column);
+		void setField(StringColumn column, const std::wstring &value);
+		void setField(StringColumn column, const TagLib::String &value);
+		void setField(StringColumn column, const wchar_t *value);
+		long long getNumber(NumberColumn column);
+		void setNumber(NumberColumn column, long long value);
 
-		void getID3v2Tags(TagLib::ID3v2::Tag*);
-		void getAPEv2Tags(TagLib::APE::ItemListMap);
-		void getFLACXiphTags(TagLib::Ogg::XiphComment*);
-		void getVorbisXiphTags(TagLib::Ogg::XiphComment*);
-		void getM4ATags();
-		void clearExtendedTags();
+		bool queueTagChange(StringColumn column, TagLib::String value);
+		bool setTagUniversal(const TagInfo *info, TagLib::String value = TagLib::String::null);
 
-		void setID3v2Tag(TagLib::String value, std::string id3tag, TagLib::ID3v2::Tag *tag);
-		void setAPEv2Tag(TagLib::String value, std::string apetag, TagLib::APE::Tag *tag);
-		void setXiphTag(TagLib::String value, std::string xiphtag, TagLib::Ogg::XiphComment *tag);
-		void setM4ATag(TagLib::String value, std::string m4atag, TagLib::MP4::Tag *tag);
+		void storeFastTags(const FastTags &fast);
 
+		SaveMode writeTags(uintmax_t*);
 		FileType release();
-		void reopen(FileType);
+		bool reopen();
+		void closeHandles();
+		bool relocate(boost::filesystem::path, boost::filesystem::path);
 	public:
 
-		File(std::wstring, MediaLibCleaner::DFC*, std::unique_ptr<MediaLibCleaner::LogProgram>*, std::unique_ptr<MediaLibCleaner::LogAlert>*);
+		File(std::wstring, MediaLibCleaner::DFC*, std::unique_ptr<MediaLibCleaner::LogProgram>*, std::unique_ptr<MediaLibCleaner::LogAlert>*, std::unique_ptr<MediaLibCleaner::RunContext>*);
 		~File();
 
+		static void* operator new(size_t, Arena*);
+		static void operator delete(void*, Arena*);
+		static void operator delete(void*);
+
 
 
 		// SONG INFO
+		std::wstring GetTag(const TagInfo *info);
+		const wchar_t* GetTagData(const TagInfo *info);
 		std::wstring GetArtist();
 		std::wstring GetTitle();
 		std::wstring GetAlbum();
@@ -525,6 +493,8 @@ namespace MediaLibCleaner
 		size_t GetCoverSize();
 		std::wstring GetCoverType();
 		int GetCovers();
+		int GetCoverWidth();
+		int GetCoverHeight();
 		std::wstring GetLengthAsString();
 		int GetLength();
 		int GetChannels();
@@ -560,15 +530,27 @@ namespace MediaLibCleaner
 		int GetCounterDir();
 		int GetCounterTotal();
 
+		// DUPLICATES (see MediaLibCleaner::DuplicateFinder)
+		int GetDuplicateGroup();
+		bool IsDuplicate();
+		void SetDuplicateGroup(int);
+
+		// INTEGRITY (see MediaLibCleaner::IntegrityVerifier)
+		IntegrityStatus GetIntegrity();
+		bool IsIntact();
+		void SetIntegrity(IntegrityStatus);
+
 		// methods for lua processor manipulations
 		bool HasTag(std::wstring tag, TagLib::String val = TagLib::String::null);
 		bool HasTag(std::wstring tag, std::vector<std::wstring> val);
+		bool HasTag(std::wstring tag, const ValueSet &val);
 		bool Rename(std::wstring);
 		bool Move(std::wstring, std::string);
 		bool Delete();
 		bool SetTag(std::wstring, TagLib::String val = TagLib::String::null);
 
 		bool IsInitiated();
+		FileType GetFileType();
 		DFC* GetDFC();
 
 		void save();
@@ -702,7 +684,7 @@ namespace MediaLibCleaner
 	};
 
 	MediaLibCleaner::DFC* AddDFC(std::list<MediaLibCleaner::DFC*>* dfc_list, boost::filesystem::path pth, std::mutex* synch, std::unique_ptr<MediaLibCleaner::LogProgram>* lp, std::unique_ptr<MediaLibCleaner::LogAlert>* la);
-	std::wstring ReplaceAllAliasOccurences(std::wstring&, MediaLibCleaner::File*, std::string, time_t, int);
+	std::wstring ReplaceAllAliasOccurences(std::wstring&, MediaLibCleaner::File*, MediaLibCleaner::RunContext*);
 	static std::string base64_encode_w(const std::vector<char>& buffer);
 	static std::string base64_encode(const char* buf, int bufLen);
 	static std::vector<char> base64_decode(std::string encoded_string);
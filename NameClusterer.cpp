@@ -0,0 +1,575 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * This file contains definitions of name clusterer. Signature of every name consists of MINHASH_BANDS * MINHASH_ROWS minimal hashes
+ * of its 3-grams; two names share a band with probability of about s^MINHASH_ROWS, where s is similarity of their sets of 3-grams,
+ * so similar names become candidates and different ones almost never do. Edit distance is computed by bit-parallel algorithm
+ * of Myers (one machine word per column of the distance matrix).
+ */
+
+#include "NameClusterer.hpp"
+
+#include <algorithm>
+#include <codecvt>
+#include <cwctype>
+#include <map>
+
+#include <boost/filesystem/fstream.hpp>
+
+#include <omp.h>
+
+
+/**
+ * Amount of bands of MinHash signature (name becomes candidate if any band is equal)
+ */
+static const int MINHASH_BANDS = 10;
+
+/**
+ * Amount of hashes in one band of MinHash signature
+ */
+static const int MINHASH_ROWS = 3;
+
+/**
+ * Amount of hashes in MinHash signature
+ */
+static const int MINHASH_SIZE = MINHASH_BANDS * MINHASH_ROWS;
+
+/**
+ * Maximum amount of names sharing one band taken as candidates (larger buckets hold names sharing only very common 3-grams)
+ */
+static const size_t MAX_BUCKET = 256;
+
+/**
+ * Function mixes bits of 64 bit number (finalizer of SplitMix64)
+ *
+ * @param[in] value  Number to mix
+ *
+ * @return Mixed number
+ */
+static unsigned long long mix64(unsigned long long value)
+{
+	value ^= value >> 30;
+	value *= 0xBF58476D1CE4E5B9ULL;
+	value ^= value >> 27;
+	value *= 0x94D049BB133111EBULL;
+	value ^= value >> 31;
+
+	return value;
+}
+
+/**
+ * Function computes MinHash signature of the name from its 3-grams (name is padded with spaces, so short names have 3-grams too)
+ *
+ * @param[in]  name       Normalized name
+ * @param[out] signature  MINHASH_SIZE minimal hashes
+ */
+static void minHash(const std::wstring &name, unsigned long long *signature)
+{
+	std::wstring padded = L" " + name + L" ";
+
+	for (int i = 0; i < MINHASH_SIZE; i++)
+		signature[i] = ~0ULL;
+
+	for (size_t p = 0; p + 3 <= padded.length(); p++)
+	{
+		unsigned long long gram = (static_cast<unsigned long long>(padded[p]) << 42) ^ (static_cast<unsigned long long>(padded[p + 1]) << 21) ^ static_cast<unsigned long long>(padded[p + 2]);
+
+		for (int i = 0; i < MINHASH_SIZE; i++)
+		{
+			unsigned long long hash = mix64(gram + 0x9E3779B97F4A7C15ULL * static_cast<unsigned long long>(i + 1));
+			if (hash < signature[i]) signature[i] = hash;
+		}
+	}
+}
+
+/**
+ * Function returns all numbers written in the name (separated by spaces)
+ *
+ * @param[in] name  Normalized name
+ *
+ * @return Numbers of the name
+ */
+static std::wstring numbersOf(const std::wstring &name)
+{
+	std::wstring numbers;
+	bool previous = false;
+
+	for (size_t i = 0; i < name.length(); i++)
+	{
+		bool digit = (name[i] >= L'0' && name[i] <= L'9');
+		if (digit && !previous && !numbers.empty()) numbers += L' ';
+		if (digit) numbers += name[i];
+		previous = digit;
+	}
+
+	return numbers;
+}
+
+/**
+ * Function computes edit distance by dynamic programming, row by row (used for names longer than 64 characters)
+ *
+ * @param[in] a  First string
+ * @param[in] b  Second string
+ *
+ * @return Edit distance
+ */
+static int editDistanceRows(const std::wstring &a, const std::wstring &b)
+{
+	std::vector<int> row(b.length() + 1);
+	for (size_t j = 0; j <= b.length(); j++) row[j] = static_cast<int>(j);
+
+	for (size_t i = 1; i <= a.length(); i++)
+	{
+		int diagonal = row[0];
+		row[0] = static_cast<int>(i);
+
+		for (size_t j = 1; j <= b.length(); j++)
+		{
+			int above = row[j];
+			row[j] = std::min(std::min(row[j] + 1, row[j - 1] + 1), diagonal + (a[i - 1] == b[j - 1] ? 0 : 1));
+			diagonal = above;
+		}
+	}
+
+	return row[b.length()];
+}
+
+/**
+ * Function checks if two different normalized names are spellings of the same name.
+ * Allowed edit distance is one per 5 characters of the longer name (names shorter than 5 characters are never joined).
+ *
+ * @param[in] a  First name
+ * @param[in] b  Second name
+ *
+ * @return True if names are similar enough
+ */
+static bool similarNames(const std::wstring &a, const std::wstring &b)
+{
+	size_t longer = std::max(a.length(), b.length());
+	size_t shorter = std::min(a.length(), b.length());
+	int allowed = static_cast<int>(longer / 5);
+
+	if (allowed == 0 || longer - shorter > static_cast<size_t>(allowed)) return false;
+	if (numbersOf(a) != numbersOf(b)) return false;
+
+	return MediaLibCleaner::EditDistance(a, b) <= allowed;
+}
+
+/**
+ * Function finds root of the set in union-find structure (path is halved on the way)
+ *
+ * @param[in,out] parent  Parent of every element
+ * @param[in]     element Element
+ *
+ * @return Root of the set of the element
+ */
+static size_t findRoot(std::vector<size_t> *parent, size_t element)
+{
+	while ((*parent)[element] != element)
+	{
+		(*parent)[element] = (*parent)[(*parent)[element]];
+		element = (*parent)[element];
+	}
+
+	return element;
+}
+
+
+
+
+/**
+ * Function normalizes name: letters are lowercased, punctuation is removed (apostrophes without a space, '&' becomes "and"),
+ * leading "the" and trailing ", the" are removed.
+ *
+ * @param[in] name  Name
+ *
+ * @return Normalized name (words separated by single spaces)
+ */
+std::wstring MediaLibCleaner::NormalizeName(const std::wstring &name)
+{
+	std::wstring lower;
+	lower.reserve(name.length());
+	for (size_t i = 0; i < name.length(); i++)
+		lower += static_cast<wchar_t>(std::towlower(name[i]));
+
+	boost::algorithm::trim(lower);
+	if (boost::algorithm::ends_with(lower, L", the")) lower.erase(lower.length() - 5);
+
+	std::wstring normalized;
+	normalized.reserve(lower.length());
+	bool separated = false;
+
+	for (size_t i = 0; i < lower.length(); i++)
+	{
+		wchar_t c = lower[i];
+
+		if (std::iswalnum(c))
+		{
+			if (separated && !normalized.empty()) normalized += L' ';
+			normalized += c;
+			separated = false;
+		}
+		else if (c == L'&')
+		{
+			if (!normalized.empty()) normalized += L' ';
+			normalized += L"and";
+			separated = true;
+		}
+		else if (c != L'\'' && c != 0x2019)
+		{
+			separated = true;
+		}
+	}
+
+	if (boost::algorithm::starts_with(normalized, L"the ")) normalized.erase(0, 4);
+
+	// name made of punctuation only
+	if (normalized.empty()) return lower;
+
+	return normalized;
+}
+
+/**
+ * Function computes edit distance (Levenshtein distance) of two strings. Column of the distance matrix for the shorter string
+ * is kept as bit vectors of vertical differences (Myers algorithm), so one character of the longer string takes a few word operations.
+ *
+ * @param[in] a  First string
+ * @param[in] b  Second string
+ *
+ * @return Minimal amount of inserted, removed and replaced characters changing one string into the other
+ */
+int MediaLibCleaner::EditDistance(const std::wstring &a, const std::wstring &b)
+{
+	const std::wstring &pattern = (a.length() <= b.length()) ? a : b;
+	const std::wstring &text = (a.length() <= b.length()) ? b : a;
+	size_t length = pattern.length();
+
+	if (length == 0) return static_cast<int>(text.length());
+	if (length > 64) return editDistanceRows(pattern, text);
+
+	// positions of every character in the pattern
+	unsigned long long ascii[128] = { 0 };
+	std::vector<std::pair<wchar_t, unsigned long long>> other;
+
+	for (size_t i = 0; i < length; i++)
+	{
+		unsigned long long bit = 1ULL << i;
+		wchar_t c = pattern[i];
+
+		if (static_cast<unsigned int>(c) < 128)
+		{
+			ascii[c] |= bit;
+			continue;
+		}
+
+		size_t o = 0;
+		while (o < other.size() && other[o].first != c) o++;
+		if (o == other.size()) other.push_back(std::make_pair(c, 0ULL));
+		other[o].second |= bit;
+	}
+
+	unsigned long long positive = ~0ULL, negative = 0, last = 1ULL << (length - 1);
+	int distance = static_cast<int>(length);
+
+	for (size_t j = 0; j < text.length(); j++)
+	{
+		wchar_t c = text[j];
+		unsigned long long equal = 0;
+
+		if (static_cast<unsigned int>(c) < 128)
+		{
+			equal = ascii[c];
+		}
+		else
+		{
+			for (size_t o = 0; o < other.size(); o++)
+			{
+				if (other[o].first == c) equal = other[o].second;
+			}
+		}
+
+		unsigned long long vertical = equal | negative;
+		unsigned long long horizontal = (((equal & positive) + positive) ^ positive) | equal;
+		unsigned long long hpositive = negative | ~(horizontal | positive);
+		unsigned long long hnegative = positive & horizontal;
+
+		if (hpositive & last) distance++;
+		else if (hnegative & last) distance--;
+
+		// first row of the matrix grows by one in every column
+		hpositive = (hpositive << 1) | 1;
+		hnegative <<= 1;
+
+		positive = hnegative | ~(vertical | hpositive);
+		negative = hpositive & vertical;
+	}
+
+	return distance;
+}
+
+
+
+
+/**
+ * MediaLibCleaner::NameClusterer constructor
+ *
+ * @param[in] logprogram  std::unique_ptr to MediaLibCleaner::LogProgram object for logging purposses
+ * @param[in] logalert    std::unique_ptr to MediaLibCleaner::LogAlert object for logging purposses
+ */
+MediaLibCleaner::NameClusterer::NameClusterer(std::unique_ptr<MediaLibCleaner::LogProgram>* logprogram, std::unique_ptr<MediaLibCleaner::LogAlert>* logalert)
+{
+	this->logprogram = logprogram;
+	this->logalert = logalert;
+}
+
+/**
+ * Method adds names of the file: artist and album artist as artist names, album as album name (files which are not audio files are ignored)
+ *
+ * @param[in] file  File to add
+ */
+void MediaLibCleaner::NameClusterer::AddFile(MediaLibCleaner::File *file)
+{
+	if (!file->IsInitiated()) return;
+
+	std::wstring artist = file->GetTag(&TagSchema[COLUMN_ARTIST]);
+	std::wstring albumartist = file->GetTag(&TagSchema[COLUMN_ALBUMARTIST]);
+	std::wstring album = file->GetAlbum();
+
+	if (!artist.empty()) this->names[NAME_ARTIST].uses[artist]++;
+	if (!albumartist.empty()) this->names[NAME_ARTIST].uses[albumartist]++;
+	if (!album.empty()) this->names[NAME_ALBUM].uses[album]++;
+}
+
+/**
+ * Method clusters names of one kind
+ *
+ * @param[in,out] kind  Names to cluster
+ *
+ * @return Amount of clusters of more than one spelling
+ */
+size_t MediaLibCleaner::NameClusterer::cluster(Names *kind)
+{
+	kind->canonical.clear();
+	kind->clusters.clear();
+
+	// 1. spellings with the same normalized name
+	std::unordered_map<std::wstring, size_t> keys;
+	std::vector<std::wstring> units;
+	std::vector<std::vector<std::wstring>> spellings;
+
+	for (auto it = kind->uses.begin(); it != kind->uses.end(); ++it)
+	{
+		std::wstring key = NormalizeName(it->first);
+		auto found = keys.find(key);
+
+		if (found == keys.end())
+		{
+			found = keys.insert(std::make_pair(key, units.size())).first;
+			units.push_back(key);
+			spellings.push_back(std::vector<std::wstring>());
+		}
+
+		spellings[found->second].push_back(it->first);
+	}
+
+	int count = static_cast<int>(units.size());
+	this->normalized += units.size();
+
+	// 2. signatures
+	std::vector<unsigned long long> signatures(units.size() * MINHASH_SIZE);
+
+	#pragma omp parallel for schedule(dynamic, 256)
+	for (int u = 0; u < count; u++)
+		minHash(units[u], &signatures[u * MINHASH_SIZE]);
+
+	// 3. names sharing any band are candidates
+	std::vector<std::vector<std::pair<size_t, size_t>>> found(MINHASH_BANDS);
+
+	#pragma omp parallel for
+	for (int band = 0; band < MINHASH_BANDS; band++)
+	{
+		// names with equal band are next to each other after sorting by hash of the band
+		std::vector<std::pair<unsigned long long, size_t>> keyed(units.size());
+
+		for (size_t u = 0; u < units.size(); u++)
+		{
+			unsigned long long key = static_cast<unsigned long long>(band);
+			for (int r = 0; r < MINHASH_ROWS; r++)
+				key = mix64(key ^ signatures[u * MINHASH_SIZE + band * MINHASH_ROWS + r]);
+
+			keyed[u] = std::make_pair(key, u);
+		}
+
+		std::sort(keyed.begin(), keyed.end());
+
+		for (size_t start = 0, end = 0; start < keyed.size(); start = end)
+		{
+			while (end < keyed.size() && keyed[end].first == keyed[start].first) end++;
+			if (end - start < 2 || end - start > MAX_BUCKET) continue;
+
+			for (size_t i = start; i < end; i++)
+			{
+				for (size_t j = i + 1; j < end; j++)
+					found[band].push_back(std::make_pair(keyed[i].second, keyed[j].second));
+			}
+		}
+	}
+
+	std::vector<std::pair<size_t, size_t>> pairs;
+	for (int band = 0; band < MINHASH_BANDS; band++)
+		pairs.insert(pairs.end(), found[band].begin(), found[band].end());
+
+	std::sort(pairs.begin(), pairs.end());
+	pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+	this->candidates += pairs.size();
+
+	// 4. verification of candidates
+	int pairs_count = static_cast<int>(pairs.size());
+	std::vector<char> similar(pairs.size(), 0);
+
+	#pragma omp parallel for schedule(dynamic, 1024)
+	for (int p = 0; p < pairs_count; p++)
+		similar[p] = similarNames(units[pairs[p].first], units[pairs[p].second]) ? 1 : 0;
+
+	std::vector<size_t> parent(units.size());
+	for (size_t u = 0; u < units.size(); u++) parent[u] = u;
+
+	for (size_t p = 0; p < pairs.size(); p++)
+	{
+		if (!similar[p]) continue;
+
+		size_t a = findRoot(&parent, pairs[p].first);
+		size_t b = findRoot(&parent, pairs[p].second);
+		if (a != b) parent[std::max(a, b)] = std::min(a, b);
+	}
+
+	// 5. clusters and their canonical names
+	std::map<size_t, std::vector<size_t>> groups;
+	for (size_t u = 0; u < units.size(); u++)
+		groups[findRoot(&parent, u)].push_back(u);
+
+	for (auto it = groups.begin(); it != groups.end(); ++it)
+	{
+		std::vector<std::wstring> spelled;
+		for (size_t i = 0; i < it->second.size(); i++)
+			spelled.insert(spelled.end(), spellings[it->second[i]].begin(), spellings[it->second[i]].end());
+
+		if (spelled.size() < 2) continue;
+
+		// most used first, then alphabetically
+		std::sort(spelled.begin(), spelled.end(), [kind](const std::wstring &a, const std::wstring &b) {
+			size_t ua = kind->uses[a], ub = kind->uses[b];
+			return (ua != ub) ? (ua > ub) : (a < b);
+		});
+
+		for (size_t i = 0; i < it->second.size(); i++)
+			kind->canonical[units[it->second[i]]] = spelled[0];
+
+		kind->clusters.push_back(spelled);
+	}
+
+	return kind->clusters.size();
+}
+
+/**
+ * Method clusters all names added so far
+ *
+ * @return Amount of clusters of more than one spelling (artists and albums)
+ */
+size_t MediaLibCleaner::NameClusterer::Run()
+{
+	this->normalized = 0;
+	this->candidates = 0;
+
+	size_t clusters = this->cluster(&this->names[NAME_ARTIST]) + this->cluster(&this->names[NAME_ALBUM]);
+
+	(*this->logprogram)->Log(L"MediaLibCleaner::NameClusterer", L"Names: " + std::to_wstring(this->names[NAME_ARTIST].uses.size()) + L" artists, " + std::to_wstring(this->names[NAME_ALBUM].uses.size()) + L" albums, "
+		+ std::to_wstring(this->normalized) + L" normalized, " + std::to_wstring(this->candidates) + L" candidate pairs, " + std::to_wstring(clusters) + L" clusters", 3);
+
+	return clusters;
+}
+
+/**
+ * Method writes all clusters of more than one spelling (canonical name first, with amount of uses of every spelling)
+ *
+ * @param[in] path  Path to the report file ("-" for standard output)
+ *
+ * @return True if the report was written
+ */
+bool MediaLibCleaner::NameClusterer::WriteReport(const std::wstring &path)
+{
+	boost::filesystem::wofstream file;
+	std::wostream *output = &std::wcout;
+
+	if (path != L"-")
+	{
+		file.imbue(std::locale(std::locale::classic(), new std::codecvt_utf8<wchar_t>));
+		file.open(boost::filesystem::path(path));
+		if (!file.is_open())
+		{
+			(*this->logprogram)->Log(L"MediaLibCleaner::NameClusterer", L"Report file could not be opened: " + path, 1);
+			return false;
+		}
+
+		output = &file;
+	}
+
+	static const wchar_t *titles[2] = { L"Artists", L"Albums" };
+
+	for (int k = 0; k < 2; k++)
+	{
+		Names &kind = this->names[k];
+
+		*output << titles[k] << L" with more than one spelling: " << kind.clusters.size() << std::endl;
+
+		for (size_t c = 0; c < kind.clusters.size(); c++)
+		{
+			*output << std::endl << kind.clusters[c][0] << std::endl;
+
+			for (size_t i = 0; i < kind.clusters[c].size(); i++)
+				*output << L"\t" << kind.clusters[c][i] << L" (" << kind.uses[kind.clusters[c][i]] << L")" << std::endl;
+		}
+
+		*output << std::endl;
+	}
+
+	return output->good();
+}
+
+/**
+ * Method returns canonical spelling of the name (the same name if it is not a part of any cluster)
+ *
+ * @param[in] kind  Kind of the name
+ * @param[in] name  Name
+ *
+ * @return Canonical spelling
+ */
+std::wstring MediaLibCleaner::NameClusterer::GetCanonical(MediaLibCleaner::NameKind kind, const std::wstring &name)
+{
+	auto found = this->names[kind].canonical.find(NormalizeName(name));
+	if (found == this->names[kind].canonical.end()) return name;
+
+	return found->second;
+}
+
+/**
+ * Method returns amount of distinct normalized names clustered by the last Run()
+ *
+ * @return Amount of names
+ */
+size_t MediaLibCleaner::NameClusterer::GetNames()
+{
+	return this->normalized;
+}
+
+/**
+ * Method returns amount of candidate pairs verified by edit distance in the last Run()
+ *
+ * @return Amount of pairs
+ */
+size_t MediaLibCleaner::NameClusterer::GetCandidates()
+{
+	return this->candidates;
+}
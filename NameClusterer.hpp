@@ -0,0 +1,89 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * File contains declarations of name clusterer - detection of different spellings of the same artist or album ("The Beatles", "Beatles, The", "Beatles")
+ */
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MediaLibCleaner.hpp"
+
+namespace MediaLibCleaner
+{
+	/**
+	 * Kinds of names clustered separately by MediaLibCleaner::NameClusterer
+	 */
+	enum NameKind {NAME_ARTIST, NAME_ALBUM};
+
+	std::wstring NormalizeName(const std::wstring &name);
+	int EditDistance(const std::wstring &a, const std::wstring &b);
+
+	/**
+	 * @class NameClusterer NameClusterer.hpp
+	 *
+	 * @brief Class MediaLibCleaner::NameClusterer groups different spellings of artist names (artist and album artist tags) and album names.
+	 *
+	 * Names are normalized first (case, punctuation, leading or trailing "the"), so spellings differing only by those fall into one cluster.
+	 * Normalized names similar to each other are found without comparing every pair: MinHash of character 3-grams of every name
+	 * is divided into bands and only names sharing a whole band become candidates. Every candidate pair is verified by edit distance
+	 * (allowed distance depends on length of names; names with different numbers are never joined - "Vol. 1" and "Vol. 2" are different albums).
+	 * Most often used spelling of every cluster is its canonical name (see GetCanonical()).
+	 */
+	class NameClusterer
+	{
+	public:
+		NameClusterer(std::unique_ptr<LogProgram>*, std::unique_ptr<LogAlert>*);
+
+		void AddFile(File*);
+		size_t Run();
+		bool WriteReport(const std::wstring &path);
+
+		std::wstring GetCanonical(NameKind kind, const std::wstring &name);
+
+		size_t GetNames();
+		size_t GetCandidates();
+
+	protected:
+		/**
+		 * @brief Structure describing all names of one kind
+		 */
+		struct Names
+		{
+			std::unordered_map<std::wstring, size_t> uses; ///< Amount of uses of every distinct name
+			std::unordered_map<std::wstring, std::wstring> canonical; ///< Canonical name, by normalized name (only names of clusters)
+			std::vector<std::vector<std::wstring>> clusters; ///< Clusters of more than one spelling (canonical name first)
+		};
+
+		/**
+		 * Names of every kind (by MediaLibCleaner::NameKind)
+		 */
+		Names names[2];
+
+		/**
+		 * Amount of distinct normalized names clustered by the last Run()
+		 */
+		size_t normalized = 0;
+
+		/**
+		 * Amount of candidate pairs verified by edit distance in the last Run()
+		 */
+		size_t candidates = 0;
+
+		/**
+		 * std::unique_ptr to MediaLibCleaner::LogAlert object for logging purposes
+		 */
+		std::unique_ptr<LogAlert>* logalert;
+
+		/**
+		 * std::unique_ptr to MediaLibCleaner::LogProgram object for logging purposes
+		 */
+		std::unique_ptr<LogProgram>* logprogram;
+
+		size_t cluster(Names *kind);
+	};
+}
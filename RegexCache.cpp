@@ -0,0 +1,68 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * File contains definitions of regex cache - regular expressions used by lua functions (_CheckTagRegex, _MatchTag), compiled once per run
+ */
+#include "RegexCache.hpp"
+#include "helpers.hpp"
+
+
+
+
+/**
+ * Method returns compiled regular expression of the pattern, compiling it if the pattern is used for the first time.
+ * Pattern is compiled outside of the lock; if two threads compile the same pattern at once, the first one stored is kept.
+ *
+ * @param[in]  pattern  Pattern as given in the config file
+ * @param[out] error    Error message if pattern is invalid (may be nullptr)
+ *
+ * @return Compiled expression (valid until the cache is destroyed) or nullptr if pattern is invalid
+ */
+const boost::wregex* MediaLibCleaner::RegexCache::Get(const std::string &pattern, std::wstring *error)
+{
+	Entry *entry = nullptr;
+
+	this->synch.lock();
+	auto found = this->patterns.find(pattern);
+	if (found != this->patterns.end()) entry = found->second.get();
+	this->synch.unlock();
+
+	if (entry == nullptr)
+	{
+		std::unique_ptr<Entry> compiled(new Entry());
+
+		try
+		{
+			compiled->regex.reset(new boost::wregex(s2ws(pattern), boost::regex_constants::perl | boost::regex_constants::optimize));
+		}
+		catch (const boost::regex_error &e)
+		{
+			compiled->error = s2ws(e.what());
+		}
+
+		this->synch.lock();
+		auto inserted = this->patterns.insert(std::make_pair(pattern, std::move(compiled)));
+		entry = inserted.first->second.get();
+		this->synch.unlock();
+	}
+
+	if (entry->regex == nullptr && error != nullptr) *error = entry->error;
+
+	return entry->regex.get();
+}
+
+/**
+ * Method returns amount of distinct patterns used so far (including invalid ones)
+ *
+ * @return Amount of patterns
+ */
+size_t MediaLibCleaner::RegexCache::GetPatterns()
+{
+	this->synch.lock();
+	size_t size = this->patterns.size();
+	this->synch.unlock();
+
+	return size;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * File contains declarations of regex cache - regular expressions used by lua functions (_CheckTagRegex, _MatchTag), compiled once per run
+ */
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <boost/regex.hpp>
+
+namespace MediaLibCleaner
+{
+	/**
+	 * @class RegexCache RegexCache.hpp
+	 *
+	 * @brief Class MediaLibCleaner::RegexCache keeps compiled regular expressions, by text of the pattern as given in the config file.
+	 *
+	 * Pattern is compiled (Perl syntax, optimized for matching) the first time it is used by any thread, later uses only look it up,
+	 * so the pattern is not converted nor compiled again for every file. Invalid patterns are remembered too, with the error message.
+	 * Compiled expressions are never changed nor removed until the cache is destroyed, so they are matched without holding the lock.
+	 */
+	class RegexCache
+	{
+	public:
+		const boost::wregex* Get(const std::string &pattern, std::wstring *error);
+
+		size_t GetPatterns();
+
+	protected:
+		/**
+		 * @brief Structure describing a single pattern
+		 */
+		struct Entry
+		{
+			std::unique_ptr<boost::wregex> regex; ///< Compiled expression, or nullptr if pattern is invalid
+			std::wstring error; ///< Error message of invalid pattern
+		};
+
+		/**
+		 * All patterns used so far, by text of the pattern (entries stay at the same address when more patterns are added)
+		 */
+		std::unordered_map<std::string, std::unique_ptr<Entry>> patterns;
+
+		/**
+		 * std::mutex protecting patterns from racing conditions
+		 */
+		std::mutex synch;
+	};
+}
@@ -0,0 +1,612 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * This file contains the scan benchmark. It generates synthetic corpus of MP3, FLAC and M4A files (tags rendered by TagLib, audio
+ * data made of valid but silent frames), scans it twice - with tags read by TagLib and by read-only parser (see ReadTagsFast()) -
+ * and reports time, memory growth and read volume of both scans and every value which differs between them.
+ */
+
+#include "ScanBenchmark.hpp"
+#include "helpers.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <vector>
+
+#include <boost/filesystem/fstream.hpp>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <Psapi.h>
+#else
+#include <fstream>
+#include <sys/resource.h>
+#endif
+
+
+/**
+ * Size of the cover stored in every generated file (covers are not loaded by read-only parser)
+ */
+static const unsigned int BENCHMARK_COVER_SIZE = 64 * 1024;
+
+/**
+ * Amount of MPEG frames (or equivalent amount of audio data) in every generated file
+ */
+static const int BENCHMARK_FRAMES = 200;
+
+/**
+ * Function writes generated file to disk
+ *
+ * @param[in] path  Path to the file
+ * @param[in] data  Contents of the file
+ */
+static void writeBenchmarkFile(const std::wstring &path, const TagLib::ByteVector &data)
+{
+	boost::filesystem::ofstream output(boost::filesystem::path(path), std::ios::out | std::ios::binary | std::ios::trunc);
+	output.write(data.data(), data.size());
+}
+
+/**
+ * Function returns text used in tags of generated file, with non-Latin-1 characters in every other file (so all ID3v2 text encodings are used)
+ */
+static TagLib::String benchmarkText(const wchar_t *prefix, int index)
+{
+	std::wstring text = prefix + std::to_wstring(index);
+	if (index % 2 == 1) text += L" \u017c\u00f3\u0142w";
+
+	return TagLib::String(text);
+}
+
+/**
+ * Function returns cover stored in generated file: PNG signature and header (with dimensions depending on file number) padded to BENCHMARK_COVER_SIZE
+ */
+static TagLib::ByteVector benchmarkCover(int index)
+{
+	TagLib::ByteVector cover("\x89PNG\r\n\x1A\n", 8);
+	cover.append(TagLib::ByteVector::fromUInt(13));
+	cover.append("IHDR");
+	cover.append(TagLib::ByteVector::fromUInt(static_cast<unsigned int>(500 + index % 100)));
+	cover.append(TagLib::ByteVector::fromUInt(static_cast<unsigned int>(500 + index % 50)));
+	cover.resize(BENCHMARK_COVER_SIZE, 'c');
+
+	return cover;
+}
+
+/**
+ * Function renders MPEG 1 Layer III frames (128 kb/s, 44100 Hz, stereo), optionally with Xing header in the first frame
+ */
+static TagLib::ByteVector renderMPEGFrames(bool xing)
+{
+	TagLib::ByteVector frame("\xFF\xFB\x90\x00", 4);
+	frame.resize(417, '\0');
+
+	TagLib::ByteVector frames;
+	for (int i = 0; i < BENCHMARK_FRAMES; i++) frames.append(frame);
+
+	if (xing)
+	{
+		// Xing header follows side information of the first frame; frames and bytes fields are present
+		TagLib::ByteVector header("Xing");
+		header.append(TagLib::ByteVector::fromUInt(3));
+		header.append(TagLib::ByteVector::fromUInt(BENCHMARK_FRAMES - 1));
+		header.append(TagLib::ByteVector::fromUInt(frames.size()));
+
+		for (unsigned int i = 0; i < header.size(); i++) frames[36 + i] = header[i];
+	}
+
+	return frames;
+}
+
+/**
+ * Function generates MP3 file with ID3v2 tag (v2.3 or v2.4), cover and, for every third file, ID3v1 tag
+ *
+ * @param[in] index  Number of the file
+ *
+ * @return Contents of the file
+ */
+static TagLib::ByteVector generateMP3(int index)
+{
+	TagLib::ID3v2::Tag id3v2;
+	id3v2.setTitle(benchmarkText(L"Title ", index));
+	id3v2.setArtist(benchmarkText(L"Artist ", index % 17));
+	id3v2.setAlbum(benchmarkText(L"Album ", index % 5));
+	id3v2.setGenre(index % 3 == 0 ? L"17" : L"Electronic");
+	id3v2.setComment(benchmarkText(L"Comment ", index));
+	id3v2.setYear(1980 + index % 40);
+	id3v2.setTrack(index % 20 + 1);
+
+	TagLib::ID3v2::TextIdentificationFrame *albumartist = new TagLib::ID3v2::TextIdentificationFrame("TPE2", TagLib::String::UTF16);
+	albumartist->setText(benchmarkText(L"Album artist ", index % 7));
+	id3v2.addFrame(albumartist);
+
+	TagLib::ID3v2::TextIdentificationFrame *bpm = new TagLib::ID3v2::TextIdentificationFrame("TBPM", TagLib::String::Latin1);
+	bpm->setText(TagLib::String::number(90 + index % 60));
+	id3v2.addFrame(bpm);
+
+	TagLib::ID3v2::UserTextIdentificationFrame *mood = new TagLib::ID3v2::UserTextIdentificationFrame(TagLib::String::UTF8);
+	mood->setDescription("MOOD");
+	mood->setText(benchmarkText(L"Mood ", index % 3));
+	id3v2.addFrame(mood);
+
+	TagLib::ID3v2::UserUrlLinkFrame *www = new TagLib::ID3v2::UserUrlLinkFrame(TagLib::String::Latin1);
+	www->setUrl("http://example.com/" + TagLib::String::number(index));
+	id3v2.addFrame(www);
+
+	TagLib::ID3v2::UnsynchronizedLyricsFrame *lyrics = new TagLib::ID3v2::UnsynchronizedLyricsFrame(TagLib::String::UTF16);
+	lyrics->setLanguage("eng");
+	lyrics->setText(benchmarkText(L"Lyrics ", index));
+	id3v2.addFrame(lyrics);
+
+	TagLib::ID3v2::AttachedPictureFrame *cover = new TagLib::ID3v2::AttachedPictureFrame();
+	cover->setMimeType("image/jpeg");
+	cover->setType(TagLib::ID3v2::AttachedPictureFrame::FrontCover);
+	cover->setPicture(benchmarkCover(index));
+	id3v2.addFrame(cover);
+
+	TagLib::ByteVector data = id3v2.render(index % 2 == 0 ? 4 : 3);
+	data.append(renderMPEGFrames(index % 4 == 1));
+
+	if (index % 3 == 1)
+	{
+		TagLib::ID3v1::Tag id3v1;
+		id3v1.setTitle("Title " + TagLib::String::number(index));
+		id3v1.setArtist("Artist");
+		id3v1.setGenre("Rock");
+		id3v1.setYear(2000);
+		id3v1.setTrack(index % 20 + 1);
+		data.append(id3v1.render());
+	}
+
+	return data;
+}
+
+/**
+ * Function renders FLAC metadata block with its header
+ *
+ * @param[in] type   Type of the block
+ * @param[in] last   True if it is the last metadata block
+ * @param[in] block  Data of the block
+ *
+ * @return Rendered block
+ */
+static TagLib::ByteVector renderFLACBlock(int type, bool last, const TagLib::ByteVector &block)
+{
+	TagLib::ByteVector data = TagLib::ByteVector::fromUInt(block.size());
+	data[0] = static_cast<char>(type | (last ? 0x80 : 0));
+	data.append(block);
+
+	return data;
+}
+
+/**
+ * Function generates FLAC file with XiphComment, cover and padding
+ *
+ * @param[in] index  Number of the file
+ *
+ * @return Contents of the file
+ */
+static TagLib::ByteVector generateFLAC(int index)
+{
+	// STREAMINFO: 44100 Hz, stereo, 16 bits per sample, 10 seconds
+	TagLib::ByteVector streaminfo = TagLib::ByteVector::fromShort(4096);
+	streaminfo.append(TagLib::ByteVector::fromShort(4096));
+	streaminfo.append(TagLib::ByteVector(6, '\0'));
+	streaminfo.append(TagLib::ByteVector::fromLongLong(static_cast<long long>((44100ULL << 44) | (1ULL << 41) | (15ULL << 36) | 441000ULL)));
+	streaminfo.append(TagLib::ByteVector(16, '\0'));
+
+	TagLib::Ogg::XiphComment xiph;
+	xiph.setTitle(benchmarkText(L"Title ", index));
+	xiph.setArtist(benchmarkText(L"Artist ", index % 17));
+	xiph.setAlbum(benchmarkText(L"Album ", index % 5));
+	xiph.setGenre("Electronic");
+	xiph.setComment(benchmarkText(L"Comment ", index));
+	xiph.setYear(1980 + index % 40);
+	xiph.setTrack(index % 20 + 1);
+	xiph.addField("ALBUMARTIST", benchmarkText(L"Album artist ", index % 7));
+	xiph.addField("BPM", TagLib::String::number(90 + index % 60));
+	xiph.addField("MOOD", benchmarkText(L"Mood ", index % 3));
+	xiph.addField("WWW", "http://example.com/" + TagLib::String::number(index));
+	xiph.addField("UNSYNCEDLYRICS", benchmarkText(L"Lyrics ", index));
+
+	TagLib::FLAC::Picture cover;
+	cover.setType(TagLib::FLAC::Picture::FrontCover);
+	cover.setMimeType("image/png");
+	cover.setDescription("cover");
+	cover.setData(benchmarkCover(index));
+
+	TagLib::ByteVector data("fLaC");
+	data.append(renderFLACBlock(0, false, streaminfo));
+	data.append(renderFLACBlock(4, false, xiph.render(false)));
+	data.append(renderFLACBlock(6, false, cover.render()));
+	data.append(renderFLACBlock(1, true, TagLib::ByteVector(4096, '\0')));
+
+	TagLib::ByteVector audio("\xFF\xF8", 2);
+	audio.resize(417 * BENCHMARK_FRAMES, 'a');
+	data.append(audio);
+
+	return data;
+}
+
+/**
+ * Function renders MP4 atom
+ *
+ * @param[in] name     Name of the atom (4 characters)
+ * @param[in] payload  Contents of the atom
+ *
+ * @return Rendered atom
+ */
+static TagLib::ByteVector renderMP4Atom(const char *name, const TagLib::ByteVector &payload)
+{
+	TagLib::ByteVector atom = TagLib::ByteVector::fromUInt(payload.size() + 8);
+	atom.append(TagLib::ByteVector(name, 4));
+	atom.append(payload);
+
+	return atom;
+}
+
+/**
+ * Function renders MP4 tag item with single data atom
+ *
+ * @param[in] name   Name of the item (4 characters)
+ * @param[in] type   Type of the data
+ * @param[in] value  Value of the item
+ *
+ * @return Rendered item
+ */
+static TagLib::ByteVector renderMP4Item(const char *name, unsigned int type, const TagLib::ByteVector &value)
+{
+	TagLib::ByteVector data = TagLib::ByteVector::fromUInt(type);
+	data.append(TagLib::ByteVector::fromUInt(0));
+	data.append(value);
+
+	return renderMP4Atom(name, renderMP4Atom("data", data));
+}
+
+/**
+ * Function renders iTunes free-form MP4 tag item
+ *
+ * @param[in] name   Name of the item
+ * @param[in] value  Value of the item
+ *
+ * @return Rendered item
+ */
+static TagLib::ByteVector renderMP4FreeForm(const char *name, const TagLib::String &value)
+{
+	TagLib::ByteVector mean = TagLib::ByteVector::fromUInt(0);
+	mean.append("com.apple.iTunes");
+
+	TagLib::ByteVector key = TagLib::ByteVector::fromUInt(0);
+	key.append(name);
+
+	TagLib::ByteVector data = TagLib::ByteVector::fromUInt(1);
+	data.append(TagLib::ByteVector::fromUInt(0));
+	data.append(value.data(TagLib::String::UTF8));
+
+	TagLib::ByteVector item = renderMP4Atom("mean", mean);
+	item.append(renderMP4Atom("name", key));
+	item.append(renderMP4Atom("data", data));
+
+	return renderMP4Atom("----", item);
+}
+
+/**
+ * Function generates M4A file with AAC track, iTunes tag and covers
+ *
+ * @param[in] index  Number of the file
+ *
+ * @return Contents of the file
+ */
+static TagLib::ByteVector generateM4A(int index)
+{
+	// audio track: AAC, 44100 Hz, stereo, 30 seconds, 128 kb/s
+	TagLib::ByteVector mdhd(12, '\0');
+	mdhd.append(TagLib::ByteVector::fromUInt(44100));
+	mdhd.append(TagLib::ByteVector::fromUInt(44100 * 30));
+	mdhd.append(TagLib::ByteVector(4, '\0'));
+
+	TagLib::ByteVector hdlr(8, '\0');
+	hdlr.append("soun");
+	hdlr.append(TagLib::ByteVector(13, '\0'));
+
+	TagLib::ByteVector esds(4, '\0');
+	esds.append(TagLib::ByteVector("\x03\x80\x80\x80\x22\x00\x01\x00\x04\x80\x80\x80\x14\x40\x15\x00\x00\x00", 18));
+	esds.append(TagLib::ByteVector::fromUInt(128000));
+	esds.append(TagLib::ByteVector::fromUInt(128000));
+	esds.append(TagLib::ByteVector("\x05\x80\x80\x80\x02\x12\x10", 7));
+
+	TagLib::ByteVector mp4a(6, '\0');
+	mp4a.append(TagLib::ByteVector::fromShort(1));
+	mp4a.append(TagLib::ByteVector(8, '\0'));
+	mp4a.append(TagLib::ByteVector::fromShort(2));
+	mp4a.append(TagLib::ByteVector::fromShort(16));
+	mp4a.append(TagLib::ByteVector(4, '\0'));
+	mp4a.append(TagLib::ByteVector::fromUInt(44100U << 16));
+	mp4a.append(renderMP4Atom("esds", esds));
+
+	TagLib::ByteVector stsd(4, '\0');
+	stsd.append(TagLib::ByteVector::fromUInt(1));
+	stsd.append(renderMP4Atom("mp4a", mp4a));
+
+	TagLib::ByteVector mdia = renderMP4Atom("mdhd", mdhd);
+	mdia.append(renderMP4Atom("hdlr", hdlr));
+	mdia.append(renderMP4Atom("minf", renderMP4Atom("stbl", renderMP4Atom("stsd", stsd))));
+
+	TagLib::ByteVector trak = renderMP4Atom("tkhd", TagLib::ByteVector(84, '\0'));
+	trak.append(renderMP4Atom("mdia", mdia));
+
+	TagLib::ByteVector trkn = TagLib::ByteVector::fromShort(0);
+	trkn.append(TagLib::ByteVector::fromShort(static_cast<short>(index % 20 + 1)));
+	trkn.append(TagLib::ByteVector::fromShort(20));
+	trkn.append(TagLib::ByteVector::fromShort(0));
+
+	TagLib::ByteVector ilst = renderMP4Item("\251nam", 1, benchmarkText(L"Title ", index).data(TagLib::String::UTF8));
+	ilst.append(renderMP4Item("\251ART", 1, benchmarkText(L"Artist ", index % 17).data(TagLib::String::UTF8)));
+	ilst.append(renderMP4Item("\251alb", 1, benchmarkText(L"Album ", index % 5).data(TagLib::String::UTF8)));
+	ilst.append(renderMP4Item("\251gen", 1, TagLib::String("Electronic").data(TagLib::String::UTF8)));
+	ilst.append(renderMP4Item("\251cmt", 1, benchmarkText(L"Comment ", index).data(TagLib::String::UTF8)));
+	ilst.append(renderMP4Item("\251day", 1, TagLib::String::number(1980 + index % 40).data(TagLib::String::UTF8)));
+	ilst.append(renderMP4Item("trkn", 0, trkn));
+	ilst.append(renderMP4Item("tmpo", 21, TagLib::ByteVector::fromShort(static_cast<short>(90 + index % 60))));
+	ilst.append(renderMP4Item("aART", 1, benchmarkText(L"Album artist ", index % 7).data(TagLib::String::UTF8)));
+	ilst.append(renderMP4Item("\251lyr", 1, benchmarkText(L"Lyrics ", index).data(TagLib::String::UTF8)));
+	ilst.append(renderMP4FreeForm("MOOD", benchmarkText(L"Mood ", index % 3)));
+	ilst.append(renderMP4FreeForm("WWW", "http://example.com/" + TagLib::String::number(index)));
+	ilst.append(renderMP4Item("covr", 13, benchmarkCover(index)));
+
+	TagLib::ByteVector meta(4, '\0');
+	meta.append(renderMP4Atom("hdlr", TagLib::ByteVector("\0\0\0\0\0\0\0\0mdirappl\0\0\0\0\0\0\0\0\0", 25)));
+	meta.append(renderMP4Atom("ilst", ilst));
+
+	TagLib::ByteVector moov = renderMP4Atom("mvhd", TagLib::ByteVector(100, '\0'));
+	moov.append(renderMP4Atom("trak", trak));
+	moov.append(renderMP4Atom("udta", renderMP4Atom("meta", meta)));
+
+	TagLib::ByteVector data = renderMP4Atom("ftyp", TagLib::ByteVector("M4A \0\0\0\0M4A mp42isom", 20));
+	data.append(renderMP4Atom("moov", moov));
+	data.append(renderMP4Atom("mdat", TagLib::ByteVector(417 * BENCHMARK_FRAMES, 'a')));
+
+	return data;
+}
+
+/**
+ * Structure describing resources used by the process (see readProcessUsage()) or by single scan (see scanBenchmarkFiles())
+ */
+struct ScanUsage
+{
+	double time = 0; ///< Time of the scan in milliseconds
+	uintmax_t memory = 0; ///< Resident memory (working set) in bytes; for the scan - its peak growth
+	uintmax_t read_bytes = 0; ///< Bytes read by read calls (reads of mapped files are not counted, they cause page faults)
+	uintmax_t page_faults = 0; ///< Page faults (minor and major)
+};
+
+/**
+ * Function reads current resident memory, amount of bytes read and amount of page faults of the process
+ *
+ * @param[out] usage  Structure to fill (time is not changed)
+ */
+static void readProcessUsage(ScanUsage *usage)
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS memory;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &memory, sizeof(memory)))
+	{
+		usage->memory = memory.WorkingSetSize;
+		usage->page_faults = memory.PageFaultCount;
+	}
+
+	IO_COUNTERS io;
+	if (GetProcessIoCounters(GetCurrentProcess(), &io)) usage->read_bytes = io.ReadTransferCount;
+#else
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	while (std::getline(status, line))
+	{
+		if (line.compare(0, 6, "VmRSS:") == 0) usage->memory = std::stoull(line.substr(6)) * 1024;
+	}
+
+	std::ifstream io("/proc/self/io");
+	while (std::getline(io, line))
+	{
+		if (line.compare(0, 6, "rchar:") == 0) usage->read_bytes = std::stoull(line.substr(6));
+	}
+
+	struct rusage resources;
+	if (getrusage(RUSAGE_SELF, &resources) == 0) usage->page_faults = static_cast<uintmax_t>(resources.ru_minflt + resources.ru_majflt);
+#endif
+}
+
+/**
+ * Function creates MediaLibCleaner::File objects for all given paths (tags are read during construction) and measures time, memory and read volume of it.
+ * Memory is sampled after every file, outside of the measured time; created files stay in memory, so peak growth includes them.
+ *
+ * @return Time of the scan, peak growth of resident memory, bytes read and page faults during the scan
+ */
+static ScanUsage scanBenchmarkFiles(const std::vector<std::wstring> &paths, MediaLibCleaner::DFC *dfc, std::unique_ptr<MediaLibCleaner::LogProgram> *lp, std::unique_ptr<MediaLibCleaner::LogAlert> *la, std::unique_ptr<MediaLibCleaner::RunContext> *rc, std::vector<MediaLibCleaner::File*> *files)
+{
+	ScanUsage before, sample, result;
+	readProcessUsage(&before);
+
+	for (size_t i = 0; i < paths.size(); i++)
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		files->push_back(new ((*rc)->GetArena()) MediaLibCleaner::File(paths[i], dfc, lp, la, rc));
+		result.time += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		readProcessUsage(&sample);
+		if (sample.memory > before.memory + result.memory) result.memory = sample.memory - before.memory;
+	}
+
+	result.read_bytes = sample.read_bytes - before.read_bytes;
+	result.page_faults = sample.page_faults - before.page_faults;
+
+	return result;
+}
+
+/**
+ * Function prints memory growth and read volume of the scan
+ *
+ * @param[in] name   Name of the scan
+ * @param[in] usage  Resources used by the scan
+ */
+static void printScanUsage(const std::wstring &name, const ScanUsage &usage)
+{
+	std::wcout << L"  " << name << L": peak memory +" << usage.memory / 1024 << L" KiB, read " << usage.read_bytes / 1024 << L" KiB, " << usage.page_faults << L" page faults" << std::endl;
+}
+
+/**
+ * Function compares value read by TagLib with value read by fast parser and prints mismatch
+ *
+ * @param[in] file      File the values come from
+ * @param[in] name      Name of the value
+ * @param[in] expected  Value read by TagLib
+ * @param[in] actual    Value read by fast parser
+ *
+ * @return 1 if values differ, 0 otherwise
+ */
+static int compareBenchmarkValue(MediaLibCleaner::File *file, const std::wstring &name, const std::wstring &expected, const std::wstring &actual)
+{
+	if (expected == actual) return 0;
+
+	std::wcout << L"  MISMATCH " << file->GetFilenameExt() << L" " << name << L": TagLib \"" << expected << L"\", fast parser \"" << actual << L"\"" << std::endl;
+	return 1;
+}
+
+/**
+ * Function compares all values read by TagLib and by read-only parser
+ *
+ * @param[in] expected  File read by TagLib
+ * @param[in] actual    The same file read by read-only parser
+ *
+ * @return Amount of values which differ
+ */
+static int compareBenchmarkFiles(MediaLibCleaner::File *expected, MediaLibCleaner::File *actual)
+{
+	using namespace MediaLibCleaner;
+
+	int mismatches = 0;
+
+	for (int i = 0; i < TAGS_COUNT; i++)
+		mismatches += compareBenchmarkValue(actual, TagSchema[i].name, expected->GetTag(&TagSchema[i]), actual->GetTag(&TagSchema[i]));
+
+	mismatches += compareBenchmarkValue(actual, L"codec", expected->GetCodec(), actual->GetCodec());
+	mismatches += compareBenchmarkValue(actual, L"bitrate", std::to_wstring(expected->GetBitrate()), std::to_wstring(actual->GetBitrate()));
+	mismatches += compareBenchmarkValue(actual, L"channels", std::to_wstring(expected->GetChannels()), std::to_wstring(actual->GetChannels()));
+	mismatches += compareBenchmarkValue(actual, L"samplerate", std::to_wstring(expected->GetSampleRate()), std::to_wstring(actual->GetSampleRate()));
+	mismatches += compareBenchmarkValue(actual, L"length", std::to_wstring(expected->GetLength()), std::to_wstring(actual->GetLength()));
+	mismatches += compareBenchmarkValue(actual, L"covers", std::to_wstring(expected->GetCovers()), std::to_wstring(actual->GetCovers()));
+	mismatches += compareBenchmarkValue(actual, L"cover size", std::to_wstring(expected->GetCoverSize()), std::to_wstring(actual->GetCoverSize()));
+	mismatches += compareBenchmarkValue(actual, L"cover mimetype", expected->GetCoverMimetype(), actual->GetCoverMimetype());
+	mismatches += compareBenchmarkValue(actual, L"cover type", expected->GetCoverType(), actual->GetCoverType());
+	mismatches += compareBenchmarkValue(actual, L"cover width", std::to_wstring(expected->GetCoverWidth()), std::to_wstring(actual->GetCoverWidth()));
+	mismatches += compareBenchmarkValue(actual, L"cover height", std::to_wstring(expected->GetCoverHeight()), std::to_wstring(actual->GetCoverHeight()));
+
+	return mismatches;
+}
+
+/**
+ * Function runs the scan benchmark: generates synthetic corpus in given directory (existing files of the same names are overwritten),
+ * scans it with tags read by TagLib and by read-only parser, prints time, memory growth and read volume of both scans and all differences between read values.
+ *
+ * @param[in] dir    Directory to generate corpus in
+ * @param[in] count  Amount of files of every format (MP3, FLAC, M4A)
+ *
+ * @return 0 if both scans read the same values, 1 if any value differs, 2 if corpus could not be generated
+ */
+int MediaLibCleaner::RunScanBenchmark(const std::wstring &dir, int count)
+{
+	namespace fs = boost::filesystem;
+
+	static const wchar_t *formats[3] = { L"mp3", L"flac", L"m4a" };
+
+	try
+	{
+		fs::create_directories(dir);
+	}
+	catch (const fs::filesystem_error &e)
+	{
+		std::wcerr << L"Could not create benchmark directory: " << s2ws(e.code().message()) << std::endl;
+		return 2;
+	}
+
+	// CORPUS
+	std::wcout << L"Generating " << count << L" files of every format in " << dir << std::endl;
+
+	std::vector<std::wstring> paths[3];
+	for (int format = 0; format < 3; format++)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			std::wstring path = (fs::path(dir) / (L"benchmark_" + std::to_wstring(i) + L"." + formats[format])).generic_wstring();
+
+			if (format == 0) writeBenchmarkFile(path, generateMP3(i));
+			else if (format == 1) writeBenchmarkFile(path, generateFLAC(i));
+			else writeBenchmarkFile(path, generateM4A(i));
+
+			if (!fs::exists(path))
+			{
+				std::wcerr << L"Could not write benchmark file: " << path << std::endl;
+				return 2;
+			}
+
+			paths[format].push_back(path);
+		}
+	}
+
+	// both scans read files from disk cache
+	std::vector<char> buffer(64 * 1024);
+	for (int format = 0; format < 3; format++)
+	{
+		for (size_t i = 0; i < paths[format].size(); i++)
+		{
+			fs::ifstream input(fs::path(paths[format][i]), std::ios::in | std::ios::binary);
+			while (input.read(buffer.data(), buffer.size())) {}
+		}
+	}
+
+	// SCANS
+	std::unique_ptr<LogProgram> logprogram(new LogProgram((fs::path(dir) / L"benchmark_error.log").generic_wstring(), 1));
+	std::unique_ptr<LogAlert> logalert(new LogAlert((fs::path(dir) / L"benchmark_alert.log").generic_wstring()));
+	std::unique_ptr<RunContext> taglib_context(new RunContext(ws2s(dir), time(nullptr), 4096, ACCURACY_HEADER, false));
+	std::unique_ptr<RunContext> fast_context(new RunContext(ws2s(dir), time(nullptr), 4096, ACCURACY_HEADER, true));
+	DFC dfc(dir, &logprogram, &logalert);
+
+	int mismatches = 0;
+	ScanUsage taglib_total, fast_total;
+
+	for (int format = 0; format < 3; format++)
+	{
+		std::vector<File*> taglib_files, fast_files;
+
+		ScanUsage taglib_usage = scanBenchmarkFiles(paths[format], &dfc, &logprogram, &logalert, &taglib_context, &taglib_files);
+		ScanUsage fast_usage = scanBenchmarkFiles(paths[format], &dfc, &logprogram, &logalert, &fast_context, &fast_files);
+
+		int format_mismatches = 0;
+		for (size_t i = 0; i < taglib_files.size(); i++)
+			format_mismatches += compareBenchmarkFiles(taglib_files[i], fast_files[i]);
+
+		std::wcout << formats[format] << L": " << paths[format].size() << L" files, TagLib " << taglib_usage.time << L" ms, fast parser " << fast_usage.time << L" ms (" << (fast_usage.time > 0 ? taglib_usage.time / fast_usage.time : 0) << L"x), " << format_mismatches << L" mismatched values" << std::endl;
+		printScanUsage(L"TagLib", taglib_usage);
+		printScanUsage(L"fast parser", fast_usage);
+
+		taglib_total.time += taglib_usage.time;
+		taglib_total.memory += taglib_usage.memory;
+		taglib_total.read_bytes += taglib_usage.read_bytes;
+		taglib_total.page_faults += taglib_usage.page_faults;
+
+		fast_total.time += fast_usage.time;
+		fast_total.memory += fast_usage.memory;
+		fast_total.read_bytes += fast_usage.read_bytes;
+		fast_total.page_faults += fast_usage.page_faults;
+
+		mismatches += format_mismatches;
+	}
+
+	std::wcout << L"Total: TagLib " << taglib_total.time << L" ms, fast parser " << fast_total.time << L" ms (" << (fast_total.time > 0 ? taglib_total.time / fast_total.time : 0) << L"x), " << mismatches << L" mismatched values" << std::endl;
+	printScanUsage(L"TagLib", taglib_total);
+	printScanUsage(L"fast parser", fast_total);
+
+	return mismatches == 0 ? 0 : 1;
+}
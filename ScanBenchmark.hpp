@@ -0,0 +1,17 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * File contains declarations of the scan benchmark - comparison of tags read by the read-only parser and by TagLib on synthetic files
+ */
+#pragma once
+
+#include <string>
+
+#include "MediaLibCleaner.hpp"
+
+namespace MediaLibCleaner
+{
+	int RunScanBenchmark(const std::wstring &dir, int count);
+}
@@ -0,0 +1,814 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * This file contains definitions of tag index. Index file is binary: header, paths of all files (UTF-8) and for every tag
+ * its name and all its values with compressed lists of files (all numbers are 32 bit little endian).
+ */
+
+#include "TagIndex.hpp"
+
+#include <algorithm>
+#include <codecvt>
+#include <list>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+
+/**
+ * First bytes of the index file (format version)
+ */
+static const char INDEX_HEADER[8] = { 'M', 'L', 'C', 'T', 'I', 'X', '0', '1' };
+
+/**
+ * Amount of ids in one block of MediaLibCleaner::PostingList
+ */
+static const unsigned int BLOCK_IDS = 128;
+
+/**
+ * @brief Structure describing position in MediaLibCleaner::PostingList during intersection
+ */
+struct PostingCursor
+{
+	const MediaLibCleaner::PostingList *list; ///< List being searched
+	size_t block = 0; ///< Index of decoded block (equal to amount of blocks if all ids were passed)
+	size_t position = 0; ///< Position in decoded block
+	std::vector<unsigned int> ids; ///< Ids of decoded block
+};
+
+/**
+ * @brief Structure describing single condition of the query
+ */
+struct QueryCondition
+{
+	int column; ///< Index of the tag in MediaLibCleaner::TagSchema
+	std::wstring op; ///< Operator: "=", "!=", "~" or "?"
+	std::wstring value; ///< Value or searched text
+};
+
+/**
+ * Function writes 32 bit number (little endian)
+ *
+ * @param[in] out    Output stream
+ * @param[in] value  Number to write
+ */
+static void writeLE32(std::ostream &out, unsigned int value)
+{
+	char bytes[4] = { static_cast<char>(value & 0xFF), static_cast<char>((value >> 8) & 0xFF), static_cast<char>((value >> 16) & 0xFF), static_cast<char>((value >> 24) & 0xFF) };
+	out.write(bytes, 4);
+}
+
+/**
+ * Function reads 32 bit number (little endian)
+ *
+ * @param[in]  in     Input stream
+ * @param[out] value  Read number
+ *
+ * @return True if number was read
+ */
+static bool readLE32(std::istream &in, unsigned int *value)
+{
+	unsigned char bytes[4];
+	if (!in.read(reinterpret_cast<char*>(bytes), 4)) return false;
+
+	*value = static_cast<unsigned int>(bytes[0]) | (static_cast<unsigned int>(bytes[1]) << 8) | (static_cast<unsigned int>(bytes[2]) << 16) | (static_cast<unsigned int>(bytes[3]) << 24);
+	return true;
+}
+
+/**
+ * Function writes string as its length and UTF-8 bytes
+ *
+ * @param[in] out    Output stream
+ * @param[in] value  String to write
+ */
+static void writeString(std::ostream &out, const std::wstring &value)
+{
+	std::wstring_convert<std::codecvt_utf8<wchar_t>> convert;
+	std::string bytes = convert.to_bytes(value);
+
+	writeLE32(out, static_cast<unsigned int>(bytes.length()));
+	out.write(bytes.data(), bytes.length());
+}
+
+/**
+ * Function reads string written by writeString()
+ *
+ * @param[in]  in     Input stream
+ * @param[in]  limit  Maximum length of the string in bytes (size of the file)
+ * @param[out] value  Read string
+ *
+ * @return True if string was read
+ */
+static bool readString(std::istream &in, unsigned long long limit, std::wstring *value)
+{
+	unsigned int length;
+	if (!readLE32(in, &length) || length > limit) return false;
+
+	std::string bytes(length, '\0');
+	if (length > 0 && !in.read(&bytes[0], length)) return false;
+
+	try
+	{
+		std::wstring_convert<std::codecvt_utf8<wchar_t>> convert;
+		*value = convert.from_bytes(bytes);
+	}
+	catch (const std::range_error&)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Function searches sorted ids for the first id not smaller than given one. Distance from the starting position
+ * is doubled until such id is passed, then binary search is used, so ids close to the starting position are found quickly.
+ *
+ * @param[in] ids   Sorted ids
+ * @param[in] from  Starting position (all ids before it are smaller)
+ * @param[in] id    Searched id
+ *
+ * @return Position of the first id not smaller than given one (size of ids if there is no such id)
+ */
+static size_t gallop(const std::vector<unsigned int> &ids, size_t from, unsigned int id)
+{
+	size_t low = from, high = from, step = 1;
+
+	while (high < ids.size() && ids[high] < id)
+	{
+		low = high + 1;
+		high += step;
+		step *= 2;
+	}
+	if (high > ids.size()) high = ids.size();
+
+	return std::lower_bound(ids.begin() + low, ids.begin() + high, id) - ids.begin();
+}
+
+/**
+ * Function starts search in the list
+ *
+ * @param[out] cursor  Cursor to initialize
+ * @param[in]  list    List to search
+ */
+static void startCursor(PostingCursor *cursor, const MediaLibCleaner::PostingList *list)
+{
+	cursor->list = list;
+	cursor->block = 0;
+	cursor->position = 0;
+
+	if (list->GetBlocks() > 0) list->DecodeBlock(0, &cursor->ids);
+}
+
+/**
+ * Function moves cursor to the first id not smaller than given one. Blocks are skipped by galloping search
+ * over their first ids, only the block which may contain the id is decoded.
+ *
+ * @param[in,out] cursor  Cursor (ids have to be searched in increasing order)
+ * @param[in]     id      Searched id
+ *
+ * @return True if the list contains the id
+ */
+static bool seekCursor(PostingCursor *cursor, unsigned int id)
+{
+	const MediaLibCleaner::PostingList *list = cursor->list;
+	size_t blocks = list->GetBlocks();
+
+	if (cursor->block >= blocks) return false;
+
+	// id is in one of next blocks: last block starting not after the id
+	if (cursor->block + 1 < blocks && list->GetBlockFirst(cursor->block + 1) <= id)
+	{
+		size_t low = cursor->block + 1, high = low + 1, step = 1;
+
+		while (high < blocks && list->GetBlockFirst(high) <= id)
+		{
+			low = high;
+			step *= 2;
+			high = low + step;
+		}
+		if (high > blocks) high = blocks;
+
+		while (high - low > 1)
+		{
+			size_t middle = (low + high) / 2;
+			if (list->GetBlockFirst(middle) <= id) low = middle;
+			else high = middle;
+		}
+
+		cursor->block = low;
+		cursor->position = 0;
+		list->DecodeBlock(low, &cursor->ids);
+	}
+
+	cursor->position = gallop(cursor->ids, cursor->position, id);
+	if (cursor->position < cursor->ids.size()) return cursor->ids[cursor->position] == id;
+
+	// whole block is smaller - next block starts after the id
+	cursor->block++;
+	cursor->position = 0;
+	if (cursor->block < blocks) list->DecodeBlock(cursor->block, &cursor->ids);
+
+	return false;
+}
+
+/**
+ * Function removes ids not present in the list (or present in the list)
+ *
+ * @param[in]     list     List of ids
+ * @param[in,out] ids      Sorted ids
+ * @param[in]     present  True to keep ids present in the list, false to keep ids not present in the list
+ */
+static void filterIds(const MediaLibCleaner::PostingList *list, std::vector<unsigned int> *ids, bool present)
+{
+	PostingCursor cursor;
+	startCursor(&cursor, list);
+
+	size_t kept = 0;
+	for (size_t i = 0; i < ids->size(); i++)
+	{
+		if (seekCursor(&cursor, (*ids)[i]) == present) (*ids)[kept++] = (*ids)[i];
+	}
+
+	ids->resize(kept);
+}
+
+/**
+ * Function counts ids present both in the list and in sorted ids. The shorter one is iterated, the longer one is searched.
+ *
+ * @param[in] list  List of ids
+ * @param[in] ids   Sorted ids
+ *
+ * @return Amount of common ids
+ */
+static size_t countCommon(const MediaLibCleaner::PostingList *list, const std::vector<unsigned int> &ids)
+{
+	size_t common = 0;
+
+	if (list->GetCount() < ids.size())
+	{
+		std::vector<unsigned int> listed;
+		list->Decode(&listed);
+
+		size_t position = 0;
+		for (size_t i = 0; i < listed.size() && position < ids.size(); i++)
+		{
+			position = gallop(ids, position, listed[i]);
+			if (position < ids.size() && ids[position] == listed[i]) common++;
+		}
+	}
+	else
+	{
+		PostingCursor cursor;
+		startCursor(&cursor, list);
+
+		for (size_t i = 0; i < ids.size(); i++)
+		{
+			if (seekCursor(&cursor, ids[i])) common++;
+		}
+	}
+
+	return common;
+}
+
+/**
+ * Function parses query (see MediaLibCleaner::TagIndex)
+ *
+ * @param[in]  query       Query
+ * @param[out] conditions  Conditions of the query
+ * @param[out] error       Description of the error
+ *
+ * @return True if query is valid
+ */
+static bool parseQuery(const std::wstring &query, std::vector<QueryCondition> *conditions, std::wstring *error)
+{
+	size_t start = 0;
+
+	while (start <= query.length())
+	{
+		size_t end = query.find(L';', start);
+		if (end == std::wstring::npos) end = query.length();
+
+		std::wstring part = boost::algorithm::trim_copy(query.substr(start, end - start));
+		start = end + 1;
+
+		if (part.empty()) continue;
+
+		size_t op = part.find_first_of(L"=!~?");
+		if (op == std::wstring::npos || (part[op] == L'!' && (op + 1 == part.length() || part[op + 1] != L'=')))
+		{
+			*error = L"Condition has no operator: " + part;
+			return false;
+		}
+
+		std::wstring name = boost::algorithm::to_lower_copy(boost::algorithm::trim_copy(part.substr(0, op)));
+		const MediaLibCleaner::TagInfo *info = MediaLibCleaner::FindTag(name);
+		if (info == nullptr)
+		{
+			*error = L"Unknown tag: " + name;
+			return false;
+		}
+
+		QueryCondition condition;
+		condition.column = static_cast<int>(info->column);
+		condition.op = (part[op] == L'!') ? L"!=" : part.substr(op, 1);
+		condition.value = boost::algorithm::trim_copy(part.substr(op + condition.op.length()));
+		conditions->push_back(condition);
+	}
+
+	if (conditions->empty())
+	{
+		*error = L"Query is empty";
+		return false;
+	}
+
+	return true;
+}
+
+
+
+
+/**
+ * Method adds id to the end of the list
+ *
+ * @param[in] id  Id (larger than all ids already in the list)
+ */
+void MediaLibCleaner::PostingList::Add(unsigned int id)
+{
+	if (this->count % BLOCK_IDS == 0)
+	{
+		this->block_first.push_back(id);
+		this->block_offset.push_back(static_cast<unsigned int>(this->data.size()));
+	}
+	else
+	{
+		unsigned int delta = id - this->last;
+		while (delta >= 0x80)
+		{
+			this->data.push_back(static_cast<unsigned char>((delta & 0x7F) | 0x80));
+			delta >>= 7;
+		}
+		this->data.push_back(static_cast<unsigned char>(delta));
+	}
+
+	this->last = id;
+	this->count++;
+}
+
+/**
+ * Method decodes all ids of the list
+ *
+ * @param[out] ids  Ids of the list
+ */
+void MediaLibCleaner::PostingList::Decode(std::vector<unsigned int> *ids) const
+{
+	std::vector<unsigned int> block;
+
+	ids->clear();
+	ids->reserve(this->count);
+
+	for (size_t b = 0; b < this->block_first.size(); b++)
+	{
+		this->DecodeBlock(b, &block);
+		ids->insert(ids->end(), block.begin(), block.end());
+	}
+}
+
+/**
+ * Method decodes ids of one block of the list
+ *
+ * @param[in]  block  Index of the block
+ * @param[out] ids    Ids of the block
+ */
+void MediaLibCleaner::PostingList::DecodeBlock(size_t block, std::vector<unsigned int> *ids) const
+{
+	size_t amount = std::min(static_cast<size_t>(BLOCK_IDS), this->count - block * BLOCK_IDS);
+	size_t position = this->block_offset[block];
+	unsigned int id = this->block_first[block];
+
+	ids->clear();
+	ids->push_back(id);
+
+	for (size_t i = 1; i < amount && position < this->data.size(); i++)
+	{
+		unsigned int delta = 0;
+		int shift = 0;
+
+		while (position < this->data.size() && (this->data[position] & 0x80) && shift < 28)
+		{
+			delta |= static_cast<unsigned int>(this->data[position++] & 0x7F) << shift;
+			shift += 7;
+		}
+		if (position < this->data.size()) delta |= static_cast<unsigned int>(this->data[position++]) << shift;
+
+		id += delta;
+		ids->push_back(id);
+	}
+}
+
+/**
+ * Method returns amount of ids in the list
+ *
+ * @return Amount of ids
+ */
+size_t MediaLibCleaner::PostingList::GetCount() const
+{
+	return this->count;
+}
+
+/**
+ * Method returns amount of blocks of the list
+ *
+ * @return Amount of blocks
+ */
+size_t MediaLibCleaner::PostingList::GetBlocks() const
+{
+	return this->block_first.size();
+}
+
+/**
+ * Method returns first id of the block
+ *
+ * @param[in] block  Index of the block
+ *
+ * @return First id of the block
+ */
+unsigned int MediaLibCleaner::PostingList::GetBlockFirst(size_t block) const
+{
+	return this->block_first[block];
+}
+
+/**
+ * Method returns amount of memory taken by the list
+ *
+ * @return Amount of bytes
+ */
+size_t MediaLibCleaner::PostingList::GetBytes() const
+{
+	return this->data.size() + (this->block_first.size() + this->block_offset.size()) * sizeof(unsigned int);
+}
+
+/**
+ * Method writes the list to the index file
+ *
+ * @param[in] out  Output stream
+ *
+ * @return True if the list was written
+ */
+bool MediaLibCleaner::PostingList::Write(std::ostream &out) const
+{
+	writeLE32(out, this->count);
+	writeLE32(out, static_cast<unsigned int>(this->data.size()));
+	if (!this->data.empty()) out.write(reinterpret_cast<const char*>(&this->data[0]), this->data.size());
+
+	for (size_t b = 0; b < this->block_first.size(); b++)
+	{
+		writeLE32(out, this->block_first[b]);
+		writeLE32(out, this->block_offset[b]);
+	}
+
+	return out.good();
+}
+
+/**
+ * Method reads the list written by Write()
+ *
+ * @param[in] in     Input stream
+ * @param[in] limit  Maximum size of the list in bytes (size of the file)
+ *
+ * @return True if the list was read and is valid
+ */
+bool MediaLibCleaner::PostingList::Read(std::istream &in, unsigned long long limit)
+{
+	unsigned int length;
+	if (!readLE32(in, &this->count) || !readLE32(in, &length) || length > limit || this->count > limit) return false;
+
+	this->data.resize(length);
+	if (length > 0 && !in.read(reinterpret_cast<char*>(&this->data[0]), length)) return false;
+
+	size_t blocks = (this->count + BLOCK_IDS - 1) / BLOCK_IDS;
+	this->block_first.resize(blocks);
+	this->block_offset.resize(blocks);
+
+	for (size_t b = 0; b < blocks; b++)
+	{
+		if (!readLE32(in, &this->block_first[b]) || !readLE32(in, &this->block_offset[b])) return false;
+		if (this->block_offset[b] > length || (b > 0 && (this->block_offset[b] < this->block_offset[b - 1] || this->block_first[b] <= this->block_first[b - 1]))) return false;
+	}
+
+	if (blocks > 0)
+	{
+		std::vector<unsigned int> ids;
+		this->DecodeBlock(blocks - 1, &ids);
+		this->last = ids.back();
+	}
+
+	return true;
+}
+
+
+
+
+/**
+ * Method adds all tags of the file to the index (files which are not audio files are ignored)
+ *
+ * @param[in] file  File to add
+ */
+void MediaLibCleaner::TagIndex::AddFile(MediaLibCleaner::File *file)
+{
+	if (!file->IsInitiated()) return;
+
+	unsigned int id = static_cast<unsigned int>(this->paths.size());
+	this->paths.push_back(file->GetPath());
+
+	for (int i = 0; i < TAGS_COUNT; i++)
+		this->postings[i][file->GetTag(&TagSchema[i])].Add(id);
+}
+
+/**
+ * Method writes the index to the file (to temporary file first, so the previous index is not lost if writing fails)
+ *
+ * @param[in] path  Path to the index file
+ *
+ * @return True if the index was written
+ */
+bool MediaLibCleaner::TagIndex::Save(const std::wstring &path)
+{
+	boost::filesystem::path target(path);
+	boost::filesystem::path temporary(path + L".tmp");
+
+	{
+		boost::filesystem::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) return false;
+
+		file.write(INDEX_HEADER, sizeof(INDEX_HEADER));
+
+		writeLE32(file, static_cast<unsigned int>(this->paths.size()));
+		for (size_t i = 0; i < this->paths.size(); i++)
+			writeString(file, this->paths[i]);
+
+		writeLE32(file, static_cast<unsigned int>(TAGS_COUNT));
+		for (int i = 0; i < TAGS_COUNT; i++)
+		{
+			writeString(file, TagSchema[i].name);
+			writeLE32(file, static_cast<unsigned int>(this->postings[i].size()));
+
+			for (auto it = this->postings[i].begin(); it != this->postings[i].end(); ++it)
+			{
+				writeString(file, it->first);
+				it->second.Write(file);
+			}
+		}
+
+		file.flush();
+		if (!file.good()) return false;
+	}
+
+	boost::system::error_code error;
+	boost::filesystem::rename(temporary, target, error);
+
+	return !error;
+}
+
+/**
+ * Method reads the index written by Save(). Tags not known by this version of the program are skipped.
+ *
+ * @param[in] path  Path to the index file
+ *
+ * @return True if the index was read
+ */
+bool MediaLibCleaner::TagIndex::Load(const std::wstring &path)
+{
+	this->paths.clear();
+	for (int i = 0; i < TAGS_COUNT; i++)
+		this->postings[i].clear();
+
+	boost::system::error_code error;
+	unsigned long long limit = boost::filesystem::file_size(boost::filesystem::path(path), error);
+	if (error) return false;
+
+	boost::filesystem::ifstream file(boost::filesystem::path(path), std::ios::binary);
+	if (!file.is_open()) return false;
+
+	char header[sizeof(INDEX_HEADER)];
+	if (!file.read(header, sizeof(header)) || !std::equal(header, header + sizeof(header), INDEX_HEADER)) return false;
+
+	unsigned int files;
+	if (!readLE32(file, &files) || files > limit) return false;
+
+	this->paths.resize(files);
+	for (unsigned int i = 0; i < files; i++)
+	{
+		if (!readString(file, limit, &this->paths[i])) return false;
+	}
+
+	unsigned int tags;
+	if (!readLE32(file, &tags)) return false;
+
+	for (unsigned int t = 0; t < tags; t++)
+	{
+		std::wstring name;
+		unsigned int values;
+		if (!readString(file, limit, &name) || !readLE32(file, &values) || values > limit) return false;
+
+		const TagInfo *info = FindTag(name);
+
+		for (unsigned int v = 0; v < values; v++)
+		{
+			std::wstring value;
+			PostingList list;
+			if (!readString(file, limit, &value) || !list.Read(file, limit)) return false;
+
+			if (info == nullptr) continue;
+			if (list.GetBlocks() > 0 && list.GetBlockFirst(list.GetBlocks() - 1) >= files) return false;
+
+			this->postings[info->column][value] = list;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Method answers the query (see MediaLibCleaner::TagIndex for its format)
+ *
+ * @param[in]  query   Query
+ * @param[out] files   Paths of matching files (if query has no tag?text condition)
+ * @param[out] values  Distinct values and amount of matching files having them (if query has tag?text condition)
+ * @param[out] error   Description of the error
+ *
+ * @return True if query is valid
+ */
+bool MediaLibCleaner::TagIndex::Query(const std::wstring &query, std::vector<std::wstring> *files, std::vector<std::pair<std::wstring, size_t>> *values, std::wstring *error)
+{
+	std::vector<QueryCondition> conditions;
+	if (!parseQuery(query, &conditions, error)) return false;
+
+	PostingList empty;
+	std::list<PostingList> merged;
+	std::vector<const PostingList*> included, excluded;
+	const QueryCondition *listing = nullptr;
+
+	for (size_t c = 0; c < conditions.size(); c++)
+	{
+		const QueryCondition &condition = conditions[c];
+		std::map<std::wstring, PostingList> &tag = this->postings[condition.column];
+
+		if (condition.op == L"=" || condition.op == L"!=")
+		{
+			auto found = tag.find(condition.value);
+			if (condition.op == L"=") included.push_back(found != tag.end() ? &found->second : &empty);
+			else if (found != tag.end()) excluded.push_back(&found->second);
+		}
+		else if (condition.op == L"~")
+		{
+			// every file has one value of the tag - lists of values are disjoint
+			std::vector<unsigned int> ids, decoded;
+			for (auto it = tag.begin(); it != tag.end(); ++it)
+			{
+				if (!boost::algorithm::icontains(it->first, condition.value)) continue;
+
+				it->second.Decode(&decoded);
+				ids.insert(ids.end(), decoded.begin(), decoded.end());
+			}
+			std::sort(ids.begin(), ids.end());
+
+			merged.push_back(PostingList());
+			for (size_t i = 0; i < ids.size(); i++)
+				merged.back().Add(ids[i]);
+			included.push_back(&merged.back());
+		}
+		else
+		{
+			if (listing != nullptr)
+			{
+				*error = L"Query can list values of only one tag";
+				return false;
+			}
+			listing = &condition;
+		}
+	}
+
+	// shortest list first - every next list is only searched for ids still matching
+	std::vector<unsigned int> ids;
+	if (included.empty())
+	{
+		ids.resize(this->paths.size());
+		for (size_t i = 0; i < ids.size(); i++) ids[i] = static_cast<unsigned int>(i);
+	}
+	else
+	{
+		std::sort(included.begin(), included.end(), [](const PostingList *a, const PostingList *b) { return a->GetCount() < b->GetCount(); });
+
+		included[0]->Decode(&ids);
+		for (size_t i = 1; i < included.size() && !ids.empty(); i++)
+			filterIds(included[i], &ids, true);
+	}
+
+	for (size_t i = 0; i < excluded.size() && !ids.empty(); i++)
+		filterIds(excluded[i], &ids, false);
+
+	if (listing != nullptr)
+	{
+		std::map<std::wstring, PostingList> &tag = this->postings[listing->column];
+		for (auto it = tag.begin(); it != tag.end(); ++it)
+		{
+			if (!listing->value.empty() && !boost::algorithm::icontains(it->first, listing->value)) continue;
+
+			size_t common = countCommon(&it->second, ids);
+			if (common > 0) values->push_back(std::make_pair(it->first, common));
+		}
+	}
+	else
+	{
+		for (size_t i = 0; i < ids.size(); i++)
+		{
+			if (ids[i] < this->paths.size()) files->push_back(this->paths[ids[i]]);
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Method returns amount of files in the index
+ *
+ * @return Amount of files
+ */
+size_t MediaLibCleaner::TagIndex::GetFiles()
+{
+	return this->paths.size();
+}
+
+/**
+ * Method returns amount of distinct values of all tags in the index
+ *
+ * @return Amount of values
+ */
+size_t MediaLibCleaner::TagIndex::GetValues()
+{
+	size_t values = 0;
+	for (int i = 0; i < TAGS_COUNT; i++)
+		values += this->postings[i].size();
+
+	return values;
+}
+
+/**
+ * Method returns amount of memory taken by lists of files
+ *
+ * @return Amount of bytes
+ */
+size_t MediaLibCleaner::TagIndex::GetBytes()
+{
+	size_t bytes = 0;
+	for (int i = 0; i < TAGS_COUNT; i++)
+	{
+		for (auto it = this->postings[i].begin(); it != this->postings[i].end(); ++it)
+			bytes += it->second.GetBytes();
+	}
+
+	return bytes;
+}
+
+
+
+
+/**
+ * Function runs the query mode: loads the index, answers the query and prints paths of matching files
+ * (or distinct values with amount of files, one per line separated by tab) to standard output. No audio file is read.
+ *
+ * @param[in] index  Path to the index file
+ * @param[in] query  Query (see MediaLibCleaner::TagIndex)
+ *
+ * @return 0 if query was answered, 2 if the index could not be read or query is invalid
+ */
+int MediaLibCleaner::RunQuery(const std::wstring &index, const std::wstring &query)
+{
+	TagIndex tagindex;
+	if (!tagindex.Load(index))
+	{
+		std::wcerr << L"Could not read tag index: " << index << std::endl;
+		return 2;
+	}
+
+	std::vector<std::wstring> files;
+	std::vector<std::pair<std::wstring, size_t>> values;
+	std::wstring error;
+
+	if (!tagindex.Query(query, &files, &values, &error))
+	{
+		std::wcerr << L"Invalid query: " << error << std::endl;
+		return 2;
+	}
+
+	for (size_t i = 0; i < files.size(); i++)
+		std::wcout << files[i] << std::endl;
+
+	for (size_t i = 0; i < values.size(); i++)
+		std::wcout << values[i].second << L"\t" << values[i].first << std::endl;
+
+	return 0;
+}
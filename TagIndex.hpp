@@ -0,0 +1,107 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * File contains declarations of tag index - inverted index of tag values of the whole library (tag value => files), kept on disk and queried by --query
+ */
+#pragma once
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "MediaLibCleaner.hpp"
+
+namespace MediaLibCleaner
+{
+	/**
+	 * @class PostingList TagIndex.hpp
+	 *
+	 * @brief Class MediaLibCleaner::PostingList keeps sorted list of file ids in compressed form.
+	 *
+	 * Ids are divided into blocks of fixed size. First id of every block is kept uncompressed (so blocks can be skipped by search),
+	 * other ids are kept as differences from the previous id, written as variable length numbers (7 bits per byte).
+	 */
+	class PostingList
+	{
+	public:
+		void Add(unsigned int id);
+		void Decode(std::vector<unsigned int> *ids) const;
+		void DecodeBlock(size_t block, std::vector<unsigned int> *ids) const;
+
+		size_t GetCount() const;
+		size_t GetBlocks() const;
+		unsigned int GetBlockFirst(size_t block) const;
+		size_t GetBytes() const;
+
+		bool Write(std::ostream &out) const;
+		bool Read(std::istream &in, unsigned long long limit);
+
+	protected:
+		/**
+		 * Compressed ids (without the first id of every block)
+		 */
+		std::vector<unsigned char> data;
+
+		/**
+		 * First id of every block
+		 */
+		std::vector<unsigned int> block_first;
+
+		/**
+		 * Offset of every block in data
+		 */
+		std::vector<unsigned int> block_offset;
+
+		/**
+		 * Amount of ids in the list
+		 */
+		unsigned int count = 0;
+
+		/**
+		 * Last id added to the list
+		 */
+		unsigned int last = 0;
+	};
+
+	/**
+	 * @class TagIndex TagIndex.hpp
+	 *
+	 * @brief Class MediaLibCleaner::TagIndex maps value of every tag to list of files having that value (files without the tag have empty value).
+	 *
+	 * Index is built from tags and paths of files after they are processed and saved to disk, so questions about the whole library can be answered by Query()
+	 * without reading any audio file. Query is a list of conditions separated by ';':
+	 * tag=value (exact value, empty value - no such tag), tag!=value (other value), tag~text (value contains text, case insensitive)
+	 * and at most one tag?text (instead of files, lists distinct values of the tag containing text, with amount of matching files).
+	 * Lists of files are intersected starting with the shortest one, skipping in the longer ones by galloping search.
+	 */
+	class TagIndex
+	{
+	public:
+		void AddFile(File*);
+
+		bool Save(const std::wstring &path);
+		bool Load(const std::wstring &path);
+
+		bool Query(const std::wstring &query, std::vector<std::wstring> *files, std::vector<std::pair<std::wstring, size_t>> *values, std::wstring *error);
+
+		size_t GetFiles();
+		size_t GetValues();
+		size_t GetBytes();
+
+	protected:
+		/**
+		 * Paths of all files, by id
+		 */
+		std::vector<std::wstring> paths;
+
+		/**
+		 * Lists of files of every value, by value, for every tag (in order of MediaLibCleaner::TagSchema)
+		 */
+		std::map<std::wstring, PostingList> postings[TAGS_COUNT];
+	};
+
+	int RunQuery(const std::wstring &index, const std::wstring &query);
+}
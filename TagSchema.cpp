@@ -0,0 +1,106 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * This file contains the table describing all tags supported by MediaLibCleaner and functions searching it
+ */
+
+#include "TagSchema.hpp"
+
+
+/**
+ * All supported tags, in order of MediaLibCleaner::StringColumn
+ */
+const MediaLibCleaner::TagInfo MediaLibCleaner::TagSchema[MediaLibCleaner::TAGS_COUNT] = {
+	{ L"artist", COLUMN_ARTIST, MLC_FRAME_ID('T', 'P', 'E', '1'), "TPE1", "ARTIST", "ARTIST", "ARTIST", nullptr },
+	{ L"title", COLUMN_TITLE, MLC_FRAME_ID('T', 'I', 'T', '2'), "TIT2", "TITLE", "TITLE", "TITLE", nullptr },
+	{ L"album", COLUMN_ALBUM, MLC_FRAME_ID('T', 'A', 'L', 'B'), "TALB", "ALBUM", "ALBUM", "ALBUM", nullptr },
+	{ L"genre", COLUMN_GENRE, MLC_FRAME_ID('T', 'C', 'O', 'N'), "TCON", "GENRE", "GENRE", "GENRE", nullptr },
+	{ L"comment", COLUMN_COMMENT, MLC_FRAME_ID('C', 'O', 'M', 'M'), "COMM", "COMMENT", "COMMENT", "COMMENT", nullptr },
+	{ L"track", COLUMN_TRACK, MLC_FRAME_ID('T', 'R', 'C', 'K'), "TRCK", "TRACKNUMBER", "TRACK", "TRACKNUMBER", nullptr },
+	{ L"year", COLUMN_YEAR, MLC_FRAME_ID('T', 'Y', 'E', 'R'), "TYER", "YEAR", "YEAR", "DATE", nullptr },
+	{ L"albumartist", COLUMN_ALBUMARTIST, MLC_FRAME_ID('T', 'P', 'E', '2'), "TPE2", "ALBUMARTIST", "ALBUMARTIST", "ALBUMARTIST", "aART" },
+	{ L"bpm", COLUMN_BPM, MLC_FRAME_ID('T', 'B', 'P', 'M'), "TBPM", "BPM", "BPM", "BPM", nullptr },
+	{ L"copyright", COLUMN_COPYRIGHT, MLC_FRAME_ID('T', 'C', 'O', 'P'), "TCOP", "COPYRIGHT", "COPYRIGHT", "COPYRIGHT", nullptr },
+	{ L"language", COLUMN_LANGUAGE, MLC_FRAME_ID('T', 'L', 'A', 'N'), "TLAN", "LANGUAGE", "LANGUAGE", "LANGUAGE", nullptr },
+	{ L"length", COLUMN_LENGTH, MLC_FRAME_ID('T', 'L', 'E', 'N'), "TLEN", "LENGTH", "LENGTH", "LENGTH", "----:com.apple.iTunes:LENGTH" },
+	{ L"mood", COLUMN_MOOD, MLC_FRAME_ID('T', 'M', 'O', 'O'), "TMOO", "MOOD", "MOOD", "MOOD", nullptr },
+	{ L"origalbum", COLUMN_ORIGALBUM, MLC_FRAME_ID('T', 'O', 'A', 'L'), "TOAL", "ORIGALBUM", "ORIGALBUM", "ORIGALBUM", "----:com.apple.iTunes:ORIGALBUM" },
+	{ L"origartist", COLUMN_ORIGARTIST, MLC_FRAME_ID('T', 'O', 'P', 'E'), "TOPE", "ORIGARTIST", "ORIGARTIST", "ORIGARTIST", "----:com.apple.iTunes:ORIGARTIST" },
+	{ L"origfilename", COLUMN_ORIGFILENAME, MLC_FRAME_ID('T', 'O', 'F', 'N'), "TOFN", "ORIGFILENAME", "ORIGFILENAME", "ORIGFILENAME", "----:com.apple.iTunes:ORIGFILENAME" },
+	{ L"origyear", COLUMN_ORIGYEAR, MLC_FRAME_ID('T', 'D', 'O', 'R'), "TDOR", "ORIGYEAR", "ORIGYEAR", "ORIGYEAR", "----:com.apple.iTunes:ORIGYEAR" },
+	{ L"publisher", COLUMN_PUBLISHER, MLC_FRAME_ID('T', 'P', 'U', 'B'), "TPUB", "ORGANIZATION", "PUBLISHER", "PUBLISHER", "----:com.apple.iTunes:PUBLISHER" },
+	{ L"unsyncedlyrics", COLUMN_UNSYNCEDLYRICS, MLC_FRAME_ID('U', 'S', 'L', 'T'), "USLT", "UNSYNCEDLYRICS", "UNSYNCEDLYRICS", "LYRICS", nullptr },
+	{ L"www", COLUMN_WWW, MLC_FRAME_ID('W', 'X', 'X', 'X'), "WXXX", "WWW", "WWW", "WWW", "----:com.apple.iTunes:WWW" }
+};
+
+/**
+ * Perfect hash table of tag names: slot => index in MediaLibCleaner::TagSchema (-1 - empty slot).
+ * Slots were computed for hash used in MediaLibCleaner::FindTag(); it has to be recomputed when tags are added.
+ */
+static const signed char TagNameSlots[32] = {
+	10, 3, 13, 19, 8, -1, 17, 11, -1, 6, 5, 18, -1, -1, 16, 1,
+	-1, 12, 0, 15, 2, -1, 4, -1, -1, -1, 14, 7, 9, -1, -1, -1
+};
+
+/**
+ * Function returns description of the tag of given name. Uses perfect hash of tag name, so only one string comparison is done.
+ *
+ * @param[in] name  Tag name (without \% signs)
+ *
+ * @return Pointer to tag description or nullptr if there is no such tag
+ */
+const MediaLibCleaner::TagInfo* MediaLibCleaner::FindTag(const std::wstring &name)
+{
+	size_t length = name.length();
+	if (length < 2) return nullptr;
+
+	unsigned int hash = (3 * static_cast<unsigned int>(length) + 18 * static_cast<unsigned int>(name[0]) + 3 * static_cast<unsigned int>(name[length - 1]) + static_cast<unsigned int>(name[1])) & 31;
+
+	int index = TagNameSlots[hash];
+	if (index < 0 || name != TagSchema[index].name) return nullptr;
+
+	return &TagSchema[index];
+}
+
+/**
+ * Function returns description of the tag stored in ID3v2 frame of given ID
+ *
+ * @param[in] frame  ID3v2 frame ID as an integer (see MLC_FRAME_ID)
+ *
+ * @return Pointer to tag description or nullptr if frame does not hold any of supported tags
+ */
+const MediaLibCleaner::TagInfo* MediaLibCleaner::FindID3v2Frame(unsigned int frame)
+{
+	for (int i = 0; i < TAGS_COUNT; i++)
+	{
+		if (TagSchema[i].frame == frame) return &TagSchema[i];
+	}
+
+	return nullptr;
+}
+
+/**
+ * Names of cover types, in order of picture types of ID3v2 APIC frame and FLAC PICTURE block (both use the same numbers)
+ */
+static const wchar_t *CoverTypeNames[21] = {
+	L"other", L"file icon", L"other file icon", L"front cover", L"back cover", L"leaflet page", L"media",
+	L"lead artist", L"artist", L"conductor", L"band", L"composer", L"lyricist", L"recording location",
+	L"during recording", L"during performance", L"movie screencapture", L"coloured fish", L"illustration",
+	L"band logo", L"publisher logo"
+};
+
+/**
+ * Function returns name of the cover type (value of \%_cover_type% alias)
+ *
+ * @param[in] type  Picture type as stored in ID3v2 APIC frame or FLAC PICTURE block
+ *
+ * @return Name of the cover type ("other" for unknown types)
+ */
+const wchar_t* MediaLibCleaner::CoverTypeName(int type)
+{
+	if (type < 0 || type > 20) return CoverTypeNames[0];
+
+	return CoverTypeNames[type];
+}
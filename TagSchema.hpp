@@ -0,0 +1,51 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * File contains declaration of the table describing all tags supported by MediaLibCleaner (names, keys in all tag formats, columns)
+ */
+#pragma once
+
+#include <string>
+
+#include "LibraryStore.hpp"
+
+/**
+ * Builds 4-byte ID3v2 frame ID as an integer (big-endian, the same as TagLib::ByteVector::toUInt())
+ */
+#define MLC_FRAME_ID(a, b, c, d) ((static_cast<unsigned int>(a) << 24) | (static_cast<unsigned int>(b) << 16) | (static_cast<unsigned int>(c) << 8) | static_cast<unsigned int>(d))
+
+namespace MediaLibCleaner
+{
+	/**
+	 * Amount of tags supported by MediaLibCleaner (they take first columns of MediaLibCleaner::StringColumn)
+	 */
+	const int TAGS_COUNT = COLUMN_WWW + 1;
+
+	/**
+	 * First tag not read by TagLib::FileRef (tags from this one on are read from format-specific tags)
+	 */
+	const int FIRST_EXTENDED_TAG = COLUMN_ALBUMARTIST;
+
+	/**
+	 * @brief Structure describing single tag supported by MediaLibCleaner
+	 */
+	struct TagInfo
+	{
+		const wchar_t *name; ///< Tag name (alias without \% signs)
+		StringColumn column; ///< Column of MediaLibCleaner::LibraryStore holding value of the tag
+		unsigned int frame; ///< ID3v2 frame ID as an integer (see MLC_FRAME_ID)
+		const char *id3; ///< ID3v2 frame ID
+		const char *xiph; ///< XiphComment field name
+		const char *ape; ///< APEv2 item name
+		const char *mp4; ///< M4A/MP4 property name (TagLib::PropertyMap key)
+		const char *mp4item; ///< M4A/MP4 atom the tag is read from (nullptr - tag is read from property)
+	};
+
+	extern const TagInfo TagSchema[TAGS_COUNT];
+
+	const TagInfo* FindTag(const std::wstring &name);
+	const TagInfo* FindID3v2Frame(unsigned int frame);
+	const wchar_t* CoverTypeName(int type);
+}
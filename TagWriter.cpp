@@ -0,0 +1,816 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * This file contains definitions of all classes and functions writing rendered tags directly into audio files
+ */
+
+#include "TagWriter.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+
+/**
+ * Size of the buffer used while copying audio stream into rewritten file
+ */
+static const size_t STREAM_BUFFER_SIZE = 1024 * 1024;
+
+/**
+ * Maximum size of ID3v2 tag (28-bit syncsafe integer)
+ */
+static const uintmax_t ID3V2_MAX_SIZE = 0x0FFFFFFF;
+
+/**
+ * Maximum length of single FLAC metadata block (24-bit integer)
+ */
+static const uintmax_t FLAC_MAX_BLOCK = 0x00FFFFFF;
+
+/**
+ * Reads 28-bit syncsafe integer (4 bytes, 7 bits each)
+ *
+ * @param[in] p  Pointer to first byte of the integer
+ *
+ * @return Decoded integer
+ */
+static uintmax_t readSyncSafe(const unsigned char *p)
+{
+	return ((uintmax_t)(p[0] & 0x7F) << 21) | ((uintmax_t)(p[1] & 0x7F) << 14) | ((uintmax_t)(p[2] & 0x7F) << 7) | (uintmax_t)(p[3] & 0x7F);
+}
+
+/**
+ * Reads 32-bit big-endian integer
+ *
+ * @param[in] p  Pointer to first byte of the integer
+ *
+ * @return Decoded integer
+ */
+static uintmax_t readBigEndian(const unsigned char *p)
+{
+	return ((uintmax_t)p[0] << 24) | ((uintmax_t)p[1] << 16) | ((uintmax_t)p[2] << 8) | (uintmax_t)p[3];
+}
+
+/**
+ * Renders 10-byte ID3v2 header with given tag size (without header)
+ *
+ * @param[in] rendered  Rendered ID3v2 tag; version and flags are copied from it
+ * @param[in] size      Size of the tag (without header)
+ *
+ * @return Rendered header
+ */
+static TagLib::ByteVector renderID3v2Header(const TagLib::ByteVector &rendered, uintmax_t size)
+{
+	TagLib::ByteVector header = rendered.mid(0, 10);
+
+	header[5] = (char)(header[5] & ~0x10); // no footer - it is not allowed together with padding
+	header[6] = (char)((size >> 21) & 0x7F);
+	header[7] = (char)((size >> 14) & 0x7F);
+	header[8] = (char)((size >> 7) & 0x7F);
+	header[9] = (char)(size & 0x7F);
+
+	return header;
+}
+
+/**
+ * Renders 4-byte FLAC metadata block header
+ *
+ * @param[in] type    Type of the block
+ * @param[in] length  Length of the block data
+ * @param[in] last    Information if this is last metadata block
+ *
+ * @return Rendered header
+ */
+static TagLib::ByteVector renderFLACBlockHeader(unsigned char type, uintmax_t length, bool last)
+{
+	TagLib::ByteVector header(4, 0);
+
+	header[0] = (char)(type | (last ? 0x80 : 0x00));
+	header[1] = (char)((length >> 16) & 0xFF);
+	header[2] = (char)((length >> 8) & 0xFF);
+	header[3] = (char)(length & 0xFF);
+
+	return header;
+}
+
+/**
+ * Reads 32-bit little-endian integer
+ *
+ * @param[in] p  Pointer to first byte of the integer
+ *
+ * @return Decoded integer
+ */
+static unsigned int readLittleEndian(const unsigned char *p)
+{
+	return (unsigned int)p[0] | ((unsigned int)p[1] << 8) | ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+/**
+ * Writes 32-bit little-endian integer
+ *
+ * @param[out] p      Pointer to first byte of the integer
+ * @param[in]  value  Integer to be written
+ */
+static void writeLittleEndian(unsigned char *p, unsigned int value)
+{
+	p[0] = (unsigned char)(value & 0xFF);
+	p[1] = (unsigned char)((value >> 8) & 0xFF);
+	p[2] = (unsigned char)((value >> 16) & 0xFF);
+	p[3] = (unsigned char)((value >> 24) & 0xFF);
+}
+
+/**
+ * Lookup tables for Ogg page checksum (slicing-by-8), filled once at program startup
+ */
+static struct OggCRCTable
+{
+	unsigned int table[8][256];
+
+	OggCRCTable()
+	{
+		for (unsigned int i = 0; i < 256; i++)
+		{
+			unsigned int crc = i << 24;
+			for (int j = 0; j < 8; j++)
+				crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : (crc << 1);
+			this->table[0][i] = crc;
+		}
+
+		for (int k = 1; k < 8; k++)
+			for (unsigned int i = 0; i < 256; i++)
+				this->table[k][i] = (this->table[k - 1][i] << 8) ^ this->table[0][this->table[k - 1][i] >> 24];
+	}
+} oggCRCTable;
+
+/**
+ * Returns amount of lacing values (segments) needed to store Ogg packet of given size
+ *
+ * @param[in] size  Size of the packet
+ *
+ * @return Amount of segments
+ */
+static uintmax_t oggSegments(uintmax_t size)
+{
+	return size / 255 + 1;
+}
+
+/**
+ * Renders given packets as given amount of Ogg pages (segments are split evenly between pages)
+ *
+ * @param[in] packets   Packets to be rendered
+ * @param[in] serial    Serial number of the logical stream
+ * @param[in] sequence  Sequence number of the first page
+ * @param[in] pages     Amount of pages (there has to be from 1 to 255 segments for each page)
+ *
+ * @return Rendered pages
+ */
+static TagLib::ByteVector renderOggPages(const std::vector<TagLib::ByteVector> &packets, unsigned int serial, unsigned int sequence, unsigned int pages)
+{
+	std::vector<unsigned char> lacing;
+	TagLib::ByteVector data;
+
+	for (size_t i = 0; i < packets.size(); i++)
+	{
+		lacing.insert(lacing.end(), packets[i].size() / 255, 255);
+		lacing.push_back((unsigned char)(packets[i].size() % 255));
+		data.append(packets[i]);
+	}
+
+	TagLib::ByteVector output;
+	size_t segment = 0;
+	unsigned int position = 0;
+	bool continued = false;
+
+	for (unsigned int p = 0; p < pages; p++)
+	{
+		size_t count = lacing.size() / pages + (p < lacing.size() % pages ? 1 : 0);
+		unsigned int length = 0;
+		bool packetEnds = false;
+
+		TagLib::ByteVector page(27, 0);
+		page[0] = 'O'; page[1] = 'g'; page[2] = 'g'; page[3] = 'S';
+		page[26] = (char)count;
+
+		for (size_t i = segment; i < segment + count; i++)
+		{
+			page.append(TagLib::ByteVector(1, (char)lacing[i]));
+			length += lacing[i];
+			if (lacing[i] < 255) packetEnds = true;
+		}
+		page.append(data.mid(position, length));
+
+		unsigned char *header = reinterpret_cast<unsigned char*>(page.data());
+		header[5] = continued ? 0x01 : 0x00;
+		if (!packetEnds) memset(header + 6, 0xFF, 8); // no packet finishes on this page - granule position -1
+		writeLittleEndian(header + 14, serial);
+		writeLittleEndian(header + 18, sequence + p);
+		writeLittleEndian(header + 22, MediaLibCleaner::OggCRC(header, page.size()));
+
+		continued = lacing[segment + count - 1] == 255;
+		segment += count;
+		position += length;
+		output.append(page);
+	}
+
+	return output;
+}
+
+/**
+ * Copies given amount of bytes from one stream to another (or until the end of input stream)
+ *
+ * @param[in]  input    Input stream
+ * @param[out] output   Output stream
+ * @param[in]  bytes    Amount of bytes to be copied
+ * @param[out] written  Amount of bytes written is added to this value
+ *
+ * @return True if all bytes (or all bytes until the end of input stream, if UINTMAX_MAX was given) were copied
+ */
+static bool copyBytes(std::istream &input, std::ostream &output, uintmax_t bytes, uintmax_t *written)
+{
+	std::vector<char> buffer(STREAM_BUFFER_SIZE);
+	bool untilEnd = bytes == UINTMAX_MAX;
+
+	while (bytes > 0 && input.good() && output.good())
+	{
+		input.read(buffer.data(), (std::streamsize)(bytes < buffer.size() ? bytes : buffer.size()));
+		output.write(buffer.data(), input.gcount());
+		*written += input.gcount();
+		bytes -= input.gcount();
+	}
+
+	return output.good() && (untilEnd ? input.eof() : bytes == 0);
+}
+
+/**
+ * Copies Ogg pages from one stream to another, changing sequence numbers of the pages of given logical stream.
+ * Checksum of each changed page is recalculated. Data that is not an Ogg page is copied as it is.
+ *
+ * @param[in]  input    Input stream (positioned at the beginning of a page)
+ * @param[out] output   Output stream
+ * @param[in]  serial   Serial number of the logical stream
+ * @param[in]  shift    Change of sequence numbers
+ * @param[out] written  Amount of bytes written is added to this value
+ *
+ * @return True on success, false otherwise
+ */
+static bool copyOggPages(std::istream &input, std::ostream &output, unsigned int serial, int shift, uintmax_t *written)
+{
+	std::vector<unsigned char> page(27 + 255 + 255 * 255);
+	char *buffer = reinterpret_cast<char*>(page.data());
+
+	while (output.good())
+	{
+		input.read(buffer, 27);
+		std::streamsize length = input.gcount();
+		if (length == 0) break;
+
+		if (length != 27 || page[0] != 'O' || page[1] != 'g' || page[2] != 'g' || page[3] != 'S')
+		{
+			output.write(buffer, length);
+			*written += length;
+			input.clear();
+			return copyBytes(input, output, UINTMAX_MAX, written);
+		}
+
+		input.read(buffer + 27, page[26]);
+		length += input.gcount();
+
+		std::streamsize body = 0;
+		for (int i = 0; i < page[26]; i++) body += page[27 + i];
+
+		input.read(buffer + length, body);
+		length += input.gcount();
+
+		if (length == 27 + page[26] + body && readLittleEndian(&page[14]) == serial)
+		{
+			writeLittleEndian(&page[18], readLittleEndian(&page[18]) + shift);
+			writeLittleEndian(&page[22], 0);
+			writeLittleEndian(&page[22], MediaLibCleaner::OggCRC(page.data(), (size_t)length));
+		}
+
+		output.write(buffer, length);
+		*written += length;
+	}
+
+	return output.good();
+}
+
+
+
+
+/**
+ * Constructor for MediaLibCleaner::SaveStats class.
+ */
+MediaLibCleaner::SaveStats::SaveStats()
+{
+	for (int i = 0; i < SAVE_MODES_COUNT; i++)
+	{
+		this->counts[i].store(0);
+		this->bytes[i].store(0);
+	}
+}
+
+/**
+ * Destructor for MediaLibCleaner::SaveStats class.
+ */
+MediaLibCleaner::SaveStats::~SaveStats()
+{
+}
+
+/**
+ * Method counts single save done in given mode.
+ *
+ * @param[in] mode     Mode in which tags were saved
+ * @param[in] written  Amount of bytes written to the disk
+ */
+void MediaLibCleaner::SaveStats::Count(MediaLibCleaner::SaveMode mode, uintmax_t written)
+{
+	this->counts[mode]++;
+	this->bytes[mode] += written;
+}
+
+/**
+ * Method returns amount of saves done in given mode.
+ *
+ * @param[in] mode  Save mode
+ *
+ * @return Amount of saves
+ */
+int MediaLibCleaner::SaveStats::GetCount(MediaLibCleaner::SaveMode mode)
+{
+	return this->counts[mode].load();
+}
+
+/**
+ * Method returns amount of bytes written in given mode.
+ *
+ * @param[in] mode  Save mode
+ *
+ * @return Amount of bytes
+ */
+uintmax_t MediaLibCleaner::SaveStats::GetBytes(MediaLibCleaner::SaveMode mode)
+{
+	return this->bytes[mode].load();
+}
+
+
+
+
+/**
+ * Function plans writing of ID3v2 tag at the beginning of MP3 file.
+ *
+ * Rendered tag is stripped from padding added by TagLib. If the frames fit into space occupied by
+ * ID3v2 tag currently present in the file, tag will be written in place (with remaining space left as padding).
+ * Otherwise file has to be rewritten and given amount of padding is reserved for future changes.
+ * No changes are made to the file by this function.
+ *
+ * @param[in]  path     Path to MP3 file
+ * @param[in]  tag      ID3v2 tag rendered by TagLib
+ * @param[in]  id3v1    ID3v1 tag rendered by TagLib (or empty if no ID3v1 tag is to be written); it replaces ID3v1 tag of the file or is appended if there is none
+ * @param[in]  padding  Amount of padding to be reserved when file has to be rewritten
+ * @param[out] plan     Planned write
+ *
+ * @return True if write was planned, false if file layout is not supported (TagLib should save it)
+ */
+bool MediaLibCleaner::PlanID3v2Write(std::wstring path, const TagLib::ByteVector &tag, const TagLib::ByteVector &id3v1, size_t padding, MediaLibCleaner::WritePlan *plan)
+{
+	const unsigned char *rendered = reinterpret_cast<const unsigned char*>(tag.data());
+
+	if (tag.size() < 10 || !tag.startsWith("ID3") || (rendered[5] & 0x10)) return false;
+
+	// find where frames rendered by TagLib end and padding begins
+	uintmax_t end = 10 + readSyncSafe(rendered + 6);
+	if (end > tag.size()) end = tag.size();
+
+	uintmax_t pos = 10;
+	while (pos + 10 <= end && rendered[pos] != 0)
+	{
+		uintmax_t framesize = rendered[3] >= 4 ? readSyncSafe(rendered + pos + 4) : readBigEndian(rendered + pos + 4);
+		pos += 10 + framesize;
+	}
+	if (pos > end) return false;
+
+	uintmax_t frames = pos - 10;
+
+	// read what is currently on the disk
+	boost::filesystem::ifstream input(path, std::ios::in | std::ios::binary);
+	if (!input.is_open()) return false;
+
+	unsigned char header[10];
+	uintmax_t available = 0;
+	input.read(reinterpret_cast<char*>(header), 10);
+	if (input.gcount() == 10 && header[0] == 'I' && header[1] == 'D' && header[2] == '3')
+	{
+		available = 10 + readSyncSafe(header + 6) + ((header[5] & 0x10) ? 10 : 0);
+	}
+
+	if (!id3v1.isEmpty())
+	{
+		char id3v1header[3];
+		input.seekg(-128, std::ios::end);
+		input.read(id3v1header, 3);
+		plan->append_tail = (input.gcount() != 3 || id3v1header[0] != 'T' || id3v1header[1] != 'A' || id3v1header[2] != 'G');
+	}
+
+	input.close();
+
+	plan->tags_size = 10 + frames;
+	plan->available = available;
+	plan->skip = available;
+	plan->tail = id3v1;
+
+	if (available >= 10 + frames)
+	{
+		plan->mode = SAVE_IN_PLACE;
+		plan->head = renderID3v2Header(tag, available - 10);
+		plan->head.append(tag.mid(10, (unsigned int)frames));
+		plan->head.resize((unsigned int)available, 0);
+	}
+	else
+	{
+		uintmax_t size = frames + padding;
+		if (size > ID3V2_MAX_SIZE) size = frames > ID3V2_MAX_SIZE ? frames : ID3V2_MAX_SIZE;
+		if (size > ID3V2_MAX_SIZE) return false;
+
+		plan->mode = SAVE_REWRITE;
+		plan->head = renderID3v2Header(tag, size);
+		plan->head.append(tag.mid(10, (unsigned int)frames));
+		plan->head.resize((unsigned int)(10 + size), 0);
+	}
+
+	return true;
+}
+
+/**
+ * Function plans writing of Vorbis Comment into FLAC file.
+ *
+ * All metadata blocks of the file are read, PADDING blocks are dropped and VORBIS_COMMENT block
+ * is replaced (or inserted right after STREAMINFO block). If new metadata fits into the space
+ * taken by metadata currently present in the file, it is written in place (remaining space becomes
+ * PADDING block). Otherwise file has to be rewritten and given amount of padding is reserved for future changes.
+ * No changes are made to the file by this function.
+ *
+ * @param[in]  path     Path to FLAC file
+ * @param[in]  comment  Vorbis Comment rendered by TagLib (without framing bit)
+ * @param[in]  padding  Amount of padding to be reserved when file has to be rewritten
+ * @param[out] plan     Planned write
+ *
+ * @return True if write was planned, false if file layout is not supported (TagLib should save it)
+ */
+bool MediaLibCleaner::PlanFLACWrite(std::wstring path, const TagLib::ByteVector &comment, size_t padding, MediaLibCleaner::WritePlan *plan)
+{
+	if (comment.size() > FLAC_MAX_BLOCK) return false;
+
+	boost::filesystem::ifstream input(path, std::ios::in | std::ios::binary);
+	if (!input.is_open()) return false;
+
+	char marker[4];
+	input.read(marker, 4);
+	if (input.gcount() != 4 || marker[0] != 'f' || marker[1] != 'L' || marker[2] != 'a' || marker[3] != 'C') return false;
+
+	std::vector<unsigned char> types;
+	std::vector<TagLib::ByteVector> blocks;
+	int commentIndex = -1;
+	bool last = false;
+
+	while (!last)
+	{
+		unsigned char header[4];
+		input.read(reinterpret_cast<char*>(header), 4);
+		if (input.gcount() != 4) return false;
+
+		last = (header[0] & 0x80) != 0;
+		unsigned char type = header[0] & 0x7F;
+		uintmax_t length = ((uintmax_t)header[1] << 16) | ((uintmax_t)header[2] << 8) | (uintmax_t)header[3];
+
+		if (type == 127 || (blocks.empty() && type != 0)) return false; // invalid block or no STREAMINFO
+
+		if (type == 1 || type == 4) // PADDING or VORBIS_COMMENT
+		{
+			if (type == 4 && commentIndex < 0)
+			{
+				commentIndex = (int)blocks.size();
+				types.push_back(type);
+				blocks.push_back(comment);
+			}
+			input.seekg(length, std::ios::cur);
+			continue;
+		}
+
+		TagLib::ByteVector data((unsigned int)length, 0);
+		input.read(data.data(), (std::streamsize)length);
+		if ((uintmax_t)input.gcount() != length) return false;
+
+		types.push_back(type);
+		blocks.push_back(data);
+	}
+
+	if (!input.good()) return false;
+	uintmax_t streamStart = (uintmax_t)input.tellg();
+	input.close();
+
+	if (commentIndex < 0)
+	{
+		types.insert(types.begin() + 1, 4);
+		blocks.insert(blocks.begin() + 1, comment);
+	}
+
+	// size of metadata without padding
+	uintmax_t metadata = 4;
+	for (size_t i = 0; i < blocks.size(); i++) metadata += 4 + blocks[i].size();
+
+	uintmax_t available = streamStart;
+	uintmax_t paddingSize = 0;
+
+	plan->tags_size = metadata;
+	plan->available = available;
+	plan->skip = streamStart;
+	plan->tail = TagLib::ByteVector();
+
+	if (metadata == available || metadata + 4 <= available)
+	{
+		plan->mode = SAVE_IN_PLACE;
+		paddingSize = available - metadata;
+	}
+	else
+	{
+		plan->mode = SAVE_REWRITE;
+		paddingSize = padding > 0 ? 4 + (padding > FLAC_MAX_BLOCK ? FLAC_MAX_BLOCK : padding) : 0;
+	}
+
+	plan->head = TagLib::ByteVector("fLaC", 4);
+	for (size_t i = 0; i < blocks.size(); i++)
+	{
+		plan->head.append(renderFLACBlockHeader(types[i], blocks[i].size(), i + 1 == blocks.size() && paddingSize == 0));
+		plan->head.append(blocks[i]);
+	}
+
+	// padding may not fit into one block - split it if needed
+	while (paddingSize > 0)
+	{
+		uintmax_t length = paddingSize - 4;
+		if (length > FLAC_MAX_BLOCK) length = (paddingSize - 4 - FLAC_MAX_BLOCK < 4) ? FLAC_MAX_BLOCK - 4 : FLAC_MAX_BLOCK;
+
+		paddingSize -= 4 + length;
+		plan->head.append(renderFLACBlockHeader(1, length, paddingSize == 0));
+		plan->head.append(TagLib::ByteVector((unsigned int)length, 0));
+	}
+
+	return true;
+}
+
+/**
+ * Function plans writing of Vorbis Comment into Ogg Vorbis file.
+ *
+ * Header pages (all pages after the first one, up to the end of the setup header) are read and the new
+ * comment packet is paginated together with the setup packet. If it fits into the same amount of pages
+ * and bytes (comment packet is padded after its framing bit, which decoders ignore), only header pages are rewritten.
+ * Otherwise file has to be rewritten: given amount of padding is added to the comment packet and, if the amount
+ * of header pages changed, sequence numbers (and checksums) of all following pages are updated while they are copied.
+ * Multiplexed streams are not supported. No changes are made to the file by this function.
+ *
+ * @param[in]  path     Path to Ogg Vorbis file
+ * @param[in]  comment  Comment header packet ("\x03vorbis" followed by Vorbis Comment rendered by TagLib with framing bit)
+ * @param[in]  padding  Amount of padding to be reserved when file has to be rewritten
+ * @param[out] plan     Planned write
+ *
+ * @return True if write was planned, false if file layout is not supported (TagLib should save it)
+ */
+bool MediaLibCleaner::PlanVorbisWrite(std::wstring path, const TagLib::ByteVector &comment, size_t padding, MediaLibCleaner::WritePlan *plan)
+{
+	if (!comment.startsWith(TagLib::ByteVector("\x03vorbis", 7))) return false;
+
+	boost::filesystem::ifstream input(path, std::ios::in | std::ios::binary);
+	if (!input.is_open()) return false;
+
+	std::vector<TagLib::ByteVector> packets;
+	TagLib::ByteVector packet;
+	unsigned int serial = 0, sequence = 0, pages = 0;
+	uintmax_t headerStart = 0;
+
+	// identification header is alone on the first page; comment and setup headers
+	// follow and audio data has to begin on a fresh page
+	for (unsigned int page = 0; packets.size() < 3; page++)
+	{
+		unsigned char header[27];
+		input.read(reinterpret_cast<char*>(header), 27);
+		if (input.gcount() != 27 || header[0] != 'O' || header[1] != 'g' || header[2] != 'g' || header[3] != 'S' || header[4] != 0) return false;
+
+		if (page == 0)
+		{
+			if (!(header[5] & 0x02)) return false;
+			serial = readLittleEndian(header + 14);
+		}
+		else if (readLittleEndian(header + 14) != serial) return false; // multiplexed stream
+		else if (page == 1) sequence = readLittleEndian(header + 18);
+
+		unsigned char lacing[255];
+		input.read(reinterpret_cast<char*>(lacing), header[26]);
+		if (input.gcount() != header[26]) return false;
+
+		for (int i = 0; i < header[26]; i++)
+		{
+			TagLib::ByteVector segment((unsigned int)lacing[i], 0);
+			input.read(segment.data(), lacing[i]);
+			if (input.gcount() != lacing[i]) return false;
+
+			packet.append(segment);
+			if (lacing[i] < 255)
+			{
+				packets.push_back(packet);
+				packet = TagLib::ByteVector();
+				if (packets.size() == 3 && i + 1 != header[26]) return false;
+			}
+		}
+
+		if (page == 0)
+		{
+			if (packets.size() != 1 || !packet.isEmpty()) return false;
+			headerStart = (uintmax_t)input.tellg();
+		}
+		else pages++;
+	}
+
+	uintmax_t headerEnd = (uintmax_t)input.tellg();
+	input.close();
+
+	if (!packets[0].startsWith(TagLib::ByteVector("\x01vorbis", 7)) || !packets[1].startsWith(TagLib::ByteVector("\x03vorbis", 7)) || !packets[2].startsWith(TagLib::ByteVector("\x05vorbis", 7))) return false;
+
+	const TagLib::ByteVector &setup = packets[2];
+	uintmax_t region = headerEnd - headerStart;
+	uintmax_t fixed = 27 * pages + setup.size() + oggSegments(setup.size());
+
+	plan->offset = headerStart;
+	plan->skip = region;
+	plan->serial = serial;
+	plan->tail = TagLib::ByteVector();
+	plan->tags_size = comment.size();
+	plan->available = 0;
+
+	std::vector<TagLib::ByteVector> headers(2);
+	headers[1] = setup;
+
+	// find size of the padded comment packet giving exactly the same header pages size
+	if (region > fixed + 1)
+	{
+		uintmax_t target = region - fixed;
+		uintmax_t estimate = (target - 1) * 255 / 256;
+		plan->available = estimate;
+
+		for (uintmax_t size = (estimate > 2 ? estimate - 2 : 0); size <= estimate + 2; size++)
+		{
+			uintmax_t segments = oggSegments(size) + oggSegments(setup.size());
+			if (size < comment.size() || size + oggSegments(size) != target || segments < pages || segments > 255 * pages) continue;
+
+			headers[0] = comment;
+			headers[0].resize((unsigned int)size, 0);
+
+			plan->mode = SAVE_IN_PLACE;
+			plan->head = renderOggPages(headers, serial, sequence, pages);
+			plan->page_shift = 0;
+			return true;
+		}
+	}
+
+	headers[0] = comment;
+	headers[0].resize((unsigned int)(comment.size() + padding), 0);
+
+	uintmax_t segments = oggSegments(headers[0].size()) + oggSegments(setup.size());
+	unsigned int newPages = (unsigned int)((segments + 254) / 255);
+
+	plan->mode = SAVE_REWRITE;
+	plan->head = renderOggPages(headers, serial, sequence, newPages);
+	plan->page_shift = (int)newPages - (int)pages;
+
+	return true;
+}
+
+/**
+ * Function executes planned write of the tags.
+ *
+ * @param[in]  path     Path to the file
+ * @param[in]  plan     Write planned by MediaLibCleaner::PlanID3v2Write(), MediaLibCleaner::PlanFLACWrite() or MediaLibCleaner::PlanVorbisWrite()
+ * @param[out] written  Amount of bytes written to the disk
+ *
+ * @return Mode in which tags were written (SAVE_FAILED on error)
+ */
+MediaLibCleaner::SaveMode MediaLibCleaner::ExecuteWritePlan(std::wstring path, const MediaLibCleaner::WritePlan &plan, uintmax_t *written)
+{
+	*written = 0;
+
+	if (plan.mode == SAVE_REWRITE)
+	{
+		if (!MediaLibCleaner::RewriteFile(path, plan, written)) return SAVE_FAILED;
+		if (plan.tail.isEmpty()) return SAVE_REWRITE;
+	}
+
+	boost::filesystem::fstream output(path, std::ios::in | std::ios::out | std::ios::binary);
+	if (!output.is_open()) return SAVE_FAILED;
+
+	if (plan.mode == SAVE_IN_PLACE)
+	{
+		output.seekp(plan.offset, std::ios::beg);
+		output.write(plan.head.data(), plan.head.size());
+		*written += plan.head.size();
+	}
+
+	if (!plan.tail.isEmpty())
+	{
+		output.seekp(plan.append_tail ? 0 : -(std::streamoff)plan.tail.size(), std::ios::end);
+		output.write(plan.tail.data(), plan.tail.size());
+		*written += plan.tail.size();
+	}
+
+	output.flush();
+	if (!output.good()) return SAVE_FAILED;
+
+	return plan.mode;
+}
+
+/**
+ * Function rewrites the file replacing part of it with planned data.
+ *
+ * New file is written next to the original one (with *.mlctmp extension) and replaces it only after the
+ * rest of the file was copied completely, so original file stays intact on any error.
+ * If the plan requires Ogg pages to be renumbered, pages are copied one by one, otherwise file is copied in large blocks.
+ *
+ * @param[in]  path     Path to the file
+ * @param[in]  plan     Planned write
+ * @param[out] written  Amount of bytes written to the disk
+ *
+ * @return True on success, false otherwise
+ */
+bool MediaLibCleaner::RewriteFile(std::wstring path, const MediaLibCleaner::WritePlan &plan, uintmax_t *written)
+{
+	std::wstring temp = path + L".mlctmp";
+	*written = 0;
+
+	{
+		boost::filesystem::ifstream input(path, std::ios::in | std::ios::binary);
+		boost::filesystem::ofstream output(temp, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!input.is_open() || !output.is_open()) return false;
+
+		bool result = copyBytes(input, output, plan.offset, written);
+
+		output.write(plan.head.data(), plan.head.size());
+		*written += plan.head.size();
+
+		input.seekg(plan.offset + plan.skip, std::ios::beg);
+		if (plan.page_shift != 0)
+			result = result && copyOggPages(input, output, plan.serial, plan.page_shift, written);
+		else
+			result = result && copyBytes(input, output, UINTMAX_MAX, written);
+
+		output.flush();
+		if (!result || !output.good())
+		{
+			output.close();
+			boost::system::error_code ec;
+			boost::filesystem::remove(temp, ec);
+			return false;
+		}
+	}
+
+	boost::system::error_code ec;
+	boost::filesystem::rename(temp, path, ec);
+	if (ec)
+	{
+		boost::filesystem::remove(temp, ec);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Function calculates Ogg page checksum (CRC-32 with 0x04C11DB7 polynomial, not reflected, no final XOR).
+ *
+ * Checksum is calculated 8 bytes at a time using precalculated lookup tables (slicing-by-8).
+ *
+ * @param[in] data    Data to be checksummed
+ * @param[in] length  Length of the data
+ * @param[in] crc     Checksum of the previous part of the data (0 for the beginning of the page)
+ *
+ * @return Checksum of the data
+ */
+unsigned int MediaLibCleaner::OggCRC(const unsigned char *data, size_t length, unsigned int crc)
+{
+	const unsigned int (*t)[256] = oggCRCTable.table;
+
+	while (length >= 8)
+	{
+		crc ^= ((unsigned int)data[0] << 24) | ((unsigned int)data[1] << 16) | ((unsigned int)data[2] << 8) | (unsigned int)data[3];
+		crc = t[7][crc >> 24] ^ t[6][(crc >> 16) & 0xFF] ^ t[5][(crc >> 8) & 0xFF] ^ t[4][crc & 0xFF]
+			^ t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+		data += 8;
+		length -= 8;
+	}
+
+	while (length--)
+	{
+		crc = (crc << 8) ^ t[0][(crc >> 24) ^ *data++];
+	}
+
+	return crc;
+}
@@ -0,0 +1,99 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * File contains declarations of all classes and functions writing rendered tags directly into audio files (bypassing TagLib's save())
+ */
+#pragma once
+
+#include <atomic>
+#include <string>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <taglib/taglib_export.h>
+#include <taglib/tbytevector.h>
+
+namespace TagLib
+{
+	namespace MP4
+	{
+		/**
+		 * Sets size of the free atom left after ilst atom when MP4 file has to grow to fit new tags.
+		 * Function is provided by modified TagLib MP4 tag writer (see modified_files/taglib/mp4/mp4tag.cpp).
+		 *
+		 * @param[in] padding  Size of the free atom data in bytes
+		 */
+		TAGLIB_EXPORT void setIlstPadding(unsigned int padding);
+	}
+}
+
+namespace MediaLibCleaner
+{
+	/**
+	 * @brief Enumerate type describing the way tags were written into the file
+	 */
+	enum SaveMode
+	{
+		SAVE_FAILED, ///< Writing tags failed, file was not changed
+		SAVE_IN_PLACE, ///< Tags were written in place, using padding already present in the file
+		SAVE_REWRITE, ///< Tags did not fit into the file, whole file has been rewritten (with new padding reserved)
+		SAVE_TAGLIB, ///< Tags were written by TagLib's save() (file layout not supported by MediaLibCleaner writers)
+		SAVE_MODES_COUNT ///< Amount of save modes (not a real mode)
+	};
+
+	/**
+	 * @brief Structure describing planned write of the tags into the file
+	 */
+	struct WritePlan
+	{
+		SaveMode mode = SAVE_FAILED; ///< SAVE_IN_PLACE or SAVE_REWRITE
+		TagLib::ByteVector head; ///< Data replacing the beginning of the file (tags with padding)
+		uintmax_t offset = 0; ///< Offset in the file at which head begins (data before it is left untouched)
+		uintmax_t skip = 0; ///< Amount of bytes of the original file (starting at offset) replaced by head
+		TagLib::ByteVector tail; ///< Data replacing the end of the file (for example ID3v1 tag); may be empty
+		bool append_tail = false; ///< Tail is appended to the file instead of replacing its end
+		int page_shift = 0; ///< Ogg only: change of page sequence numbers of pages following head (0 - pages are copied as they are)
+		unsigned int serial = 0; ///< Ogg only: serial number of the logical stream which pages are renumbered
+		uintmax_t tags_size = 0; ///< Size of the tags without padding
+		uintmax_t available = 0; ///< Space available for tags in the file before the write
+	};
+
+	/**
+	 * @class SaveStats TagWriter.hpp
+	 *
+	 * @brief Class MediaLibCleaner::SaveStats counts how tags were written to the files during the run (thread-safe).
+	 */
+	class SaveStats
+	{
+	public:
+		SaveStats();
+		~SaveStats();
+
+		void Count(SaveMode mode, uintmax_t written);
+
+		int GetCount(SaveMode mode);
+		uintmax_t GetBytes(SaveMode mode);
+
+	protected:
+		/**
+		* Amount of saves done in each of the save modes
+		*/
+		std::atomic<int> counts[SAVE_MODES_COUNT];
+
+		/**
+		* Amount of bytes written in each of the save modes
+		*/
+		std::atomic<unsigned long long> bytes[SAVE_MODES_COUNT];
+	};
+
+	bool PlanID3v2Write(std::wstring path, const TagLib::ByteVector &tag, const TagLib::ByteVector &id3v1, size_t padding, WritePlan *plan);
+	bool PlanFLACWrite(std::wstring path, const TagLib::ByteVector &comment, size_t padding, WritePlan *plan);
+	bool PlanVorbisWrite(std::wstring path, const TagLib::ByteVector &comment, size_t padding, WritePlan *plan);
+	SaveMode ExecuteWritePlan(std::wstring path, const WritePlan &plan, uintmax_t *written);
+	bool RewriteFile(std::wstring path, const WritePlan &plan, uintmax_t *written);
+
+	unsigned int OggCRC(const unsigned char *data, size_t length, unsigned int crc = 0);
+}
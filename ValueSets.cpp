@@ -0,0 +1,83 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * File contains definitions of value sets - named lists of allowed tag values defined once by the script (_DefineValueSet) and used by _CheckTagValues
+ */
+#include "ValueSets.hpp"
+
+
+
+
+/**
+ * Method defines new set of values. If set of that name already exists, it is returned unchanged.
+ *
+ * @param[in] name    Name of the set as given in the config file
+ * @param[in] values  Values of the set
+ *
+ * @return Set of given name (valid until the object is destroyed)
+ */
+const MediaLibCleaner::ValueSet* MediaLibCleaner::ValueSets::Define(const std::string &name, const std::vector<std::wstring> &values)
+{
+	std::unique_ptr<ValueSet> set(new ValueSet(values.begin(), values.end()));
+
+	this->synch.lock();
+	auto inserted = this->sets.insert(std::make_pair(name, std::move(set)));
+	const ValueSet *result = inserted.first->second.get();
+	this->synch.unlock();
+
+	return result;
+}
+
+/**
+ * Method returns set of given name
+ *
+ * @param[in] name  Name of the set as given in the config file
+ *
+ * @return Set of given name (valid until the object is destroyed) or nullptr if there is no such set
+ */
+const MediaLibCleaner::ValueSet* MediaLibCleaner::ValueSets::Get(const std::string &name)
+{
+	const ValueSet *result = nullptr;
+
+	this->synch.lock();
+	auto found = this->sets.find(name);
+	if (found != this->sets.end()) result = found->second.get();
+	this->synch.unlock();
+
+	return result;
+}
+
+/**
+ * Method returns amount of defined sets
+ *
+ * @return Amount of sets
+ */
+size_t MediaLibCleaner::ValueSets::GetSets()
+{
+	this->synch.lock();
+	size_t size = this->sets.size();
+	this->synch.unlock();
+
+	return size;
+}
+
+/**
+ * Method returns amount of values in all defined sets
+ *
+ * @return Amount of values
+ */
+size_t MediaLibCleaner::ValueSets::GetValues()
+{
+	size_t values = 0;
+
+	this->synch.lock();
+	for (auto it = this->sets.begin(); it != this->sets.end(); ++it)
+	{
+		values += it->second->size();
+	}
+	this->synch.unlock();
+
+	return values;
+}
@@ -0,0 +1,53 @@
+/**
+ * @file
+ * @author Szymon Oracki <szymon.oracki@oustish.pl>
+ * @version 1.0.0
+ *
+ * File contains declarations of value sets - named lists of allowed tag values defined once by the script (_DefineValueSet) and used by _CheckTagValues
+ */
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace MediaLibCleaner
+{
+	/**
+	 * Set of allowed values of a tag
+	 */
+	typedef std::unordered_set<std::wstring> ValueSet;
+
+	/**
+	 * @class ValueSets ValueSets.hpp
+	 *
+	 * @brief Class MediaLibCleaner::ValueSets keeps named sets of tag values shared by all threads.
+	 *
+	 * Set is created by its first definition and never changed later (further definitions of the same name are ignored),
+	 * so sets are read without holding the lock and every value is converted only once per run, not once per file.
+	 * Checking if a value belongs to the set takes constant time regardless of its size.
+	 */
+	class ValueSets
+	{
+	public:
+		const ValueSet* Define(const std::string &name, const std::vector<std::wstring> &values);
+		const ValueSet* Get(const std::string &name);
+
+		size_t GetSets();
+		size_t GetValues();
+
+	protected:
+		/**
+		 * All sets, by name as given in the config file (sets stay at the same address when more sets are defined)
+		 */
+		std::unordered_map<std::string, std::unique_ptr<ValueSet>> sets;
+
+		/**
+		 * std::mutex protecting sets from racing conditions
+		 */
+		std::mutex synch;
+	};
+}
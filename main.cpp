@@ -31,11 +31,101 @@ int error_level = 0,
  */
 	max_threads = 0;
 
+/**
+ * Global variable containing amount of padding (in bytes) reserved in the file when it has to be rewritten to fit new tags
+ */
+size_t tag_padding = 4096;
+
+/**
+ * Global variable containing accuracy of audio properties (technical info) read during scan
+ */
+MediaLibCleaner::PropertyAccuracy property_accuracy = MediaLibCleaner::ACCURACY_HEADER;
+
+/**
+ * Global variable deciding if tags are read during scan by read-only parser (TagLib is used only for files parser does not handle)
+ */
+bool fast_scan = true;
+
+/**
+ * Global variable deciding if files with the same audio data are searched for after scan (see MediaLibCleaner::DuplicateFinder)
+ */
+bool find_duplicates = false;
+
+/**
+ * Global variable containing path to the report of duplicates ("-" for standard output)
+ */
+std::string duplicate_report = "-";
+
+/**
+ * Global variable deciding if audio data of all files is verified after scan (see MediaLibCleaner::IntegrityVerifier)
+ */
+bool verify_integrity = false;
+
+/**
+ * Global variable containing amount of threads verifying files, independent of _max_threads (0 - one per processor)
+ */
+int verify_threads = 2;
+
+/**
+ * Global variable containing path to the report of damaged files ("-" for standard output)
+ */
+std::string damage_report = "-";
+
+/**
+ * Global variable containing path to the store of checksums of audio data kept between runs ("" - checksums are not used; see MediaLibCleaner::ChecksumStore)
+ */
+std::string checksum_store = "";
+
+/**
+ * Global variable containing part of known files verified against the checksum store in one run (30 - one in 30 files, 0 - all files)
+ */
+int checksum_fraction = 30;
+
+/**
+ * Global variable containing maximum amount of MiB read to record or verify checksums in one run (0 - no limit)
+ */
+int checksum_budget = 0;
+
+/**
+ * Global variable containing path to the tag index written after scan ("" - index is not written; see MediaLibCleaner::TagIndex)
+ */
+std::string tag_index = "";
+
+/**
+ * Global variable deciding if different spellings of artist and album names are searched for after scan (see MediaLibCleaner::NameClusterer)
+ */
+bool cluster_names = false;
+
+/**
+ * Global variable containing path to the report of names with more than one spelling ("-" for standard output)
+ */
+std::string name_report = "-";
+
 /**
  * Global variable representing MediaLibCleaner::FilesAggregator object
  */
 std::unique_ptr<MediaLibCleaner::FilesAggregator> filesAggregator;
 
+/**
+ * Global variable representing MediaLibCleaner::DirectoryAggregator object (aggregates of directories available in lua as dir table)
+ */
+std::unique_ptr<MediaLibCleaner::DirectoryAggregator> directoryAggregator;
+
+/**
+ * Global variable representing MediaLibCleaner::NameClusterer object (nullptr if names are not clustered)
+ */
+std::unique_ptr<MediaLibCleaner::NameClusterer> nameClusterer;
+
+/**
+ * Global variable representing MediaLibCleaner::ValueSets object (sets of values defined by _DefineValueSet)
+ */
+std::unique_ptr<MediaLibCleaner::ValueSets> valueSets;
+
+/**
+ * Global variable representing MediaLibCleaner::LookupTables object (tables loaded by _LoadTable)
+ */
+std::unique_ptr<MediaLibCleaner::LookupTables> lookupTables;
+
 /**
 * Global variable containing all currently processed MediaLibCleaner::File object by different threads
 */
@@ -61,6 +151,11 @@ int total_files = 0;
 */
 time_t datetime_raw = 0;
 
+/**
+* Global variable containing MediaLibCleaner::RunContext object (precomputed system aliases, tag writing settings and statistics)
+*/
+std::unique_ptr<MediaLibCleaner::RunContext> runcontext;
+
 /**
 * Global variable holding status if _Delete or _Move was called succesfully
 */
@@ -81,6 +176,36 @@ static int lua_caller_isaudiofile(lua_State *L) {
 	return lua_IsAudioFile(L, cfile, &programlog, &alertlog);
 }
 
+/**
+ * Function calling lua_IsDuplicate() function. This function is registered withing lua processor!
+ *
+ * @param[in] L	lua_State object to config file
+ *
+ * @return Number of output arguments on stack for lua processor
+ */
+static int lua_caller_isduplicate(lua_State *L) {
+	lua_getglobal(L, "__thread");
+	int thd = static_cast<int>(lua_tonumber(L, -1));
+	auto cfile = current_file_thd[thd];
+
+	return lua_IsDuplicate(L, cfile, &programlog, &alertlog);
+}
+
+/**
+ * Function calling lua_IsIntact() function. This function is registered withing lua processor!
+ *
+ * @param[in] L	lua_State object to config file
+ *
+ * @return Number of output arguments on stack for lua processor
+ */
+static int lua_caller_isintact(lua_State *L) {
+	lua_getglobal(L, "__thread");
+	int thd = static_cast<int>(lua_tonumber(L, -1));
+	auto cfile = current_file_thd[thd];
+
+	return lua_IsIntact(L, cfile, &programlog, &alertlog);
+}
+
 /**
 * Function calling lua_SetTags() function. This function is registered within lua processor!
 *
@@ -211,6 +336,120 @@ static int lua_caller_log(lua_State *L)
 	return lua_Log(L, cfile, &programlog, &alertlog);
 }
 
+/**
+* Function calling lua_CanonicalName() function. This function is registered within lua processor!
+*
+* @param[in] L lua_State object to config file
+*
+* @return Number of output arguments on stack for lua processor
+*/
+static int lua_caller_canonicalname(lua_State *L)
+{
+	return lua_CanonicalName(L, nameClusterer.get(), &programlog, &alertlog);
+}
+
+/**
+* Function calling lua_DefineValueSet() function. This function is registered within lua processor!
+*
+* @param[in] L lua_State object to config file
+*
+* @return Number of output arguments on stack for lua processor
+*/
+static int lua_caller_definevalueset(lua_State *L)
+{
+	return lua_DefineValueSet(L, valueSets.get(), &programlog, &alertlog);
+}
+
+/**
+* Function calling lua_ValueSet() function. This function is registered within lua processor!
+*
+* @param[in] L lua_State object to config file
+*
+* @return Number of output arguments on stack for lua processor
+*/
+static int lua_caller_valueset(lua_State *L)
+{
+	return lua_ValueSet(L, valueSets.get(), &programlog, &alertlog);
+}
+
+/**
+* Function calling lua_LoadTable() function. This function is registered within lua processor!
+*
+* @param[in] L lua_State object to config file
+*
+* @return Number of output arguments on stack for lua processor
+*/
+static int lua_caller_loadtable(lua_State *L)
+{
+	return lua_LoadTable(L, lookupTables.get(), &programlog, &alertlog);
+}
+
+/**
+* Function calling lua_Lookup() function. This function is registered within lua processor!
+*
+* @param[in] L lua_State object to config file
+*
+* @return Number of output arguments on stack for lua processor
+*/
+static int lua_caller_lookup(lua_State *L)
+{
+	return lua_Lookup(L, lookupTables.get(), &programlog, &alertlog);
+}
+
+/**
+* Function calling lua_CheckTagRegex() function. This function is registered within lua processor!
+*
+* @param[in] L lua_State object to config file
+*
+* @return Number of output arguments on stack for lua processor
+*/
+static int lua_caller_checktagregex(lua_State *L)
+{
+	lua_getglobal(L, "__thread");
+	int thd = static_cast<int>(lua_tonumber(L, -1));
+	auto cfile = current_file_thd[thd];
+
+	return lua_CheckTagRegex(L, cfile, runcontext->GetRegexCache(), &programlog, &alertlog);
+}
+
+/**
+* Function calling lua_MatchTag() function. This function is registered within lua processor!
+*
+* @param[in] L lua_State object to config file
+*
+* @return Number of output arguments on stack for lua processor
+*/
+static int lua_caller_matchtag(lua_State *L)
+{
+	lua_getglobal(L, "__thread");
+	int thd = static_cast<int>(lua_tonumber(L, -1));
+	auto cfile = current_file_thd[thd];
+
+	return lua_MatchTag(L, cfile, runcontext->GetRegexCache(), &programlog, &alertlog);
+}
+
+/**
+* Names of all lua functions working on the current file (see lua_caller_nofile())
+*/
+static const char *const FILE_FUNCTIONS[] = { "_IsAudioFile", "_IsDuplicate", "_IsIntact", "_SetTags", "_RemoveTags", "_SetRequiredTags", "_CheckTagValues",
+	"_CheckTagRegex", "_MatchTag", "_Rename", "_Move", "_Delete", "_Log" };
+
+/**
+* Function registered under names of all functions working on the current file when there is no current file (_action == "Directory").
+* It does nothing and returns false, so per-file code of the script not guarded by _action == "" does not break the pass.
+*
+* @param[in] L lua_State object to config file (name of the function is the first upvalue)
+*
+* @return Number of output arguments on stack for lua processor
+*/
+static int lua_caller_nofile(lua_State *L)
+{
+	programlog->Log(L"ProcessDirectories", L"Function " + s2ws(lua_tostring(L, lua_upvalueindex(1))) + L" works on the current file, ignored outside of file processing", 3);
+
+	lua_pushboolean(L, false);
+	return 1;
+}
+
 
 
 
@@ -256,6 +495,10 @@ int main(int argc, char *argv[]) {
 	desc.add_options()
 		("help", "produce help message")
 		("config", po::value<std::string>(), "path to LUA config file")
+		("benchmark-scan", po::value<std::string>(), "generate synthetic audio files in given directory and compare scan by TagLib with scan by fast parser")
+		("benchmark-files", po::value<int>()->default_value(100), "amount of files of every format generated by --benchmark-scan")
+		("query", po::value<std::string>(), "answer query (e.g. \"albumartist=;genre=Jazz\") from tag index given by --index, without reading audio files")
+		("index", po::value<std::string>(), "path to tag index written by previous run (_tag_index)")
 		;
 
 	po::variables_map vm;
@@ -269,6 +512,24 @@ int main(int argc, char *argv[]) {
 		return 7;
 	}
 
+	// benchmark does not need any config file
+	if (vm.count("benchmark-scan"))
+	{
+		return MediaLibCleaner::RunScanBenchmark(s2ws(vm["benchmark-scan"].as<std::string>()), vm["benchmark-files"].as<int>());
+	}
+
+	// query is answered from the index only
+	if (vm.count("query"))
+	{
+		if (!vm.count("index"))
+		{
+			std::wcerr << L"ERROR: --query requires path to tag index (--index)." << std::endl;
+			return 7;
+		}
+
+		return MediaLibCleaner::RunQuery(s2ws(vm["index"].as<std::string>()), s2ws(vm["query"].as<std::string>()));
+	}
+
 	// if not, try to figure out which config file to use
 	std::wstring wconfig;
 	if (vm.count("config")) // LUA
@@ -309,20 +570,36 @@ int main(int argc, char *argv[]) {
 	replaceAll(wcfgc, L"\\", L"\\\\");
 	std::string config = ws2s(wcfgc);
 
+	// sets of values and lookup tables are defined by the script, usually in _action == System
+	std::unique_ptr<MediaLibCleaner::ValueSets> temp6(new MediaLibCleaner::ValueSets());
+	valueSets.swap(temp6);
+	std::unique_ptr<MediaLibCleaner::LookupTables> temp7(new MediaLibCleaner::LookupTables());
+	lookupTables.swap(temp7);
+
 	// init lua processor
 	lua_State *L = luaL_newstate();
 	luaL_openlibs(L);
 
 	// register C functions in lua processor
 	lua_register(L, "_IsAudioFile", lua_caller_isaudiofile);
+	lua_register(L, "_IsDuplicate", lua_caller_isduplicate);
+	lua_register(L, "_IsIntact", lua_caller_isintact);
 	lua_register(L, "_SetTags", lua_caller_settags);
 	lua_register(L, "_RemoveTags", lua_caller_removetags);
 	lua_register(L, "_SetRequiredTags", lua_caller_setrequiredtags);
 	lua_register(L, "_CheckTagValues", lua_caller_checktagvalues);
+	lua_register(L, "_CheckTagRegex", lua_caller_checktagregex);
+	lua_register(L, "_MatchTag", lua_caller_matchtag);
 	lua_register(L, "_Rename", lua_caller_rename);
 	lua_register(L, "_Move", lua_caller_move);
 	lua_register(L, "_Delete", lua_caller_delete);
 	lua_register(L, "_Log", lua_caller_log);
+	// names are clustered after scan - here every name is returned unchanged
+	lua_register(L, "_CanonicalName", lua_caller_canonicalname);
+	lua_register(L, "_DefineValueSet", lua_caller_definevalueset);
+	lua_register(L, "_ValueSet", lua_caller_valueset);
+	lua_register(L, "_LoadTable", lua_caller_loadtable);
+	lua_register(L, "_Lookup", lua_caller_lookup);
 
 	// _action == System
 	// as we need these informations once at the beginning
@@ -344,6 +621,48 @@ int main(int argc, char *argv[]) {
 	lua_pushstring(L, "-");
 	lua_setglobal(L, "_alert_log");
 
+	lua_pushnumber(L, 4096);
+	lua_setglobal(L, "_tag_padding");
+
+	lua_pushstring(L, "header");
+	lua_setglobal(L, "_property_accuracy");
+
+	lua_pushboolean(L, 1);
+	lua_setglobal(L, "_fast_scan");
+
+	lua_pushboolean(L, 0);
+	lua_setglobal(L, "_find_duplicates");
+
+	lua_pushstring(L, "-");
+	lua_setglobal(L, "_duplicate_report");
+
+	lua_pushboolean(L, 0);
+	lua_setglobal(L, "_verify_integrity");
+
+	lua_pushnumber(L, 2);
+	lua_setglobal(L, "_verify_threads");
+
+	lua_pushstring(L, "-");
+	lua_setglobal(L, "_damage_report");
+
+	lua_pushstring(L, "");
+	lua_setglobal(L, "_checksum_store");
+
+	lua_pushnumber(L, 30);
+	lua_setglobal(L, "_checksum_fraction");
+
+	lua_pushnumber(L, 0);
+	lua_setglobal(L, "_checksum_budget");
+
+	lua_pushstring(L, "");
+	lua_setglobal(L, "_tag_index");
+
+	lua_pushboolean(L, 0);
+	lua_setglobal(L, "_cluster_names");
+
+	lua_pushstring(L, "-");
+	lua_setglobal(L, "_name_report");
+
 	std::wcout << L"Executing script... (SYSTEM)" << std::endl; //d
 
 	// execute script
@@ -378,6 +697,86 @@ int main(int argc, char *argv[]) {
 	error_level = static_cast<int>(lua_tonumber(L, -4));
 	max_threads = static_cast<int>(lua_tonumber(L, -5));
 
+	// optional parameters
+	lua_getglobal(L, "_tag_padding");
+	if (lua_isnumber(L, -1) && lua_tonumber(L, -1) >= 0) {
+		tag_padding = static_cast<size_t>(lua_tonumber(L, -1));
+	}
+
+	lua_getglobal(L, "_property_accuracy");
+	if (lua_isstring(L, -1)) {
+		std::string accuracy = lua_tostring(L, -1);
+
+		if (accuracy == "none")
+			property_accuracy = MediaLibCleaner::ACCURACY_NONE;
+		else if (accuracy == "header")
+			property_accuracy = MediaLibCleaner::ACCURACY_HEADER;
+		else if (accuracy == "accurate")
+			property_accuracy = MediaLibCleaner::ACCURACY_ACCURATE;
+		else
+			std::wcerr << L"Unknown _property_accuracy value (allowed: none, header, accurate), using 'header'." << std::endl;
+	}
+
+	lua_getglobal(L, "_fast_scan");
+	if (lua_isboolean(L, -1)) {
+		fast_scan = lua_toboolean(L, -1) != 0;
+	}
+
+	lua_getglobal(L, "_find_duplicates");
+	if (lua_isboolean(L, -1)) {
+		find_duplicates = lua_toboolean(L, -1) != 0;
+	}
+
+	lua_getglobal(L, "_duplicate_report");
+	if (lua_isstring(L, -1)) {
+		duplicate_report = lua_tostring(L, -1);
+	}
+
+	lua_getglobal(L, "_verify_integrity");
+	if (lua_isboolean(L, -1)) {
+		verify_integrity = lua_toboolean(L, -1) != 0;
+	}
+
+	lua_getglobal(L, "_verify_threads");
+	if (lua_isnumber(L, -1)) {
+		verify_threads = static_cast<int>(lua_tonumber(L, -1));
+	}
+
+	lua_getglobal(L, "_damage_report");
+	if (lua_isstring(L, -1)) {
+		damage_report = lua_tostring(L, -1);
+	}
+
+	lua_getglobal(L, "_checksum_store");
+	if (lua_isstring(L, -1)) {
+		checksum_store = lua_tostring(L, -1);
+	}
+
+	lua_getglobal(L, "_checksum_fraction");
+	if (lua_isnumber(L, -1)) {
+		checksum_fraction = static_cast<int>(lua_tonumber(L, -1));
+	}
+
+	lua_getglobal(L, "_checksum_budget");
+	if (lua_isnumber(L, -1)) {
+		checksum_budget = static_cast<int>(lua_tonumber(L, -1));
+	}
+
+	lua_getglobal(L, "_tag_index");
+	if (lua_isstring(L, -1)) {
+		tag_index = lua_tostring(L, -1);
+	}
+
+	lua_getglobal(L, "_cluster_names");
+	if (lua_isboolean(L, -1)) {
+		cluster_names = lua_toboolean(L, -1) != 0;
+	}
+
+	lua_getglobal(L, "_name_report");
+	if (lua_isstring(L, -1)) {
+		name_report = lua_tostring(L, -1);
+	}
+
 
 	//>> - C: It's hard to leave everything... My kids, your father...
 	//>> - B: We're gonna be spending a lot of time together.
@@ -406,6 +805,28 @@ int main(int argc, char *argv[]) {
 	programlog->Log(L"Main", L"_error_log value: " + s2ws(error_log), 3);
 	programlog->Log(L"Main", L"_error_level value: " + std::to_wstring(error_level), 3);
 	programlog->Log(L"Main", L"_max_threads value: " + std::to_wstring(max_threads) , 3);
+	programlog->Log(L"Main", L"_tag_padding value: " + std::to_wstring(tag_padding), 3);
+	programlog->Log(L"Main", L"_property_accuracy value: " + std::to_wstring(static_cast<int>(property_accuracy)), 3);
+	programlog->Log(L"Main", L"_fast_scan value: " + std::to_wstring(static_cast<int>(fast_scan)), 3);
+	programlog->Log(L"Main", L"_find_duplicates value: " + std::to_wstring(static_cast<int>(find_duplicates)), 3);
+	programlog->Log(L"Main", L"_duplicate_report value: " + s2ws(duplicate_report), 3);
+	programlog->Log(L"Main", L"_verify_integrity value: " + std::to_wstring(static_cast<int>(verify_integrity)), 3);
+	programlog->Log(L"Main", L"_verify_threads value: " + std::to_wstring(verify_threads), 3);
+	programlog->Log(L"Main", L"_damage_report value: " + s2ws(damage_report), 3);
+	programlog->Log(L"Main", L"_checksum_store value: " + s2ws(checksum_store), 3);
+	programlog->Log(L"Main", L"_checksum_fraction value: " + std::to_wstring(checksum_fraction), 3);
+	programlog->Log(L"Main", L"_checksum_budget value: " + std::to_wstring(checksum_budget), 3);
+	programlog->Log(L"Main", L"_tag_index value: " + s2ws(tag_index), 3);
+	programlog->Log(L"Main", L"_cluster_names value: " + std::to_wstring(static_cast<int>(cluster_names)), 3);
+	programlog->Log(L"Main", L"_name_report value: " + s2ws(name_report), 3);
+
+	// compute all run-constant system aliases once for all threads
+	programlog->Log(L"Main", L"Creating MediaLibCleaner::RunContext object", 3);
+	std::unique_ptr<MediaLibCleaner::RunContext> temp3(new MediaLibCleaner::RunContext(path, datetime_raw, tag_padding, property_accuracy, fast_scan));
+	runcontext.swap(temp3);
+
+	// MP4 files are saved by TagLib - make it reserve the same amount of padding
+	TagLib::MP4::setIlstPadding(static_cast<unsigned int>(tag_padding));
 
 	// BELOW ARE PROCEDURES TO SCAN GIVEN DIRECTORY AND RETRIEVE ALL INFO WE REQUIRE
 	// create MediaLibCleaner::FilesAggregator object nad swap it with global variable one
@@ -460,7 +881,93 @@ int main(int argc, char *argv[]) {
 	// full multi-core support (in theory)
 	programlog->Log(L"Main", L"Beginning parsing paths and files", 3);
 	std::wcout << L"Scanning files..." << std::endl;
-	scan(&dfc_list, path_list, &programlog, &alertlog, path, &filesAggregator, &total_files);
+	scan(&dfc_list, path_list, &programlog, &alertlog, path, &filesAggregator, &total_files, &runcontext);
+
+	// total files count is known only now
+	runcontext->SetTotalFiles(total_files);
+
+	// duplicates have to be known before any file is processed (_IsDuplicate(), %_dup_group%)
+	if (find_duplicates)
+	{
+		programlog->Log(L"Main", L"Searching for files with the same audio data", 3);
+		std::wcout << L"Searching for duplicates..." << std::endl;
+
+		MediaLibCleaner::DuplicateFinder finder(&programlog, &alertlog);
+		for (auto it = filesAggregator->begin(); it != filesAggregator->end(); ++it)
+			finder.AddFile(*it);
+
+		size_t groups = finder.Run();
+		finder.WriteReport(s2ws(duplicate_report));
+
+		std::wcout << L"Duplicates: " << groups << L" groups, " << finder.GetFullyHashed() << L" of " << finder.GetCandidates() << L" files hashed completely" << std::endl;
+		programlog->Log(L"Main", L"Audio data hashed to find duplicates: " + std::to_wstring(finder.GetBytesHashed()) + L" bytes", 3);
+	}
+
+	// the same for damaged files (_IsIntact())
+	if (verify_integrity)
+	{
+		programlog->Log(L"Main", L"Verifying integrity of audio files", 3);
+		std::wcout << L"Verifying files..." << std::endl;
+
+		MediaLibCleaner::IntegrityVerifier verifier(&programlog, &alertlog);
+		for (auto it = filesAggregator->begin(); it != filesAggregator->end(); ++it)
+			verifier.AddFile(*it);
+
+		size_t damaged = verifier.Run(verify_threads);
+		verifier.WriteReport(s2ws(damage_report));
+
+		std::wcout << L"Damaged files: " << damaged << L" of " << verifier.GetVerified() << L" verified" << std::endl;
+		programlog->Log(L"Main", L"Data read to verify files: " + std::to_wstring(verifier.GetBytesRead()) + L" bytes", 3);
+	}
+
+	// checksums kept between runs - silent corruption is reported to alert log
+	if (!checksum_store.empty())
+	{
+		programlog->Log(L"Main", L"Verifying checksums of audio data", 3);
+		std::wcout << L"Verifying checksums..." << std::endl;
+
+		MediaLibCleaner::ChecksumStore store(&programlog, &alertlog);
+		if (store.Load(s2ws(checksum_store)))
+		{
+			for (auto it = filesAggregator->begin(); it != filesAggregator->end(); ++it)
+				store.AddFile(*it);
+
+			size_t corrupted = store.Run(checksum_fraction, static_cast<unsigned long long>(checksum_budget) * 1048576);
+			store.Save(s2ws(checksum_store));
+
+			std::wcout << L"Checksums: " << store.GetAdded() << L" recorded, " << store.GetVerified() << L" verified, " << corrupted << L" corrupted files" << std::endl;
+		}
+	}
+
+
+	// different spellings of the same name (_CanonicalName())
+	if (cluster_names)
+	{
+		programlog->Log(L"Main", L"Clustering artist and album names", 3);
+		std::wcout << L"Clustering names..." << std::endl;
+
+		std::unique_ptr<MediaLibCleaner::NameClusterer> temp5(new MediaLibCleaner::NameClusterer(&programlog, &alertlog));
+		nameClusterer.swap(temp5);
+		for (auto it = filesAggregator->begin(); it != filesAggregator->end(); ++it)
+			nameClusterer->AddFile(*it);
+
+		size_t clusters = nameClusterer->Run();
+		nameClusterer->WriteReport(s2ws(name_report));
+
+		std::wcout << L"Names with more than one spelling: " << clusters << L" (" << nameClusterer->GetCandidates() << L" pairs of " << nameClusterer->GetNames() << L" names compared)" << std::endl;
+	}
+
+	// summary of every directory (dir table) is computed from tags read during scan, before any file is changed
+	programlog->Log(L"Main", L"Aggregating directories", 3);
+	std::unique_ptr<MediaLibCleaner::DirectoryAggregator> temp4(new MediaLibCleaner::DirectoryAggregator(&programlog, &alertlog));
+	directoryAggregator.swap(temp4);
+	for (auto it = filesAggregator->begin(); it != filesAggregator->end(); ++it)
+		directoryAggregator->AddFile(*it);
+	directoryAggregator->Run();
+
+	// album-scoped rules - once per directory, changes are saved together with changes made for each file
+	bool on_directory = processDirectories(config, &directoryAggregator, &programlog, &alertlog);
+	programlog->Log(L"Main", L"_OnDirectory defined: " + std::to_wstring(static_cast<int>(on_directory)), 3);
 
 
 	// ITERATE OVER COLLECTION AND PROCESS FILES
@@ -481,7 +988,25 @@ int main(int argc, char *argv[]) {
 
 	programlog->Log(L"Main", L"Starting iteration through collection.", 3);
 	std::wcout << L"Processing files..." << std::endl;
-	process(wconfig, &filesAggregator, &programlog);
+	process(wconfig, &filesAggregator, &directoryAggregator, &programlog, &runcontext);
+	programlog->Log(L"Main", L"Regular expressions compiled: " + std::to_wstring(runcontext->GetRegexCache()->GetPatterns()), 3);
+	programlog->Log(L"Main", L"Value sets defined: " + std::to_wstring(valueSets->GetSets()) + L" (" + std::to_wstring(valueSets->GetValues()) + L" values)", 3);
+	programlog->Log(L"Main", L"Lookup tables loaded: " + std::to_wstring(lookupTables->GetTables()) + L" (" + std::to_wstring(lookupTables->GetRows()) + L" rows)", 3);
+
+	// index of tags and paths as left by processing (deleted files are skipped), for --query
+	if (!tag_index.empty())
+	{
+		programlog->Log(L"Main", L"Writing tag index", 3);
+
+		MediaLibCleaner::TagIndex tagindex;
+		for (auto it = filesAggregator->begin(); it != filesAggregator->end(); ++it)
+			tagindex.AddFile(*it);
+
+		if (tagindex.Save(s2ws(tag_index)))
+			programlog->Log(L"Main", L"Tag index: " + std::to_wstring(tagindex.GetFiles()) + L" files, " + std::to_wstring(tagindex.GetValues()) + L" values, " + std::to_wstring(tagindex.GetBytes()) + L" bytes of file lists", 3);
+		else
+			programlog->Log(L"Main", L"Tag index could not be written: " + s2ws(tag_index), 1);
+	}
 
 
 	// delete all empty directories IF _Move or _Delete was called
@@ -521,6 +1046,9 @@ int main(int argc, char *argv[]) {
 	//>> - How do you know?
 
 
+	// aggregates refer to DFC objects
+	directoryAggregator.reset();
+
 	// deleting DFC objects
 	for (auto it = dfc_list.begin(); it != dfc_list.end(); ++it)
 		delete (*it);
@@ -542,13 +1070,35 @@ int main(int argc, char *argv[]) {
 	programlog->Log(L"Main", L"Program execution time: " + std::to_wstring(diff) + L" sec", 3);
 	programlog->Log(L"Main", L"Total files: " + std::to_wstring(total_files), 3);
 
+	// tag writing statistics
+	MediaLibCleaner::SaveStats *stats = runcontext->GetSaveStats();
+	std::wcout << L"Tags written: " << stats->GetCount(MediaLibCleaner::SAVE_IN_PLACE) << L" in place, "
+		<< stats->GetCount(MediaLibCleaner::SAVE_REWRITE) << L" with file rewrite, "
+		<< stats->GetCount(MediaLibCleaner::SAVE_TAGLIB) << L" by TagLib, "
+		<< stats->GetCount(MediaLibCleaner::SAVE_FAILED) << L" failed" << std::endl;
+	programlog->Log(L"Main", L"Tags written in place: " + std::to_wstring(stats->GetCount(MediaLibCleaner::SAVE_IN_PLACE)) + L" files, " + std::to_wstring(stats->GetBytes(MediaLibCleaner::SAVE_IN_PLACE)) + L" bytes", 3);
+	programlog->Log(L"Main", L"Tags written with file rewrite: " + std::to_wstring(stats->GetCount(MediaLibCleaner::SAVE_REWRITE)) + L" files, " + std::to_wstring(stats->GetBytes(MediaLibCleaner::SAVE_REWRITE)) + L" bytes", 3);
+	programlog->Log(L"Main", L"Tags written by TagLib: " + std::to_wstring(stats->GetCount(MediaLibCleaner::SAVE_TAGLIB)) + L" files", 3);
+	programlog->Log(L"Main", L"Tag writes failed: " + std::to_wstring(stats->GetCount(MediaLibCleaner::SAVE_FAILED)) + L" files", 3);
+
+	// memory taken by metadata of the files (columnar store vs one copy of every value per file)
+	MediaLibCleaner::LibraryStore *store = runcontext->GetStore();
+	size_t rows = store->GetRows();
+	if (rows > 0)
+	{
+		programlog->Log(L"Main", L"Metadata memory: " + std::to_wstring(store->GetBytes() / rows) + L" bytes per file (" + std::to_wstring(store->GetFlatBytes() / rows) + L" bytes per file without interning)", 3);
+	}
+
 
 	//>> - No. No, not yet. But one day. Not you and me, but a people. The civilization that evolved past the dimmensions that we know.
 
-	// needs to be done this way to avoid massive amount of std::wcout calls upon destruction
+	// files are not destructed one by one - their memory (and all metadata) is freed in bulk with RunContext arenas
 	MediaLibCleaner::FilesAggregator *d = filesAggregator.release();
 	delete d;
 
+	programlog->Log(L"Main", L"Freeing " + std::to_wstring(runcontext->GetArena()->GetChunks()) + L" arena chunk(s) of files", 3);
+	runcontext.reset();
+
 	programlog->Log(L"Main", L"Program finished", 3);
 
 	return 0;
@@ -596,9 +1146,11 @@ void lua_error_reporting(lua_State *L, int status) {
 *
 * @param[in] wconfig std::wstring containing LUA config file
 * @param[in] fA MediaLibCleaner::FilesAggregator object containing all files that will be processed
+* @param[in] dA MediaLibCleaner::DirectoryAggregator object with aggregates of directories of processed files
 * @param[in] lp MediaLibCleaner::LogProgram object for logging purposses
+* @param[in] rc MediaLibCleaner::RunContext object with precomputed system aliases (shared read-only by all threads)
 */
-void process(std::wstring wconfig, std::unique_ptr<MediaLibCleaner::FilesAggregator>* fA, std::unique_ptr<MediaLibCleaner::LogProgram>* lp)
+void process(std::wstring wconfig, std::unique_ptr<MediaLibCleaner::FilesAggregator>* fA, std::unique_ptr<MediaLibCleaner::DirectoryAggregator>* dA, std::unique_ptr<MediaLibCleaner::LogProgram>* lp, std::unique_ptr<MediaLibCleaner::RunContext>* rc)
 {
 	std::wstring new_config, wid;
 	lua_State *L = nullptr;
@@ -615,7 +1167,7 @@ void process(std::wstring wconfig, std::unique_ptr<MediaLibCleaner::FilesAggrega
 	//>> - R: If we're talking about a couple of years, I can use time to research gravity. Observations from the wormhole - that's gold to professor Brand. 
 
 
-	#pragma omp parallel shared(lp, fA, wconfig) private(new_config, L, nc, s, cfile, id, wid)
+	#pragma omp parallel shared(lp, fA, dA, rc, wconfig) private(new_config, L, nc, s, cfile, id, wid)
 	{
 		id = omp_get_thread_num();
 		wid = std::to_wstring(id);
@@ -628,7 +1180,7 @@ void process(std::wstring wconfig, std::unique_ptr<MediaLibCleaner::FilesAggrega
 
 			(*lp)->Log(L"Process (" + wid + L")", L"File: " + cfile->GetPath(), 3);
 			(*lp)->Log(L"Process (" + wid + L")", L"Creating config file", 3);
-			new_config = MediaLibCleaner::ReplaceAllAliasOccurences(wconfig, cfile, path, datetime_raw, total_files);
+			new_config = MediaLibCleaner::ReplaceAllAliasOccurences(wconfig, cfile, rc->get());
 
 			(*lp)->Log(L"Process (" + wid + L")", L"Lua procesor init", 3);
 			lua_State *L = luaL_newstate();
@@ -637,14 +1189,23 @@ void process(std::wstring wconfig, std::unique_ptr<MediaLibCleaner::FilesAggrega
 			(*lp)->Log(L"Process (" + wid + L")", L"Registering functions", 3);
 			// register C functions in lua processor
 			lua_register(L, "_IsAudioFile", lua_caller_isaudiofile);
+			lua_register(L, "_IsDuplicate", lua_caller_isduplicate);
+			lua_register(L, "_IsIntact", lua_caller_isintact);
 			lua_register(L, "_SetTags", lua_caller_settags);
 			lua_register(L, "_RemoveTags", lua_caller_removetags);
 			lua_register(L, "_SetRequiredTags", lua_caller_setrequiredtags);
 			lua_register(L, "_CheckTagValues", lua_caller_checktagvalues);
+			lua_register(L, "_CheckTagRegex", lua_caller_checktagregex);
+			lua_register(L, "_MatchTag", lua_caller_matchtag);
 			lua_register(L, "_Rename", lua_caller_rename);
 			lua_register(L, "_Move", lua_caller_move);
 			lua_register(L, "_Delete", lua_caller_delete);
 			lua_register(L, "_Log", lua_caller_log);
+			lua_register(L, "_CanonicalName", lua_caller_canonicalname);
+			lua_register(L, "_DefineValueSet", lua_caller_definevalueset);
+			lua_register(L, "_ValueSet", lua_caller_valueset);
+			lua_register(L, "_LoadTable", lua_caller_loadtable);
+			lua_register(L, "_Lookup", lua_caller_lookup);
 
 			(*lp)->Log(L"Process (" + wid + L")", L"Converting wide string to string", 3);
 			nc = ws2s(new_config);
@@ -658,6 +1219,9 @@ void process(std::wstring wconfig, std::unique_ptr<MediaLibCleaner::FilesAggrega
 			lua_pushinteger(L, id);
 			lua_setglobal(L, "__thread");
 
+			lua_PushDirectory(L, (*dA)->Get(cfile));
+			lua_setglobal(L, "dir");
+
 			current_file_thd[id] = cfile;
 
 			(*lp)->Log(L"Process (" + wid + L")", L"Executing script", 3);
@@ -681,6 +1245,131 @@ void process(std::wstring wconfig, std::unique_ptr<MediaLibCleaner::FilesAggrega
 	}
 }
 
+/**
+* Function creating lua processor for _action == "Directory" and executing the script in it
+*
+* Only functions not working on the current file are available; all other functions do nothing (see lua_caller_nofile()).
+*
+* @param[in]  config LUA config file (without aliases replaced)
+* @param[out] status Status of loading and executing the script (0 if script was executed)
+*
+* @return New lua processor (has to be closed by the caller)
+*/
+static lua_State* newDirectoryState(const std::string &config, int *status)
+{
+	lua_State *L = luaL_newstate();
+	luaL_openlibs(L);
+
+	lua_register(L, "_CanonicalName", lua_caller_canonicalname);
+	lua_register(L, "_DefineValueSet", lua_caller_definevalueset);
+	lua_register(L, "_ValueSet", lua_caller_valueset);
+	lua_register(L, "_LoadTable", lua_caller_loadtable);
+	lua_register(L, "_Lookup", lua_caller_lookup);
+
+	for (size_t i = 0; i < sizeof(FILE_FUNCTIONS) / sizeof(FILE_FUNCTIONS[0]); i++)
+	{
+		lua_pushstring(L, FILE_FUNCTIONS[i]);
+		lua_pushcclosure(L, lua_caller_nofile, 1);
+		lua_setglobal(L, FILE_FUNCTIONS[i]);
+	}
+
+	lua_pushstring(L, "Directory");
+	lua_setglobal(L, "_action");
+
+	*status = luaL_loadstring(L, config.c_str());
+	if (*status == 0) {
+		*status = lua_pcall(L, 0, 0, 0);
+	}
+
+	return L;
+}
+
+/**
+* Function calling _OnDirectory(dir) function of the LUA script once for every directory with audio files
+*
+* Script is executed with _action set to "Directory" (hook may be defined by the whole script or only in that pass), then _OnDirectory is called
+* with table describing the directory (the same as dir global, see lua_PushDirectory()) which array part contains views of all audio files
+* of the directory (see lua_PushFileView()). Per-file code of the script should be guarded by _action == ""; functions working on the current file
+* do nothing in this pass. If the script does not define the hook in this pass, directories are not processed at all.
+* Files are grouped by full path of their directory, so every file belongs to exactly one directory; each directory is handled by a single thread,
+* with its own lua processor, so views of the same file are never used by two threads. Tags changed by views are saved when files are processed by process().
+*
+* @param[in] config LUA config file (without aliases replaced)
+* @param[in] dA MediaLibCleaner::DirectoryAggregator object with aggregates and files of all directories
+* @param[in] lp MediaLibCleaner::LogProgram object for logging purposses
+* @param[in] la MediaLibCleaner::LogAlert object for logging purposses
+*
+* @return True if _OnDirectory is defined (directories were processed), false otherwise
+*/
+bool processDirectories(std::string config, std::unique_ptr<MediaLibCleaner::DirectoryAggregator>* dA, std::unique_ptr<MediaLibCleaner::LogProgram>* lp, std::unique_ptr<MediaLibCleaner::LogAlert>* la)
+{
+	// look for the hook the same way it is called, once, before any lua processor per directory is created
+	int status;
+	lua_State *probe = newDirectoryState(config, &status);
+
+	lua_getglobal(probe, "_OnDirectory");
+	bool defined = (status == 0 && lua_isfunction(probe, -1));
+
+	if (status != 0) {
+		(*lp)->Log(L"ProcessDirectories", L"Error occured while looking for _OnDirectory", 3);
+		lua_error_reporting(probe, status);
+	}
+	lua_close(probe);
+
+	if (!defined) return false;
+
+	(*lp)->Log(L"Main", L"Calling _OnDirectory for every directory", 3);
+	std::wcout << L"Processing directories..." << std::endl;
+
+	int count = static_cast<int>((*dA)->GetDirectories());
+
+	if (max_threads > 0)
+		omp_set_num_threads(max_threads);
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int d = 0; d < count; d++)
+	{
+		const MediaLibCleaner::DirectoryAggregate *aggregate = (*dA)->GetAggregate(d);
+		const std::vector<MediaLibCleaner::File*> *files = (*dA)->GetFiles(d);
+
+		(*lp)->Log(L"ProcessDirectories", L"Directory: " + aggregate->path, 3);
+
+		int s;
+		lua_State *L = newDirectoryState(config, &s);
+
+		if (s == 0) {
+			lua_getglobal(L, "_OnDirectory");
+
+			// hook may depend on the directory (e.g. defined under a condition) - skip quietly if it is missing
+			if (lua_isfunction(L, -1)) {
+				lua_PushDirectory(L, aggregate);
+				lua_Integer views = 0;
+				for (size_t i = 0; i < files->size(); i++)
+				{
+					// view of a file from another directory would be changed by two threads at once
+					if ((*files)[i]->GetFolderPath() != aggregate->path) {
+						(*lp)->Log(L"ProcessDirectories", L"File " + (*files)[i]->GetPath() + L" does not belong to " + aggregate->path + L", skipped", 1);
+						continue;
+					}
+
+					lua_PushFileView(L, (*files)[i], lp, la);
+					lua_rawseti(L, -2, ++views);
+				}
+
+				s = lua_pcall(L, 1, 0, 0);
+			}
+		}
+		if (s != 0) {
+			(*lp)->Log(L"ProcessDirectories", L"Error occured in " + aggregate->path, 3);
+			lua_error_reporting(L, s);
+		}
+
+		lua_close(L);
+	}
+
+	return true;
+}
+
 /**
 * Function scanning given directory to find all files
 *
@@ -694,9 +1383,10 @@ void process(std::wstring wconfig, std::unique_ptr<MediaLibCleaner::FilesAggrega
 * @param[in] pth Scanning insertion path
 * @param[out] fA std::unique_ptr to MediaLibCleaner::FilesAggregator object into which all new MediaLibCleaner::File objects will be saved
 * @param[out] tf Total files amount (global)
+* @param[in] rc MediaLibCleaner::RunContext object passed to every MediaLibCleaner::File object
 */
 void scan(std::list<MediaLibCleaner::DFC*>* dfcl, MediaLibCleaner::PathsAggregator* pathl, std::unique_ptr<MediaLibCleaner::LogProgram>* lp, std::unique_ptr<MediaLibCleaner::LogAlert>* la,
-	std::string pth, std::unique_ptr<MediaLibCleaner::FilesAggregator>* fA, int* tf)
+	std::string pth, std::unique_ptr<MediaLibCleaner::FilesAggregator>* fA, int* tf, std::unique_ptr<MediaLibCleaner::RunContext>* rc)
 {
 	std::mutex dfcl_mutex;
 	MediaLibCleaner::DFC *currdfc = MediaLibCleaner::AddDFC(dfcl, pth, &dfcl_mutex, lp, la);
@@ -709,7 +1399,7 @@ void scan(std::list<MediaLibCleaner::DFC*>* dfcl, MediaLibCleaner::PathsAggregat
 	if (max_threads > 0)
 		omp_set_num_threads(max_threads);
 
-	#pragma omp parallel shared(dfcl_mutex, pathl, lp, la, pth, fA, tf, dfcl) private(currdfc, currpath, dirpath, id, wid)
+	#pragma omp parallel shared(dfcl_mutex, pathl, lp, la, pth, fA, tf, dfcl, rc) private(currdfc, currpath, dirpath, id, wid)
 	{
 		id = omp_get_thread_num();
 		wid = std::to_wstring(id);
@@ -740,7 +1430,7 @@ void scan(std::list<MediaLibCleaner::DFC*>* dfcl, MediaLibCleaner::PathsAggregat
 
 			// create File object for file
 			(*lp)->Log(L"Scan (" + wid + L")", L"Creating MediaLibCleaner::File object for file.", 3);
-			MediaLibCleaner::File *filez = new MediaLibCleaner::File(currpath.generic_wstring(), currdfc, lp, la);
+			MediaLibCleaner::File *filez = new ((*rc)->GetArena()) MediaLibCleaner::File(currpath.generic_wstring(), currdfc, lp, la, rc);
 			(*fA)->AddFile(filez);
 
 			// increment total_files counter if audio file
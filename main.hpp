@@ -49,6 +49,13 @@ This project is using these libraries:
 #include "helpers.hpp"
 #include "LuaFunctions.hpp"
 #include "MediaLibCleaner.hpp"
+#include "ScanBenchmark.hpp"
+#include "DuplicateFinder.hpp"
+#include "IntegrityVerifier.hpp"
+#include "ChecksumStore.hpp"
+#include "DirectoryAggregator.hpp"
+#include "TagIndex.hpp"
+#include "NameClusterer.hpp"
 
 #include <Windows.h>
 
@@ -57,5 +64,6 @@ This project is using these libraries:
 
 
 void lua_error_reporting(lua_State*, int);
-void process(std::wstring, std::unique_ptr<MediaLibCleaner::FilesAggregator>*, std::unique_ptr<MediaLibCleaner::LogProgram>*);
-void scan(std::list<MediaLibCleaner::DFC*>* dfcl, MediaLibCleaner::PathsAggregator* pathl, std::unique_ptr<MediaLibCleaner::LogProgram>* lp, std::unique_ptr<MediaLibCleaner::LogAlert>* la, std::string pth, std::unique_ptr<MediaLibCleaner::FilesAggregator>* fA, int* tf);
\ No newline at end of file
+void process(std::wstring, std::unique_ptr<MediaLibCleaner::FilesAggregator>*, std::unique_ptr<MediaLibCleaner::DirectoryAggregator>*, std::unique_ptr<MediaLibCleaner::LogProgram>*, std::unique_ptr<MediaLibCleaner::RunContext>*);
+bool processDirectories(std::string, std::unique_ptr<MediaLibCleaner::DirectoryAggregator>*, std::unique_ptr<MediaLibCleaner::LogProgram>*, std::unique_ptr<MediaLibCleaner::LogAlert>*);
+void scan(std::list<MediaLibCleaner::DFC*>* dfcl, MediaLibCleaner::PathsAggregator* pathl, std::unique_ptr<MediaLibCleaner::LogProgram>* lp, std::unique_ptr<MediaLibCleaner::LogAlert>* la, std::string pth, std::unique_ptr<MediaLibCleaner::FilesAggregator>* fA, int* tf, std::unique_ptr<MediaLibCleaner::RunContext>* rc);
\ No newline at end of file
@@ -27,7 +27,7 @@
  * This file has been modified by Szymon 'Oustish' Oracki.
  * 
  * Changelist:
- * - added aliases for more freeform tags: (lines 862-868)
+ * - added aliases for more freeform tags: (lines 914-920)
      { "----:com.apple.iTunes:LENGTH", "LENGTH" },
      { "----:com.apple.iTunes:ORIGALBUM", "ORIGALBUM" },
      { "----:com.apple.iTunes:ORIGARTIST", "ORIGARTIST" },
@@ -35,8 +35,14 @@
      { "----:com.apple.iTunes:ORIGYEAR", "ORIGYEAR" },
      { "----:com.apple.iTunes:PUBLISHER", "PUBLISHER" },
      { "----:com.apple.iTunes:WWW", "WWW" },
+ * - saveExisting() uses 'free' atoms adjacent to 'ilst' parents (meta, udta, moov) as padding too,
+ *   so growing tags do not move 'mdat' as long as there is enough free space
+ * - size of the free atom left after 'ilst' when file has to grow is configurable with MP4::setIlstPadding()
+ *   (declared by MediaLibCleaner in TagWriter.hpp; if it is not called, ilst is rounded up to the next 1 KiB boundary as before)
  */
 
+#include <vector>
+
 #include <tdebug.h>
 #include <tstring.h>
 #include <tpropertymap.h>
@@ -46,6 +52,26 @@
 
 using namespace TagLib;
 
+namespace TagLib {
+  namespace MP4 {
+    // not declared in mp4tag.h, so the public headers stay untouched
+    TAGLIB_EXPORT void setIlstPadding(unsigned int padding);
+  }
+}
+
+namespace
+{
+  // size of the free atom left after ilst whenever the file has to grow
+  // (-1: round ilst up to the next 1 KiB boundary, as unmodified TagLib does)
+  int ilstPadding = -1;
+}
+
+void
+MP4::setIlstPadding(unsigned int padding)
+{
+  ilstPadding = static_cast<int>(padding);
+}
+
 class MP4::Tag::TagPrivate
 {
 public:
@@ -615,7 +641,7 @@ MP4::Tag::saveNew(ByteVector data)
   data = renderAtom("meta", ByteVector(4, '\0') +
                     renderAtom("hdlr", ByteVector(8, '\0') + ByteVector("mdirappl") +
                                ByteVector(9, '\0')) +
-                    data + padIlst(data));
+                    data + padIlst(data, ilstPadding));
 
   AtomList path = d->atoms->path("moov", "udta");
   if(path.size() != 2) {
@@ -660,9 +686,36 @@ MP4::Tag::saveExisting(ByteVector data, const AtomList &path)
     }
   }
 
+  // if 'ilst' ends its parent, 'free' atoms right after the parent (in 'udta',
+  // 'moov' or at the top level) are adjacent too - use them as padding as well;
+  // grown[i] is the amount of such padding lying outside of path[i]
+  std::vector<long> grown(path.size() - 1, 0);
+  for(int level = static_cast<int>(path.size()) - 2; level >= 0; level--) {
+    MP4::Atom *parent = path[level];
+    if(offset + length != parent->offset + parent->length) {
+      break;
+    }
+
+    const AtomList &siblings = level > 0 ? path[level - 1]->children : d->atoms->atoms;
+    AtomList::ConstIterator it = siblings.find(parent);
+    if(it == siblings.end() || ++it == siblings.end()) {
+      continue;
+    }
+
+    MP4::Atom *next = *it;
+    if(next->name != "free" || next->offset != offset + length) {
+      continue;
+    }
+
+    length += next->length;
+    for(unsigned int i = level; i < grown.size(); i++) {
+      grown[i] += next->length;
+    }
+  }
+
   long delta = data.size() - length;
   if(delta > 0 || (delta < 0 && delta > -8)) {
-    data.append(padIlst(data));
+    data.append(padIlst(data, ilstPadding));
     delta = data.size() - length;
   }
   else if(delta < 0) {
@@ -672,8 +725,15 @@ MP4::Tag::saveExisting(ByteVector data, const AtomList &path)
 
   d->file->insert(data, offset, length);
 
+  for(unsigned int i = 0; i < grown.size(); i++) {
+    if(delta + grown[i] != 0) {
+      AtomList parent;
+      parent.append(path[i]);
+      updateParents(parent, delta + grown[i]);
+    }
+  }
+
   if(delta) {
-    updateParents(path, delta, 1);
     updateOffsets(delta, offset);
   }
 }